@@ -0,0 +1,121 @@
+#include "asynclog.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QCoreApplication>
+
+/*
+ * AsyncLog和qDebug单次调用耗时的对比（调用线程中的耗时，不包括后台线程的格式化和输出）
+ * 两者都输出到stderr，结果输出到stdout，可以 AsyncLogBench 2>/dev/null 只看结果，
+ * 也可以 AsyncLogBench 2>log.txt 对比输出到文件时的耗时
+ *
+ * 渲染循环中每帧只有几条日志，这里按每批1000条（小于环形缓冲的容量）、批之间间隔10ms模拟，
+ * 不会因为环形缓冲满了丢弃记录；--burst时连续调用，观察缓冲满了以后的丢弃
+*/
+
+namespace {
+
+const int kBatches = 50;
+const int kBatchSize = 1000;
+
+struct Result
+{
+    double avgNs = 0.0;
+    double p99Ns = 0.0;
+    double maxNs = 0.0;
+};
+
+// 每次调用单独计时，统计平均值、p99和最大值
+template<typename Call>
+Result measure(Call call, bool pause)
+{
+    std::vector<qint64> samples;
+    samples.reserve(kBatches * kBatchSize);
+    QElapsedTimer timer;
+    timer.start();
+    int i = 0;
+    for (int batch = 0; batch < kBatches; batch++) {
+        for (int n = 0; n < kBatchSize; n++, i++) {
+            const qint64 start = timer.nsecsElapsed();
+            call(i);
+            samples.push_back(timer.nsecsElapsed() - start);
+        }
+        if (pause) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    std::sort(samples.begin(), samples.end());
+    qint64 sum = 0;
+    for (qint64 sample : samples) {
+        sum += sample;
+    }
+    Result result;
+    result.avgNs = double(sum) / samples.size();
+    result.p99Ns = samples[samples.size() * 99 / 100];
+    result.maxNs = samples.back();
+    return result;
+}
+
+void print(const char* name, const Result& result)
+{
+    printf("%-28s avg %9.1f ns  p99 %9.1f ns  max %11.1f ns\n", name, result.avgNs, result.p99Ns, result.maxNs);
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    const bool burst = a.arguments().contains("--burst");
+
+    // 和渲染循环中的日志一样：一个整数和一个浮点数
+    const Result qt = measure([](int i) {
+        qDebug() << "frame" << i << "cost:" << 1.5 << "ms";
+    }, !burst);
+
+    const Result async = measure([](int i) {
+        ALOG("frame {} cost: {} ms", i, 1.5);
+    }, !burst);
+    AsyncLog::flush();
+
+    // 限流：每秒最多输出10条，其余的只计数
+    const Result limited = measure([](int i) {
+        ALOG_RATE(10, "frame {} cost: {} ms", i, 1.5);
+    }, !burst);
+
+    // 4个线程同时写日志，每个线程有自己的环形缓冲，互相之间没有锁竞争
+    std::vector<Result> threadResults(4);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threadResults.size(); t++) {
+        threads.emplace_back([&threadResults, t, burst]() {
+            threadResults[t] = measure([t](int i) {
+                ALOG("thread {} frame {}", int(t), i);
+            }, !burst);
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    AsyncLog::flush();
+
+    const AsyncLog::Stats stats = AsyncLog::stats();
+    printf("calls per case: %d (%s)\n", kBatches * kBatchSize, burst ? "burst" : "batches of 1000, 10 ms apart");
+    print("qDebug", qt);
+    print("ALOG", async);
+    print("ALOG_RATE(10/s)", limited);
+    for (size_t t = 0; t < threadResults.size(); t++) {
+        print(QString("ALOG thread %1 of 4").arg(t).toUtf8().constData(), threadResults[t]);
+    }
+    printf("speedup avg: %.1fx  p99: %.1fx\n", qt.avgNs / async.avgNs, qt.p99Ns / async.p99Ns);
+    printf("async log written %llu dropped %llu suppressed %llu\n",
+           static_cast<unsigned long long>(stats.written),
+           static_cast<unsigned long long>(stats.dropped),
+           static_cast<unsigned long long>(stats.suppressed));
+    return 0;
+}
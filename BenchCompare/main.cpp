@@ -0,0 +1,150 @@
+#include <cstdio>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QCoreApplication>
+
+/*
+ * 例子的离屏帧时间（--frame-bench，见common/framebench.h）和baseline比较：
+ *   BenchCompare --baseline baseline.json [--threshold 10] [--min-delta 0.05] result.json...
+ *   BenchCompare --baseline baseline.json --update result.json...
+ *
+ * baseline是以例子名为key的json对象，值为--frame-bench输出的结果，--update时用本次的结果更新（没有时创建）
+ * 比较cpu p50/p90和gpu p50，比baseline慢threshold%以上并且差值大于min-delta毫秒时为回归，有回归时返回1
+ * baseline和结果需要在同一台机器、同一个驱动下测得（renderer不同时给出提示）
+*/
+
+namespace {
+
+struct Metric
+{
+    const char* group;
+    const char* name;
+};
+
+const Metric metrics[] = {
+    {"cpu_ms", "p50"},
+    {"cpu_ms", "p90"},
+    {"gpu_ms", "p50"},
+};
+
+bool readJson(const QString& path, QJsonObject* object)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        fprintf(stderr, "can't read %s: %s\n", qPrintable(path), qPrintable(file.errorString()));
+        return false;
+    }
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+    if (!document.isObject()) {
+        fprintf(stderr, "%s: %s\n", qPrintable(path), qPrintable(error.errorString()));
+        return false;
+    }
+    *object = document.object();
+    return true;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QString baselinePath;
+    double threshold = 10.0;
+    double minDelta = 0.05;
+    bool update = false;
+    QStringList resultPaths;
+    const QStringList args = a.arguments();
+    for (int i = 1; i < args.size(); i++) {
+        if (args[i] == "--baseline" && i + 1 < args.size()) {
+            baselinePath = args[++i];
+        } else if (args[i] == "--threshold" && i + 1 < args.size()) {
+            threshold = args[++i].toDouble();
+        } else if (args[i] == "--min-delta" && i + 1 < args.size()) {
+            minDelta = args[++i].toDouble();
+        } else if (args[i] == "--update") {
+            update = true;
+        } else {
+            resultPaths.append(args[i]);
+        }
+    }
+    if (baselinePath.isEmpty() || resultPaths.isEmpty()) {
+        fprintf(stderr, "usage: BenchCompare --baseline baseline.json [--threshold PCT] [--min-delta MS] [--update] result.json...\n");
+        return 2;
+    }
+
+    QJsonObject baseline;
+    const bool hasBaseline = QFileInfo::exists(baselinePath);
+    if (hasBaseline && !readJson(baselinePath, &baseline)) {
+        return 2;
+    }
+
+    if (update) {
+        for (const QString& path : resultPaths) {
+            QJsonObject result;
+            if (!readJson(path, &result)) {
+                return 2;
+            }
+            baseline[result["example"].toString()] = result;
+        }
+        QFile file(baselinePath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            fprintf(stderr, "can't write %s: %s\n", qPrintable(baselinePath), qPrintable(file.errorString()));
+            return 2;
+        }
+        file.write(QJsonDocument(baseline).toJson());
+        printf("%s: %d examples\n", qPrintable(baselinePath), baseline.size());
+        return 0;
+    }
+
+    if (!hasBaseline) {
+        fprintf(stderr, "no baseline %s, record one with --update\n", qPrintable(baselinePath));
+        return 2;
+    }
+
+    int regressions = 0;
+    printf("%-20s %-10s %12s %12s %9s\n", "example", "metric", "baseline ms", "current ms", "change");
+    for (const QString& path : resultPaths) {
+        QJsonObject result;
+        if (!readJson(path, &result)) {
+            return 2;
+        }
+        const QString example = result["example"].toString();
+        if (!baseline.contains(example)) {
+            printf("%-20s no baseline\n", qPrintable(example));
+            continue;
+        }
+        const QJsonObject reference = baseline[example].toObject();
+        if (reference["renderer"] != result["renderer"]) {
+            printf("%-20s renderer differs: %s / %s\n", qPrintable(example),
+                   qPrintable(reference["renderer"].toString()), qPrintable(result["renderer"].toString()));
+        }
+
+        for (const Metric& metric : metrics) {
+            const QJsonValue before = reference[metric.group].toObject()[metric.name];
+            const QJsonValue after = result[metric.group].toObject()[metric.name];
+            if (!before.isDouble() || !after.isDouble()) {
+                continue;
+            }
+            const double change = before.toDouble() > 0.0 ? (after.toDouble() / before.toDouble() - 1.0) * 100.0 : 0.0;
+            const bool regressed = change > threshold && after.toDouble() - before.toDouble() > minDelta;
+            if (regressed) {
+                regressions++;
+            }
+            printf("%-20s %-10s %12.3f %12.3f %+8.1f%%%s\n", qPrintable(example),
+                   qPrintable(QString("%1 %2").arg(QString(metric.group).left(3)).arg(metric.name)),
+                   before.toDouble(), after.toDouble(), change, regressed ? "  REGRESSION" : "");
+        }
+    }
+
+    if (regressions > 0) {
+        printf("%d regressions (threshold %.1f%%)\n", regressions, threshold);
+        return 1;
+    }
+    printf("no regressions (threshold %.1f%%)\n", threshold);
+    return 0;
+}
@@ -0,0 +1,28 @@
+#!/bin/sh
+# 离屏测试所有例子的帧时间并和baseline比较（见common/framebench.h、BenchCompare/main.cpp）
+#   sh BenchCompare/run_bench.sh <qmake构建目录> [帧数]
+# 也可以在构建目录中 make bench
+# 默认用mesa llvmpipe和offscreen平台，BENCH_BASELINE指定baseline文件，没有baseline时用这次的结果创建
+set -e
+
+BUILD=${1:?usage: run_bench.sh BUILD_DIR [FRAMES]}
+FRAMES=${2:-300}
+SOURCE=$(cd "$(dirname "$0")/.." && pwd)
+BASELINE=${BENCH_BASELINE:-$SOURCE/BenchCompare/baseline.json}
+EXAMPLES="Blend Box3d ColourRect CoordinateSystems HelloRect HelloTriangle MultiTexture RenderToTexture RendererCore RotateCamera Texture Transform"
+
+export LIBGL_ALWAYS_SOFTWARE=${LIBGL_ALWAYS_SOFTWARE:-1}
+export QT_QPA_PLATFORM=${QT_QPA_PLATFORM:-offscreen}
+
+mkdir -p "$BUILD/bench"
+RESULTS=""
+for example in $EXAMPLES; do
+    "$BUILD/$example/$example" --frame-bench "$FRAMES" --frame-bench-out "$BUILD/bench/$example.json"
+    RESULTS="$RESULTS $BUILD/bench/$example.json"
+done
+
+if [ -f "$BASELINE" ]; then
+    "$BUILD/BenchCompare/BenchCompare" --baseline "$BASELINE" $RESULTS
+else
+    "$BUILD/BenchCompare/BenchCompare" --baseline "$BASELINE" --update $RESULTS
+fi
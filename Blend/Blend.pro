@@ -25,3 +25,12 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 
 RESOURCES += \
     res.qrc
+
+include(../common/glstatecache.pri)
+include(../common/asynclog.pri)
+include(../common/shaderlink.pri)
+include(../common/textureloader.pri)
+include(../common/texturecache.pri)
+include(../common/framebench.pri)
+include(../common/gpuprofiler.pri)
+include(../common/framehud.pri)
@@ -1,4 +1,5 @@
 #include "widget.h"
+#include "framebench.h"
 
 #include <QApplication>
 
@@ -11,6 +12,24 @@ int main(int argc, char *argv[])
 
     QApplication a(argc, argv);
     Widget w;
+    // 命令行参数：--texture-budget MB 纹理缓存的显存预算
+    // --gpu-profile：每秒输出每个图层的gpu耗时和着色器调用次数
+    // --texture-cycle N：底层图片在N张生成的图片之间轮换，触发纹理缓存的释放和重新加载（预算默认为一半的图片，可以用--texture-budget修改）
+    const QStringList args = a.arguments();
+    w.setGpuProfile(args.contains("--gpu-profile"));
+    int index = args.indexOf("--texture-cycle");
+    if (index >= 0) {
+        w.setTextureCycle(args.value(index + 1).toInt());
+    }
+    index = args.indexOf("--texture-budget");
+    if (index >= 0) {
+        w.setTextureBudget(qint64(args.value(index + 1).toDouble() * 1024 * 1024));
+    }
+    // --frame-bench N：不显示窗口，离屏渲染N帧，输出cpu/gpu帧时间统计后退出（见common/framebench.h）
+    const FrameBench::Options bench = FrameBench::parse(a.arguments());
+    if (bench.frames > 0) {
+        return FrameBench::run(&w, bench);
+    }
     w.show();
     return a.exec();
 }
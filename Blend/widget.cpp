@@ -1,9 +1,12 @@
 #include "widget.h"
 #include "ui_widget.h"
+#include "asynclog.h"
+#include "shaderlink.h"
 
 #include <QDebug>
 #include <QImage>
 #include <QTimer>
+#include <QPainter>
 /*
  * 通过opengl blend依次叠加绘制多个纹理
  * 主要原理是一个一个的纹理绘制，通过opengl blend混合，而不是多个纹理一起绘制，使用shader混合
@@ -58,12 +61,21 @@ Widget::Widget(QWidget *parent) :
     ui(new Ui::Widget)
 {
     ui->setupUi(this);
+
+    // 图片解码完成后重绘，paintGL中上传到纹理
+    connect(&m_textureLoader, &TextureLoader::textureDecoded, this, QOverload<>::of(&Widget::update));
+
+    connect(&m_titleTimer, &QTimer::timeout, this, &Widget::updateTitle);
+    m_titleTimer.start(1000);
 }
 
 Widget::~Widget()
 {
     makeCurrent();
     m_vbo.destroy();
+    m_textureCache.clear();
+    m_gpuProfiler.destroy();
+    m_hud.destroy();
     doneCurrent();
 
     delete ui;
@@ -74,6 +86,9 @@ void Widget::initializeGL()
     qDebug() << "format:" << context()->format();
 
     initializeOpenGLFunctions();
+    m_hud.initialize(this);
+    m_stateCache.initialize();
+    m_gpuProfiler.initialize(context());
     // 黑色背景
     glClearColor(0.0f, 1.0f, 0.0f, 1.0f);
 
@@ -95,9 +110,7 @@ void Widget::initializeGL()
     m_ebo.allocate(indices, sizeof(indices));
 
     // 编译着色器
-    m_shaderProgram.addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShaderSource);
-    m_shaderProgram.addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShaderSource);
-    m_shaderProgram.link();
+    buildCachedProgram(m_shaderProgram, vertexShaderSource, fragmentShaderSource, "Blend");
     m_shaderProgram.bind();
 
     // 指定顶点坐标在vbo中的访问方式
@@ -119,27 +132,72 @@ void Widget::initializeGL()
     m_matrixUniform = m_shaderProgram.uniformLocation("matrix");
 
     // 设置纹理
-    // 设置st方向上纹理超出坐标时的显示策略
-    m_texture.setWrapMode(QOpenGLTexture::DirectionS, QOpenGLTexture::ClampToEdge);
-    m_texture.setWrapMode(QOpenGLTexture::DirectionT, QOpenGLTexture::ClampToEdge);
-    // 设置纹理缩放时的策略
-    m_texture.setMinificationFilter(QOpenGLTexture::Linear);
-    m_texture.setMagnificationFilter(QOpenGLTexture::Linear);
-    m_texture.setData(QImage(":/wall.jpg"));
-
-    // 设置st方向上纹理超出坐标时的显示策略
-    m_texture2.setWrapMode(QOpenGLTexture::DirectionS, QOpenGLTexture::ClampToEdge);
-    m_texture2.setWrapMode(QOpenGLTexture::DirectionT, QOpenGLTexture::ClampToEdge);
-    // 设置纹理缩放时的策略
-    m_texture2.setMinificationFilter(QOpenGLTexture::Linear);
-    m_texture2.setMagnificationFilter(QOpenGLTexture::Linear);
-    m_texture2.setData(QImage(":/face.png"));
+    // 纹理由m_textureCache管理，paintGL中第一次用到时加载，
+    // st方向上超出坐标时的显示策略和缩放策略使用缓存的默认值（ClampToEdge/Linear）
 
     // 图片是rgba8888格式，注意这里的参数GL_RGBA8/GL_RGBA
     //glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, wall.width(), wall.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, wall.bits());
 
     m_vao.release();
-    qDebug() << m_shaderProgram.log();
+    ALOG("{}", m_shaderProgram.log());
+}
+
+void Widget::setTextureBudget(qint64 bytes)
+{
+    m_textureCache.setBudget(bytes);
+}
+
+void Widget::setTextureCycle(int count)
+{
+    m_cyclePaths.clear();
+    if (count <= 0) {
+        return;
+    }
+    m_cycleDir.reset(new QTemporaryDir);
+    if (!m_cycleDir->isValid()) {
+        qDebug() << "texture cycle: can't create temporary dir" << m_cycleDir->errorString();
+        return;
+    }
+
+    // wall.jpg叠加不同的颜色，保存为不同的文件，每张图片在缓存中是单独的纹理
+    const QImage wall = QImage(":/wall.jpg").convertToFormat(QImage::Format_RGB32);
+    for (int i = 0; i < count; i++) {
+        QImage image = wall;
+        QPainter painter(&image);
+        painter.fillRect(image.rect(), QColor::fromHsv(i * 360 / count, 255, 255, 96));
+        painter.end();
+        const QString path = m_cycleDir->filePath(QString("cycle_%1.jpg").arg(i));
+        if (!image.save(path)) {
+            qDebug() << "texture cycle: can't write" << path;
+            m_cyclePaths.clear();
+            return;
+        }
+        m_cyclePaths.append(path);
+    }
+
+    // 单层RGBA8纹理，预算只够一半的图片
+    m_textureCache.setBudget(qint64(wall.width()) * wall.height() * 4 * qMax(count / 2, 1));
+    qDebug() << "texture cycle:" << count << "images, budget" << m_textureCache.budget() / 1024 << "KB";
+}
+
+QString Widget::bottomLayerPath()
+{
+    if (m_cyclePaths.isEmpty()) {
+        return ":/wall.jpg";
+    }
+    const int cycleFrames = 10;
+    const int index = (m_cycleFrame / cycleFrames) % m_cyclePaths.size();
+    // 每转完一圈输出一次纹理缓存的统计
+    if (m_cycleFrame > 0 && m_cycleFrame % (cycleFrames * m_cyclePaths.size()) == 0) {
+        ALOG("texture cycle: {}", m_textureCache.stats().summary());
+    }
+    m_cycleFrame++;
+    return m_cyclePaths.at(index);
+}
+
+void Widget::setGpuProfile(bool enabled)
+{
+    m_gpuProfiler.setEnabled(enabled);
 }
 
 void Widget::resizeGL(int w, int h)
@@ -150,16 +208,26 @@ void Widget::resizeGL(int w, int h)
 
 void Widget::paintGL()
 {
+    // 统计这一帧的cpu/gpu耗时，作用域结束（包括提前return）时绘制HUD
+    FrameHud::Frame hudFrame(m_hud);
+
+    // 上传已经解码好的图片（在绑定纹理之前）
+    m_textureLoader.uploadReady();
+    m_textureCache.beginFrame();
+    // 读取几帧之前已经完成的查询结果，不等待gpu
+    m_gpuProfiler.beginFrame();
+
+    // 下面的bind和状态设置都通过m_stateCache完成，和当前状态相同的调用会被跳过
+    m_stateCache.beginFrame();
+
     // 混合参数的具体含义可以参考 https://learnopengl-cn.github.io/04%20Advanced%20OpenGL/03%20Blending/
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    m_stateCache.setBlend(true);
+    m_stateCache.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     // 绘制第一张图片（wall）
 
-    // 激活纹理单元0
-    glActiveTexture(GL_TEXTURE0);
-    // 将第一张图片纹理绑定到纹理单元0
-    m_texture.bind();
+    // 激活纹理单元0，将第一张图片纹理绑定到纹理单元0
+    m_stateCache.bindTexture(0, m_textureCache.texture(bottomLayerPath()));
 
     // 调节绘制位置（旋转/缩放/移动）
     QMatrix4x4 modelview;
@@ -171,20 +239,21 @@ void Widget::paintGL()
     //modelview.scale(0.9f);
 
     // 绑定program
-    m_shaderProgram.bind();
+    m_stateCache.useProgram(m_shaderProgram);
     // 更新变化矩阵的数据到gpu顶点着色器的采样器matrix中
     m_shaderProgram.setUniformValue(m_matrixUniform, modelview);
-    m_vao.bind();
+    m_stateCache.bindVertexArray(m_vao);
     // 开始绘制
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-    m_vao.release();
-    m_shaderProgram.release();
+    {
+        GpuProfiler::Scope scope(m_gpuProfiler, "layer wall");
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    }
+    // 不再release：第二张图片还是用同一个program和vao，release之后马上又要bind，都是无用的调用
 
     // 绘制第二张图片（face）
-    // 激活纹理单元0
-    glActiveTexture(GL_TEXTURE0);
     // 将第二张图片纹理绑定到纹理单元0 （绘制完第一张，纹理单元0就可以继续使用了，这样就算绘制yuv，也最多只使用0，1，2三个纹理单元）
-    m_texture2.bind();
+    // 纹理单元0已经是激活状态，glActiveTexture会被跳过
+    m_stateCache.bindTexture(0, m_textureCache.texture(":/face.png"));
 
     // 调节绘制位置（旋转/缩放/移动）
     QMatrix4x4 modelview2;
@@ -203,13 +272,35 @@ void Widget::paintGL()
     // 旋转（垂直于z轴的面逆时针旋转conut角度）
     //modelview2.rotate(90.0f, 0.0f, 0.0f, 1.0f);
 
-    // 绑定program
-    m_shaderProgram.bind();
+    // 绑定program（和上面相同，program和vao的绑定都会被跳过）
+    m_stateCache.useProgram(m_shaderProgram);
     // 更新变化矩阵的数据到gpu顶点着色器的采样器matrix中
     m_shaderProgram.setUniformValue(m_matrixUniform, modelview2);
-    m_vao.bind();
+    m_stateCache.bindVertexArray(m_vao);
     // 开始绘制
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-    m_vao.release();
-    m_shaderProgram.release();
+    {
+        GpuProfiler::Scope scope(m_gpuProfiler, "layer face");
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    }
+    m_gpuProfiler.endFrame();
+
+    // 超过显存预算时释放本帧没有用到的纹理
+    m_textureCache.endFrame();
+
+    if (m_gpuProfiler.isActive()) {
+        ALOG_RATE(1, "gpu profile: {}", m_gpuProfiler.summary());
+    }
+
+    m_textureLoader.frameDone();
+
+    // 轮换图片时持续重绘
+    if (!m_cyclePaths.isEmpty()) {
+        update();
+    }
+}
+
+void Widget::updateTitle()
+{
+    // 最近一帧实际调用和跳过的gl状态函数次数，以及纹理缓存的统计
+    setWindowTitle(m_stateCache.currentFrame().summary() + " | " + m_textureCache.stats().summary());
 }
@@ -7,6 +7,16 @@
 #include <QOpenGLVertexArrayObject>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLTexture>
+#include <QTimer>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QScopedPointer>
+
+#include "glstatecache.h"
+#include "gpuprofiler.h"
+#include "texturecache.h"
+#include "textureloader.h"
+#include "framehud.h"
 
 namespace Ui {
 class Widget;
@@ -20,11 +30,24 @@ public:
     explicit Widget(QWidget *parent = nullptr);
     ~Widget();
 
+    // 纹理缓存的显存预算
+    void setTextureBudget(qint64 bytes);
+    // 纹理缓存的测试：底层图片在count张生成的图片之间轮换（每10帧换一张），显存预算设为只能容纳一半的图片，
+    // 换回来时图片已经被释放，需要重新加载（标题栏中evictions/misses一直增加），需要在show之前调用
+    void setTextureCycle(int count);
+    // 统计每个图层的gpu耗时和着色器调用次数（见common/gpuprofiler.h），需要在show之前调用
+    void setGpuProfile(bool enabled);
+
 protected:
     virtual void initializeGL() override;
     virtual void resizeGL(int w, int h) override;
     virtual void paintGL() override;
 
+private:
+    void updateTitle();
+    // 底层图片的路径：默认是wall.jpg，设置了setTextureCycle()时按帧轮换
+    QString bottomLayerPath();
+
 private:
     Ui::Widget *ui;
 
@@ -38,12 +61,30 @@ private:
     // 着色器程序：编译链接着色器
     QOpenGLShaderProgram m_shaderProgram;
 
-    // 纹理
-    QOpenGLTexture m_texture {QOpenGLTexture::Target2D};
-    QOpenGLTexture m_texture2 {QOpenGLTexture::Target2D};
-
     // 向顶点着色器传递数据的矩阵
     int m_matrixUniform = 0;
+
+    // gl状态缓存，跳过重复的bind和状态设置
+    GLStateCache m_stateCache;
+
+    // 纹理异步加载：图片在线程池中解码，解码完成前使用占位纹理
+    TextureLoader m_textureLoader;
+    // 纹理：按图片路径从缓存中取得，超过显存预算时释放最久没有使用的纹理
+    TextureCache m_textureCache {m_textureLoader};
+
+    // setTextureCycle()生成的图片，为空时不轮换
+    QScopedPointer<QTemporaryDir> m_cycleDir;
+    QStringList m_cyclePaths;
+    int m_cycleFrame = 0;
+
+    // 每个图层一个scope，默认关闭
+    GpuProfiler m_gpuProfiler;
+
+    // 标题栏的统计由定时器每秒更新一次，不在paintGL中调用setWindowTitle
+    QTimer m_titleTimer;
+
+    // 帧统计HUD：FRAME_HUD=1时显示，默认关闭
+    FrameHud m_hud;
 };
 
 #endif // WIDGET_H
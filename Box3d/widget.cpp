@@ -1,9 +1,12 @@
 #include "widget.h"
 #include "ui_widget.h"
+#include "asynclog.h"
+#include "shaderlink.h"
+#include "shaderdefines.h"
+#include "meshoptimizer.h"
 
 #include <QDebug>
 #include <QImage>
-#include <QTimer>
 /*
  * 绘制立方体（多个顶点坐标，开启深度测试，开启模型/视图/裁剪矩阵）
  * 绘制立方体和绘制平面的区别是：绘制一个面变成绘制6个面，需要开启深度测试和模型/视图/裁剪矩阵
@@ -65,11 +68,6 @@ float vertices[] = {
     -0.5f,  0.5f, -0.5f,  0.0f, 1.0f
 };
 
-unsigned int indices[] = { // 注意索引从0开始!
-                           0, 1, 3, // 第一个三角形
-                           1, 2, 3  // 第二个三角形
-                         };
-
 const char* vertexShaderSource = R"(#version 330 core
                                  layout (location = 0) in vec3 aPos; // 来自cpu的顶点坐标
                                  layout (location = 1) in vec2 aTexCoord; // 来自cpu的纹理坐标
@@ -89,6 +87,9 @@ const char* vertexShaderSource = R"(#version 330 core
                                  TexCoord = vec2(aTexCoord.x, 1.0 - aTexCoord.y);
                                  })";
 
+// 第二张图片的混合比例，以MIX_FACTOR注入片段着色器
+const double mixFactor = 0.2;
+
 const char* fragmentShaderSource = R"(#version 330 core
                                    out vec4 FragColor;
 
@@ -100,7 +101,7 @@ const char* fragmentShaderSource = R"(#version 330 core
                                    void main()
                                    {
                                    // 混合纹理坐标/纹理数据/颜色
-                                   FragColor = mix(texture(texture1, TexCoord), texture(texture2, TexCoord), 0.2);
+                                   FragColor = mix(texture(texture1, TexCoord), texture(texture2, TexCoord), MIX_FACTOR);
                                    } )";
 
 Widget::Widget(QWidget *parent) :
@@ -108,12 +109,20 @@ Widget::Widget(QWidget *parent) :
     ui(new Ui::Widget)
 {
     ui->setupUi(this);
+
+    // 图片解码完成后重绘，paintGL中上传到纹理
+    connect(&m_textureLoader, &TextureLoader::textureDecoded, this, QOverload<>::of(&Widget::update));
+    m_frameScheduler.start();
+
+    connect(&m_titleTimer, &QTimer::timeout, this, &Widget::updateTitle);
+    m_titleTimer.start(1000);
 }
 
 Widget::~Widget()
 {
     makeCurrent();
     m_vbo.destroy();
+    m_hud.destroy();
     doneCurrent();
 
     delete ui;
@@ -124,6 +133,8 @@ void Widget::initializeGL()
     qDebug() << "format:" << context()->format();
 
     initializeOpenGLFunctions();
+    m_hud.initialize(this);
+    m_stateCache.initialize();
 
     // 构造10个立方体的位置
     m_boxPositions.push_back(QVector3D(0.0f,  0.0f,  0.0f));
@@ -150,21 +161,29 @@ void Widget::initializeGL()
     // vao也会保存ebo
     m_vao.bind();
 
+    // 立方体网格预处理：合并重复顶点生成索引，再按照vertex cache和顶点读取的局部性重排
+    MeshStats before;
+    MeshStats after;
+    const IndexedMesh mesh = MeshOptimizer::optimize(vertices, int(sizeof(vertices) / sizeof(float) / 5), 5, &before, &after);
+    m_indexCount = int(mesh.indices.size());
+    qDebug() << "cube mesh: vertices" << before.vertexCount << "->" << after.vertexCount
+             << "ACMR" << before.acmr << "->" << after.acmr
+             << "vertex fetch bytes" << before.fetchBytes << "->" << after.fetchBytes;
+
     // vbo初始化
     m_vbo.create();
     m_vbo.bind();
     m_vbo.setUsagePattern(QOpenGLBuffer::StaticDraw);
-    m_vbo.allocate(vertices, sizeof(vertices));
+    m_vbo.allocate(mesh.vertices.data(), int(mesh.vertices.size() * sizeof(float)));
 
     // ebo初始化
     m_ebo.create();
     m_ebo.bind();
-    m_ebo.allocate(indices, sizeof(indices));
+    m_ebo.allocate(mesh.indices.data(), int(mesh.indices.size() * sizeof(unsigned int)));
 
     // 编译着色器
-    m_shaderProgram.addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShaderSource);
-    m_shaderProgram.addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShaderSource);
-    m_shaderProgram.link();
+    const QString fragmentShader = QString::fromStdString(ShaderDefines().set("MIX_FACTOR", mixFactor).inject(fragmentShaderSource));
+    buildCachedProgram(m_shaderProgram, vertexShaderSource, fragmentShader, "Box3d");
     m_shaderProgram.bind();
 
     // 指定顶点坐标在vbo中的访问方式
@@ -194,7 +213,7 @@ void Widget::initializeGL()
     // 设置纹理缩放时的策略
     m_texture.setMinificationFilter(QOpenGLTexture::Linear);
     m_texture.setMagnificationFilter(QOpenGLTexture::Linear);
-    m_texture.setData(QImage(":/wall.jpg"));
+    m_textureLoader.load(m_texture, ":/wall.jpg");
 
     // 设置st方向上纹理超出坐标时的显示策略
     m_texture2.setWrapMode(QOpenGLTexture::DirectionS, QOpenGLTexture::ClampToEdge);
@@ -202,14 +221,14 @@ void Widget::initializeGL()
     // 设置纹理缩放时的策略
     m_texture2.setMinificationFilter(QOpenGLTexture::Linear);
     m_texture2.setMagnificationFilter(QOpenGLTexture::Linear);
-    m_texture2.setData(QImage(":/face.png"));
+    m_textureLoader.load(m_texture2, ":/face.png");
 
     // 图片是rgba8888格式，注意这里的参数GL_RGBA8/GL_RGBA
     //glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, wall.width(), wall.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, wall.bits());
 
     m_vao.release();
 
-    qDebug() << m_shaderProgram.log();
+    ALOG("{}", m_shaderProgram.log());
 }
 
 void Widget::resizeGL(int w, int h)
@@ -220,23 +239,26 @@ void Widget::resizeGL(int w, int h)
 
 void Widget::paintGL()
 {
-    // 每隔100ms刷新一次
-    static int count = 0;
-    QTimer::singleShot(100, this, [this](){
-        count += 1;
-        update();
-    });
-
-    // 激活纹理单元0
-    glActiveTexture(GL_TEXTURE0);
-    // 绑定纹理到纹理单元0
-    m_texture.bind();
-    glActiveTexture(GL_TEXTURE1);
-    m_texture2.bind();
+    // 统计这一帧的cpu/gpu耗时，作用域结束（包括提前return）时绘制HUD
+    FrameHud::Frame hudFrame(m_hud);
+
+    // 上传已经解码好的图片（在绑定纹理之前）
+    m_textureLoader.uploadReady();
+
+    // 动画时间按单调时钟推进，每秒旋转10度，和帧率无关
+    m_frameScheduler.beginFrame();
+    const float time = float(m_frameScheduler.time() * 10.0);
+
+    // 下面的bind都通过m_stateCache完成，和当前状态相同的调用会被跳过
+    m_stateCache.beginFrame();
+
+    // 激活纹理单元0，绑定纹理到纹理单元0
+    m_stateCache.bindTexture(0, m_texture);
+    m_stateCache.bindTexture(1, m_texture2);
 
     // 我们这里只有一个shaderProgram和vao，其实没有必要重复bind和release
-    // 这里只是为了教学，在多个shaderProgram的情况下，这是标准操作
-    m_shaderProgram.bind();
+    // 这里只是为了教学，在多个shaderProgram的情况下，这是标准操作（重复的bind会被m_stateCache跳过）
+    m_stateCache.useProgram(m_shaderProgram);
 
     // 视图矩阵：将世界坐标转换为观察坐标
     QMatrix4x4 viewMatri;
@@ -248,12 +270,12 @@ void Widget::paintGL()
     // 这里透视投影中有对下面参数的介绍：https://learnopengl-cn.github.io/01%20Getting%20started/08%20Coordinate%20Systems/#3d
     projectionMatri.perspective(45.0f, width()/height(), 0.1f, 100.0f);
 
-    m_shaderProgram.bind();
+    m_stateCache.useProgram(m_shaderProgram);
     // 更新变化矩阵的数据到gpu顶点着色器的采样器中
     m_shaderProgram.setUniformValue(m_viewMatrix, viewMatri);
     m_shaderProgram.setUniformValue(m_projectionMatrix, projectionMatri);
 
-    m_vao.bind();
+    m_stateCache.bindVertexArray(m_vao);
 
     // 在不同位置绘制10个立方体
     for(unsigned int i = 0; i < 10; i++) {
@@ -262,16 +284,25 @@ void Widget::paintGL()
         // 移动到指定位置
         modelMatri.translate(m_boxPositions[i]);
         // 旋转一定角度
-        float angle = 20.0f * i + count;
+        float angle = 20.0f * i + time;
         modelMatri.rotate(angle, 1.0f, 0.3f, 0.5f);
 
         m_shaderProgram.setUniformValue(m_modelMatrix, modelMatri);
 
         // 绘制一个立方体
-        // glDrawArrays不使用顶点索引
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        // glDrawElements根据ebo中的索引去vbo中找顶点，重复的顶点只需要变换一次
+        glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, 0);
     }
 
-    m_vao.release();
-    m_shaderProgram.release();
+    // 下一帧开始时状态缓存会作废，这里不需要release
+
+    m_frameScheduler.endFrame();
+
+    m_textureLoader.frameDone();
+}
+
+void Widget::updateTitle()
+{
+    // 最近一帧实际调用和跳过的gl状态函数次数，以及帧率和帧间隔抖动
+    setWindowTitle(m_stateCache.currentFrame().summary() + " | " + m_frameScheduler.stats().summary());
 }
@@ -7,6 +7,12 @@
 #include <QOpenGLVertexArrayObject>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLTexture>
+#include <QTimer>
+
+#include "framescheduler.h"
+#include "glstatecache.h"
+#include "textureloader.h"
+#include "framehud.h"
 
 namespace Ui {
 class Widget;
@@ -25,6 +31,9 @@ protected:
     virtual void resizeGL(int w, int h) override;
     virtual void paintGL() override;
 
+private:
+    void updateTitle();
+
 private:
     Ui::Widget *ui;
 
@@ -34,6 +43,8 @@ private:
     QOpenGLBuffer m_vbo; // 默认即为VertexBuffer(GL_ARRAY_BUFFER)类型
     // 索引缓冲对象(Element Buffer Object，EBO或Index Buffer Object，IBO)，用来缓存顶点坐标的索引
     QOpenGLBuffer m_ebo {QOpenGLBuffer::IndexBuffer};
+    // ebo中的索引数量
+    int m_indexCount = 0;
 
     // 着色器程序：编译链接着色器
     QOpenGLShaderProgram m_shaderProgram;
@@ -49,6 +60,20 @@ private:
 
     // 多个立方体的位置
     QVector<QVector3D> m_boxPositions;
+
+    // gl状态缓存，跳过重复的bind和状态设置
+    GLStateCache m_stateCache;
+
+    // 动画帧调度：按时间推进旋转角度，每帧swap完成后请求下一帧
+    FrameScheduler m_frameScheduler {this};
+    // 标题栏的统计每秒更新一次：setWindowTitle要同步访问窗口系统，不放在paintGL中
+    QTimer m_titleTimer;
+
+    // 纹理异步加载：图片在线程池中解码，解码完成前使用占位纹理
+    TextureLoader m_textureLoader;
+
+    // 帧统计HUD：FRAME_HUD=1时显示，默认关闭
+    FrameHud m_hud;
 };
 
 #endif // WIDGET_H
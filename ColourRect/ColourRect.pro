@@ -22,3 +22,9 @@ FORMS += \
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
 !isEmpty(target.path): INSTALLS += target
+
+include(../common/damagetracker.pri)
+include(../common/asynclog.pri)
+include(../common/shaderlink.pri)
+include(../common/framebench.pri)
+include(../common/framehud.pri)
@@ -1,7 +1,43 @@
 #include "widget.h"
+#include "framebench.h"
 
+#include <QDebug>
+#include <QTimer>
+#include <QElapsedTimer>
 #include <QApplication>
 
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+// 进程（所有线程，包括驱动线程）消耗的cpu时间，单位ms
+double processCpuTimeMs()
+{
+#ifdef Q_OS_WIN
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        return 0.0;
+    }
+    // FILETIME单位为100ns
+    const quint64 kernelTime = (quint64(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+    const quint64 userTime = (quint64(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+    return (kernelTime + userTime) / 10000.0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0.0;
+    }
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0
+            + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+#endif
+}
+
+}
+
 int main(int argc, char *argv[])
 {
     QSurfaceFormat format = QSurfaceFormat::defaultFormat();
@@ -11,6 +47,44 @@ int main(int argc, char *argv[])
 
     QApplication a(argc, argv);
     Widget w;
+    // 命令行参数：
+    // --continuous：连续重绘（原来的行为），默认按需重绘
+    // --measure S：显示后运行S秒，输出cpu占用和重绘次数后退出，分别用两种模式运行对比，例如
+    //   ColourRect --measure 30 和 ColourRect --continuous --measure 30
+    const QStringList args = a.arguments();
+    const bool continuous = args.contains("--continuous");
+    w.setContinuous(continuous);
+    // --frame-bench N：不显示窗口，离屏渲染N帧，输出cpu/gpu帧时间统计后退出（见common/framebench.h）
+    const FrameBench::Options bench = FrameBench::parse(a.arguments());
+    if (bench.frames > 0) {
+        return FrameBench::run(&w, bench);
+    }
     w.show();
+
+    const int index = args.indexOf("--measure");
+    if (index >= 0) {
+        const int seconds = qMax(args.value(index + 1).toInt(), 1);
+        // 启动（创建context、编译着色器）的cpu时间不计入
+        QElapsedTimer wallTimer;
+        double cpuStartMs = 0.0;
+        int framesStart = 0;
+        QTimer::singleShot(1000, &w, [&]() {
+            wallTimer.start();
+            cpuStartMs = processCpuTimeMs();
+            framesStart = w.damageTracker().stats().frames;
+            QTimer::singleShot(seconds * 1000, &w, [&]() {
+                const double wallMs = wallTimer.elapsed();
+                const double cpuMs = processCpuTimeMs() - cpuStartMs;
+                const int frames = w.damageTracker().stats().frames - framesStart;
+                // cpu占用按单核计算，100%为占满一个核
+                qDebug() << (continuous ? "continuous:" : "on-demand:")
+                         << "cpu" << cpuMs / wallMs * 100.0 << "%"
+                         << "frames" << frames << "(" << frames * 1000.0 / wallMs << "fps )"
+                         << "cpu per frame" << (frames > 0 ? cpuMs / frames : 0.0) << "ms";
+                qDebug() << qPrintable(w.damageTracker().stats().summary());
+                a.quit();
+            });
+        });
+    }
     return a.exec();
 }
@@ -1,5 +1,7 @@
 #include "widget.h"
 #include "ui_widget.h"
+#include "asynclog.h"
+#include "shaderlink.h"
 
 #include <QDebug>
 #include <QTime>
@@ -7,6 +9,8 @@
 /*
  * cpu根据时间计算颜色，然后通过uniform设置给片段着色器
  * uniform是cpu和片段着色器中交互数据的工具，不同于顶点坐标，它是全局的，在任何着色器中都可以使用
+ *
+ * 颜色按秒变化，没有必要每帧重绘：默认按需重绘，每秒开始时计算一次颜色，颜色变化时才重绘
 */
 
 float vertices[] = {
@@ -43,22 +47,50 @@ Widget::Widget(QWidget *parent) :
     ui(new Ui::Widget)
 {
     ui->setupUi(this);
+
+    // 声明会让画面失效的输入：ourColor uniform和窗口大小
+    m_damage.watch(DamageTracker::Uniform | DamageTracker::Resize);
+    // 颜色按秒变化，每秒开始时重新计算
+    m_damage.setTimeQuantum(1000);
+    connect(&m_damage, &DamageTracker::timeQuantumElapsed, this, &Widget::updateColor);
+    updateColor();
 }
 
 Widget::~Widget()
 {
     makeCurrent();
     m_vbo.destroy();
+    m_hud.destroy();
     doneCurrent();
 
     delete ui;
 }
 
+void Widget::setContinuous(bool continuous)
+{
+    m_damage.setContinuous(continuous);
+}
+
+void Widget::updateColor()
+{
+    // 动态调整片段着色器ourColor颜色
+    float timeValue = QTime::currentTime().second();
+    float greenValue = (sin(timeValue) / 2.0f) + 0.5f;
+
+    QVector4D color(1.0f, greenValue, 0.0f, 1.0f);
+    // 颜色没有变化时不重绘，也不输出日志
+    if (m_damage.setUniform("ourColor", color)) {
+        m_color = color;
+        ALOG("greenValue: {}", greenValue);
+    }
+}
+
 void Widget::initializeGL()
 {
     qDebug() << "format:" << context()->format();
 
     initializeOpenGLFunctions();
+    m_hud.initialize(this);
     // 黑色背景
     glClearColor(0.0f, 1.0f, 0.0f, 1.0f);
 
@@ -80,9 +112,7 @@ void Widget::initializeGL()
     m_ebo.allocate(indices, sizeof(indices));
 
     // 编译着色器
-    m_shaderProgram.addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShaderSource);
-    m_shaderProgram.addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShaderSource);
-    m_shaderProgram.link();
+    buildCachedProgram(m_shaderProgram, vertexShaderSource, fragmentShaderSource, "ColourRect");
 
     // 指定顶点坐标在vbo中的访问方式
     // 参数解释：顶点坐标在shader中的参数名称，顶点坐标为float，起始偏移为0字节，顶点坐标类型为vec3，步幅为3个float
@@ -101,20 +131,21 @@ void Widget::resizeGL(int w, int h)
 
 void Widget::paintGL()
 {
-    // 为了循环触发绘制
-    update();
+    // 统计这一帧的cpu/gpu耗时，作用域结束（包括提前return）时绘制HUD
+    FrameHud::Frame hudFrame(m_hud);
+
+    // 记录本帧的重绘原因，连续重绘模式下会请求下一帧
+    m_damage.beginFrame();
 
     // 我们这里只有一个shaderProgram和vao，其实没有必要重复bind和release
     // 这里只是为了教学，在多个shaderProgram的情况下，这是标准操作
     m_shaderProgram.bind();
 
-    // 动态调整片段着色器ourColor颜色
-    float timeValue = QTime::currentTime().second();
-    float greenValue = (sin(timeValue) / 2.0f) + 0.5f;
-    qDebug() << "greenValue:" << greenValue;
-
-    QVector4D color(1.0f, greenValue, 0.0f, 1.0f);
-    m_shaderProgram.setUniformValue("ourColor", color);
+    if (m_damage.isContinuous()) {
+        // 连续重绘模式下保持原来的行为：每帧根据时间计算颜色
+        updateColor();
+    }
+    m_shaderProgram.setUniformValue("ourColor", m_color);
 
     m_vao.bind();
     // glDrawElements会根据ebo中的6个索引去vbo中找顶点位置
@@ -6,6 +6,10 @@
 #include <QOpenGLBuffer>
 #include <QOpenGLVertexArrayObject>
 #include <QOpenGLShaderProgram>
+#include <QVector4D>
+
+#include "damagetracker.h"
+#include "framehud.h"
 
 namespace Ui {
 class Widget;
@@ -19,11 +23,19 @@ public:
     explicit Widget(QWidget *parent = nullptr);
     ~Widget();
 
+    // 连续重绘模式（每帧都update），默认为按需重绘，需要在show之前调用
+    void setContinuous(bool continuous);
+    const DamageTracker& damageTracker() const { return m_damage; }
+
 protected:
     virtual void initializeGL() override;
     virtual void resizeGL(int w, int h) override;
     virtual void paintGL() override;
 
+private:
+    // 根据当前时间计算颜色，颜色变化时才重绘
+    void updateColor();
+
 private:
     Ui::Widget *ui;
 
@@ -36,6 +48,13 @@ private:
 
     // 着色器程序：编译链接着色器
     QOpenGLShaderProgram m_shaderProgram;
+
+    // 按需重绘：颜色每秒才变化一次，只在颜色变化（或者窗口大小变化）时重绘
+    DamageTracker m_damage {this};
+    QVector4D m_color;
+
+    // 帧统计HUD：FRAME_HUD=1时显示，默认关闭
+    FrameHud m_hud;
 };
 
 #endif // WIDGET_H
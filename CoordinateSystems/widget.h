@@ -8,6 +8,9 @@
 #include <QOpenGLShaderProgram>
 #include <QOpenGLTexture>
 
+#include "textureloader.h"
+#include "framehud.h"
+
 namespace Ui {
 class Widget;
 }
@@ -46,6 +49,12 @@ private:
     int m_modelMatrix = 0;
     int m_viewMatrix = 0;
     int m_projectionMatrix = 0;
+
+    // 纹理异步加载：图片在线程池中解码，解码完成前使用占位纹理
+    TextureLoader m_textureLoader;
+
+    // 帧统计HUD：FRAME_HUD=1时显示，默认关闭
+    FrameHud m_hud;
 };
 
 #endif // WIDGET_H
@@ -1,4 +1,5 @@
 #include "widget.h"
+#include "framebench.h"
 
 #include <QApplication>
 
@@ -11,6 +12,11 @@ int main(int argc, char *argv[])
 
     QApplication a(argc, argv);
     Widget w;
+    // --frame-bench N：不显示窗口，离屏渲染N帧，输出cpu/gpu帧时间统计后退出（见common/framebench.h）
+    const FrameBench::Options bench = FrameBench::parse(a.arguments());
+    if (bench.frames > 0) {
+        return FrameBench::run(&w, bench);
+    }
     w.show();
     return a.exec();
 }
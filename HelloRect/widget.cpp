@@ -1,5 +1,7 @@
 #include "widget.h"
 #include "ui_widget.h"
+#include "asynclog.h"
+#include "shaderlink.h"
 
 #include <QDebug>
 
@@ -42,6 +44,7 @@ Widget::~Widget()
 {
     makeCurrent();
     m_vbo.destroy();
+    m_hud.destroy();
     doneCurrent();
 
     delete ui;
@@ -52,6 +55,7 @@ void Widget::initializeGL()
     qDebug() << "format:" << context()->format();
 
     initializeOpenGLFunctions();
+    m_hud.initialize(this);
     // 黑色背景
     glClearColor(0.0f, 1.0f, 0.0f, 1.0f);
 
@@ -73,9 +77,7 @@ void Widget::initializeGL()
     m_ebo.allocate(indices, sizeof(indices));
 
     // 编译着色器
-    m_shaderProgram.addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShaderSource);
-    m_shaderProgram.addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShaderSource);
-    m_shaderProgram.link();
+    buildCachedProgram(m_shaderProgram, vertexShaderSource, fragmentShaderSource, "HelloRect");
 
 
     // 指定顶点坐标在vbo中的访问方式
@@ -94,6 +96,9 @@ void Widget::resizeGL(int w, int h)
 
 void Widget::paintGL()
 {
+    // 统计这一帧的cpu/gpu耗时，作用域结束（包括提前return）时绘制HUD
+    FrameHud::Frame hudFrame(m_hud);
+
     // 我们这里只有一个shaderProgram和vao，其实没有必要重复bind和release
     // 这里只是为了教学，在多个shaderProgram的情况下，这是标准操作
     m_shaderProgram.bind();
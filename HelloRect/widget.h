@@ -7,6 +7,8 @@
 #include <QOpenGLVertexArrayObject>
 #include <QOpenGLShaderProgram>
 
+#include "framehud.h"
+
 namespace Ui {
 class Widget;
 }
@@ -36,6 +38,9 @@ private:
 
     // 着色器程序：编译链接着色器
     QOpenGLShaderProgram m_shaderProgram;
+
+    // 帧统计HUD：FRAME_HUD=1时显示，默认关闭
+    FrameHud m_hud;
 };
 
 #endif // WIDGET_H
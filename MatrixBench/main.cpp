@@ -0,0 +1,268 @@
+#include "simdmath.h"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <QDebug>
+#include <QMatrix4x4>
+#include <QElapsedTimer>
+#include <QCoreApplication>
+
+/*
+ * SimdMath的正确性测试和microbenchmark（不需要opengl环境）
+ * 1. 和QMatrix4x4的translate()+rotate()对比，每个元素的误差不超过容差，平移部分必须逐位相同
+ * 2. 很大的角度（RotateCamera中100万个立方体时角度可达2e7度）和双精度的参考结果对比
+ * 3. 对比QMatrix4x4和各个实现批量计算模型矩阵的耗时，以及4x4矩阵乘法的耗时
+ * 有不一致时返回1，可以直接在ci中运行
+*/
+
+namespace {
+
+// RotateCamera中立方体的旋转轴，归一化在编译期完成
+constexpr RotationAxis kCubeAxis(1.0f, 0.3f, 0.5f);
+
+// 旋转部分的元素都在[-1, 1]内，容差约为1.0附近的32个ulp
+const float kTolerance = 32 * 1.1920929e-7f;
+
+struct Scene
+{
+    std::vector<float> translations;
+    std::vector<float> angles;
+};
+
+Scene makeScene(int count, float minAngle, float maxAngle)
+{
+    Scene scene;
+    std::mt19937 rng(20201010);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> angle(minAngle, maxAngle);
+    for (int i = 0; i < count; i++) {
+        scene.translations.push_back(position(rng));
+        scene.translations.push_back(position(rng));
+        scene.translations.push_back(position(rng));
+        scene.angles.push_back(angle(rng));
+    }
+    return scene;
+}
+
+void qtModelMatrices(const Scene& scene, float angleOffset, float* out)
+{
+    const int count = int(scene.angles.size());
+    for (int i = 0; i < count; i++) {
+        QMatrix4x4 model;
+        model.translate(scene.translations[i * 3], scene.translations[i * 3 + 1], scene.translations[i * 3 + 2]);
+        model.rotate(scene.angles[i] + angleOffset, 1.0f, 0.3f, 0.5f);
+        memcpy(out + i * 16, model.constData(), 16 * sizeof(float));
+    }
+}
+
+// 双精度的参考结果
+void referenceModelMatrices(const Scene& scene, float* out)
+{
+    const double length = std::sqrt(1.0 + 0.3 * 0.3 + 0.5 * 0.5);
+    const double x = 1.0 / length, y = 0.3 / length, z = 0.5 / length;
+    const int count = int(scene.angles.size());
+    for (int i = 0; i < count; i++) {
+        const double radians = std::fmod(double(scene.angles[i]), 360.0) * 3.14159265358979323846 / 180.0;
+        const double c = std::cos(radians), s = std::sin(radians), t = 1.0 - c;
+        const double m[16] = {
+            t * x * x + c,     t * x * y + s * z, t * x * z - s * y, 0.0,
+            t * x * y - s * z, t * y * y + c,     t * y * z + s * x, 0.0,
+            t * x * z + s * y, t * y * z - s * x, t * z * z + c,     0.0,
+            scene.translations[i * 3], scene.translations[i * 3 + 1], scene.translations[i * 3 + 2], 1.0
+        };
+        for (int e = 0; e < 16; e++) {
+            out[i * 16 + e] = float(m[e]);
+        }
+    }
+}
+
+// 返回是否在容差内，maxError输出最大误差
+bool compare(const float* expected, const float* actual, int count, float& maxError)
+{
+    bool ok = true;
+    maxError = 0.0f;
+    for (int i = 0; i < count; i++) {
+        for (int e = 0; e < 16; e++) {
+            const float a = expected[i * 16 + e];
+            const float b = actual[i * 16 + e];
+            if (e >= 12) {
+                // 平移部分只是复制，必须逐位相同
+                ok = ok && memcmp(&a, &b, sizeof(float)) == 0;
+                continue;
+            }
+            const float error = std::fabs(a - b);
+            maxError = qMax(maxError, error);
+            ok = ok && error <= kTolerance;
+        }
+    }
+    return ok;
+}
+
+bool verify()
+{
+    const SimdMath::Backend backends[] = {SimdMath::Scalar, SimdMath::SSE2, SimdMath::AVX2};
+    // 数量不是8的倍数，覆盖SIMD最后补齐的一组
+    const int count = 10007;
+    bool ok = true;
+
+    // QMatrix4x4先把角度转换为float弧度，角度很大时本身误差就很大，这里只比较常见的角度范围
+    const Scene scene = makeScene(count, -720.0f, 720.0f);
+    std::vector<float> expected(count * 16);
+    qtModelMatrices(scene, 0.0f, expected.data());
+
+    // 很大的角度和双精度参考结果比较
+    const Scene largeScene = makeScene(count, -2.0e7f, 2.0e7f);
+    std::vector<float> reference(count * 16);
+    referenceModelMatrices(largeScene, reference.data());
+
+    std::vector<float> actual(count * 16);
+    for (SimdMath::Backend backend : backends) {
+        if (backend > SimdMath::bestBackend()) {
+            qDebug() << SimdMath::backendName(backend) << "not supported, skipped";
+            continue;
+        }
+        SimdMath::setBackend(backend);
+
+        float maxError = 0.0f;
+        SimdMath::translateRotate(scene.translations.data(), scene.angles.data(), 0.0f, nullptr, count, kCubeAxis, actual.data());
+        const bool qtOk = compare(expected.data(), actual.data(), count, maxError);
+        qDebug() << SimdMath::backendName(backend) << "vs QMatrix4x4 max error:" << maxError << (qtOk ? "ok" : "MISMATCH");
+
+        SimdMath::translateRotate(largeScene.translations.data(), largeScene.angles.data(), 0.0f, nullptr, count, kCubeAxis, actual.data());
+        const bool referenceOk = compare(reference.data(), actual.data(), count, maxError);
+        qDebug() << SimdMath::backendName(backend) << "large angles vs double max error:" << maxError << (referenceOk ? "ok" : "MISMATCH");
+
+        // 按索引计算（视锥体剔除后的可见物体）和直接计算的结果一致
+        std::vector<int> indices;
+        for (int i = count - 1; i >= 0; i -= 3) {
+            indices.push_back(i);
+        }
+        std::vector<float> indexed(indices.size() * 16);
+        SimdMath::translateRotate(scene.translations.data(), scene.angles.data(), 0.0f, indices.data(), int(indices.size()), kCubeAxis, indexed.data());
+        SimdMath::translateRotate(scene.translations.data(), scene.angles.data(), 0.0f, nullptr, count, kCubeAxis, actual.data());
+        bool indexedOk = true;
+        for (size_t n = 0; n < indices.size(); n++) {
+            indexedOk = indexedOk && memcmp(&indexed[n * 16], &actual[indices[n] * 16], 16 * sizeof(float)) == 0;
+        }
+        qDebug() << SimdMath::backendName(backend) << "indexed batch:" << (indexedOk ? "ok" : "MISMATCH");
+
+        ok = ok && qtOk && referenceOk && indexedOk;
+    }
+
+    // 矩阵乘法和QMatrix4x4::operator*对比
+    Mat4 a, b;
+    memcpy(a.m, expected.data(), sizeof(a.m));
+    memcpy(b.m, expected.data() + 16, sizeof(b.m));
+    const Mat4 product = SimdMath::multiply(a, b);
+    const QMatrix4x4 qtProduct = QMatrix4x4(expected.data()).transposed() * QMatrix4x4(expected.data() + 16).transposed();
+    float maxError = 0.0f;
+    for (int e = 0; e < 16; e++) {
+        maxError = qMax(maxError, std::fabs(product.m[e] - qtProduct.constData()[e]));
+    }
+    // 乘积中包含平移，数值比旋转部分大，容差按数值大小放大
+    const bool multiplyOk = maxError <= kTolerance * 256;
+    qDebug() << "multiply vs QMatrix4x4 max error:" << maxError << (multiplyOk ? "ok" : "MISMATCH");
+
+    return ok && multiplyOk;
+}
+
+void bench()
+{
+    const int counts[] = {1000, 100000};
+    // 每种数量总共计算约1000万个矩阵
+    const int totalMatrices = 10000000;
+
+    for (int count : counts) {
+        const Scene scene = makeScene(count, 0.0f, 360.0f);
+        std::vector<float> out(count * 16);
+        const int rounds = totalMatrices / count;
+
+        // 每一轮角度都变化，和RotateCamera每帧的情况一样
+        QElapsedTimer timer;
+        timer.start();
+        for (int r = 0; r < rounds; r++) {
+            qtModelMatrices(scene, float(r), out.data());
+        }
+        const double qtNs = double(timer.nsecsElapsed()) / (double(rounds) * count);
+        qDebug() << "matrices:" << count << "QMatrix4x4 translate+rotate:" << qtNs << "ns/matrix";
+
+        const SimdMath::Backend backends[] = {SimdMath::Scalar, SimdMath::SSE2, SimdMath::AVX2};
+        for (SimdMath::Backend backend : backends) {
+            if (backend > SimdMath::bestBackend()) {
+                continue;
+            }
+            SimdMath::setBackend(backend);
+            timer.restart();
+            for (int r = 0; r < rounds; r++) {
+                SimdMath::translateRotate(scene.translations.data(), scene.angles.data(), float(r), nullptr, count, kCubeAxis, out.data());
+            }
+            const double ns = double(timer.nsecsElapsed()) / (double(rounds) * count);
+            qDebug() << "matrices:" << count << "SimdMath" << SimdMath::backendName(backend) << ":" << ns << "ns/matrix"
+                     << "speedup:" << qtNs / ns;
+        }
+    }
+
+    // 4x4矩阵乘法：观察矩阵乘以每个物体的模型矩阵
+    const int count = 1000;
+    const int rounds = 10000;
+    const Scene scene = makeScene(count, 0.0f, 360.0f);
+    std::vector<float> models(count * 16);
+    qtModelMatrices(scene, 0.0f, models.data());
+
+    QMatrix4x4 qtView;
+    qtView.lookAt(QVector3D(3.0f, 0.0f, 10.0f), QVector3D(0.0f, 0.0f, 0.0f), QVector3D(0.0f, 1.0f, 0.0f));
+    QVector<QMatrix4x4> qtModels;
+    for (int i = 0; i < count; i++) {
+        qtModels.append(QMatrix4x4(models.data() + i * 16).transposed());
+    }
+    std::vector<Mat4> simdModels(count);
+    memcpy(simdModels.data(), models.data(), models.size() * sizeof(float));
+    Mat4 view;
+    memcpy(view.m, qtView.constData(), sizeof(view.m));
+
+    // 累加结果的一个元素，避免乘法被编译器优化掉
+    float qtChecksum = 0.0f;
+    QElapsedTimer timer;
+    timer.start();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < count; i++) {
+            qtChecksum += (qtView * qtModels[i])(0, 3);
+        }
+    }
+    const double qtNs = double(timer.nsecsElapsed()) / (double(rounds) * count);
+
+    float checksum = 0.0f;
+    timer.restart();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < count; i++) {
+            checksum += SimdMath::multiply(view, simdModels[i]).m[12];
+        }
+    }
+    const double ns = double(timer.nsecsElapsed()) / (double(rounds) * count);
+    qDebug() << "mat4 multiply QMatrix4x4:" << qtNs << "ns SimdMath:" << ns << "ns speedup:" << qtNs / ns
+             << "(checksum" << qtChecksum << checksum << ")";
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    // --verify：只做正确性测试
+    const bool verifyOnly = a.arguments().contains("--verify");
+
+    qDebug() << "best backend:" << SimdMath::backendName(SimdMath::bestBackend());
+    const bool ok = verify();
+    if (!ok) {
+        qDebug() << "SimdMath results don't match QMatrix4x4";
+        return 1;
+    }
+
+    if (!verifyOnly) {
+        bench();
+    }
+    return 0;
+}
@@ -1,5 +1,8 @@
 #include "widget.h"
 #include "ui_widget.h"
+#include "asynclog.h"
+#include "shaderlink.h"
+#include "shaderdefines.h"
 
 #include <QDebug>
 #include <QImage>
@@ -38,6 +41,9 @@ const char* vertexShaderSource = R"(#version 330 core
                                  TexCoord = vec2(aTexCoord.x, 1.0 - aTexCoord.y);
                                  })";
 
+// 第二张图片的混合比例，以MIX_FACTOR注入片段着色器
+const double mixFactor = 0.2;
+
 const char* fragmentShaderSource = R"(#version 330 core
                                    out vec4 FragColor;
 
@@ -50,7 +56,7 @@ const char* fragmentShaderSource = R"(#version 330 core
                                    void main()
                                    {
                                    // 混合纹理坐标/纹理数据/颜色
-                                   FragColor = mix(texture(texture1, TexCoord), texture(texture2, TexCoord), 0.2);
+                                   FragColor = mix(texture(texture1, TexCoord), texture(texture2, TexCoord), MIX_FACTOR);
                                    } )";
 
 Widget::Widget(QWidget *parent) :
@@ -58,12 +64,16 @@ Widget::Widget(QWidget *parent) :
     ui(new Ui::Widget)
 {
     ui->setupUi(this);
+
+    // 图片解码完成后重绘，paintGL中上传到纹理
+    connect(&m_textureLoader, &TextureLoader::textureDecoded, this, QOverload<>::of(&Widget::update));
 }
 
 Widget::~Widget()
 {
     makeCurrent();
     m_vbo.destroy();
+    m_hud.destroy();
     doneCurrent();
 
     delete ui;
@@ -74,6 +84,7 @@ void Widget::initializeGL()
     qDebug() << "format:" << context()->format();
 
     initializeOpenGLFunctions();
+    m_hud.initialize(this);
     // 黑色背景
     glClearColor(0.0f, 1.0f, 0.0f, 1.0f);
 
@@ -95,9 +106,8 @@ void Widget::initializeGL()
     m_ebo.allocate(indices, sizeof(indices));
 
     // 编译着色器
-    m_shaderProgram.addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShaderSource);
-    m_shaderProgram.addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShaderSource);
-    m_shaderProgram.link();
+    const QString fragmentShader = QString::fromStdString(ShaderDefines().set("MIX_FACTOR", mixFactor).inject(fragmentShaderSource));
+    buildCachedProgram(m_shaderProgram, vertexShaderSource, fragmentShader, "MultiTexture");
     m_shaderProgram.bind();
 
     // 指定顶点坐标在vbo中的访问方式
@@ -125,7 +135,7 @@ void Widget::initializeGL()
     // 设置纹理缩放时的策略
     m_texture.setMinificationFilter(QOpenGLTexture::Linear);
     m_texture.setMagnificationFilter(QOpenGLTexture::Linear);
-    m_texture.setData(QImage(":/wall.jpg"));
+    m_textureLoader.load(m_texture, ":/wall.jpg");
 
     // 设置st方向上纹理超出坐标时的显示策略
     m_texture2.setWrapMode(QOpenGLTexture::DirectionS, QOpenGLTexture::ClampToEdge);
@@ -133,13 +143,13 @@ void Widget::initializeGL()
     // 设置纹理缩放时的策略
     m_texture2.setMinificationFilter(QOpenGLTexture::Linear);
     m_texture2.setMagnificationFilter(QOpenGLTexture::Linear);
-    m_texture2.setData(QImage(":/face.png"));
+    m_textureLoader.load(m_texture2, ":/face.png");
 
     // 图片是rgba8888格式，注意这里的参数GL_RGBA8/GL_RGBA
     //glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, wall.width(), wall.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, wall.bits());
 
     m_vao.release();
-    qDebug() << m_shaderProgram.log();
+    ALOG("{}", m_shaderProgram.log());
 }
 
 void Widget::resizeGL(int w, int h)
@@ -150,6 +160,12 @@ void Widget::resizeGL(int w, int h)
 
 void Widget::paintGL()
 {
+    // 统计这一帧的cpu/gpu耗时，作用域结束（包括提前return）时绘制HUD
+    FrameHud::Frame hudFrame(m_hud);
+
+    // 上传已经解码好的图片（在绑定纹理之前）
+    m_textureLoader.uploadReady();
+
     // 激活纹理单元0
     glActiveTexture(GL_TEXTURE0);
     // 绑定纹理到纹理单元0
@@ -165,4 +181,6 @@ void Widget::paintGL()
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
     m_vao.release();
     m_shaderProgram.release();
+
+    m_textureLoader.frameDone();
 }
@@ -9,10 +9,16 @@ CONFIG += c++11
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    latencyprobe.cpp \
     main.cpp \
+    offscreenscene.cpp \
+    renderthread.cpp \
     widget.cpp
 
 HEADERS += \
+    latencyprobe.h \
+    offscreenscene.h \
+    renderthread.h \
     widget.h
 
 FORMS += \
@@ -25,3 +31,12 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 
 RESOURCES += \
     res.qrc
+
+include(../common/asyncreadback.pri)
+include(../common/asynclog.pri)
+include(../common/textureloader.pri)
+include(../common/shadervariantcache.pri)
+include(../common/framebench.pri)
+include(../common/gpuprofiler.pri)
+include(../common/trace.pri)
+include(../common/framehud.pri)
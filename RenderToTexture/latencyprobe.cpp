@@ -0,0 +1,67 @@
+#include "latencyprobe.h"
+
+#include <algorithm>
+
+namespace {
+
+const int kIntervalMs = 5;
+
+}
+
+LatencyProbe::LatencyProbe(QObject *parent)
+    : QObject(parent)
+{
+    // PreciseTimer：毫秒精度，避免CoarseTimer本身5%的误差混进统计
+    m_timer.setTimerType(Qt::PreciseTimer);
+    m_timer.setInterval(kIntervalMs);
+    connect(&m_timer, &QTimer::timeout, this, &LatencyProbe::onTimeout);
+}
+
+void LatencyProbe::start()
+{
+    m_samples.clear();
+    m_clock.start();
+    m_lastNs = 0;
+    m_timer.start();
+}
+
+void LatencyProbe::stop()
+{
+    m_timer.stop();
+}
+
+QString LatencyProbe::report() const
+{
+    if (m_samples.isEmpty()) {
+        return QString("event loop latency: no samples");
+    }
+
+    QVector<qint64> sorted = m_samples;
+    std::sort(sorted.begin(), sorted.end());
+    qint64 sum = 0;
+    int over16ms = 0;
+    for (qint64 sample : sorted) {
+        sum += sample;
+        if (sample > 16000) {
+            over16ms++;
+        }
+    }
+    const int p99Index = qMin(sorted.size() - 1, sorted.size() * 99 / 100);
+    return QString("event loop latency avg %1 ms p99 %2 ms max %3 ms, >16ms %4 of %5 samples")
+            .arg(double(sum) / sorted.size() / 1000.0, 0, 'f', 2)
+            .arg(sorted[p99Index] / 1000.0, 0, 'f', 2)
+            .arg(sorted.last() / 1000.0, 0, 'f', 2)
+            .arg(over16ms)
+            .arg(sorted.size());
+}
+
+void LatencyProbe::onTimeout()
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    // 比预期的触发时间晚了多少，提前触发的按0计算
+    const qint64 late = qMax<qint64>(0, now - m_lastNs - kIntervalMs * 1000000LL);
+    if (m_lastNs > 0) {
+        m_samples.append(late / 1000);
+    }
+    m_lastNs = now;
+}
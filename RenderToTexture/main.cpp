@@ -1,5 +1,10 @@
 #include "widget.h"
+#include "framebench.h"
+#include "latencyprobe.h"
+#include "trace.h"
 
+#include <QDebug>
+#include <QTimer>
 #include <QApplication>
 
 int main(int argc, char *argv[])
@@ -10,7 +15,52 @@ int main(int argc, char *argv[])
     QSurfaceFormat::setDefaultFormat(format);
 
     QApplication a(argc, argv);
+    // GL_TRACE=trace.json：输出cpu/gpu时间线（见common/trace.h）
+    Trace::setThreadName("gui");
     Widget w;
+    // 命令行参数：
+    // --render-thread：离屏渲染和readpix放到独立的渲染线程中
+    // --heavy N：合成的重负载场景，离屏渲染时重复绘制N次，并连续绘制
+    // --sync-readback：使用同步的toImage读取离屏数据
+    // --duration S：运行S秒后输出gui线程事件循环的延迟统计并退出，用于对比单线程和渲染线程模式，
+    //   例如 --heavy 200 --sync-readback --duration 10 和 --heavy 200 --sync-readback --render-thread --duration 10
+    // --effect none|invert|grayscale|blur：上屏时的特效，运行时按E键切换
+    // --gpu-profile：每秒输出离屏、读取、上屏各个pass的gpu耗时和着色器调用次数
+    const QStringList args = a.arguments();
+    w.setGpuProfile(args.contains("--gpu-profile"));
+    w.setRenderThread(args.contains("--render-thread"));
+    int index = args.indexOf("--heavy");
+    if (index >= 0) {
+        w.setDrawCount(args.value(index + 1).toInt());
+    }
+    w.setAsyncReadback(!args.contains("--sync-readback"));
+    index = args.indexOf("--effect");
+    if (index >= 0) {
+        bool ok = false;
+        w.setEffect(PostEffect::fromName(args.value(index + 1).toStdString(), &ok));
+        if (!ok) {
+            qDebug() << "unknown effect:" << args.value(index + 1);
+        }
+    }
+
+    // --frame-bench N：不显示窗口，离屏渲染N帧，输出cpu/gpu帧时间统计后退出（见common/framebench.h）
+    const FrameBench::Options bench = FrameBench::parse(a.arguments());
+    if (bench.frames > 0) {
+        return FrameBench::run(&w, bench);
+    }
+
+    LatencyProbe probe;
+    index = args.indexOf("--duration");
+    if (index >= 0) {
+        w.setContinuous(true);
+        probe.start();
+        QTimer::singleShot(args.value(index + 1).toInt() * 1000, &a, [&]() {
+            probe.stop();
+            qDebug() << (args.contains("--render-thread") ? "render thread:" : "single thread:")
+                     << qPrintable(probe.report());
+            a.quit();
+        });
+    }
     w.show();
     return a.exec();
 }
@@ -0,0 +1,224 @@
+#include "offscreenscene.h"
+
+#include <QDebug>
+#include <QImageReader>
+
+namespace {
+
+float vertices[] = {
+    //     ---- 位置 ----       ---- 颜色 ----     - 纹理坐标 -
+    1.0f,  1.0f, 0.0f,   1.0f, 0.0f, 0.0f,   1.0f, 1.0f,   // 右上
+    1.0f, -1.0f, 0.0f,   0.0f, 1.0f, 0.0f,   1.0f, 0.0f,   // 右下
+    -1.0f, -1.0f, 0.0f,  0.0f, 0.0f, 1.0f,   0.0f, 0.0f,   // 左下
+    -1.0f,  1.0f, 0.0f,  1.0f, 1.0f, 0.0f,   0.0f, 1.0f    // 左上
+};
+
+// 第二张图片的混合比例
+const double mixFactor = 0.2;
+
+unsigned int indices[] = { // 注意索引从0开始!
+                           0, 1, 3, // 第一个三角形
+                           1, 2, 3  // 第二个三角形
+                         };
+
+const char* vertexShaderSource = R"(#version 330 core
+                                 layout (location = 0) in vec3 aPos; // 来自cpu的顶点坐标
+                                 layout (location = 1) in vec3 aColor; // 来自cpu的颜色数据
+                                 layout (location = 2) in vec2 aTexCoord; // 来自cpu的纹理坐标
+
+                                 // 颜色和纹理坐标用于输出到片段着色器
+                                 out vec3 ourColor;
+                                 out vec2 TexCoord;
+
+                                 void main()
+                                 {
+                                 gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);
+                                 ourColor = aColor;
+                                 // 片段着色器采样图片是从下向上采样，所以图像是倒的，这里反转一个y
+                                 TexCoord = vec2(aTexCoord.x, 1.0 - aTexCoord.y);
+                                 })";
+
+const char* fragmentShaderSource = R"(#version 330 core
+                                   out vec4 FragColor;
+
+                                   in vec3 ourColor;
+                                   in vec2 TexCoord;
+
+                                   uniform sampler2D texture1;
+                                   uniform sampler2D texture2;
+
+                                   void main()
+                                   {
+                                   // 混合纹理坐标/纹理数据
+                                   FragColor = mix(texture(texture1, TexCoord), texture(texture2, TexCoord), MIX_FACTOR);
+                                   } )";
+
+}
+
+ShaderDefines OffscreenScene::programDefines()
+{
+    return ShaderDefines().set("MIX_FACTOR", mixFactor);
+}
+
+OffscreenScene::OffscreenScene()
+{
+}
+
+OffscreenScene::~OffscreenScene()
+{
+}
+
+void OffscreenScene::setShaderCompiler(ShaderCompiler *compiler)
+{
+    m_compiler = compiler;
+}
+
+bool OffscreenScene::initialize()
+{
+    initializeOpenGLFunctions();
+
+    // 只读取图片头部得到大小，图片在线程池中解码
+    QImageReader bg(":/bg.jpeg");
+    m_size = bg.size();
+    if (!m_size.isValid()) {
+        qDebug() << "Can't load background image." << bg.errorString();
+        return false;
+    }
+
+    // vao初始化
+    m_vao.create();
+    // 绑定vao，下面对vbo/ebo的操作都保存到了vao上，下次绘制该物体直接m_vao.bind()即可，不用重复vbo/ebo的bind/allocate操作
+    // vao也会保存ebo
+    m_vao.bind();
+
+    // vbo初始化
+    m_vbo.create();
+    m_vbo.bind();
+    m_vbo.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    m_vbo.allocate(vertices, sizeof(vertices));
+
+    // ebo初始化
+    m_ebo.create();
+    m_ebo.bind();
+    m_ebo.allocate(indices, sizeof(indices));
+
+    // 编译着色器，常量以#define注入（见shadervariantcache.h）
+    // 设置了ShaderCompiler时这里只提交编译，第一次render()时才等待编译完成
+    m_programs.setSources(vertexShaderSource, fragmentShaderSource);
+    m_programs.setCompiler(m_compiler);
+    m_programs.request(programDefines());
+
+    // 指定顶点坐标在vbo中的访问方式，和program无关，不需要等待编译完成
+    // 参数解释：顶点坐标在shader中的参数location，顶点坐标类型为vec3，顶点坐标为float，步幅为8个float，起始偏移为0字节
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), reinterpret_cast<void*>(0 * sizeof(float)));
+    // 启用顶点属性
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), reinterpret_cast<void*>(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), reinterpret_cast<void*>(6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+
+    // 设置纹理
+    // 设置st方向上纹理超出坐标时的显示策略
+    m_texture.setWrapMode(QOpenGLTexture::DirectionS, QOpenGLTexture::ClampToEdge);
+    m_texture.setWrapMode(QOpenGLTexture::DirectionT, QOpenGLTexture::ClampToEdge);
+    // 设置纹理缩放时的策略
+    m_texture.setMinificationFilter(QOpenGLTexture::Linear);
+    m_texture.setMagnificationFilter(QOpenGLTexture::Linear);
+    m_textureLoader.load(m_texture, ":/bg.jpeg");
+
+    // 设置st方向上纹理超出坐标时的显示策略
+    m_texture2.setWrapMode(QOpenGLTexture::DirectionS, QOpenGLTexture::ClampToEdge);
+    m_texture2.setWrapMode(QOpenGLTexture::DirectionT, QOpenGLTexture::ClampToEdge);
+    // 设置纹理缩放时的策略
+    m_texture2.setMinificationFilter(QOpenGLTexture::Linear);
+    m_texture2.setMagnificationFilter(QOpenGLTexture::Linear);
+    m_textureLoader.load(m_texture2, ":/gyy.jpeg");
+
+    // 图片是rgba8888格式，注意这里的参数GL_RGBA8/GL_RGBA
+    //glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, wall.width(), wall.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, wall.bits());
+
+    m_vao.release();
+    return true;
+}
+
+void OffscreenScene::destroy()
+{
+    m_vbo.destroy();
+    m_ebo.destroy();
+    m_vao.destroy();
+
+    m_texture.destroy();
+    m_texture2.destroy();
+
+    m_programs.clear();
+    m_shaderProgram = nullptr;
+}
+
+QSize OffscreenScene::size() const
+{
+    return m_size;
+}
+
+void OffscreenScene::setDrawCount(int count)
+{
+    m_drawCount = qMax(count, 1);
+}
+
+int OffscreenScene::drawCount() const
+{
+    return m_drawCount;
+}
+
+TextureLoader &OffscreenScene::textureLoader()
+{
+    return m_textureLoader;
+}
+
+void OffscreenScene::render()
+{
+    // 上传已经解码好的图片（在绑定纹理之前）
+    m_textureLoader.uploadReady();
+
+    // viewport设置为离屏texture大小，
+    glViewport(0, 0, m_size.width(), m_size.height());
+    // 清理背景
+    glClearColor(0.0f, 0.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // 激活纹理单元0
+    glActiveTexture(GL_TEXTURE0);
+    // 绑定纹理到纹理单元0
+    m_texture.bind();
+    glActiveTexture(GL_TEXTURE1);
+    m_texture2.bind();
+
+    if (!m_shaderProgram) {
+        // 第一次使用，异步编译还没有完成时在这里等待
+        m_shaderProgram = m_programs.program(programDefines());
+        if (!m_shaderProgram) {
+            m_textureLoader.frameDone();
+            return;
+        }
+        m_shaderProgram->bind();
+        // 关联片段着色器中的纹理单元和opengl中的纹理单元（opengl一般提供16个纹理单元）
+        // 告诉片段着色器，纹理texture1属于纹理单元0
+        m_shaderProgram->setUniformValue("texture1", 0);
+        // 告诉片段着色器，纹理texture2属于纹理单元1
+        m_shaderProgram->setUniformValue("texture2", 1);
+    }
+
+    m_shaderProgram->bind();
+    m_vao.bind();
+    // glDrawElements会根据ebo中的6个索引去vbo中找顶点位置
+    // 重负载场景下重复绘制同样的内容，结果不变，只是gpu的工作量成倍增加
+    for (int i = 0; i < m_drawCount; i++) {
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    }
+    m_vao.release();
+    m_shaderProgram->release();
+
+    m_textureLoader.frameDone();
+}
@@ -0,0 +1,72 @@
+#ifndef OFFSCREENSCENE_H
+#define OFFSCREENSCENE_H
+
+#include <QSize>
+#include <QOpenGLFunctions>
+#include <QOpenGLBuffer>
+#include <QOpenGLVertexArrayObject>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLTexture>
+
+#include "textureloader.h"
+#include "shadervariantcache.h"
+#include "shadercompiler.h"
+
+/*
+ * 离屏渲染的场景：两张图片混合后渲染到当前绑定的fbo中，fbo大小为大图片的大小
+ * gui线程渲染（Widget::paintGL）和渲染线程（RenderThread）共用这部分代码
+ *
+ * 所有接口都需要在创建它的context current的情况下调用
+*/
+class OffscreenScene : protected QOpenGLFunctions
+{
+public:
+    OffscreenScene();
+    ~OffscreenScene();
+
+    // initialize()之前设置，着色器交给compiler异步编译，不设置时在initialize()中直接编译
+    void setShaderCompiler(ShaderCompiler* compiler);
+
+    // 加载图片，创建vao/vbo/ebo/着色器/纹理
+    bool initialize();
+    void destroy();
+
+    // 离屏纹理大小（大图片的大小）
+    QSize size() const;
+
+    // 合成的重负载场景：每帧把两张图片重复混合绘制count次，用于模拟很重的渲染，默认1次
+    void setDrawCount(int count);
+    int drawCount() const;
+
+    // 渲染到当前绑定的fbo，会设置viewport并清理背景
+    // 图片在线程池中解码，解码完成前的几帧使用占位纹理
+    void render();
+
+    // 图片解码完成时发出textureDecoded()，gui线程渲染时连接到update
+    TextureLoader& textureLoader();
+
+private:
+    static ShaderDefines programDefines();
+
+private:
+    //顶点数组对象(Vertex Array Object，VAO)，用来缓存顶点缓冲对象的操作（例如setAttributeBuffer）
+    QOpenGLVertexArrayObject m_vao;
+    // 顶点缓冲对象(Vertex Buffer Objects, VBO)，用来缓存顶点坐标
+    QOpenGLBuffer m_vbo; // 默认即为VertexBuffer(GL_ARRAY_BUFFER)类型
+    // 索引缓冲对象(Element Buffer Object，EBO或Index Buffer Object，IBO)，用来缓存顶点坐标的索引
+    QOpenGLBuffer m_ebo {QOpenGLBuffer::IndexBuffer};
+    // 着色器程序：混合比例MIX_FACTOR以#define注入，program由m_programs持有
+    ShaderVariantCache m_programs;
+    QOpenGLShaderProgram* m_shaderProgram = nullptr;
+    ShaderCompiler* m_compiler = nullptr;
+    // 纹理
+    QOpenGLTexture m_texture {QOpenGLTexture::Target2D};
+    QOpenGLTexture m_texture2 {QOpenGLTexture::Target2D};
+
+    QSize m_size;
+    int m_drawCount = 1;
+
+    TextureLoader m_textureLoader;
+};
+
+#endif // OFFSCREENSCENE_H
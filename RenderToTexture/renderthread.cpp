@@ -0,0 +1,277 @@
+#include "renderthread.h"
+#include "offscreenscene.h"
+#include "asyncreadback.h"
+#include "asynclog.h"
+#include "tracegpu.h"
+
+#include <utility>
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QCoreApplication>
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
+#include <QOpenGLFramebufferObject>
+
+RenderThread::RenderThread(QOpenGLContext *shareContext, QObject *parent)
+    : QThread(parent)
+{
+    // context在gui线程中创建，再移动到渲染线程中使用
+    m_context = new QOpenGLContext;
+    m_context->setFormat(shareContext->format());
+    m_context->setShareContext(shareContext);
+    if (!m_context->create()) {
+        qFatal("render thread: create context failed");
+    }
+    m_context->moveToThread(this);
+
+    // 渲染线程不需要窗口，makeCurrent到一个离屏surface上即可
+    m_surface = new QOffscreenSurface;
+    m_surface->setFormat(m_context->format());
+    m_surface->create();
+}
+
+RenderThread::~RenderThread()
+{
+    stop();
+    wait();
+
+    delete m_context;
+    delete m_surface;
+}
+
+void RenderThread::setDrawCount(int count)
+{
+    QMutexLocker locker(&m_mutex);
+    m_drawCount = count;
+}
+
+void RenderThread::setAsyncReadback(bool async)
+{
+    QMutexLocker locker(&m_mutex);
+    m_asyncReadback = async;
+}
+
+void RenderThread::stop()
+{
+    QMutexLocker locker(&m_mutex);
+    m_stop = true;
+    m_frameTaken.wakeAll();
+}
+
+GLuint RenderThread::acquireFrame(QOpenGLExtraFunctions *f)
+{
+    GLsync rendered = 0;
+    GLuint texture = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_readyFresh) {
+            // 有新帧时和正在上屏的fbo交换，之前上屏的fbo交给渲染线程继续使用
+            std::swap(m_presentIndex, m_readyIndex);
+            m_readyFresh = false;
+            m_presented = true;
+            rendered = m_buffers[m_presentIndex].renderedFence;
+            m_buffers[m_presentIndex].renderedFence = 0;
+            m_frameTaken.wakeOne();
+        }
+        // 没有新帧时（例如窗口大小变化触发的paintGL）继续上屏上一帧
+        if (m_presented && m_buffers[m_presentIndex].fbo) {
+            texture = m_buffers[m_presentIndex].fbo->texture();
+        }
+    }
+
+    if (rendered) {
+        // gpu侧等待渲染线程的绘制完成，gui线程不阻塞
+        f->glWaitSync(rendered, 0, GL_TIMEOUT_IGNORED);
+        f->glDeleteSync(rendered);
+    }
+    return texture;
+}
+
+void RenderThread::releaseFrame(QOpenGLExtraFunctions *f)
+{
+    QMutexLocker locker(&m_mutex);
+    Buffer& buffer = m_buffers[m_presentIndex];
+    if (!m_presented || !buffer.fbo) {
+        return;
+    }
+    // 上屏的绘制命令之后插入fence，渲染线程再次渲染到这个fbo之前等待它
+    // flush保证fence已经提交，否则另一个context中的glWaitSync可能永远等不到
+    GLsync presented = f->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    f->glFlush();
+    if (buffer.presentedFence) {
+        // 同一帧上屏了多次，只需要等待最后一次
+        f->glDeleteSync(buffer.presentedFence);
+    }
+    buffer.presentedFence = presented;
+}
+
+QSize RenderThread::frameSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_frameSize;
+}
+
+QImage RenderThread::latestImage() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_latestImage;
+}
+
+void RenderThread::run()
+{
+    if (!m_context->makeCurrent(m_surface)) {
+        qDebug() << "render thread: makeCurrent failed";
+        return;
+    }
+    QOpenGLExtraFunctions* f = m_context->extraFunctions();
+    Trace::setThreadName("render thread");
+    // 渲染线程的context在时间线上单独一条gpu轨道
+    TraceGpu traceGpu;
+    traceGpu.initialize(m_context, "GPU render thread");
+
+    OffscreenScene scene;
+    if (!scene.initialize()) {
+        qDebug() << "render thread: initialize scene failed";
+        m_context->doneCurrent();
+        m_context->moveToThread(QCoreApplication::instance()->thread());
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        for (Buffer& buffer : m_buffers) {
+            // 默认创建一个GL_TEXTURE_2D的纹理附件的fbo，且纹理附件attach到GL_COLOR_ATTACHMENT0
+            buffer.fbo = new QOpenGLFramebufferObject(scene.size());
+            if (!buffer.fbo->isValid()) {
+                qFatal("fbo invalid");
+            }
+        }
+        m_frameSize = scene.size();
+    }
+
+    AsyncReadback readback;
+    readback.create(scene.size());
+    readback.setCallback([this](const QImage& image, quint64 frameId) {
+        Q_UNUSED(frameId);
+        QMutexLocker locker(&m_mutex);
+        m_latestImage = image;
+    });
+
+    QElapsedTimer logTimer;
+    logTimer.start();
+    int frames = 0;
+    qint64 renderNs = 0;
+    qint64 readbackNs = 0;
+
+    forever {
+        Buffer* buffer = nullptr;
+        GLsync presented = 0;
+        bool asyncReadback = true;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_stop) {
+                break;
+            }
+            scene.setDrawCount(m_drawCount);
+            asyncReadback = m_asyncReadback;
+            // m_renderIndex只有渲染线程自己修改，gui线程不会访问这个fbo
+            buffer = &m_buffers[m_renderIndex];
+            presented = buffer->presentedFence;
+            buffer->presentedFence = 0;
+        }
+
+        if (presented) {
+            // gpu侧等待gui线程对这个fbo的采样完成
+            f->glWaitSync(presented, 0, GL_TIMEOUT_IGNORED);
+            f->glDeleteSync(presented);
+        }
+
+        TRACE_SCOPE("render frame");
+        traceGpu.collect();
+        QElapsedTimer t;
+        t.start();
+        // fbo绑定以后，后面所有的渲染都渲染到fbo的texture附件上了
+        buffer->fbo->bind();
+        {
+            TraceGpu::Scope traceScope(traceGpu, "offscreen");
+            scene.render();
+        }
+        renderNs += t.nsecsElapsed();
+
+        // 读取离屏数据，这里的等待只阻塞渲染线程
+        t.restart();
+        if (asyncReadback) {
+            readback.poll();
+            readback.readback();
+        } else {
+            const QImage image = buffer->fbo->toImage();
+            QMutexLocker locker(&m_mutex);
+            m_latestImage = image;
+        }
+        readbackNs += t.nsecsElapsed();
+        buffer->fbo->release();
+
+        // 插入fence并flush，gui线程上屏前等待
+        GLsync rendered = f->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        f->glFlush();
+
+        {
+            QMutexLocker locker(&m_mutex);
+            buffer->renderedFence = rendered;
+            // 上一帧还没有被gui线程取走时等待，渲染线程最多领先一帧
+            while (m_readyFresh && !m_stop) {
+                m_frameTaken.wait(&m_mutex);
+            }
+            if (m_stop) {
+                break;
+            }
+            std::swap(m_renderIndex, m_readyIndex);
+            m_readyFresh = true;
+        }
+        emit frameReady();
+
+        frames++;
+        if (logTimer.elapsed() >= 1000) {
+            const AsyncReadback::Stats stats = readback.stats();
+            ALOG("render thread: {} fps render submit: {} us {} {} us",
+                 frames * 1000.0 / logTimer.elapsed(), renderNs / frames / 1000,
+                 asyncReadback ? "readback submit:" : "toImage:", readbackNs / frames / 1000);
+            ALOG("render thread: readback latency: {} ms stalls: {}", stats.lastLatencyMs, stats.stalls);
+            frames = 0;
+            renderNs = 0;
+            readbackNs = 0;
+            logTimer.restart();
+        }
+    }
+
+    readback.destroy();
+    traceGpu.destroy();
+    {
+        QMutexLocker locker(&m_mutex);
+        for (Buffer& buffer : m_buffers) {
+            destroyBuffer(f, buffer);
+        }
+        m_frameSize = QSize();
+    }
+    scene.destroy();
+
+    m_context->doneCurrent();
+    // 线程结束后context回到gui线程，在析构函数中删除
+    m_context->moveToThread(QCoreApplication::instance()->thread());
+}
+
+void RenderThread::destroyBuffer(QOpenGLExtraFunctions *f, RenderThread::Buffer &buffer)
+{
+    // fence是共享对象，gui线程创建的presentedFence也可以在这里删除
+    if (buffer.renderedFence) {
+        f->glDeleteSync(buffer.renderedFence);
+        buffer.renderedFence = 0;
+    }
+    if (buffer.presentedFence) {
+        f->glDeleteSync(buffer.presentedFence);
+        buffer.presentedFence = 0;
+    }
+    delete buffer.fbo;
+    buffer.fbo = nullptr;
+}
@@ -0,0 +1,95 @@
+#ifndef RENDERTHREAD_H
+#define RENDERTHREAD_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QImage>
+#include <QSize>
+#include <QOpenGLExtraFunctions>
+
+class QOpenGLContext;
+class QOffscreenSurface;
+class QOpenGLFramebufferObject;
+
+/*
+ * 独立的渲染线程：离屏渲染和readpix都在这个线程自己的context中完成，gui线程只负责把结果纹理画到屏幕上，
+ * 离屏渲染很重（或者同步readpix）时，gui线程的事件处理（鼠标键盘输入等）不会被gl调用阻塞
+ *
+ * 渲染线程的context和控件的context共享（shareContext），纹理和fence对象在两个context之间可见
+ * 结果纹理使用三个fbo轮转：渲染线程正在渲染的、已经渲染好等待上屏的、gui线程正在上屏的，
+ * 两个线程之间的同步：
+ * 1. 渲染线程渲染完成后插入renderedFence，gui线程上屏前glWaitSync等待这个fence，gpu侧等待，cpu不阻塞
+ * 2. gui线程上屏后插入presentedFence，渲染线程再次渲染到这个fbo之前glWaitSync等待，避免覆盖正在被采样的纹理
+ * 3. 渲染线程最多领先gui线程一帧，渲染好的帧还没有被取走时，渲染线程在条件变量上等待（不占用gui线程）
+ *
+ * 构造函数需要在gui线程中、控件的context创建之后调用（QOffscreenSurface只能在gui线程创建）
+*/
+class RenderThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit RenderThread(QOpenGLContext* shareContext, QObject *parent = nullptr);
+    ~RenderThread();
+
+    // 合成的重负载场景，见OffscreenScene::setDrawCount，可以在渲染过程中修改
+    void setDrawCount(int count);
+    // false时使用同步的toImage读取离屏数据
+    void setAsyncReadback(bool async);
+    // 通知渲染线程退出，之后需要wait()
+    void stop();
+
+    // 以下接口在gui线程中控件的context current时调用
+    // 取最新的一帧用于上屏，返回fbo的纹理id，还没有渲染好任何一帧时返回0
+    GLuint acquireFrame(QOpenGLExtraFunctions* f);
+    // 上屏的绘制命令提交以后调用，和acquireFrame成对使用
+    void releaseFrame(QOpenGLExtraFunctions* f);
+
+    // 离屏纹理大小，渲染线程初始化完成以前为空
+    QSize frameSize() const;
+    // 最近一次读取到的离屏数据
+    QImage latestImage() const;
+
+signals:
+    // 渲染线程中发出，新的一帧可以上屏了（连接到QWidget::update）
+    void frameReady();
+
+protected:
+    virtual void run() override;
+
+private:
+    struct Buffer
+    {
+        QOpenGLFramebufferObject* fbo = nullptr;
+        // 渲染线程渲染完成
+        GLsync renderedFence = 0;
+        // gui线程上屏完成
+        GLsync presentedFence = 0;
+    };
+
+    void destroyBuffer(QOpenGLExtraFunctions* f, Buffer& buffer);
+
+private:
+    QOpenGLContext* m_context = nullptr;
+    QOffscreenSurface* m_surface = nullptr;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_frameTaken;
+    // 以下成员由m_mutex保护
+    Buffer m_buffers[3];
+    int m_renderIndex = 0;
+    int m_readyIndex = 1;
+    int m_presentIndex = 2;
+    // m_readyIndex中是还没有被取走的新帧
+    bool m_readyFresh = false;
+    // gui线程已经上屏过至少一帧
+    bool m_presented = false;
+    bool m_stop = false;
+    int m_drawCount = 1;
+    bool m_asyncReadback = true;
+    QSize m_frameSize;
+    QImage m_latestImage;
+};
+
+#endif // RENDERTHREAD_H
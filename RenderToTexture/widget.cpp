@@ -1,63 +1,23 @@
 #include "widget.h"
 #include "ui_widget.h"
+#include "renderthread.h"
+#include "asynclog.h"
+#include "trace.h"
 
 #include <QDebug>
 #include <QImage>
+#include <QKeyEvent>
+#include <QVector2D>
 #include <QElapsedTimer>
 
 /*
  * 将两个图片渲染到纹理（离屏渲染），其中一个是大图片， 作为纹理大小，
  * 图片渲染到纹理以后，可以将纹理拿去上屏渲染（渲染大小为控件大小），渲染前可以在shader中做一些特效处理
  * 也可以同时readpix读取混合后到纹理数据（图片混合后的原尺寸大小）
+ *
+ * 渲染线程模式（setRenderThread）：离屏渲染和readpix在RenderThread中完成，这里只把渲染线程的结果纹理画到屏幕上
 */
 
-/***************************离屏渲染相关*****************************/
-
-float vertices[] = {
-    //     ---- 位置 ----       ---- 颜色 ----     - 纹理坐标 -
-    1.0f,  1.0f, 0.0f,   1.0f, 0.0f, 0.0f,   1.0f, 1.0f,   // 右上
-    1.0f, -1.0f, 0.0f,   0.0f, 1.0f, 0.0f,   1.0f, 0.0f,   // 右下
-    -1.0f, -1.0f, 0.0f,  0.0f, 0.0f, 1.0f,   0.0f, 0.0f,   // 左下
-    -1.0f,  1.0f, 0.0f,  1.0f, 1.0f, 0.0f,   0.0f, 1.0f    // 左上
-};
-
-unsigned int indices[] = { // 注意索引从0开始!
-                           0, 1, 3, // 第一个三角形
-                           1, 2, 3  // 第二个三角形
-                         };
-
-const char* vertexShaderSource = R"(#version 330 core
-                                 layout (location = 0) in vec3 aPos; // 来自cpu的顶点坐标
-                                 layout (location = 1) in vec3 aColor; // 来自cpu的颜色数据
-                                 layout (location = 2) in vec2 aTexCoord; // 来自cpu的纹理坐标
-
-                                 // 颜色和纹理坐标用于输出到片段着色器
-                                 out vec3 ourColor;
-                                 out vec2 TexCoord;
-
-                                 void main()
-                                 {
-                                 gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);
-                                 ourColor = aColor;
-                                 // 片段着色器采样图片是从下向上采样，所以图像是倒的，这里反转一个y
-                                 TexCoord = vec2(aTexCoord.x, 1.0 - aTexCoord.y);
-                                 })";
-
-const char* fragmentShaderSource = R"(#version 330 core
-                                   out vec4 FragColor;
-
-                                   in vec3 ourColor;
-                                   in vec2 TexCoord;
-
-                                   uniform sampler2D texture1;
-                                   uniform sampler2D texture2;
-
-                                   void main()
-                                   {
-                                   // 混合纹理坐标/纹理数据
-                                   FragColor = mix(texture(texture1, TexCoord), texture(texture2, TexCoord), 0.2);
-                                   } )";
-
 /***************************屏幕渲染相关*****************************/
 
 float screenVertices[] = {
@@ -68,143 +28,140 @@ float screenVertices[] = {
     -0.9f,  0.9f, 0.0f,     0.0f, 1.0f    // 左上
 };
 
-const char* screenVertexShaderSource = R"(#version 330 core
-                                       layout (location = 0) in vec2 aPos;
-                                       layout (location = 1) in vec2 aTexCoords;
-
-                                       out vec2 TexCoords;
-
-                                       void main()
-                                       {
-                                       gl_Position = vec4(aPos.x, aPos.y, 0.0, 1.0);
-                                       TexCoords = aTexCoords;
-                                       })";
-
-const char* screenFragmentShaderSource = R"(#version 330 core
-                                         out vec4 FragColor;
-
-                                         in vec2 TexCoords;
-
-                                         uniform sampler2D screenTexture;
-
-                                         void main()
-                                         {
-                                         //FragColor = vec4(1.0f, 0.5f, 0.2f, 1.0f);
-                                         FragColor = texture(screenTexture, TexCoords);
-                                         // 特效处理：反相
-                                         //FragColor = vec4(vec3(1.0 - texture(screenTexture, TexCoords)), 1.0);
+unsigned int indices[] = { // 注意索引从0开始!
+                           0, 1, 3, // 第一个三角形
+                           1, 2, 3  // 第二个三角形
+                         };
 
-                                         // 特效处理：灰度
-                                         //FragColor = texture(screenTexture, TexCoords);
-                                         //float average = 0.2126 * FragColor.r + 0.7152 * FragColor.g + 0.0722 * FragColor.b;
-                                         //FragColor = vec4(average, average, average, 1.0);
-                                         })";
+// 上屏的着色器和特效（反相、灰度、模糊）见common/posteffect.h
 
 Widget::Widget(QWidget *parent) :
     QOpenGLWidget(parent),
     ui(new Ui::Widget)
 {
     ui->setupUi(this);
+    // 接收按键，切换特效
+    setFocusPolicy(Qt::StrongFocus);
 }
 
 Widget::~Widget()
 {
-    makeCurrent();
-    m_offScreenVbo.destroy();
-    m_offScreenEbo.destroy();
-    m_offScreenVao.destroy();
+    // 先停止渲染线程，它的context和控件的context共享资源
+    if (m_renderThread) {
+        m_renderThread->stop();
+        m_renderThread->wait();
+        delete m_renderThread;
+    }
 
-    m_offScreenTexture.destroy();
-    m_offScreenTexture2.destroy();
+    makeCurrent();
+    m_scene.destroy();
+    m_screenPrograms.clear();
+    m_shaderCompiler.destroy();
+    m_gpuProfiler.destroy();
+    m_traceGpu.destroy();
 
+    m_readback.destroy();
     if (m_offScreenFbo) {
         delete m_offScreenFbo;
     }
 
+    m_hud.destroy();
     doneCurrent();
 
     delete ui;
 }
 
-void Widget::initializeGL()
+void Widget::setRenderThread(bool enabled)
 {
-    qDebug() << "format:" << context()->format();
-
-    initializeOpenGLFunctions();
-
-    /***************************离屏渲染相关*****************************/
+    m_useRenderThread = enabled;
+}
 
-    QImage bg(":/bg.jpeg");
-    m_offScreenSize = bg.size();
-    // 默认创建一个GL_TEXTURE_2D的纹理附件的fbo，且纹理附件attach到GL_COLOR_ATTACHMENT0
-    m_offScreenFbo = new QOpenGLFramebufferObject(m_offScreenSize);
-    if (!m_offScreenFbo->isValid()) {
-        qFatal("fbo invalid");
+void Widget::setDrawCount(int count)
+{
+    m_drawCount = qMax(count, 1);
+    if (m_drawCount > 1) {
+        m_continuous = true;
     }
+}
 
-    // vao初始化
-    m_offScreenVao.create();
-    // 绑定vao，下面对vbo/ebo的操作都保存到了vao上，下次绘制该物体直接m_vao.bind()即可，不用重复vbo/ebo的bind/allocate操作
-    // vao也会保存ebo
-    m_offScreenVao.bind();
-
-    // vbo初始化
-    m_offScreenVbo.create();
-    m_offScreenVbo.bind();
-    m_offScreenVbo.setUsagePattern(QOpenGLBuffer::StaticDraw);
-    m_offScreenVbo.allocate(vertices, sizeof(vertices));
+void Widget::setAsyncReadback(bool async)
+{
+    m_asyncReadback = async;
+}
 
-    // ebo初始化
-    m_offScreenEbo.create();
-    m_offScreenEbo.bind();
-    m_offScreenEbo.allocate(indices, sizeof(indices));
-
-    // 编译着色器
-    m_offScreenShaderProgram.addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShaderSource);
-    m_offScreenShaderProgram.addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShaderSource);
-    m_offScreenShaderProgram.link();
-    m_offScreenShaderProgram.bind();
-
-    // 指定顶点坐标在vbo中的访问方式
-    // 参数解释：顶点坐标在shader中的参数location，顶点坐标为float，起始偏移为0字节，顶点坐标类型为vec3，步幅为3个float
-    m_offScreenShaderProgram.setAttributeBuffer(0, GL_FLOAT, 0 * sizeof(float), 3, 8 * sizeof(float));
-    // 启用顶点属性
-    m_offScreenShaderProgram.enableAttributeArray(0);
+void Widget::setContinuous(bool continuous)
+{
+    m_continuous = continuous;
+}
 
-    m_offScreenShaderProgram.setAttributeBuffer(1, GL_FLOAT, 3 * sizeof(float), 3, 8 * sizeof(float));
-    m_offScreenShaderProgram.enableAttributeArray(1);
+void Widget::setEffect(PostEffect::Effect effect)
+{
+    if (m_effect == effect) {
+        return;
+    }
+    m_effect = effect;
+    // paintGL中按新的特效重新取program
+    m_screenShaderProgram = nullptr;
+    update();
+}
 
-    m_offScreenShaderProgram.setAttributeBuffer(2, GL_FLOAT, 6 * sizeof(float), 2, 8 * sizeof(float));
-    m_offScreenShaderProgram.enableAttributeArray(2);
+void Widget::setGpuProfile(bool enabled)
+{
+    m_gpuProfiler.setEnabled(enabled);
+}
 
-    // 关联片段着色器中的纹理单元和opengl中的纹理单元（opengl一般提供16个纹理单元）
-    // 告诉片段着色器，纹理texture1属于纹理单元0
-    m_offScreenShaderProgram.setUniformValue("texture1", 0);
-    // 告诉片段着色器，纹理texture2属于纹理单元1
-    m_offScreenShaderProgram.setUniformValue("texture2", 1);
+void Widget::keyPressEvent(QKeyEvent *event)
+{
+    if (event->key() == Qt::Key_E) {
+        setEffect(PostEffect::next(m_effect));
+        return;
+    }
+    QOpenGLWidget::keyPressEvent(event);
+}
 
-    // 设置纹理
-    // 设置st方向上纹理超出坐标时的显示策略
-    m_offScreenTexture.setWrapMode(QOpenGLTexture::DirectionS, QOpenGLTexture::ClampToEdge);
-    m_offScreenTexture.setWrapMode(QOpenGLTexture::DirectionT, QOpenGLTexture::ClampToEdge);
-    // 设置纹理缩放时的策略
-    m_offScreenTexture.setMinificationFilter(QOpenGLTexture::Linear);
-    m_offScreenTexture.setMagnificationFilter(QOpenGLTexture::Linear);
-    m_offScreenTexture.setData(bg);
+void Widget::initializeGL()
+{
+    TRACE_SCOPE("initializeGL");
+    qDebug() << "format:" << context()->format();
 
-    // 设置st方向上纹理超出坐标时的显示策略
-    m_offScreenTexture2.setWrapMode(QOpenGLTexture::DirectionS, QOpenGLTexture::ClampToEdge);
-    m_offScreenTexture2.setWrapMode(QOpenGLTexture::DirectionT, QOpenGLTexture::ClampToEdge);
-    // 设置纹理缩放时的策略
-    m_offScreenTexture2.setMinificationFilter(QOpenGLTexture::Linear);
-    m_offScreenTexture2.setMagnificationFilter(QOpenGLTexture::Linear);
-    m_offScreenTexture2.setData(QImage(":/gyy.jpeg"));
+    initializeOpenGLFunctions();
+    m_hud.initialize(this);
+    m_shaderCompiler.initialize(context());
+    m_gpuProfiler.initialize(context());
+    m_traceGpu.initialize(context());
 
-    // 图片是rgba8888格式，注意这里的参数GL_RGBA8/GL_RGBA
-    //glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, wall.width(), wall.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, wall.bits());
+    /***************************离屏渲染相关*****************************/
 
-    m_offScreenVao.release();
-    qDebug() << m_offScreenShaderProgram.log();
+    m_logTimer.start();
+    if (m_useRenderThread) {
+        // 离屏渲染相关的资源都在渲染线程中创建，新的一帧渲染好以后通知控件重绘
+        m_renderThread = new RenderThread(context());
+        m_renderThread->setDrawCount(m_drawCount);
+        m_renderThread->setAsyncReadback(m_asyncReadback);
+        connect(m_renderThread, &RenderThread::frameReady, this, QOverload<>::of(&Widget::update));
+        m_renderThread->start();
+    } else {
+        m_scene.setShaderCompiler(&m_shaderCompiler);
+        if (!m_scene.initialize()) {
+            qFatal("initialize offscreen scene failed");
+        }
+        m_scene.setDrawCount(m_drawCount);
+        // 图片解码完成后重绘，渲染线程模式下一直在渲染，不需要连接
+        connect(&m_scene.textureLoader(), &TextureLoader::textureDecoded, this, QOverload<>::of(&Widget::update));
+        m_offScreenSize = m_scene.size();
+        // 默认创建一个GL_TEXTURE_2D的纹理附件的fbo，且纹理附件attach到GL_COLOR_ATTACHMENT0
+        m_offScreenFbo = new QOpenGLFramebufferObject(m_offScreenSize);
+        if (!m_offScreenFbo->isValid()) {
+            qFatal("fbo invalid");
+        }
+
+        // PBO环的大小和离屏纹理一致，读取结果通过回调交付
+        m_readback.create(m_offScreenSize);
+        m_readback.setCallback([this](const QImage& image, quint64 frameId) {
+            Q_UNUSED(frameId);
+            m_offScreenImage = image;
+        });
+    }
 
 
     /***************************屏幕渲染相关*****************************/
@@ -226,20 +183,21 @@ void Widget::initializeGL()
     m_screenEbo.bind();
     m_screenEbo.allocate(indices, sizeof(indices));
 
-    // 编译着色器
-    m_screenShaderProgram.addShaderFromSourceCode(QOpenGLShader::Vertex, screenVertexShaderSource);
-    m_screenShaderProgram.addShaderFromSourceCode(QOpenGLShader::Fragment, screenFragmentShaderSource);
-    m_screenShaderProgram.link();
-    m_screenShaderProgram.bind();
+    // 先提交当前特效的变体，和离屏的着色器并行编译，paintGL中第一次用到时才等待
+    m_screenPrograms.setSources(PostEffect::vertexShader(), PostEffect::fragmentShader());
+    m_screenPrograms.setCompiler(&m_shaderCompiler);
+    m_screenPrograms.request(PostEffect::defines(m_effect));
 
-    // 指定顶点坐标在vbo中的访问方式
-    // 参数解释：顶点坐标在shader中的参数location，顶点坐标为float，起始偏移为0字节，顶点坐标类型为vec3，步幅为3个float
-    m_screenShaderProgram.setAttributeBuffer(0, GL_FLOAT, 0 * sizeof(float), 3, 5 * sizeof(float));
+    // 指定顶点坐标在vbo中的访问方式，和program无关，所有变体共用
+    // 参数解释：顶点坐标在shader中的参数location，顶点坐标类型为vec3，顶点坐标为float，步幅为5个float，起始偏移为0字节
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), reinterpret_cast<void*>(0 * sizeof(float)));
     // 启用顶点属性
-    m_screenShaderProgram.enableAttributeArray(0);
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), reinterpret_cast<void*>(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
 
-    m_screenShaderProgram.setAttributeBuffer(1, GL_FLOAT, 3 * sizeof(float), 2, 5 * sizeof(float));
-    m_screenShaderProgram.enableAttributeArray(1);
+    m_screenVao.release();
 }
 
 void Widget::resizeGL(int w, int h)
@@ -248,60 +206,132 @@ void Widget::resizeGL(int w, int h)
     Q_UNUSED(h);
 }
 
-void Widget::paintGL()
+GLuint Widget::renderOffScreen()
 {
-    //update(); 开启循环paint，方便调试toImage耗时
-
-    /***************************离屏渲染相关*****************************/
-
     // fbo绑定以后，后面所有的渲染都渲染到fbo的texture附件上了
     m_offScreenFbo->bind();
-    // viewport设置为离屏texture大小，
-    glViewport(0, 0, m_offScreenSize.width(), m_offScreenSize.height());
-    // 清理背景
-    glClearColor(0.0f, 0.0f, 1.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
+    {
+        TRACE_SCOPE("offscreen");
+        TraceGpu::Scope traceScope(m_traceGpu, "offscreen");
+        GpuProfiler::Scope scope(m_gpuProfiler, "offscreen");
+        m_scene.render();
+    }
 
-    // 激活纹理单元0
-    glActiveTexture(GL_TEXTURE0);
-    // 绑定纹理到纹理单元0
-    m_offScreenTexture.bind();
-    glActiveTexture(GL_TEXTURE1);
-    m_offScreenTexture2.bind();
-
-    m_offScreenShaderProgram.bind();
-    m_offScreenVao.bind();
-    // glDrawElements会根据ebo中的6个索引去vbo中找顶点位置
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-    m_offScreenVao.release();
-    m_offScreenShaderProgram.release();
+    GpuProfiler::Scope readbackScope(m_gpuProfiler, "readback");
 
     // 读取离屏数据
     QElapsedTimer t;
     t.start();
-    //m_offScreenFbo->toImage().save("/Users/barry/test.jpg");
-    // 性能还不错（25ms左右，渲染帧率30fps以内的话，不需要放到单独线程）,内部使用glReadPixels实现
-    m_offScreenFbo->toImage();
-    qDebug() << "toImage cost:" << t.elapsed() << " ms";
+    const bool log = m_logTimer.elapsed() >= 1000;
+    if (m_asyncReadback) {
+        // 先交付之前已经完成的读取，再发起本帧的读取，本帧的结果1~2帧后才交付，渲染循环中不再等待gpu
+        m_readback.poll();
+        m_readback.readback();
+        const AsyncReadback::Stats stats = m_readback.stats();
+        if (log) {
+            ALOG("readback submit cost: {} us latency: {} ms / {} frames", t.nsecsElapsed() / 1000,
+                 stats.lastLatencyMs, stats.avgLatencyFrames);
+            ALOG("readback throughput: {} fps {} MB/s stalls: {}",
+                 stats.deliveredPerSecond, stats.megabytesPerSecond, stats.stalls);
+        }
+    } else {
+        //m_offScreenFbo->toImage().save("/Users/barry/test.jpg");
+        // 性能还不错（25ms左右，渲染帧率30fps以内的话，不需要放到单独线程）,内部使用glReadPixels实现
+        TRACE_SCOPE("toImage");
+        m_offScreenImage = m_offScreenFbo->toImage();
+        if (log) {
+            ALOG("toImage cost: {} ms", t.elapsed());
+        }
+    }
+    if (log) {
+        m_logTimer.restart();
+    }
+
+    // 恢复屏幕fbo
+    m_offScreenFbo->release();
+    return m_offScreenFbo->texture();
+}
+
+void Widget::paintGL()
+{
+    // 统计这一帧的cpu/gpu耗时，作用域结束（包括提前return）时绘制HUD
+    FrameHud::Frame hudFrame(m_hud);
+
+    // 连续绘制：单线程模式下不断重绘，渲染线程模式下由frameReady驱动重绘
+    if (m_continuous && !m_renderThread) {
+        update();
+    }
+
+    TRACE_SCOPE("paintGL");
+    // 读取几帧之前已经完成的查询结果，不等待gpu
+    m_gpuProfiler.beginFrame();
+    m_traceGpu.collect();
+
+    /***************************离屏渲染相关*****************************/
+
+    GLuint offScreenTexture = 0;
+    if (m_renderThread) {
+        // 取渲染线程最新的一帧，gpu侧等待它渲染完成，gui线程不阻塞
+        offScreenTexture = m_renderThread->acquireFrame(context()->extraFunctions());
+    } else {
+        offScreenTexture = renderOffScreen();
+    }
 
 
     /***************************屏幕渲染相关*****************************/
 
-    // 恢复屏幕fbo
-    m_offScreenFbo->release();
     // opengl glViewport使用设备像素，而width()/height()是逻辑像素，需要转换
     glViewport(0, 0, width() * devicePixelRatio(), height() * devicePixelRatio());
     // 清理背景
     glClearColor(0.0f, 1.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
 
+    // 渲染线程还没有渲染好第一帧时只清理背景
+    if (offScreenTexture == 0) {
+        m_gpuProfiler.endFrame();
+        return;
+    }
+
+    // 切换特效以后取对应的变体，特效在编译期确定，着色器中没有分支
+    if (!m_screenShaderProgram) {
+        m_screenShaderProgram = m_screenPrograms.program(PostEffect::defines(m_effect));
+        qDebug() << "effect:" << PostEffect::name(m_effect) << qPrintable(m_screenPrograms.stats().summary());
+        if (!m_screenShaderProgram) {
+            m_gpuProfiler.endFrame();
+            return;
+        }
+    }
+
     glActiveTexture(GL_TEXTURE0);
     // 将fbo的texture渲染到屏幕
-    glBindTexture(GL_TEXTURE_2D, m_offScreenFbo->texture());
-    m_screenShaderProgram.bind();
+    glBindTexture(GL_TEXTURE_2D, offScreenTexture);
+    m_screenShaderProgram->bind();
+    m_screenShaderProgram->setUniformValue("screenTexture", 0);
+    // 渲染线程模式下离屏纹理的大小和场景相同
+    const QSize textureSize = m_renderThread ? m_renderThread->frameSize() : m_offScreenSize;
+    m_screenShaderProgram->setUniformValue("uTexelSize", QVector2D(1.0f / textureSize.width(), 1.0f / textureSize.height()));
     m_screenVao.bind();
-    // glDrawElements会根据ebo中的6个索引去vbo中找顶点位置
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    {
+        TraceGpu::Scope traceScope(m_traceGpu, "screen");
+        GpuProfiler::Scope scope(m_gpuProfiler, "screen");
+        // glDrawElements会根据ebo中的6个索引去vbo中找顶点位置
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    }
     m_screenVao.release();
-    m_screenShaderProgram.release();
+    m_screenShaderProgram->release();
+    m_gpuProfiler.endFrame();
+    if (m_gpuProfiler.isActive()) {
+        ALOG_RATE(1, "gpu profile: {}", m_gpuProfiler.summary());
+    }
+
+    // 启动时提交的着色器都编译完成以后输出一次：启动编译的总耗时，以及第一次使用时还没有编译完成、需要等待的次数和耗时
+    if (!m_compileReported && m_shaderCompiler.stats().pending == 0) {
+        m_compileReported = true;
+        ALOG("shader compile: {}", m_shaderCompiler.stats().summary());
+    }
+
+    if (m_renderThread) {
+        // 采样渲染线程纹理的命令之后插入fence，渲染线程覆盖这个纹理前等待
+        m_renderThread->releaseFrame(context()->extraFunctions());
+    }
 }
@@ -8,6 +8,18 @@
 #include <QOpenGLShaderProgram>
 #include <QOpenGLTexture>
 #include <QOpenGLFramebufferObject>
+#include <QElapsedTimer>
+
+#include "asyncreadback.h"
+#include "offscreenscene.h"
+#include "posteffect.h"
+#include "shadervariantcache.h"
+#include "shadercompiler.h"
+#include "gpuprofiler.h"
+#include "tracegpu.h"
+#include "framehud.h"
+
+class RenderThread;
 
 namespace Ui {
 class Widget;
@@ -21,30 +33,62 @@ public:
     explicit Widget(QWidget *parent = nullptr);
     ~Widget();
 
+    // 以下设置需要在show之前调用
+    // 离屏渲染和readpix放到独立的渲染线程中，gui线程只负责上屏
+    void setRenderThread(bool enabled);
+    // 合成的重负载场景：离屏渲染时重复绘制count次，同时开启连续绘制
+    void setDrawCount(int count);
+    // false时使用同步的toImage读取离屏数据，方便对比耗时
+    void setAsyncReadback(bool async);
+    // 开启连续绘制（不断update）
+    void setContinuous(bool continuous);
+    // 上屏时的特效，可以随时切换（运行时按E键切换到下一个特效），每个特效是一个单独编译的着色器变体
+    void setEffect(PostEffect::Effect effect);
+    // 统计离屏、读取、上屏各个pass的gpu耗时和着色器调用次数（见common/gpuprofiler.h），需要在show之前调用
+    // 渲染线程模式下离屏和读取在渲染线程的context中，只统计上屏
+    void setGpuProfile(bool enabled);
+
 protected:
     virtual void initializeGL() override;
     virtual void resizeGL(int w, int h) override;
     virtual void paintGL() override;
+    virtual void keyPressEvent(QKeyEvent *event) override;
+
+private:
+    // gui线程中离屏渲染并读取离屏数据，返回离屏纹理
+    GLuint renderOffScreen();
 
 private:
     Ui::Widget *ui;
 
+    // 离屏和上屏的着色器在initializeGL中一起提交，并行编译，第一帧用到时才等待
+    ShaderCompiler m_shaderCompiler;
+    bool m_compileReported = false;
+
+    // 每个pass一个scope，默认关闭
+    GpuProfiler m_gpuProfiler;
+    // GL_TRACE开启时，各个pass在gpu上的执行时间输出到trace的时间线上
+    TraceGpu m_traceGpu;
+
     // 离屏渲染相关
 
-    //顶点数组对象(Vertex Array Object，VAO)，用来缓存顶点缓冲对象的操作（例如setAttributeBuffer）
-    QOpenGLVertexArrayObject m_offScreenVao;
-    // 顶点缓冲对象(Vertex Buffer Objects, VBO)，用来缓存顶点坐标
-    QOpenGLBuffer m_offScreenVbo; // 默认即为VertexBuffer(GL_ARRAY_BUFFER)类型
-    // 索引缓冲对象(Element Buffer Object，EBO或Index Buffer Object，IBO)，用来缓存顶点坐标的索引
-    QOpenGLBuffer m_offScreenEbo {QOpenGLBuffer::IndexBuffer};
-    // 着色器程序：编译链接着色器
-    QOpenGLShaderProgram m_offScreenShaderProgram;
-    // 纹理
-    QOpenGLTexture m_offScreenTexture {QOpenGLTexture::Target2D};
-    QOpenGLTexture m_offScreenTexture2 {QOpenGLTexture::Target2D};
+    // 离屏渲染的场景（两张图片混合），渲染线程模式下由渲染线程自己创建
+    OffscreenScene m_scene;
     // 离屏渲染到fbo的纹理附件中
     QOpenGLFramebufferObject* m_offScreenFbo = nullptr;
     QSize m_offScreenSize;
+    // 异步读取离屏数据，false时使用同步的toImage，方便对比耗时
+    bool m_asyncReadback = true;
+    int m_drawCount = 1;
+    bool m_continuous = false;
+    // 渲染线程模式
+    bool m_useRenderThread = false;
+    RenderThread* m_renderThread = nullptr;
+    AsyncReadback m_readback;
+    // 最近一次读取到的离屏数据
+    QImage m_offScreenImage;
+    // 读取耗时每秒输出一次
+    QElapsedTimer m_logTimer;
 
 
     // 屏幕渲染相关
@@ -55,8 +99,13 @@ private:
     QOpenGLBuffer m_screenVbo; // 默认即为VertexBuffer(GL_ARRAY_BUFFER)类型
     // 索引缓冲对象(Element Buffer Object，EBO或Index Buffer Object，IBO)，用来缓存顶点坐标的索引
     QOpenGLBuffer m_screenEbo {QOpenGLBuffer::IndexBuffer};
-    // 着色器程序：编译链接着色器
-    QOpenGLShaderProgram m_screenShaderProgram;
+    // 着色器程序：每个特效一个变体，切换特效时从m_screenPrograms中取（第一次使用时编译）
+    ShaderVariantCache m_screenPrograms;
+    QOpenGLShaderProgram* m_screenShaderProgram = nullptr;
+    PostEffect::Effect m_effect = PostEffect::None;
+
+    // 帧统计HUD：FRAME_HUD=1时显示，默认关闭
+    FrameHud m_hud;
 };
 
 #endif // WIDGET_H
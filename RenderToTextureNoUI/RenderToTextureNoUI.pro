@@ -10,9 +10,17 @@ CONFIG += c++11
 
 SOURCES += \
     main.cpp \
+    offscreenprocessor.cpp \
+    offscreenrenderpool.cpp \
+    programcache.cpp \
+    stagebench.cpp \
     widget.cpp
 
 HEADERS += \
+    offscreenprocessor.h \
+    offscreenrenderpool.h \
+    programcache.h \
+    stagebench.h \
     widget.h
 
 FORMS += \
@@ -25,3 +33,7 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 
 RESOURCES += \
     res.qrc
+
+include(../common/asyncreadback.pri)
+include(../common/trace.pri)
+include(../common/shaderlink.pri)
@@ -1,8 +1,15 @@
 #include "widget.h"
+#include "offscreenprocessor.h"
+#include "offscreenrenderpool.h"
+#include "stagebench.h"
+#include "trace.h"
+
+#include <vector>
 
 #include <QApplication>
 #include <QDebug>
 #include <QtConcurrent>
+#include <QElapsedTimer>
 
 #include <QOpenGLContext>
 #include <QOffscreenSurface>
@@ -12,6 +19,10 @@
 #include <QOpenGLTexture>
 #include <QOpenGLBuffer>
 
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
 /*
  * 不使用ui surface的情况下进行QOpenGLFramebufferObject离屏渲染：
  * 之前虽然我们使用QOpenGLFramebufferObject实现了离屏渲染（渲染到了纹理）
@@ -29,11 +40,15 @@ QImage processImage(const QImage& image,
                     const QString& textureVar,
                     const QString& vertexPosVar,
                     const QString& textureCoordVar) {
+    TRACE_SCOPE("processImage");
     QOpenGLContext context;
-    if(!context.create())
     {
-        qDebug() << "Can't create GL context.";
-        return {};
+        TRACE_SCOPE("create context");
+        if(!context.create())
+        {
+            qDebug() << "Can't create GL context.";
+            return {};
+        }
     }
 
     // 创建离屏surface，作为后续的渲染设备
@@ -57,6 +72,8 @@ QImage processImage(const QImage& image,
     context.functions()->glViewport(0, 0, image.width(), image.height());
 
     QOpenGLShaderProgram program(&context);
+    // 每次调用都从源码编译、不输出日志：bench()中和OffscreenProcessor对比的就是这种做法，
+    // 不使用磁盘上的program binary缓存（见shaderlink.h）
     if (!program.addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShader))
     {
         qDebug() << "Can't add vertex shader.";
@@ -79,7 +96,10 @@ QImage processImage(const QImage& image,
     }
 
     QOpenGLTexture texture(QOpenGLTexture::Target2D);
-    texture.setData(image);
+    {
+        TRACE_SCOPE("texture upload");
+        texture.setData(image);
+    }
 
     texture.bind();
     if(!texture.isBound())
@@ -147,49 +167,178 @@ QImage processImage(const QImage& image,
     context.functions()->glDrawElements(GL_TRIANGLE_STRIP, 4, GL_UNSIGNED_INT, Q_NULLPTR);
 
     // readpix读取渲染的数据
+    TRACE_SCOPE("readback");
     return fbo.toImage(false);
 }
 
+namespace {
+
+const char* vertexShader =
+        "attribute vec4 aPosition;\n"
+        "attribute vec2 aTexCoord;\n"
+        "varying vec2 vTexCoord;\n"
+        "void main()\n"
+        "{\n"
+        "   gl_Position = aPosition;\n"
+        "   vTexCoord = aTexCoord;\n"
+        "}";
+
+// 使用片段着色器将棕褐色效果应用于图像
+const char* fragmentShader =
+        "uniform sampler2D texture;\n"
+        "varying vec2 vTexCoord;\n"
+        "void main()\n"
+        "{\n"
+        "   vec2 uv = vTexCoord;\n"
+        "   vec4 orig = texture2D(texture, uv);\n"
+        "   vec3 col = orig.rgb;\n"
+        "   float y = 0.3 * col.r + 0.59 * col.g + 0.11 * col.b;\n"
+        "   gl_FragColor = vec4(y + 0.15, y + 0.07, y - 0.12, 1.0);\n"
+        "}";
+
+}
+
 void run() {
+    Trace::setThreadName("QtConcurrent worker");
+    TRACE_SCOPE("run");
     qDebug() << "run thread id:" << (int64_t)QThread::currentThreadId();
-    QString vertexShader =
-            "attribute vec4 aPosition;\n"
-            "attribute vec2 aTexCoord;\n"
-            "varying vec2 vTexCoord;\n"
-            "void main()\n"
-            "{\n"
-            "   gl_Position = aPosition;\n"
-            "   vTexCoord = aTexCoord;\n"
-            "}";
-
-    // 使用片段着色器将棕褐色效果应用于图像
-    QString fragmentShader =
-            "uniform sampler2D texture;\n"
-            "varying vec2 vTexCoord;\n"
-            "void main()\n"
-            "{\n"
-            "   vec2 uv = vTexCoord;\n"
-            "   vec4 orig = texture2D(texture, uv);\n"
-            "   vec3 col = orig.rgb;\n"
-            "   float y = 0.3 * col.r + 0.59 * col.g + 0.11 * col.b;\n"
-            "   gl_FragColor = vec4(y + 0.15, y + 0.07, y - 0.12, 1.0);\n"
-            "}";
-
-
-    QImage image = processImage(QImage(":/girls.jpeg"),
-                                vertexShader,
-                                fragmentShader,
-                                "texture",
-                                "aPosition",
-                                "aTexCoord");
+
+    // 常驻的处理器，批量处理时context/program/vbo只创建一次
+    OffscreenProcessor processor;
+    if (!processor.create()) {
+        return;
+    }
+
+    QImage image = processor.process(QImage(":/girls.jpeg"),
+                                     vertexShader,
+                                     fragmentShader,
+                                     "texture",
+                                     "aPosition",
+                                     "aTexCoord");
 
     image.save(QCoreApplication::applicationDirPath() + "/../../../out.jpeg");
 }
 
+// 对比每次调用都重新创建context的processImage和常驻的OffscreenProcessor每秒能处理多少次
+void bench(int iterations) {
+    Trace::setThreadName("QtConcurrent worker");
+    TRACE_SCOPE("bench");
+    const QImage input(":/girls.jpeg");
+    QElapsedTimer t;
+
+    t.start();
+    for (int i = 0; i < iterations; i++) {
+        processImage(input, vertexShader, fragmentShader, "texture", "aPosition", "aTexCoord");
+    }
+    qint64 processImageNs = t.nsecsElapsed();
+
+    OffscreenProcessor processor;
+    if (!processor.create()) {
+        return;
+    }
+    t.start();
+    for (int i = 0; i < iterations; i++) {
+        processor.process(input, vertexShader, fragmentShader, "texture", "aPosition", "aTexCoord");
+    }
+    qint64 processorNs = t.nsecsElapsed();
+
+    // 异步读取：cpu提交下一张图片时gpu还在处理上一张
+    int delivered = 0;
+    t.start();
+    for (int i = 0; i < iterations; i++) {
+        processor.processAsync(input, vertexShader, fragmentShader, "texture", "aPosition", "aTexCoord",
+                               [&delivered](const QImage&) { delivered++; });
+    }
+    processor.flush();
+    qint64 asyncNs = t.nsecsElapsed();
+    const AsyncReadback::Stats stats = processor.readbackStats();
+
+    qDebug() << "image size:" << input.size() << "iterations:" << iterations;
+    qDebug() << "processImage                    calls/sec:" << iterations * 1e9 / processImageNs;
+    qDebug() << "OffscreenProcessor              calls/sec:" << iterations * 1e9 / processorNs;
+    qDebug() << "OffscreenProcessor processAsync calls/sec:" << iterations * 1e9 / asyncNs
+             << "delivered:" << delivered << "avg latency:" << stats.avgLatencyMs << "ms /"
+             << stats.avgLatencyFrames << "calls" << "stalls:" << stats.stalls;
+}
+
+// 不同工作线程数下OffscreenRenderPool的吞吐
+// llvmpipe自己也会用LP_NUM_THREADS个线程光栅化，可以组合不同的LP_NUM_THREADS找到驱动线程和工作线程的最佳分配
+void poolBench(int jobs) {
+    const QImage input(":/girls.jpeg");
+    const QByteArray lpThreads = qgetenv("LP_NUM_THREADS");
+    qDebug() << "image size:" << input.size() << "jobs:" << jobs
+             << "LP_NUM_THREADS:" << (lpThreads.isEmpty() ? QByteArray("default") : lpThreads);
+
+    OffscreenRenderPool::Job job;
+    job.image = input;
+    job.vertexShader = vertexShader;
+    job.fragmentShader = fragmentShader;
+    job.textureVar = "texture";
+    job.vertexPosVar = "aPosition";
+    job.textureCoordVar = "aTexCoord";
+
+    QList<int> threadCounts;
+    for (int n = 1; n < QThread::idealThreadCount(); n *= 2) {
+        threadCounts.append(n);
+    }
+    threadCounts.append(QThread::idealThreadCount());
+
+    for (int threads : threadCounts) {
+        OffscreenRenderPool pool(threads);
+        if (!pool.start()) {
+            return;
+        }
+
+        // 先跑一轮，让每个工作线程都完成context创建和shader编译
+        std::vector<std::future<QImage>> warmup;
+        for (int i = 0; i < threads; i++) {
+            warmup.push_back(pool.submit(job));
+        }
+        for (auto& future : warmup) {
+            future.wait();
+        }
+
+        QElapsedTimer t;
+        t.start();
+        std::vector<std::future<QImage>> futures;
+        futures.reserve(jobs);
+        for (int i = 0; i < jobs; i++) {
+            futures.push_back(pool.submit(job));
+        }
+        for (auto& future : futures) {
+            future.wait();
+        }
+        const qint64 ns = t.nsecsElapsed();
+        pool.stop();
+
+        quint64 stolen = 0;
+        for (quint64 n : pool.stats().stolen) {
+            stolen += n;
+        }
+        qDebug() << "threads:" << threads << "images/sec:" << jobs * 1e9 / ns << "stolen:" << stolen;
+    }
+}
+
+// 峰值内存，单位KB（linux上即VmHWM），用来和headless-egl-cmake对比
+long peakRssKb() {
+#ifdef Q_OS_UNIX
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return usage.ru_maxrss;
+    }
+#endif
+    return -1;
+}
+
 int main(int argc, char *argv[])
 {
+    QElapsedTimer startup;
+    startup.start();
+
     // 即使不需要窗口surface，但是opengl context要求必须是guiapplication程序
     QApplication a(argc, argv);
+    // GL_TRACE=trace.json：输出各个线程的时间线（见common/trace.h）
+    Trace::setThreadName("main");
     /*
     QSurfaceFormat format;
     format.setVersion(3, 3);
@@ -202,8 +351,32 @@ int main(int argc, char *argv[])
     qDebug() << "main thread id:" << (int64_t)QThread::currentThreadId();
 
     // 测试放在子线程中离屏渲染
-     QFuture<void> future = QtConcurrent::run(run);
-     future.waitForFinished();
+    // --bench N：对比processImage和OffscreenProcessor的吞吐（例如在Mesa llvmpipe下：LIBGL_ALWAYS_SOFTWARE=1）
+    // --pool-bench N：不同线程数下OffscreenRenderPool处理N张图片的吞吐
+    // --stage-bench N：processImage各个阶段在不同图片尺寸、格式下的耗时（见stagebench.h）
+    int benchIndex = a.arguments().indexOf("--bench");
+    int poolBenchIndex = a.arguments().indexOf("--pool-bench");
+    const StageBench::Options stageBench = StageBench::parse(a.arguments());
+    if (stageBench.iterations > 0) {
+        // 每次测量都创建QOffscreenSurface，在gui线程中运行
+        const QVector<StageBench::Result> results = StageBench::run(stageBench, QImage(":/girls.jpeg"),
+                                                                    vertexShader, fragmentShader,
+                                                                    "texture", "aPosition", "aTexCoord");
+        StageBench::print(results);
+        StageBench::writeCsv(results, stageBench.csv);
+    } else if (poolBenchIndex >= 0) {
+        // OffscreenRenderPool需要在gui线程中创建
+        poolBench(a.arguments().value(poolBenchIndex + 1, "200").toInt());
+    } else if (benchIndex >= 0) {
+        int iterations = a.arguments().value(benchIndex + 1, "100").toInt();
+        QFuture<void> future = QtConcurrent::run(bench, iterations);
+        future.waitForFinished();
+    } else {
+        QFuture<void> future = QtConcurrent::run(run);
+        future.waitForFinished();
+        // 和headless-egl-cmake输出的startup/peak rss对比（QT_QPA_PLATFORM=offscreen时不需要X server）
+        qDebug() << "startup: main->first image" << startup.elapsed() << "ms" << "peak rss:" << peakRssKb() << "KB";
+    }
 
     qDebug() << "processImage finish";
 
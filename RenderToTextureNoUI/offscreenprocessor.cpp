@@ -0,0 +1,310 @@
+#include "offscreenprocessor.h"
+#include "trace.h"
+
+#include <QDebug>
+#include <QVector2D>
+
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
+#include <QOpenGLFunctions>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLTexture>
+#include <QOpenGLPixelTransferOptions>
+
+namespace {
+
+struct VertexData
+{
+    QVector2D position;
+    QVector2D texCoord;
+};
+
+const VertexData quadVertices[] =
+{
+    {{ -1.0f, +1.0f }, { 0.0f, 1.0f }}, // top-left
+    {{ +1.0f, +1.0f }, { 1.0f, 1.0f }}, // top-right
+    {{ -1.0f, -1.0f }, { 0.0f, 0.0f }}, // bottom-left
+    {{ +1.0f, -1.0f }, { 1.0f, 0.0f }}  // bottom-right
+};
+
+const GLuint quadIndices[] =
+{
+    0, 1, 2, 3
+};
+
+}
+
+OffscreenProcessor::OffscreenProcessor()
+{
+}
+
+OffscreenProcessor::OffscreenProcessor(QOpenGLContext *shareContext,
+                                       QOffscreenSurface *surface,
+                                       const QSharedPointer<QMutex> &compileLock)
+    : m_shareContext(shareContext)
+    , m_surface(surface)
+    , m_programCache(compileLock)
+{
+}
+
+OffscreenProcessor::~OffscreenProcessor()
+{
+    if (!isValid()) {
+        return;
+    }
+
+    // gl资源需要在context current的情况下释放
+    m_context->makeCurrent(m_surface);
+    // 未交付的异步读取在这里交付掉
+    m_readback.flush();
+    m_readback.destroy();
+    m_programCache.clear();
+    m_texture.reset();
+    m_fbo.reset();
+    m_vertexBuf.destroy();
+    m_indexBuf.destroy();
+    m_context->doneCurrent();
+}
+
+bool OffscreenProcessor::create()
+{
+    m_context.reset(new QOpenGLContext);
+    if (m_shareContext) {
+        // 共享组内的texture/buffer对象可以在各个context之间共用
+        m_context->setFormat(m_shareContext->format());
+        m_context->setShareContext(m_shareContext);
+    }
+    if(!m_context->create())
+    {
+        qDebug() << "Can't create GL context.";
+        m_context.reset();
+        return false;
+    }
+    if (m_shareContext && !m_context->shareContext())
+    {
+        qDebug() << "Can't share GL context.";
+        m_context.reset();
+        return false;
+    }
+
+    // 创建离屏surface，作为后续的渲染设备
+    if (!m_surface) {
+        m_ownedSurface.reset(new QOffscreenSurface);
+        m_ownedSurface->setFormat(m_context->format());
+        m_ownedSurface->create();
+        m_surface = m_ownedSurface.data();
+    }
+    if(!m_surface->isValid())
+    {
+        qDebug() << "Surface not valid.";
+        m_context.reset();
+        return false;
+    }
+
+    // 将离屏surface关联到opengl上下文，之后一直保持current
+    if(!m_context->makeCurrent(m_surface))
+    {
+        qDebug() << "Can't make context current.";
+        m_context.reset();
+        return false;
+    }
+
+    // 四边形的顶点数据是固定的，只需要上传一次
+    if(!m_vertexBuf.create() || !m_indexBuf.create())
+    {
+        qDebug() << "Can't create vertex/index buffer.";
+        m_context.reset();
+        return false;
+    }
+    m_vertexBuf.bind();
+    m_vertexBuf.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    m_vertexBuf.allocate(quadVertices, sizeof(quadVertices));
+    m_indexBuf.bind();
+    m_indexBuf.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    m_indexBuf.allocate(quadIndices, sizeof(quadIndices));
+
+    return true;
+}
+
+bool OffscreenProcessor::isValid() const
+{
+    return !m_context.isNull();
+}
+
+QImage OffscreenProcessor::process(const QImage &image,
+                                   const QString &vertexShader,
+                                   const QString &fragmentShader,
+                                   const QString &textureVar,
+                                   const QString &vertexPosVar,
+                                   const QString &textureCoordVar)
+{
+    TRACE_SCOPE("process");
+    if (!draw(image, vertexShader, fragmentShader, textureVar, vertexPosVar, textureCoordVar)) {
+        return {};
+    }
+
+    // readpix读取渲染的数据
+    TRACE_SCOPE("readback");
+    return m_fbo->toImage(false);
+}
+
+void OffscreenProcessor::processAsync(const QImage &image,
+                                      const QString &vertexShader,
+                                      const QString &fragmentShader,
+                                      const QString &textureVar,
+                                      const QString &vertexPosVar,
+                                      const QString &textureCoordVar,
+                                      const Callback &done)
+{
+    if (!draw(image, vertexShader, fragmentShader, textureVar, vertexPosVar, textureCoordVar)) {
+        if (done) {
+            done(QImage());
+        }
+        return;
+    }
+
+    // PBO的大小跟着图片尺寸走，尺寸变化时先把旧尺寸的读取交付掉再重建
+    if (!m_readback.isCreated() || m_readback.size() != image.size()) {
+        m_readback.flush();
+        m_readback.create(image.size());
+        // 和toImage(false)一致，保持glReadPixels的行序
+        m_readback.setFlipped(false);
+    }
+
+    m_readback.readback([done](const QImage& result, quint64 frameId) {
+        Q_UNUSED(frameId);
+        if (done) {
+            done(result);
+        }
+    });
+}
+
+int OffscreenProcessor::poll()
+{
+    if (!isValid() || !m_readback.isCreated()) {
+        return 0;
+    }
+    m_context->makeCurrent(m_surface);
+    return m_readback.poll();
+}
+
+void OffscreenProcessor::flush()
+{
+    if (!isValid() || !m_readback.isCreated()) {
+        return;
+    }
+    m_context->makeCurrent(m_surface);
+    m_readback.flush();
+}
+
+AsyncReadback::Stats OffscreenProcessor::readbackStats() const
+{
+    return m_readback.stats();
+}
+
+bool OffscreenProcessor::draw(const QImage &image,
+                              const QString &vertexShader,
+                              const QString &fragmentShader,
+                              const QString &textureVar,
+                              const QString &vertexPosVar,
+                              const QString &textureCoordVar)
+{
+    if (!isValid() || image.isNull()) {
+        return false;
+    }
+
+    if(QOpenGLContext::currentContext() != m_context.data()
+            && !m_context->makeCurrent(m_surface))
+    {
+        qDebug() << "Can't make context current.";
+        return false;
+    }
+
+    if (!prepareTarget(image.size())) {
+        return false;
+    }
+
+    QOpenGLShaderProgram* prog = m_programCache.program(vertexShader, fragmentShader);
+    if (!prog || !prog->bind())
+    {
+        qDebug() << "Can't bind program.";
+        return false;
+    }
+
+    if (!uploadTexture(image)) {
+        return false;
+    }
+
+    m_vertexBuf.bind();
+    m_indexBuf.bind();
+
+    QByteArray posVar = vertexPosVar.toLatin1();
+    QByteArray texCoordVar = textureCoordVar.toLatin1();
+    int offset = 0;
+    prog->enableAttributeArray(posVar.constData());
+    prog->setAttributeBuffer(posVar.constData(), GL_FLOAT, offset, 2, sizeof(VertexData));
+    offset += sizeof(QVector2D);
+    prog->enableAttributeArray(texCoordVar.constData());
+    prog->setAttributeBuffer(texCoordVar.constData(), GL_FLOAT, offset, 2, sizeof(VertexData));
+    prog->setUniformValue(textureVar.toLatin1().constData(), 0);
+
+    {
+        TRACE_SCOPE("draw");
+        m_context->functions()->glDrawElements(GL_TRIANGLE_STRIP, 4, GL_UNSIGNED_INT, Q_NULLPTR);
+    }
+    return true;
+}
+
+bool OffscreenProcessor::prepareTarget(const QSize &size)
+{
+    // 尺寸变化时才重建fbo
+    if (m_fbo.isNull() || m_fbo->size() != size) {
+        m_fbo.reset(new QOpenGLFramebufferObject(size));
+        if (!m_fbo->isValid())
+        {
+            qDebug() << "fbo invalid.";
+            m_fbo.reset();
+            return false;
+        }
+    }
+
+    m_fbo->bind();
+    m_context->functions()->glViewport(0, 0, size.width(), size.height());
+    return true;
+}
+
+bool OffscreenProcessor::uploadTexture(const QImage &image)
+{
+    TRACE_SCOPE("texture upload");
+    // 和QOpenGLTexture::setData(QImage)一样转换成RGBA8888再上传
+    QImage glImage = image.convertToFormat(QImage::Format_RGBA8888);
+
+    // 尺寸变化时才重新分配纹理存储，否则只更新纹理数据
+    if (m_texture.isNull() || m_texture->width() != glImage.width() || m_texture->height() != glImage.height()) {
+        m_texture.reset(new QOpenGLTexture(QOpenGLTexture::Target2D));
+        if (m_context->isOpenGLES() && m_context->format().majorVersion() < 3) {
+            m_texture->setFormat(QOpenGLTexture::RGBAFormat);
+        } else {
+            m_texture->setFormat(QOpenGLTexture::RGBA8_UNorm);
+        }
+        m_texture->setSize(glImage.width(), glImage.height());
+        // 绘制尺寸和图片尺寸一致，不需要mipmap
+        m_texture->setMipLevels(1);
+        m_texture->setMinificationFilter(QOpenGLTexture::Linear);
+        m_texture->setMagnificationFilter(QOpenGLTexture::Linear);
+        m_texture->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8);
+    }
+
+    QOpenGLPixelTransferOptions uploadOptions;
+    uploadOptions.setAlignment(1);
+    m_texture->setData(0, QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, glImage.constBits(), &uploadOptions);
+
+    m_texture->bind(0);
+    if(!m_texture->isBound(0))
+    {
+        qDebug() << "Texture not bound.";
+        return false;
+    }
+    return true;
+}
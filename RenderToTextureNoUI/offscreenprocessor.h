@@ -0,0 +1,109 @@
+#ifndef OFFSCREENPROCESSOR_H
+#define OFFSCREENPROCESSOR_H
+
+#include <functional>
+
+#include <QImage>
+#include <QMutex>
+#include <QScopedPointer>
+#include <QSharedPointer>
+#include <QOpenGLBuffer>
+
+#include "asyncreadback.h"
+#include "programcache.h"
+
+class QOpenGLContext;
+class QOffscreenSurface;
+class QOpenGLFramebufferObject;
+class QOpenGLShaderProgram;
+class QOpenGLTexture;
+
+/*
+ * 常驻的离屏图像处理器
+ * processImage每次调用都会重新创建context/surface/fbo/shader program/texture/vbo/ibo，用完就销毁，
+ * 批量处理图片时这些初始化的开销远大于一次四边形的绘制。
+ * OffscreenProcessor把它们都保留下来：
+ * 1. context和surface只创建一次
+ * 2. 链接好的shader program按照shader源码的hash缓存
+ * 3. 四边形的vbo/ibo只上传一次
+ * 4. fbo和texture在图片尺寸不变时复用
+ * 这样重复调用process()时只剩下纹理上传、绘制和readpix
+ * processAsync()进一步把readpix改为异步的PBO读取，结果在之后的processAsync()/poll()/flush()中交付，
+ * 批量处理时cpu准备下一张图片和gpu处理上一张图片可以重叠
+ *
+ * 注意：opengl context只能在一个线程中current，所以create()/process()/析构都要在同一个线程中调用
+ *
+ * 多个线程并行处理时（见OffscreenRenderPool），每个线程一个OffscreenProcessor，
+ * 它们的context共享同一个shareContext，program各自缓存，共用一个编译锁，shader只编译一次（其余的加载磁盘缓存的binary）；
+ * 这时surface需要提前在gui线程中创建好再传进来
+*/
+class OffscreenProcessor
+{
+public:
+    OffscreenProcessor();
+    // shareContext/surface都不为空：共享context，使用外部创建好的surface（不负责释放），
+    // compileLock为同一个共享组内各个OffscreenProcessor共用的编译锁（见ProgramCache）
+    OffscreenProcessor(QOpenGLContext* shareContext,
+                       QOffscreenSurface* surface,
+                       const QSharedPointer<QMutex>& compileLock);
+    ~OffscreenProcessor();
+
+    // 创建context和surface，并上传四边形的顶点数据
+    bool create();
+    bool isValid() const;
+
+    QImage process(const QImage& image,
+                   const QString& vertexShader,
+                   const QString& fragmentShader,
+                   const QString& textureVar,
+                   const QString& vertexPosVar,
+                   const QString& textureCoordVar);
+
+    typedef std::function<void(const QImage& image)> Callback;
+    // 异步版本的process，done会在之后的processAsync()/poll()/flush()调用中被回调
+    void processAsync(const QImage& image,
+                      const QString& vertexShader,
+                      const QString& fragmentShader,
+                      const QString& textureVar,
+                      const QString& vertexPosVar,
+                      const QString& textureCoordVar,
+                      const Callback& done);
+    // 交付已经完成的异步读取，不阻塞
+    int poll();
+    // 阻塞等待所有异步读取完成
+    void flush();
+    AsyncReadback::Stats readbackStats() const;
+
+private:
+    bool draw(const QImage& image,
+              const QString& vertexShader,
+              const QString& fragmentShader,
+              const QString& textureVar,
+              const QString& vertexPosVar,
+              const QString& textureCoordVar);
+    bool prepareTarget(const QSize& size);
+    bool uploadTexture(const QImage& image);
+
+private:
+    QScopedPointer<QOpenGLContext> m_context;
+    QOpenGLContext* m_shareContext = Q_NULLPTR;
+    // 离屏surface，作为渲染设备
+    QOffscreenSurface* m_surface = Q_NULLPTR;
+    // 自己创建的surface
+    QScopedPointer<QOffscreenSurface> m_ownedSurface;
+    // 尺寸不变时复用
+    QScopedPointer<QOpenGLFramebufferObject> m_fbo;
+    QScopedPointer<QOpenGLTexture> m_texture;
+
+    // 全屏四边形，create()时上传一次
+    QOpenGLBuffer m_vertexBuf {QOpenGLBuffer::VertexBuffer};
+    QOpenGLBuffer m_indexBuf {QOpenGLBuffer::IndexBuffer};
+
+    // 异步读取fbo的PBO环，尺寸变化时重建
+    AsyncReadback m_readback;
+
+    // program属于这个context，只在这个线程中使用
+    ProgramCache m_programCache;
+};
+
+#endif // OFFSCREENPROCESSOR_H
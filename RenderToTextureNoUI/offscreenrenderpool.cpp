@@ -0,0 +1,218 @@
+#include "offscreenrenderpool.h"
+#include "offscreenprocessor.h"
+#include "trace.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
+
+class OffscreenRenderPool::Worker : public QThread
+{
+public:
+    Worker(OffscreenRenderPool* pool, int index, QOffscreenSurface* surface)
+        : m_pool(pool)
+        , m_index(index)
+        , m_surface(surface)
+    {
+    }
+
+protected:
+    void run() override
+    {
+        Trace::setThreadName("render pool worker");
+        // context在工作线程中创建，和根context共享
+        OffscreenProcessor processor(m_pool->m_rootContext.data(), m_surface, m_pool->m_compileLock);
+        const bool valid = processor.create();
+        if (!valid) {
+            qDebug() << "worker" << m_index << "can't create offscreen processor.";
+        }
+
+        for (;;) {
+            Task task;
+            if (!m_pool->take(m_index, task)) {
+                break;
+            }
+
+            QImage result;
+            if (valid) {
+                const Job& job = task.job;
+                result = processor.process(job.image, job.vertexShader, job.fragmentShader,
+                                           job.textureVar, job.vertexPosVar, job.textureCoordVar);
+            }
+            // 先计数再set_value，等待future返回以后调用stats()一定能看到这个任务
+            m_pool->m_queues.at(m_index)->processed.fetchAndAddOrdered(1);
+            task.promise.set_value(result);
+        }
+    }
+
+private:
+    OffscreenRenderPool* m_pool;
+    int m_index;
+    QOffscreenSurface* m_surface;
+};
+
+OffscreenRenderPool::OffscreenRenderPool(int threadCount)
+    : m_threadCount(qMax(threadCount, 1))
+{
+}
+
+OffscreenRenderPool::~OffscreenRenderPool()
+{
+    stop();
+    qDeleteAll(m_queues);
+}
+
+bool OffscreenRenderPool::start()
+{
+    if (!m_workers.isEmpty()) {
+        return true;
+    }
+
+    // 根context只用来作为共享组的成员，本身不做渲染
+    m_rootContext.reset(new QOpenGLContext);
+    if (!m_rootContext->create())
+    {
+        qDebug() << "Can't create root GL context.";
+        return false;
+    }
+
+    m_rootSurface.reset(new QOffscreenSurface);
+    m_rootSurface->setFormat(m_rootContext->format());
+    m_rootSurface->create();
+
+    m_compileLock.reset(new QMutex);
+
+    m_stopping = false;
+    qDeleteAll(m_queues);
+    m_queues.clear();
+    for (int i = 0; i < m_threadCount; i++) {
+        // QOffscreenSurface需要在gui线程创建，创建好以后可以在其他线程中使用
+        QOffscreenSurface* surface = new QOffscreenSurface;
+        surface->setFormat(m_rootContext->format());
+        surface->create();
+        m_surfaces.append(surface);
+        m_queues.append(new WorkQueue);
+    }
+
+    for (int i = 0; i < m_threadCount; i++) {
+        QThread* worker = new Worker(this, i, m_surfaces[i]);
+        m_workers.append(worker);
+        worker->start();
+    }
+
+    return true;
+}
+
+void OffscreenRenderPool::stop()
+{
+    if (m_workers.isEmpty()) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_wakeMutex);
+        m_stopping = true;
+        m_wakeCondition.wakeAll();
+    }
+
+    // 工作线程处理完队列中剩余的任务后退出
+    for (QThread* worker : m_workers) {
+        worker->wait();
+    }
+    qDeleteAll(m_workers);
+    m_workers.clear();
+
+    // 每个工作线程的program已经在它自己的context中释放
+    m_compileLock.reset();
+
+    qDeleteAll(m_surfaces);
+    m_surfaces.clear();
+    m_rootSurface.reset();
+    m_rootContext.reset();
+}
+
+int OffscreenRenderPool::threadCount() const
+{
+    return m_threadCount;
+}
+
+std::future<QImage> OffscreenRenderPool::submit(const Job &job)
+{
+    Task task;
+    task.job = job;
+    std::future<QImage> future = task.promise.get_future();
+
+    if (m_workers.isEmpty()) {
+        qDebug() << "OffscreenRenderPool not started.";
+        task.promise.set_value(QImage());
+        return future;
+    }
+
+    // 轮流放到各个工作线程队列的尾部
+    const int index = int(uint(m_nextQueue.fetchAndAddRelaxed(1)) % uint(m_threadCount));
+    {
+        WorkQueue* queue = m_queues.at(index);
+        QMutexLocker locker(&queue->mutex);
+        queue->tasks.push_back(std::move(task));
+    }
+
+    {
+        QMutexLocker locker(&m_wakeMutex);
+        m_queued.fetchAndAddOrdered(1);
+        m_wakeCondition.wakeOne();
+    }
+
+    return future;
+}
+
+OffscreenRenderPool::Stats OffscreenRenderPool::stats() const
+{
+    Stats stats;
+    for (const WorkQueue* queue : m_queues) {
+        stats.processed.append(queue->processed.loadAcquire());
+        stats.stolen.append(queue->stolen.loadAcquire());
+    }
+    return stats;
+}
+
+bool OffscreenRenderPool::take(int index, Task &task)
+{
+    WorkQueue* own = m_queues.at(index);
+
+    for (;;) {
+        // 优先从自己队列的头部取
+        {
+            QMutexLocker locker(&own->mutex);
+            if (!own->tasks.empty()) {
+                task = std::move(own->tasks.front());
+                own->tasks.pop_front();
+                m_queued.fetchAndAddOrdered(-1);
+                return true;
+            }
+        }
+
+        // 自己的队列空了，从其他线程队列的尾部偷任务
+        for (int i = 1; i < m_threadCount; i++) {
+            WorkQueue* victim = m_queues.at((index + i) % m_threadCount);
+            QMutexLocker locker(&victim->mutex);
+            if (!victim->tasks.empty()) {
+                task = std::move(victim->tasks.back());
+                victim->tasks.pop_back();
+                m_queued.fetchAndAddOrdered(-1);
+                own->stolen.fetchAndAddOrdered(1);
+                return true;
+            }
+        }
+
+        // 所有队列都空了，等待新的任务或者退出
+        QMutexLocker locker(&m_wakeMutex);
+        if (m_queued.load() > 0) {
+            continue;
+        }
+        if (m_stopping) {
+            return false;
+        }
+        m_wakeCondition.wait(&m_wakeMutex);
+    }
+}
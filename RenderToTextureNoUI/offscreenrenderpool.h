@@ -0,0 +1,103 @@
+#ifndef OFFSCREENRENDERPOOL_H
+#define OFFSCREENRENDERPOOL_H
+
+#include <deque>
+#include <future>
+
+#include <QList>
+#include <QImage>
+#include <QMutex>
+#include <QThread>
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QWaitCondition>
+#include <QSharedPointer>
+#include <QScopedPointer>
+
+class QOpenGLContext;
+class QOffscreenSurface;
+
+/*
+ * 多线程并行离屏渲染
+ * N个工作线程，每个线程一个OffscreenProcessor（自己的context，使用gui线程提前创建好的QOffscreenSurface），
+ * 所有工作线程的context都和一个根context共享，共用一个编译锁，同样的shader只编译链接一次（见ProgramCache）
+ *
+ * 任务通过work-stealing队列分发：每个工作线程有自己的双端队列，submit轮流放到各个队列的尾部，
+ * 工作线程从自己队列的头部取任务，自己的队列空了就从其他线程队列的尾部偷任务
+ *
+ * 注意：构造/start/析构都需要在gui线程中调用（QOffscreenSurface的要求）
+*/
+class OffscreenRenderPool
+{
+public:
+    struct Job
+    {
+        QImage image;
+        QString vertexShader;
+        QString fragmentShader;
+        QString textureVar;
+        QString vertexPosVar;
+        QString textureCoordVar;
+    };
+
+    struct Stats
+    {
+        // 每个工作线程处理的任务数和偷来的任务数，
+        // future就绪时对应的任务已经计入processed
+        QList<quint64> processed;
+        QList<quint64> stolen;
+    };
+
+    explicit OffscreenRenderPool(int threadCount = QThread::idealThreadCount());
+    ~OffscreenRenderPool();
+
+    // 创建根context/surface并启动工作线程
+    bool start();
+    // 等待所有任务完成并退出工作线程
+    void stop();
+
+    int threadCount() const;
+    std::future<QImage> submit(const Job& job);
+    // 可以在工作线程运行时调用
+    Stats stats() const;
+
+private:
+    struct Task
+    {
+        Job job;
+        std::promise<QImage> promise;
+    };
+
+    struct WorkQueue
+    {
+        QMutex mutex;
+        std::deque<Task> tasks;
+        // 只由所属的工作线程修改，stats()在其他线程读取
+        QAtomicInteger<quint64> processed;
+        QAtomicInteger<quint64> stolen;
+    };
+
+    class Worker;
+
+    bool take(int index, Task& task);
+
+private:
+    const int m_threadCount;
+
+    QScopedPointer<QOpenGLContext> m_rootContext;
+    QScopedPointer<QOffscreenSurface> m_rootSurface;
+    QList<QOffscreenSurface*> m_surfaces;
+    QSharedPointer<QMutex> m_compileLock;
+
+    QList<WorkQueue*> m_queues;
+    QList<QThread*> m_workers;
+
+    // 所有队列中的任务总数，没有任务时工作线程在m_wakeCondition上休眠
+    QAtomicInt m_queued;
+    QAtomicInt m_nextQueue;
+    QMutex m_wakeMutex;
+    QWaitCondition m_wakeCondition;
+    bool m_stopping = false;
+};
+
+#endif // OFFSCREENRENDERPOOL_H
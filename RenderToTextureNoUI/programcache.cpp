@@ -0,0 +1,53 @@
+#include "programcache.h"
+#include "trace.h"
+#include "shaderlink.h"
+
+#include <QMutexLocker>
+#include <QCryptographicHash>
+#include <QOpenGLShaderProgram>
+
+ProgramCache::ProgramCache(const QSharedPointer<QMutex> &compileLock)
+    : m_compileLock(compileLock)
+{
+}
+
+ProgramCache::~ProgramCache()
+{
+    clear();
+}
+
+QOpenGLShaderProgram *ProgramCache::program(const QString &vertexShader, const QString &fragmentShader)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(vertexShader.toUtf8());
+    // 分隔符，避免两段源码拼接后产生相同的hash
+    hash.addData("\0", 1);
+    hash.addData(fragmentShader.toUtf8());
+    const QByteArray key = hash.result();
+
+    QOpenGLShaderProgram* prog = m_programs.value(key, Q_NULLPTR);
+    if (prog) {
+        return prog;
+    }
+
+    // 其他线程正在编译同样的shader时等它完成，之后从磁盘缓存加载binary，而不是重复编译
+    QMutexLocker locker(m_compileLock.data());
+
+    // 除了内存中的缓存，链接好的program binary还会缓存到磁盘（见shaderlink.h）
+    TRACE_SCOPE("shader compile");
+    prog = new QOpenGLShaderProgram;
+    if (!buildCachedProgram(*prog, vertexShader, fragmentShader, "ProgramCache"))
+    {
+        delete prog;
+        return Q_NULLPTR;
+    }
+
+    m_programs.insert(key, prog);
+    return prog;
+}
+
+void ProgramCache::clear()
+{
+    qDeleteAll(m_programs);
+    m_programs.clear();
+}
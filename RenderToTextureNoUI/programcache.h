@@ -0,0 +1,41 @@
+#ifndef PROGRAMCACHE_H
+#define PROGRAMCACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QSharedPointer>
+
+class QOpenGLShaderProgram;
+
+/*
+ * 链接好的shader program缓存，key为顶点/片段着色器源码的sha1
+ *
+ * 每个context一个ProgramCache，不能跨线程共用：QOpenGLShaderProgram不是线程安全的，
+ * uniform/attribute的设置也保存在program对象上，并且它内部的gl函数表属于创建它的context，
+ * 那个context销毁以后就失效了
+ *
+ * 多个线程（见OffscreenRenderPool）之间共享的只是编译锁：同一时间只有一个线程在编译链接，
+ * 第一个线程链接完成后program binary写入磁盘缓存，其他线程拿到锁时直接加载binary，同样的shader只编译一次
+ * （驱动不支持program binary时每个context各编译一次）
+*/
+class ProgramCache
+{
+public:
+    // compileLock为空时不和其他ProgramCache同步
+    explicit ProgramCache(const QSharedPointer<QMutex>& compileLock = QSharedPointer<QMutex>());
+    // 析构时需要创建program的context是current的
+    ~ProgramCache();
+
+    // 只能在创建program的context current的线程中调用
+    QOpenGLShaderProgram* program(const QString& vertexShader, const QString& fragmentShader);
+    void clear();
+
+private:
+    Q_DISABLE_COPY(ProgramCache)
+
+    QSharedPointer<QMutex> m_compileLock;
+    QHash<QByteArray, QOpenGLShaderProgram*> m_programs;
+};
+
+#endif // PROGRAMCACHE_H
@@ -0,0 +1,404 @@
+#include "stagebench.h"
+
+#include <algorithm>
+
+#include <QFile>
+#include <QDebug>
+#include <QVector2D>
+#include <QTextStream>
+#include <QElapsedTimer>
+
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
+#include <QOpenGLFunctions>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLTimerQuery>
+#include <QOpenGLTexture>
+#include <QOpenGLBuffer>
+
+namespace {
+
+struct Shaders
+{
+    QString vertexShader;
+    QString fragmentShader;
+    QString textureVar;
+    QString vertexPosVar;
+    QString textureCoordVar;
+};
+
+double elapsedMs(const QElapsedTimer& timer)
+{
+    return timer.nsecsElapsed() / 1e6;
+}
+
+double median(QVector<double> samples)
+{
+    if (samples.isEmpty()) {
+        return -1.0;
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+// 每个阶段一个GL_TIME_ELAPSED查询，阶段之间是顺序的，不会嵌套
+class GpuTimer
+{
+public:
+    explicit GpuTimer(QOpenGLContext* context)
+    {
+#if !defined(QT_OPENGL_ES_2)
+        m_enabled = !context->isOpenGLES()
+                && (context->format().version() >= qMakePair(3, 3) || context->hasExtension("GL_ARB_timer_query"));
+        for (int i = 0; i < StageBench::StageCount && m_enabled; i++) {
+            m_enabled = m_queries[i].create();
+        }
+#else
+        Q_UNUSED(context);
+#endif
+    }
+
+    void begin(StageBench::Stage stage)
+    {
+#if !defined(QT_OPENGL_ES_2)
+        if (m_enabled) {
+            m_queries[stage].begin();
+        }
+#else
+        Q_UNUSED(stage);
+#endif
+    }
+
+    void end(StageBench::Stage stage)
+    {
+#if !defined(QT_OPENGL_ES_2)
+        if (m_enabled) {
+            m_queries[stage].end();
+        }
+#else
+        Q_UNUSED(stage);
+#endif
+    }
+
+    // 读取结果并释放查询对象，需要在context销毁之前调用
+    void collect(const QList<StageBench::Stage>& stages, double* gpuMs)
+    {
+#if !defined(QT_OPENGL_ES_2)
+        if (m_enabled) {
+            for (StageBench::Stage stage : stages) {
+                gpuMs[stage] = m_queries[stage].waitForResult() / 1e6;
+            }
+        }
+        for (QOpenGLTimerQuery& query : m_queries) {
+            query.destroy();
+        }
+#else
+        Q_UNUSED(stages);
+        Q_UNUSED(gpuMs);
+#endif
+    }
+
+private:
+    bool m_enabled = false;
+#if !defined(QT_OPENGL_ES_2)
+    QOpenGLTimerQuery m_queries[StageBench::StageCount];
+#endif
+};
+
+// processImage的步骤，逐个阶段计时，没有计时的阶段为-1
+bool measure(const QImage& image, const Shaders& shaders, double* cpuMs, double* gpuMs)
+{
+    for (int i = 0; i < StageBench::StageCount; i++) {
+        cpuMs[i] = -1.0;
+        gpuMs[i] = -1.0;
+    }
+    QElapsedTimer timer;
+
+    timer.start();
+    QOpenGLContext context;
+    if(!context.create())
+    {
+        qDebug() << "Can't create GL context.";
+        return false;
+    }
+    cpuMs[StageBench::Context] = elapsedMs(timer);
+
+    timer.start();
+    QOffscreenSurface surface;
+    surface.setFormat(context.format());
+    surface.create();
+    if(!surface.isValid() || !context.makeCurrent(&surface))
+    {
+        qDebug() << "Can't make context current.";
+        return false;
+    }
+    cpuMs[StageBench::Surface] = elapsedMs(timer);
+
+    QOpenGLFunctions* f = context.functions();
+    GLint maxSize = 0;
+    f->glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    if (image.width() > maxSize || image.height() > maxSize) {
+        qDebug() << "image size" << image.size() << "not supported, max texture size" << maxSize;
+        return false;
+    }
+    GpuTimer gpu(&context);
+
+    gpu.begin(StageBench::Fbo);
+    timer.start();
+    QOpenGLFramebufferObject fbo(image.size());
+    f->glViewport(0, 0, image.width(), image.height());
+    gpu.end(StageBench::Fbo);
+    f->glFinish();
+    cpuMs[StageBench::Fbo] = elapsedMs(timer);
+
+    gpu.begin(StageBench::Program);
+    timer.start();
+    QOpenGLShaderProgram program(&context);
+    if (!program.addCacheableShaderFromSourceCode(QOpenGLShader::Vertex, shaders.vertexShader)
+            || !program.addCacheableShaderFromSourceCode(QOpenGLShader::Fragment, shaders.fragmentShader)
+            || !program.link() || !program.bind())
+    {
+        qDebug() << "Can't build program:" << program.log();
+        gpu.end(StageBench::Program);
+        gpu.collect({}, gpuMs);
+        return false;
+    }
+    gpu.end(StageBench::Program);
+    f->glFinish();
+    cpuMs[StageBench::Program] = elapsedMs(timer);
+
+    gpu.begin(StageBench::Upload);
+    timer.start();
+    QOpenGLTexture texture(QOpenGLTexture::Target2D);
+    texture.setData(image);
+    texture.bind();
+    gpu.end(StageBench::Upload);
+    f->glFinish();
+    cpuMs[StageBench::Upload] = elapsedMs(timer);
+
+    struct VertexData
+    {
+        QVector2D position;
+        QVector2D texCoord;
+    };
+
+    const VertexData vertices[] =
+    {
+        {{ -1.0f, +1.0f }, { 0.0f, 1.0f }}, // top-left
+        {{ +1.0f, +1.0f }, { 1.0f, 1.0f }}, // top-right
+        {{ -1.0f, -1.0f }, { 0.0f, 0.0f }}, // bottom-left
+        {{ +1.0f, -1.0f }, { 1.0f, 0.0f }}  // bottom-right
+    };
+
+    const GLuint indices[] =
+    {
+        0, 1, 2, 3
+    };
+
+    gpu.begin(StageBench::Draw);
+    timer.start();
+    QOpenGLBuffer vertexBuf(QOpenGLBuffer::VertexBuffer);
+    QOpenGLBuffer indexBuf(QOpenGLBuffer::IndexBuffer);
+    vertexBuf.create();
+    vertexBuf.bind();
+    vertexBuf.allocate(vertices, sizeof(vertices));
+    indexBuf.create();
+    indexBuf.bind();
+    indexBuf.allocate(indices, sizeof(indices));
+
+    const QByteArray posVar = shaders.vertexPosVar.toLatin1();
+    const QByteArray texCoordVar = shaders.textureCoordVar.toLatin1();
+    program.enableAttributeArray(posVar.constData());
+    program.setAttributeBuffer(posVar.constData(), GL_FLOAT, 0, 2, sizeof(VertexData));
+    program.enableAttributeArray(texCoordVar.constData());
+    program.setAttributeBuffer(texCoordVar.constData(), GL_FLOAT, sizeof(QVector2D), 2, sizeof(VertexData));
+    program.setUniformValue(shaders.textureVar.toLatin1().constData(), 0);
+    f->glDrawElements(GL_TRIANGLE_STRIP, 4, GL_UNSIGNED_INT, Q_NULLPTR);
+    gpu.end(StageBench::Draw);
+    f->glFinish();
+    cpuMs[StageBench::Draw] = elapsedMs(timer);
+
+    gpu.begin(StageBench::Readback);
+    timer.start();
+    const QImage result = fbo.toImage(false);
+    gpu.end(StageBench::Readback);
+    cpuMs[StageBench::Readback] = elapsedMs(timer);
+
+    gpu.collect({StageBench::Fbo, StageBench::Program, StageBench::Upload, StageBench::Draw, StageBench::Readback},
+                gpuMs);
+    return !result.isNull();
+}
+
+// 带宽按RGBA8计算，单位MB/s
+double bandwidth(int size, double ms)
+{
+    return ms > 0.0 ? double(size) * size * 4 / (ms * 1e3) : 0.0;
+}
+
+}
+
+StageBench::Options StageBench::parse(const QStringList &args)
+{
+    Options options;
+    int index = args.indexOf("--stage-bench");
+    if (index >= 0) {
+        const int iterations = args.value(index + 1).toInt();
+        options.iterations = iterations > 0 ? iterations : 5;
+    }
+    index = args.indexOf("--stage-bench-sizes");
+    if (index >= 0) {
+        QList<int> sizes;
+        for (const QString& size : args.value(index + 1).split(',')) {
+            if (size.toInt() > 0) {
+                sizes.append(size.toInt());
+            }
+        }
+        if (!sizes.isEmpty()) {
+            options.sizes = sizes;
+        }
+    }
+    index = args.indexOf("--stage-bench-csv");
+    if (index >= 0 && !args.value(index + 1).isEmpty()) {
+        options.csv = args.value(index + 1);
+    }
+    return options;
+}
+
+QVector<StageBench::Result> StageBench::run(const Options &options, const QImage &source,
+                                            const QString &vertexShader, const QString &fragmentShader,
+                                            const QString &textureVar, const QString &vertexPosVar,
+                                            const QString &textureCoordVar)
+{
+    const Shaders shaders {vertexShader, fragmentShader, textureVar, vertexPosVar, textureCoordVar};
+    QVector<Result> results;
+
+    for (int size : options.sizes) {
+        // 缩放不计时，每个尺寸只做一次
+        const QImage scaled = source.scaled(size, size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        for (QImage::Format format : options.formats) {
+            const QImage image = scaled.convertToFormat(format);
+            QVector<double> cpuSamples[StageCount];
+            QVector<double> gpuSamples[StageCount];
+            bool ok = true;
+            for (int i = 0; i < options.iterations && ok; i++) {
+                double cpuMs[StageCount];
+                double gpuMs[StageCount];
+                ok = measure(image, shaders, cpuMs, gpuMs);
+                for (int stage = 0; stage < StageCount && ok; stage++) {
+                    if (cpuMs[stage] >= 0.0) {
+                        cpuSamples[stage].append(cpuMs[stage]);
+                    }
+                    if (gpuMs[stage] >= 0.0) {
+                        gpuSamples[stage].append(gpuMs[stage]);
+                    }
+                }
+            }
+            if (!ok) {
+                qDebug() << "stage bench: skip" << size << formatName(format);
+                continue;
+            }
+
+            Result result;
+            result.size = size;
+            result.format = format;
+            for (int stage = 0; stage < StageCount; stage++) {
+                result.cpuMs[stage] = median(cpuSamples[stage]);
+                result.gpuMs[stage] = median(gpuSamples[stage]);
+            }
+            results.append(result);
+        }
+    }
+    return results;
+}
+
+void StageBench::print(const QVector<Result> &results)
+{
+    // 每个阶段一列"cpu/gpu"，没有gpu时间时只有cpu
+    QString header = QString::asprintf("%-6s %-11s", "size", "format");
+    for (int stage = 0; stage < StageCount; stage++) {
+        header += QString::asprintf(" %15s", stageName(Stage(stage)));
+    }
+    header += QString::asprintf(" %12s %12s", "upload MB/s", "readbk MB/s");
+    qDebug().noquote() << "stage bench: median ms, cpu/gpu";
+    qDebug().noquote() << header;
+
+    for (const Result& result : results) {
+        QString line = QString::asprintf("%-6d %-11s", result.size, formatName(result.format));
+        for (int stage = 0; stage < StageCount; stage++) {
+            const QString cell = result.gpuMs[stage] >= 0.0
+                    ? QString::asprintf("%.2f/%.2f", result.cpuMs[stage], result.gpuMs[stage])
+                    : QString::asprintf("%.2f", result.cpuMs[stage]);
+            line += QString::asprintf(" %15s", qPrintable(cell));
+        }
+        line += QString::asprintf(" %12.0f %12.0f",
+                                  bandwidth(result.size, result.cpuMs[Upload]),
+                                  bandwidth(result.size, result.cpuMs[Readback]));
+        qDebug().noquote() << line;
+    }
+}
+
+bool StageBench::writeCsv(const QVector<Result> &results, const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        qDebug() << "stage bench: can't write" << path << file.errorString();
+        return false;
+    }
+    QTextStream out(&file);
+    out << "size,format,stage,cpu_ms,gpu_ms,mb_per_s\n";
+    for (const Result& result : results) {
+        for (int stage = 0; stage < StageCount; stage++) {
+            out << result.size << ',' << formatName(result.format) << ',' << stageName(Stage(stage)) << ','
+                << result.cpuMs[stage] << ',';
+            if (result.gpuMs[stage] >= 0.0) {
+                out << result.gpuMs[stage];
+            }
+            out << ',';
+            if (stage == Upload || stage == Readback) {
+                out << bandwidth(result.size, result.cpuMs[stage]);
+            }
+            out << '\n';
+        }
+    }
+    qDebug() << "stage bench: csv" << path;
+    return true;
+}
+
+const char *StageBench::stageName(Stage stage)
+{
+    switch (stage) {
+    case Context:
+        return "context";
+    case Surface:
+        return "surface";
+    case Fbo:
+        return "fbo";
+    case Program:
+        return "program";
+    case Upload:
+        return "upload";
+    case Draw:
+        return "draw";
+    case Readback:
+        return "readback";
+    default:
+        return "";
+    }
+}
+
+const char *StageBench::formatName(QImage::Format format)
+{
+    switch (format) {
+    case QImage::Format_ARGB32:
+        return "ARGB32";
+    case QImage::Format_RGBA8888:
+        return "RGBA8888";
+    case QImage::Format_RGB888:
+        return "RGB888";
+    case QImage::Format_Grayscale8:
+        return "Grayscale8";
+    default:
+        return "other";
+    }
+}
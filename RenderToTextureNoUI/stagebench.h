@@ -0,0 +1,81 @@
+#ifndef STAGEBENCH_H
+#define STAGEBENCH_H
+
+#include <QList>
+#include <QImage>
+#include <QString>
+#include <QVector>
+#include <QStringList>
+
+/*
+ * processImage的分阶段耗时：按processImage的步骤逐个计时，找出每次调用的时间花在哪里
+ *   context   QOpenGLContext::create()
+ *   surface   QOffscreenSurface::create() + makeCurrent
+ *   fbo       QOpenGLFramebufferObject分配
+ *   program   addCacheableShaderFromSourceCode + link（第一次之后命中program binary磁盘缓存）
+ *   upload    QOpenGLTexture::setData(image)（包括转换为RGBA8888和生成mipmap）
+ *   draw      vbo/ibo创建上传、设置顶点属性、glDrawElements
+ *   readback  fbo.toImage(false)
+ *
+ * 图片尺寸从256x256到8192x8192，格式ARGB32/RGBA8888/RGB888/Grayscale8，每个组合跑N次取中位数
+ * 每个gl阶段结束时glFinish，cpu时间包括gpu执行完的时间（否则绘制的耗时都会算到readback里）；
+ * gpu时间是每个阶段的GL_TIME_ELAPSED查询（QOpenGLTimerQuery），需要gl 3.3或者ARB_timer_query，gles上没有
+ * context/surface不是gl命令，只有cpu时间
+ *
+ * upload/readback的带宽按RGBA8（每像素4字节）计算，结果输出为表格和csv（每行一个尺寸、格式、阶段）
+ *
+ * 注意：需要在gui线程中调用（QOffscreenSurface的要求）
+*/
+class StageBench
+{
+public:
+    enum Stage {
+        Context,
+        Surface,
+        Fbo,
+        Program,
+        Upload,
+        Draw,
+        Readback,
+        StageCount
+    };
+
+    struct Options
+    {
+        // 0表示没有--stage-bench
+        int iterations = 0;
+        QList<int> sizes {256, 512, 1024, 2048, 4096, 8192};
+        QList<QImage::Format> formats {QImage::Format_ARGB32, QImage::Format_RGBA8888,
+                                       QImage::Format_RGB888, QImage::Format_Grayscale8};
+        QString csv {"stagebench.csv"};
+    };
+
+    struct Result
+    {
+        int size = 0;
+        QImage::Format format = QImage::Format_Invalid;
+        // 中位数，单位ms，没有gpu时间时为-1
+        double cpuMs[StageCount];
+        double gpuMs[StageCount];
+    };
+
+    /*
+     * --stage-bench N              每个组合跑N次（默认5）
+     * --stage-bench-sizes 256,1024 只测试这些边长
+     * --stage-bench-csv FILE       csv输出路径，默认stagebench.csv
+    */
+    static Options parse(const QStringList& args);
+
+    static QVector<Result> run(const Options& options, const QImage& source,
+                               const QString& vertexShader, const QString& fragmentShader,
+                               const QString& textureVar, const QString& vertexPosVar,
+                               const QString& textureCoordVar);
+
+    static void print(const QVector<Result>& results);
+    static bool writeCsv(const QVector<Result>& results, const QString& path);
+
+    static const char* stageName(Stage stage);
+    static const char* formatName(QImage::Format format);
+};
+
+#endif // STAGEBENCH_H
@@ -0,0 +1,22 @@
+#include "widget.h"
+#include "framebench.h"
+
+#include <QApplication>
+
+int main(int argc, char *argv[])
+{
+    QSurfaceFormat format = QSurfaceFormat::defaultFormat();
+    format.setProfile(QSurfaceFormat::CoreProfile);
+    format.setVersion(3, 3);
+    QSurfaceFormat::setDefaultFormat(format);
+
+    QApplication a(argc, argv);
+    Widget w;
+    // --frame-bench N：不显示窗口，离屏渲染N帧，输出cpu/gpu帧时间统计后退出（见common/framebench.h）
+    const FrameBench::Options bench = FrameBench::parse(a.arguments());
+    if (bench.frames > 0) {
+        return FrameBench::run(&w, bench);
+    }
+    w.show();
+    return a.exec();
+}
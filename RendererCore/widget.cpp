@@ -0,0 +1,95 @@
+#include "widget.h"
+
+#include <QDebug>
+
+// 每行（列）的四边形数量，每帧gridSize * gridSize次绘制调用
+static const int gridSize = 32;
+
+Widget::Widget(QWidget *parent) :
+    QOpenGLWidget(parent)
+{
+    resize(800, 800);
+
+    connect(&m_titleTimer, &QTimer::timeout, this, &Widget::updateTitle);
+    m_titleTimer.start(1000);
+}
+
+Widget::~Widget()
+{
+    makeCurrent();
+    if (m_gl33Renderer) {
+        m_gl33Grid.destroy(*m_gl33Renderer);
+    }
+    if (m_gles2Renderer) {
+        m_gles2Grid.destroy(*m_gles2Renderer);
+    }
+    m_hud.destroy();
+    doneCurrent();
+}
+
+void Widget::initializeGL()
+{
+    qDebug() << "format:" << context()->format();
+
+    // QOpenGLExtraFunctions包含gles3/gl 3.3的glGenVertexArrays等函数，gles2 context上不会用到
+    const bool ok = context()->isOpenGLES() ? create(m_gles2Renderer, m_gles2Grid)
+                                            : create(m_gl33Renderer, m_gl33Grid);
+    if (!ok) {
+        m_gl33Renderer.reset();
+        m_gles2Renderer.reset();
+    }
+    m_hud.initialize(this);
+    m_time.start();
+}
+
+void Widget::paintGL()
+{
+    // 统计这一帧的cpu/gpu耗时，作用域结束（包括提前return）时绘制HUD
+    FrameHud::Frame hudFrame(m_hud);
+
+    QElapsedTimer timer;
+    timer.start();
+    if (m_gl33Renderer) {
+        render(*m_gl33Renderer, m_gl33Grid);
+        m_backend = GL33Renderer::backendName();
+    } else if (m_gles2Renderer) {
+        render(*m_gles2Renderer, m_gles2Grid);
+        m_backend = Gles2Renderer::backendName();
+    }
+
+    // cpu提交绘制调用的耗时，不包括gpu的执行时间
+    m_submitNs += timer.nsecsElapsed();
+    m_submitFrames++;
+    update();
+}
+
+void Widget::updateTitle()
+{
+    if (m_submitFrames == 0) {
+        return;
+    }
+    setWindowTitle(QString("%1 %2 draws, cpu %3 ms").arg(m_backend).arg(gridSize * gridSize)
+                   .arg(m_submitNs / 1e6 / m_submitFrames, 0, 'f', 2));
+    m_submitNs = 0;
+    m_submitFrames = 0;
+}
+
+template<typename Renderer>
+bool Widget::create(std::unique_ptr<Renderer>& renderer, QuadGrid<Renderer>& grid)
+{
+    renderer.reset(new Renderer(context()->extraFunctions()));
+    std::string log;
+    if (!grid.create(*renderer, gridSize, &log)) {
+        qDebug() << Renderer::backendName() << "create failed:" << log.c_str();
+        return false;
+    }
+    qDebug() << "backend:" << Renderer::backendName();
+    return true;
+}
+
+template<typename Renderer>
+void Widget::render(Renderer& renderer, QuadGrid<Renderer>& grid)
+{
+    grid.render(renderer, defaultFramebufferObject(), int(width() * devicePixelRatioF()),
+                int(height() * devicePixelRatioF()), m_time.elapsed() / 1000.0f);
+}
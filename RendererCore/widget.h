@@ -0,0 +1,61 @@
+#ifndef WIDGET_H
+#define WIDGET_H
+
+#include <QOpenGLWidget>
+#include <QOpenGLExtraFunctions>
+#include <QElapsedTimer>
+#include <QTimer>
+
+#include <memory>
+
+#include "glbackends.h"
+#include "quadgrid.h"
+#include "framehud.h"
+
+/*
+ * 使用RendererCore绘制QuadGrid（和headless-egl-cmake/renderer-bench相同的负载）：
+ * desktop gl使用GL33Backend，gles（例如windows上的ANGLE）使用Gles2Backend，
+ * 两个后端都在编译期实例化，运行时按context的类型选择其中一个
+*/
+class Widget : public QOpenGLWidget
+{
+    Q_OBJECT
+
+public:
+    explicit Widget(QWidget *parent = nullptr);
+    ~Widget();
+
+protected:
+    virtual void initializeGL() override;
+    virtual void paintGL() override;
+
+private:
+    typedef RendererCore<GL33Backend<QOpenGLExtraFunctions>> GL33Renderer;
+    typedef RendererCore<Gles2Backend<QOpenGLExtraFunctions>> Gles2Renderer;
+
+    template<typename Renderer>
+    bool create(std::unique_ptr<Renderer>& renderer, QuadGrid<Renderer>& grid);
+    template<typename Renderer>
+    void render(Renderer& renderer, QuadGrid<Renderer>& grid);
+    // 标题栏显示上一秒平均每帧的cpu提交耗时
+    void updateTitle();
+
+    std::unique_ptr<GL33Renderer> m_gl33Renderer;
+    QuadGrid<GL33Renderer> m_gl33Grid;
+    std::unique_ptr<Gles2Renderer> m_gles2Renderer;
+    QuadGrid<Gles2Renderer> m_gles2Grid;
+
+    QElapsedTimer m_time;
+
+    // 每帧只累加cpu提交耗时，标题栏由m_titleTimer每秒更新一次，
+    // setWindowTitle不在paintGL中调用，不计入两个后端的对比
+    QTimer m_titleTimer;
+    const char* m_backend = "none";
+    qint64 m_submitNs = 0;
+    int m_submitFrames = 0;
+
+    // 帧统计HUD：FRAME_HUD=1时显示，默认关闭
+    FrameHud m_hud;
+};
+
+#endif // WIDGET_H
@@ -1,6 +1,8 @@
 #include "widget.h"
+#include "framebench.h"
 
 #include <QApplication>
+#include <QDebug>
 
 int main(int argc, char *argv[])
 {
@@ -11,6 +13,44 @@ int main(int argc, char *argv[])
 
     QApplication a(argc, argv);
     Widget w;
+    // 命令行参数：
+    // --cubes N：立方体数量（10 ~ 1000000）
+    // --instanced：使用实例化绘制
+    // --bench-frames N：连续绘制N帧，输出平均cpu帧耗时和每帧draw call数量后退出
+    // --no-cull：关闭视锥体剔除
+    // --cull-backend scalar|sse|avx：指定视锥体剔除的实现，默认为cpu支持的最快实现
+    // --frame-skip：自适应跳帧，paintGL超过一个刷新周期时跳过整数个刷新周期
+    const QStringList args = a.arguments();
+    int index = args.indexOf("--cubes");
+    if (index >= 0) {
+        w.setCubeCount(args.value(index + 1).toInt());
+    }
+    w.setInstanced(args.contains("--instanced"));
+    index = args.indexOf("--bench-frames");
+    if (index >= 0) {
+        w.setBenchmarkFrames(args.value(index + 1).toInt());
+    }
+    w.setCulling(!args.contains("--no-cull"));
+    index = args.indexOf("--cull-backend");
+    if (index >= 0) {
+        const QString backend = args.value(index + 1).toLower();
+        if (backend == "avx") {
+            w.setCullingBackend(FrustumCuller::AVX);
+        } else if (backend == "sse") {
+            w.setCullingBackend(FrustumCuller::SSE);
+        } else if (backend == "scalar") {
+            w.setCullingBackend(FrustumCuller::Scalar);
+        } else {
+            qDebug() << "unknown cull backend:" << args.value(index + 1) << "usage: --cull-backend scalar|sse|avx";
+            return 1;
+        }
+    }
+    w.setAdaptiveFrameSkip(args.contains("--frame-skip"));
+    // --frame-bench N：不显示窗口，离屏渲染N帧，输出cpu/gpu帧时间统计后退出（见common/framebench.h）
+    const FrameBench::Options bench = FrameBench::parse(a.arguments());
+    if (bench.frames > 0) {
+        return FrameBench::run(&w, bench);
+    }
     w.show();
     return a.exec();
 }
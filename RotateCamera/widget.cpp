@@ -1,10 +1,17 @@
 #include "widget.h"
 #include "ui_widget.h"
+#include "asynclog.h"
+#include "shaderlink.h"
+#include "shaderdefines.h"
+#include "meshoptimizer.h"
+#include "simdmath.h"
 
 #include <cmath>
+#include <random>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QImage>
-#include <QTimer>
+#include <QCoreApplication>
 /*
  * 通过调节观察矩阵，来调节我们的观看角度（camera）
  * opengl中camera原理参考这里 https://learnopengl-cn.github.io/01%20Getting%20started/09%20Camera/
@@ -19,6 +26,9 @@ float vertices[] = {
 };
 */
 
+// 立方体的旋转轴，归一化以及旋转矩阵中用到的分量乘积在编译期算好
+constexpr RotationAxis cubeRotationAxis(1.0f, 0.3f, 0.5f);
+
 // 36个顶点（6个面 x 每个面有2个三角形组成 x 每个三角形有3个顶点）
 float vertices[] = {
     -0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
@@ -64,11 +74,6 @@ float vertices[] = {
     -0.5f,  0.5f, -0.5f,  0.0f, 1.0f
 };
 
-unsigned int indices[] = { // 注意索引从0开始!
-                           0, 1, 3, // 第一个三角形
-                           1, 2, 3  // 第二个三角形
-                         };
-
 const char* vertexShaderSource = R"(#version 330 core
                                  layout (location = 0) in vec3 aPos; // 来自cpu的顶点坐标
                                  layout (location = 1) in vec2 aTexCoord; // 来自cpu的纹理坐标
@@ -88,6 +93,9 @@ const char* vertexShaderSource = R"(#version 330 core
                                  TexCoord = vec2(aTexCoord.x, 1.0 - aTexCoord.y);
                                  })";
 
+// 第二张图片的混合比例，以MIX_FACTOR注入片段着色器
+const double mixFactor = 0.2;
+
 const char* fragmentShaderSource = R"(#version 330 core
                                    out vec4 FragColor;
 
@@ -99,42 +107,160 @@ const char* fragmentShaderSource = R"(#version 330 core
                                    void main()
                                    {
                                    // 混合纹理坐标/纹理数据/颜色
-                                   FragColor = mix(texture(texture1, TexCoord), texture(texture2, TexCoord), 0.2);
+                                   FragColor = mix(texture(texture1, TexCoord), texture(texture2, TexCoord), MIX_FACTOR);
                                    } )";
 
+// 实例化绘制的顶点着色器：模型矩阵不再是uniform，而是每个实例一份的顶点属性
+const char* instancedVertexShaderSource = R"(#version 330 core
+                                          layout (location = 0) in vec3 aPos; // 来自cpu的顶点坐标
+                                          layout (location = 1) in vec2 aTexCoord; // 来自cpu的纹理坐标
+                                          // 每个实例的模型矩阵，mat4占用2~5四个location（每个location一列）
+                                          layout (location = 2) in mat4 aModel;
+                                          uniform mat4 view;
+                                          uniform mat4 projection;
+
+                                          out vec2 TexCoord;
+
+                                          void main()
+                                          {
+                                          gl_Position = projection * view * aModel * vec4(aPos.x, aPos.y, aPos.z, 1.0);
+                                          TexCoord = vec2(aTexCoord.x, 1.0 - aTexCoord.y);
+                                          })";
+
 Widget::Widget(QWidget *parent) :
     QOpenGLWidget(parent),
     ui(new Ui::Widget)
 {
     ui->setupUi(this);
+
+    // 图片解码完成后重绘，paintGL中上传到纹理
+    connect(&m_textureLoader, &TextureLoader::textureDecoded, this, QOverload<>::of(&Widget::update));
+    m_frameScheduler.start();
+
+    connect(&m_titleTimer, &QTimer::timeout, this, &Widget::showFrameStats);
+    m_titleTimer.start(1000);
 }
 
 Widget::~Widget()
 {
     makeCurrent();
     m_vbo.destroy();
+    m_instanceVbo.destroy();
+    m_hud.destroy();
     doneCurrent();
 
     delete ui;
 }
 
+void Widget::setCubeCount(int count)
+{
+    m_cubeCount = qMax(count, 1);
+}
+
+void Widget::setInstanced(bool instanced)
+{
+    m_instanced = instanced;
+}
+
+void Widget::setBenchmarkFrames(int frames)
+{
+    m_benchmarkFrames = frames;
+}
+
+void Widget::setCulling(bool culling)
+{
+    m_culling = culling;
+}
+
+void Widget::setCullingBackend(FrustumCuller::Backend backend)
+{
+    m_culler.setBackend(backend);
+}
+
+void Widget::setAdaptiveFrameSkip(bool enabled)
+{
+    m_frameScheduler.setAdaptiveFrameSkip(enabled);
+}
+
+void Widget::buildBoxPositions()
+{
+    // 构造10个立方体的位置
+    const QVector3D fixedPositions[] = {
+        QVector3D(0.0f,  0.0f,  0.0f),
+        QVector3D(2.0f,  5.0f, -15.0f),
+        QVector3D(-1.5f, -2.2f, -2.5f),
+        QVector3D(-3.8f, -2.0f, -12.3f),
+        QVector3D(2.4f, -0.4f, -3.5f),
+        QVector3D(-1.7f,  3.0f, -7.5f),
+        QVector3D(1.3f, -2.0f, -2.5f),
+        QVector3D(1.5f,  2.0f, -2.5f),
+        QVector3D(1.5f,  0.2f, -1.5f),
+        QVector3D(-1.3f,  1.0f, -1.5f)
+    };
+
+    m_boxPositions.clear();
+    m_boxPositions.reserve(m_cubeCount);
+    for (int i = 0; i < m_cubeCount && i < 10; i++) {
+        m_boxPositions.push_back(fixedPositions[i]);
+    }
+
+    // 多出来的立方体随机分布在一个立方体区域内，区域边长随数量增长，保持密度大致不变
+    // 固定随机种子，每次运行的场景一致，方便对比
+    const float halfExtent = std::cbrt(float(m_cubeCount)) * 1.5f;
+    std::mt19937 rng(20201010);
+    std::uniform_real_distribution<float> dist(-halfExtent, halfExtent);
+    while (m_boxPositions.size() < m_cubeCount) {
+        m_boxPositions.push_back(QVector3D(dist(rng), dist(rng), dist(rng)));
+    }
+
+    m_fieldRadius = 0.0f;
+    for (const QVector3D& position : m_boxPositions) {
+        m_fieldRadius = qMax(m_fieldRadius, position.length());
+    }
+
+    // 批量计算模型矩阵用的连续数据：每个立方体的平移(x, y, z)和初始旋转角度
+    m_boxTranslations.resize(m_boxPositions.size() * 3);
+    m_boxAngles.resize(m_boxPositions.size());
+    for (int i = 0; i < m_boxPositions.size(); i++) {
+        m_boxTranslations[i * 3] = m_boxPositions[i].x();
+        m_boxTranslations[i * 3 + 1] = m_boxPositions[i].y();
+        m_boxTranslations[i * 3 + 2] = m_boxPositions[i].z();
+        m_boxAngles[i] = 20.0f * i;
+    }
+
+    // 立方体边长为1并且每帧都在旋转，包围盒取外接球的包围盒（半边长为sqrt(3)/2），旋转后不需要更新
+    const float boxHalfExtent = std::sqrt(3.0f) * 0.5f;
+    m_culler.clear();
+    m_culler.reserve(m_boxPositions.size());
+    for (const QVector3D& position : m_boxPositions) {
+        m_culler.addBox(position.x(), position.y(), position.z(), boxHalfExtent, boxHalfExtent, boxHalfExtent);
+    }
+}
+
+void Widget::cullBoxes(const QMatrix4x4 &viewProjection)
+{
+    if (!m_culling) {
+        m_visibleBoxes.resize(m_boxPositions.size());
+        for (int i = 0; i < m_boxPositions.size(); i++) {
+            m_visibleBoxes[i] = i;
+        }
+        return;
+    }
+
+    // QMatrix4x4内部是列主序
+    m_culler.setFrustum(viewProjection.constData());
+    m_culler.cull(m_visibleBoxes);
+}
+
 void Widget::initializeGL()
 {
     qDebug() << "format:" << context()->format();
 
     initializeOpenGLFunctions();
+    m_hud.initialize(this);
+    m_stateCache.initialize();
 
-    // 构造10个立方体的位置
-    m_boxPositions.push_back(QVector3D(0.0f,  0.0f,  0.0f));
-    m_boxPositions.push_back(QVector3D(2.0f,  5.0f, -15.0f));
-    m_boxPositions.push_back(QVector3D(-1.5f, -2.2f, -2.5f));
-    m_boxPositions.push_back(QVector3D(-3.8f, -2.0f, -12.3f));
-    m_boxPositions.push_back(QVector3D(2.4f, -0.4f, -3.5f));
-    m_boxPositions.push_back(QVector3D(-1.7f,  3.0f, -7.5f));
-    m_boxPositions.push_back(QVector3D(1.3f, -2.0f, -2.5f));
-    m_boxPositions.push_back(QVector3D(1.5f,  2.0f, -2.5f));
-    m_boxPositions.push_back(QVector3D(1.5f,  0.2f, -1.5f));
-    m_boxPositions.push_back(QVector3D(-1.3f,  1.0f, -1.5f));
+    buildBoxPositions();
 
     // 启动z缓冲，绘制3d立体场景需要
     glEnable(GL_DEPTH_TEST);
@@ -149,21 +275,29 @@ void Widget::initializeGL()
     // vao也会保存ebo
     m_vao.bind();
 
+    // 立方体网格预处理：合并重复顶点生成索引，再按照vertex cache和顶点读取的局部性重排
+    MeshStats before;
+    MeshStats after;
+    const IndexedMesh mesh = MeshOptimizer::optimize(vertices, int(sizeof(vertices) / sizeof(float) / 5), 5, &before, &after);
+    m_indexCount = int(mesh.indices.size());
+    qDebug() << "cube mesh: vertices" << before.vertexCount << "->" << after.vertexCount
+             << "ACMR" << before.acmr << "->" << after.acmr
+             << "vertex fetch bytes" << before.fetchBytes << "->" << after.fetchBytes;
+
     // vbo初始化
     m_vbo.create();
     m_vbo.bind();
     m_vbo.setUsagePattern(QOpenGLBuffer::StaticDraw);
-    m_vbo.allocate(vertices, sizeof(vertices));
+    m_vbo.allocate(mesh.vertices.data(), int(mesh.vertices.size() * sizeof(float)));
 
     // ebo初始化
     m_ebo.create();
     m_ebo.bind();
-    m_ebo.allocate(indices, sizeof(indices));
+    m_ebo.allocate(mesh.indices.data(), int(mesh.indices.size() * sizeof(unsigned int)));
 
     // 编译着色器
-    m_shaderProgram.addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShaderSource);
-    m_shaderProgram.addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShaderSource);
-    m_shaderProgram.link();
+    const QString fragmentShader = QString::fromStdString(ShaderDefines().set("MIX_FACTOR", mixFactor).inject(fragmentShaderSource));
+    buildCachedProgram(m_shaderProgram, vertexShaderSource, fragmentShader, "RotateCamera");
     m_shaderProgram.bind();
 
     // 指定顶点坐标在vbo中的访问方式
@@ -193,7 +327,7 @@ void Widget::initializeGL()
     // 设置纹理缩放时的策略
     m_texture.setMinificationFilter(QOpenGLTexture::Linear);
     m_texture.setMagnificationFilter(QOpenGLTexture::Linear);
-    m_texture.setData(QImage(":/wall.jpg"));
+    m_textureLoader.load(m_texture, ":/wall.jpg");
 
     // 设置st方向上纹理超出坐标时的显示策略
     m_texture2.setWrapMode(QOpenGLTexture::DirectionS, QOpenGLTexture::ClampToEdge);
@@ -201,14 +335,55 @@ void Widget::initializeGL()
     // 设置纹理缩放时的策略
     m_texture2.setMinificationFilter(QOpenGLTexture::Linear);
     m_texture2.setMagnificationFilter(QOpenGLTexture::Linear);
-    m_texture2.setData(QImage(":/face.png"));
+    m_textureLoader.load(m_texture2, ":/face.png");
 
     // 图片是rgba8888格式，注意这里的参数GL_RGBA8/GL_RGBA
     //glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, wall.width(), wall.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, wall.bits());
 
     m_vao.release();
 
-    qDebug() << m_shaderProgram.log();
+    ALOG("{}", m_shaderProgram.log());
+
+    // 实例化绘制：立方体的顶点数据复用m_vbo，每个实例的模型矩阵放在m_instanceVbo中
+    m_instancedVao.create();
+    m_instancedVao.bind();
+
+    if (!buildCachedProgram(m_instancedShaderProgram, instancedVertexShaderSource, fragmentShader, "RotateCamera instanced")) {
+        // 实例化的program不可用时退回到逐个立方体绘制
+        ALOG("instanced program unavailable, falling back to loop drawing: {}", m_instancedShaderProgram.log());
+        m_instancedVao.release();
+        m_instanced = false;
+        return;
+    }
+    m_instancedShaderProgram.bind();
+
+    m_vbo.bind();
+    // ebo的绑定也保存在vao上
+    m_ebo.bind();
+    m_instancedShaderProgram.setAttributeBuffer(0, GL_FLOAT, 0 * sizeof(float), 3, 5 * sizeof(float));
+    m_instancedShaderProgram.enableAttributeArray(0);
+    m_instancedShaderProgram.setAttributeBuffer(1, GL_FLOAT, 3 * sizeof(float), 2, 5 * sizeof(float));
+    m_instancedShaderProgram.enableAttributeArray(1);
+
+    // 每帧都会重新上传所有模型矩阵
+    m_instanceVbo.create();
+    m_instanceVbo.bind();
+    m_instanceVbo.setUsagePattern(QOpenGLBuffer::StreamDraw);
+    for (int i = 0; i < 4; i++) {
+        // mat4属性按列拆成4个vec4属性，步幅为一个矩阵（16个float）
+        m_instancedShaderProgram.setAttributeBuffer(2 + i, GL_FLOAT, i * 4 * sizeof(float), 4, 16 * sizeof(float));
+        m_instancedShaderProgram.enableAttributeArray(2 + i);
+        // divisor为1：每绘制一个实例才前进一次，而不是每个顶点前进一次
+        glVertexAttribDivisor(2 + i, 1);
+    }
+
+    m_instancedShaderProgram.setUniformValue("texture1", 0);
+    m_instancedShaderProgram.setUniformValue("texture2", 1);
+    m_instancedViewMatrix = m_instancedShaderProgram.uniformLocation("view");
+    m_instancedProjectionMatrix = m_instancedShaderProgram.uniformLocation("projection");
+
+    m_instancedVao.release();
+    m_instancedShaderProgram.release();
 }
 
 void Widget::resizeGL(int w, int h)
@@ -219,62 +394,171 @@ void Widget::resizeGL(int w, int h)
 
 void Widget::paintGL()
 {
-    // 每隔100ms刷新一次
-    static int count = 0;
-    QTimer::singleShot(100, this, [this](){
-        count += 1;
-        update();
-    });
-
-    // 激活纹理单元0
-    glActiveTexture(GL_TEXTURE0);
-    // 绑定纹理到纹理单元0
-    m_texture.bind();
-    glActiveTexture(GL_TEXTURE1);
-    m_texture2.bind();
+    // 统计这一帧的cpu/gpu耗时，作用域结束（包括提前return）时绘制HUD
+    FrameHud::Frame hudFrame(m_hud);
+
+    // 上传已经解码好的图片（在绑定纹理之前）
+    m_textureLoader.uploadReady();
+
+    QElapsedTimer frameTimer;
+    frameTimer.start();
+
+    // 动画时间按单调时钟推进，每秒前进10（相机10弧度，立方体10度），和帧率无关
+    // 每帧swap完成后由m_frameScheduler请求下一帧（benchmark时也一样，帧率受垂直同步限制，不影响cpu帧耗时的统计）
+    m_frameScheduler.beginFrame();
+    const float time = float(m_frameScheduler.time() * 10.0);
+
+    // 下面的bind都通过m_stateCache完成，和当前状态相同的调用会被跳过
+    m_stateCache.beginFrame();
+
+    // 激活纹理单元0，绑定纹理到纹理单元0
+    m_stateCache.bindTexture(0, m_texture);
+    m_stateCache.bindTexture(1, m_texture2);
 
+    int drawCalls = m_instanced ? drawInstanced(time) : drawLoop(time);
+
+    m_frameScheduler.endFrame();
+    benchmarkFrame(frameTimer.nsecsElapsed(), drawCalls);
+
+    m_textureLoader.frameDone();
+}
+
+int Widget::drawLoop(float time)
+{
     // 我们这里只有一个shaderProgram和vao，其实没有必要重复bind和release
-    // 这里只是为了教学，在多个shaderProgram的情况下，这是标准操作
-    m_shaderProgram.bind();
+    // 这里只是为了教学，在多个shaderProgram的情况下，这是标准操作（重复的bind会被m_stateCache跳过）
+    m_stateCache.useProgram(m_shaderProgram);
 
     // 视图矩阵：将世界坐标转换为观察坐标
-    QMatrix4x4 viewMatri;    
-    // 让相机在一个圆上旋转
-    float radius = 10.0f;
-    float camX = sin(count) * radius;
-    float camZ = cos(count) * radius;
+    QMatrix4x4 viewMatri;
+    // 让相机在一个圆上旋转，立方体多的时候半径随场景变大
+    float radius = qMax(10.0f, m_fieldRadius * 2.0f);
+    float camX = sin(time) * radius;
+    float camZ = cos(time) * radius;
     // 摄像机位置，一个目标位置和一个表示世界空间中的上向量的向量（我们计算右向量使用的那个上向量，详细原理介绍 https://learnopengl-cn.github.io/01%20Getting%20started/09%20Camera/
     viewMatri.lookAt(QVector3D(camX, 0.0, camZ), QVector3D(0.0, 0.0, 0.0), QVector3D(0.0, 1.0, 0.0));
 
     // 投影矩阵：将观察坐标转换为投影坐标
     QMatrix4x4 projectionMatri;
     // 这里透视投影中有对下面参数的介绍：https://learnopengl-cn.github.io/01%20Getting%20started/08%20Coordinate%20Systems/#3d
-    projectionMatri.perspective(45.0f, width()/height(), 0.1f, 100.0f);
+    projectionMatri.perspective(45.0f, width()/height(), 0.1f, qMax(100.0f, radius + m_fieldRadius + 1.0f));
 
-    m_shaderProgram.bind();
+    m_stateCache.useProgram(m_shaderProgram);
     // 更新变化矩阵的数据到gpu顶点着色器的采样器中
     m_shaderProgram.setUniformValue(m_viewMatrix, viewMatri);
     m_shaderProgram.setUniformValue(m_projectionMatrix, projectionMatri);
 
-    m_vao.bind();
+    // 剔除视锥体外的立方体，不在屏幕上的立方体不需要设置uniform和提交draw call
+    cullBoxes(projectionMatri * viewMatri);
+
+    // 模型矩阵：将局部坐标转换为世界坐标（先旋转一定角度，再移动到指定位置）
+    // 所有可见立方体的模型矩阵一次批量算好，等价于每个立方体 modelMatri.translate(pos); modelMatri.rotate(20.0f * i + time, 1.0f, 0.3f, 0.5f);
+    const int visibleCount = int(m_visibleBoxes.size());
+    m_modelMatrices.resize(visibleCount * 16);
+    SimdMath::translateRotate(m_boxTranslations.data(), m_boxAngles.data(), time,
+                              m_visibleBoxes.data(), visibleCount, cubeRotationAxis, m_modelMatrices.data());
 
-    // 在不同位置绘制10个立方体
-    for(unsigned int i = 0; i < 10; i++) {
-        // 模型矩阵：将局部坐标转换为世界坐标
-        QMatrix4x4 modelMatri;
-        // 移动到指定位置
-        modelMatri.translate(m_boxPositions[i]);
-        // 旋转一定角度
-        float angle = 20.0f * i + count;
-        modelMatri.rotate(angle, 1.0f, 0.3f, 0.5f);
+    m_stateCache.bindVertexArray(m_vao);
 
-        m_shaderProgram.setUniformValue(m_modelMatrix, modelMatri);
+    // 在不同位置绘制多个立方体
+    for (int n = 0; n < visibleCount; n++) {
+        // 矩阵已经是列主序的16个float，直接传给着色器
+        glUniformMatrix4fv(m_modelMatrix, 1, GL_FALSE, m_modelMatrices.data() + n * 16);
 
         // 绘制一个立方体
-        // glDrawArrays不使用顶点索引
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        // glDrawElements根据ebo中的索引去vbo中找顶点，重复的顶点只需要变换一次
+        glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, 0);
     }
 
-    m_vao.release();
-    m_shaderProgram.release();
+    return int(m_visibleBoxes.size());
+}
+
+int Widget::drawInstanced(float time)
+{
+    QMatrix4x4 viewMatri;
+    float radius = qMax(10.0f, m_fieldRadius * 2.0f);
+    viewMatri.lookAt(QVector3D(sin(time) * radius, 0.0, cos(time) * radius), QVector3D(0.0, 0.0, 0.0), QVector3D(0.0, 1.0, 0.0));
+
+    QMatrix4x4 projectionMatri;
+    projectionMatri.perspective(45.0f, width()/height(), 0.1f, qMax(100.0f, radius + m_fieldRadius + 1.0f));
+
+    // 只有可见的立方体写入实例数据，需要上传的数据量也随之减少
+    cullBoxes(projectionMatri * viewMatri);
+
+    // 批量计算所有可见立方体的模型矩阵，按列主序连续写入实例数据
+    // 旋转角度仍然使用立方体原来的序号，剔除不影响画面
+    const int instanceCount = int(m_visibleBoxes.size());
+    m_instanceData.resize(instanceCount * 16);
+    GLfloat* data = m_instanceData.data();
+    SimdMath::translateRotate(m_boxTranslations.data(), m_boxAngles.data(), time,
+                              m_visibleBoxes.data(), instanceCount, cubeRotationAxis, data);
+
+    m_stateCache.useProgram(m_instancedShaderProgram);
+    m_instancedShaderProgram.setUniformValue(m_instancedViewMatrix, viewMatri);
+    m_instancedShaderProgram.setUniformValue(m_instancedProjectionMatrix, projectionMatri);
+
+    if (instanceCount == 0) {
+        return 0;
+    }
+
+    m_stateCache.bindVertexArray(m_instancedVao);
+    m_instanceVbo.bind();
+    // 重新分配缓冲（orphan），驱动不需要等待上一帧对旧数据的使用
+    m_instanceVbo.allocate(data, instanceCount * 16 * sizeof(GLfloat));
+
+    // 一次绘制所有立方体
+    glDrawElementsInstanced(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, 0, instanceCount);
+
+    return 1;
+}
+
+void Widget::benchmarkFrame(qint64 cpuTimeNs, int drawCalls)
+{
+    if (m_benchmarkFrames <= 0) {
+        return;
+    }
+
+    m_frameCount++;
+    m_cpuTimeNs += cpuTimeNs;
+    m_drawCalls += drawCalls;
+    m_visibleTotal += qint64(m_visibleBoxes.size());
+    m_cullTimeUs += m_culling ? m_culler.stats().cullTimeUs : 0.0;
+    m_stateIssued += m_stateCache.currentFrame().totalIssued();
+    m_stateSkipped += m_stateCache.currentFrame().totalSkipped();
+
+    if (m_frameCount == m_benchmarkFrames) {
+        // cpu帧耗时只包含paintGL中cpu侧的计算和提交，不包含gpu执行时间
+        qDebug() << "cubes:" << m_boxPositions.size()
+                 << "mode:" << (m_instanced ? "instanced" : "loop")
+                 << "frames:" << m_frameCount
+                 << "cpu frame time:" << m_cpuTimeNs / 1e6 / m_frameCount << "ms"
+                 << "draw calls/frame:" << double(m_drawCalls) / m_frameCount;
+        const double visible = double(m_visibleTotal) / m_frameCount;
+        qDebug() << "culling:" << (m_culling ? FrustumCuller::backendName(m_culler.backend()) : "off")
+                 << "visible/frame:" << visible
+                 << "culled/frame:" << m_boxPositions.size() - visible
+                 << "cull time:" << m_cullTimeUs / m_frameCount << "us";
+        qDebug() << "gl state calls/frame issued:" << double(m_stateIssued) / m_frameCount
+                 << "skipped:" << double(m_stateSkipped) / m_frameCount;
+        qDebug() << "frame pacing:" << qPrintable(m_frameScheduler.stats().summary());
+        QCoreApplication::quit();
+    }
+}
+
+void Widget::showFrameStats()
+{
+    if (m_benchmarkFrames > 0) {
+        return;
+    }
+
+    // 最近一帧的剔除结果、gl状态调用次数和帧间隔抖动显示在标题栏上
+    QString title = m_stateCache.currentFrame().summary() + " | " + m_frameScheduler.stats().summary();
+    if (m_culling) {
+        const FrustumCuller::Stats& stats = m_culler.stats();
+        title = QString("visible %1 / culled %2 / cull %3 us (%4) | ")
+                .arg(stats.visible).arg(stats.culled)
+                .arg(stats.cullTimeUs, 0, 'f', 1)
+                .arg(FrustumCuller::backendName(m_culler.backend())) + title;
+    }
+    setWindowTitle(title);
 }
@@ -2,17 +2,28 @@
 #define WIDGET_H
 
 #include <QOpenGLWidget>
-#include <QOpenGLFunctions>
+#include <QOpenGLExtraFunctions>
 #include <QOpenGLBuffer>
 #include <QOpenGLVertexArrayObject>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLTexture>
+#include <QTimer>
+
+#include <vector>
+
+#include "framescheduler.h"
+#include "frustumculler.h"
+#include "glstatecache.h"
+#include "simdmath.h"
+#include "textureloader.h"
+#include "framehud.h"
 
 namespace Ui {
 class Widget;
 }
 
-class Widget : public QOpenGLWidget, protected QOpenGLFunctions
+// QOpenGLExtraFunctions包含实例化绘制需要的glVertexAttribDivisor/glDrawArraysInstanced
+class Widget : public QOpenGLWidget, protected QOpenGLExtraFunctions
 {
     Q_OBJECT
 
@@ -20,11 +31,36 @@ public:
     explicit Widget(QWidget *parent = nullptr);
     ~Widget();
 
+    // 以下设置需要在show之前调用
+    // 立方体数量，前10个位置固定，多出来的随机分布
+    void setCubeCount(int count);
+    // 实例化绘制：所有立方体一次glDrawArraysInstanced画完
+    void setInstanced(bool instanced);
+    // 大于0时连续绘制frames帧，输出平均cpu帧耗时和draw call数量后退出
+    void setBenchmarkFrames(int frames);
+    // 视锥体剔除：只绘制包围盒和视锥体相交的立方体，默认开启
+    void setCulling(bool culling);
+    void setCullingBackend(FrustumCuller::Backend backend);
+    // 自适应跳帧：paintGL超过一个刷新周期时跳过整数个刷新周期，默认关闭
+    void setAdaptiveFrameSkip(bool enabled);
+
 protected:
     virtual void initializeGL() override;
     virtual void resizeGL(int w, int h) override;
     virtual void paintGL() override;
 
+private:
+    void buildBoxPositions();
+    // 用 投影矩阵*观察矩阵 剔除视锥体外的立方体，结果保存在m_visibleBoxes中
+    void cullBoxes(const QMatrix4x4& viewProjection);
+    // 每个立方体单独设置模型矩阵并绘制
+    int drawLoop(float time);
+    // 模型矩阵写入实例缓冲，一次绘制所有立方体
+    int drawInstanced(float time);
+    void benchmarkFrame(qint64 cpuTimeNs, int drawCalls);
+    // 标题栏显示最近一帧的剔除结果和gl状态调用次数，由m_titleTimer每秒调用一次
+    void showFrameStats();
+
 private:
     Ui::Widget *ui;
 
@@ -34,6 +70,8 @@ private:
     QOpenGLBuffer m_vbo; // 默认即为VertexBuffer(GL_ARRAY_BUFFER)类型
     // 索引缓冲对象(Element Buffer Object，EBO或Index Buffer Object，IBO)，用来缓存顶点坐标的索引
     QOpenGLBuffer m_ebo {QOpenGLBuffer::IndexBuffer};
+    // ebo中的索引数量
+    int m_indexCount = 0;
 
     // 着色器程序：编译链接着色器
     QOpenGLShaderProgram m_shaderProgram;
@@ -49,6 +87,54 @@ private:
 
     // 多个立方体的位置
     QVector<QVector3D> m_boxPositions;
+    int m_cubeCount = 10;
+    // 所有立方体到原点的最大距离，用来调整相机半径和远平面
+    float m_fieldRadius = 0.0f;
+    // 批量计算模型矩阵的输入：每个立方体3个float的平移，以及初始旋转角度
+    std::vector<float> m_boxTranslations;
+    std::vector<float> m_boxAngles;
+    // 逐个绘制时每帧计算好的模型矩阵（每个可见立方体16个float）
+    std::vector<float> m_modelMatrices;
+
+    // 视锥体剔除相关
+    bool m_culling = true;
+    FrustumCuller m_culler;
+    // 本帧需要绘制的立方体序号
+    std::vector<int> m_visibleBoxes;
+
+    // gl状态缓存，跳过重复的bind和状态设置
+    GLStateCache m_stateCache;
+
+    // 动画帧调度：按时间推进相机和立方体的动画，每帧swap完成后请求下一帧
+    FrameScheduler m_frameScheduler {this};
+    // setWindowTitle要同步访问窗口系统，不放在paintGL中
+    QTimer m_titleTimer;
+
+    // 实例化绘制相关
+    bool m_instanced = false;
+    QOpenGLVertexArrayObject m_instancedVao;
+    // 每个实例一个模型矩阵（16个float）
+    QOpenGLBuffer m_instanceVbo;
+    QVector<GLfloat> m_instanceData;
+    QOpenGLShaderProgram m_instancedShaderProgram;
+    int m_instancedViewMatrix = 0;
+    int m_instancedProjectionMatrix = 0;
+
+    // benchmark统计
+    int m_benchmarkFrames = 0;
+    int m_frameCount = 0;
+    qint64 m_cpuTimeNs = 0;
+    qint64 m_drawCalls = 0;
+    qint64 m_visibleTotal = 0;
+    double m_cullTimeUs = 0.0;
+    qint64 m_stateIssued = 0;
+    qint64 m_stateSkipped = 0;
+
+    // 纹理异步加载：图片在线程池中解码，解码完成前使用占位纹理
+    TextureLoader m_textureLoader;
+
+    // 帧统计HUD：FRAME_HUD=1时显示，默认关闭
+    FrameHud m_hud;
 };
 
 #endif // WIDGET_H
@@ -27,3 +27,9 @@ RESOURCES += \
     res.qrc
 
 DISTFILES +=
+
+include(../common/asynclog.pri)
+include(../common/shaderlink.pri)
+include(../common/textureloader.pri)
+include(../common/framebench.pri)
+include(../common/framehud.pri)
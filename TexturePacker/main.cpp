@@ -0,0 +1,180 @@
+#include "texturepack.h"
+
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <QFile>
+#include <QImage>
+#include <QFileInfo>
+#include <QByteArray>
+#include <QStringList>
+#include <QCoreApplication>
+
+/*
+ * 离线生成纹理包（格式见common/texturepack.h）：
+ *   TexturePacker [--no-mips] -o textures.tpk ../Texture/wall.jpg ../MultiTexture/face.png ...
+ *
+ * 每张图片解码并转换为RGBA8，用2x2盒式滤波生成完整的mipmap链（和glGenerateMipmap的效果接近），
+ * 运行时设置环境变量TEXTURE_PACK=textures.tpk，TextureLoader按文件名从纹理包中加载
+*/
+
+namespace {
+
+struct Texture
+{
+    QString name;
+    TexturePack::Entry entry;
+    std::vector<QByteArray> levels;
+};
+
+quint64 align(quint64 value)
+{
+    return (value + TexturePack::DataAlignment - 1) / TexturePack::DataAlignment * TexturePack::DataAlignment;
+}
+
+// 2x2盒式滤波缩小一半，奇数尺寸时最后一行/列重复采样
+QByteArray downsample(const QByteArray& source, int width, int height)
+{
+    const int w = qMax(width >> 1, 1);
+    const int h = qMax(height >> 1, 1);
+    QByteArray result(w * h * 4, Qt::Uninitialized);
+    const uchar* src = reinterpret_cast<const uchar*>(source.constData());
+    uchar* dst = reinterpret_cast<uchar*>(result.data());
+    for (int y = 0; y < h; y++) {
+        const int y0 = qMin(y * 2, height - 1);
+        const int y1 = qMin(y * 2 + 1, height - 1);
+        for (int x = 0; x < w; x++) {
+            const int x0 = qMin(x * 2, width - 1);
+            const int x1 = qMin(x * 2 + 1, width - 1);
+            for (int c = 0; c < 4; c++) {
+                const int sum = src[(y0 * width + x0) * 4 + c] + src[(y0 * width + x1) * 4 + c]
+                        + src[(y1 * width + x0) * 4 + c] + src[(y1 * width + x1) * 4 + c];
+                dst[(y * w + x) * 4 + c] = uchar((sum + 2) / 4);
+            }
+        }
+    }
+    return result;
+}
+
+bool loadTexture(const QString& path, bool mips, Texture& texture)
+{
+    QImage image(path);
+    if (image.isNull()) {
+        fprintf(stderr, "can't load %s\n", qPrintable(path));
+        return false;
+    }
+    // 和QOpenGLTexture::setData(QImage)一样转换为RGBA8888，行顺序不变
+    image = image.convertToFormat(QImage::Format_RGBA8888);
+
+    texture.name = QFileInfo(path).fileName();
+    const QByteArray name = texture.name.toUtf8();
+    if (name.size() >= TexturePack::NameSize) {
+        fprintf(stderr, "name too long: %s\n", name.constData());
+        return false;
+    }
+
+    TexturePack::Entry& entry = texture.entry;
+    memset(&entry, 0, sizeof(entry));
+    memcpy(entry.name, name.constData(), size_t(name.size()));
+    entry.width = quint32(image.width());
+    entry.height = quint32(image.height());
+    entry.format = TexturePack::RGBA8;
+
+    // 去掉QImage每行末尾的对齐填充
+    QByteArray level(image.width() * image.height() * 4, Qt::Uninitialized);
+    const int rowBytes = image.width() * 4;
+    for (int y = 0; y < image.height(); y++) {
+        memcpy(level.data() + y * rowBytes, image.constScanLine(y), size_t(rowBytes));
+    }
+    texture.levels.push_back(level);
+
+    int width = image.width();
+    int height = image.height();
+    while (mips && (width > 1 || height > 1) && texture.levels.size() < TexturePack::MaxMipLevels) {
+        texture.levels.push_back(downsample(texture.levels.back(), width, height));
+        width = qMax(width >> 1, 1);
+        height = qMax(height >> 1, 1);
+    }
+    entry.mipCount = quint32(texture.levels.size());
+    return true;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QStringList args = a.arguments();
+    args.removeFirst();
+    const bool mips = !args.removeAll("--no-mips");
+    QString output;
+    const int index = args.indexOf("-o");
+    if (index >= 0 && index + 1 < args.size()) {
+        output = args.at(index + 1);
+        args.removeAt(index + 1);
+        args.removeAt(index);
+    }
+    if (output.isEmpty() || args.isEmpty()) {
+        fprintf(stderr, "usage: TexturePacker [--no-mips] -o output.tpk image...\n");
+        return 1;
+    }
+
+    std::vector<Texture> textures;
+    QStringList names;
+    for (const QString& path : args) {
+        Texture texture;
+        if (!loadTexture(path, mips, texture)) {
+            return 1;
+        }
+        // 运行时按文件名查找，不能重复
+        if (names.contains(texture.name)) {
+            fprintf(stderr, "duplicate name: %s\n", qPrintable(texture.name));
+            return 1;
+        }
+        names.append(texture.name);
+        textures.push_back(texture);
+    }
+
+    // 先计算所有mip层级的偏移，索引写在文件开头
+    quint64 offset = sizeof(TexturePack::Header) + textures.size() * sizeof(TexturePack::Entry);
+    for (Texture& texture : textures) {
+        for (size_t level = 0; level < texture.levels.size(); level++) {
+            offset = align(offset);
+            texture.entry.mipOffset[level] = offset;
+            texture.entry.mipSize[level] = quint64(texture.levels[level].size());
+            offset += texture.entry.mipSize[level];
+        }
+    }
+
+    QFile file(output);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        fprintf(stderr, "can't write %s: %s\n", qPrintable(output), qPrintable(file.errorString()));
+        return 1;
+    }
+
+    TexturePack::Header header;
+    memcpy(header.magic, TexturePack::magic(), 4);
+    header.version = TexturePack::Version;
+    header.textureCount = quint32(textures.size());
+    header.reserved = 0;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const Texture& texture : textures) {
+        file.write(reinterpret_cast<const char*>(&texture.entry), sizeof(texture.entry));
+    }
+    for (const Texture& texture : textures) {
+        for (size_t level = 0; level < texture.levels.size(); level++) {
+            // 对齐填充
+            file.write(QByteArray(int(texture.entry.mipOffset[level] - quint64(file.pos())), '\0'));
+            file.write(texture.levels[level]);
+        }
+        printf("%-24s %5u x %-5u mips %2u\n", qPrintable(texture.name),
+               texture.entry.width, texture.entry.height, texture.entry.mipCount);
+    }
+    if (file.error() != QFileDevice::NoError) {
+        fprintf(stderr, "write failed: %s\n", qPrintable(file.errorString()));
+        return 1;
+    }
+    printf("%s: %d textures %lld bytes\n", qPrintable(output), int(textures.size()), static_cast<long long>(file.pos()));
+    return 0;
+}
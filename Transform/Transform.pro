@@ -25,3 +25,11 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 
 RESOURCES += \
     res.qrc
+
+include(../common/framescheduler.pri)
+include(../common/asynclog.pri)
+include(../common/shaderlink.pri)
+include(../common/shaderdefines.pri)
+include(../common/textureloader.pri)
+include(../common/framebench.pri)
+include(../common/framehud.pri)
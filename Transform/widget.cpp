@@ -1,9 +1,11 @@
 #include "widget.h"
 #include "ui_widget.h"
+#include "asynclog.h"
+#include "shaderlink.h"
+#include "shaderdefines.h"
 
 #include <QDebug>
 #include <QImage>
-#include <QTimer>
 /*
  * 通过变换矩阵来移动/缩放/旋转顶点坐标
  * 主要使用线性代数的矩阵转换原理
@@ -42,6 +44,9 @@ const char* vertexShaderSource = R"(#version 330 core
                                  TexCoord = vec2(aTexCoord.x, 1.0 - aTexCoord.y);
                                  })";
 
+// 第二张图片的混合比例，以MIX_FACTOR注入片段着色器
+const double mixFactor = 0.2;
+
 const char* fragmentShaderSource = R"(#version 330 core
                                    out vec4 FragColor;
 
@@ -54,7 +59,7 @@ const char* fragmentShaderSource = R"(#version 330 core
                                    void main()
                                    {
                                    // 混合纹理坐标/纹理数据/颜色
-                                   FragColor = mix(texture(texture1, TexCoord), texture(texture2, TexCoord), 0.2);
+                                   FragColor = mix(texture(texture1, TexCoord), texture(texture2, TexCoord), MIX_FACTOR);
                                    } )";
 
 Widget::Widget(QWidget *parent) :
@@ -62,12 +67,20 @@ Widget::Widget(QWidget *parent) :
     ui(new Ui::Widget)
 {
     ui->setupUi(this);
+
+    // 图片解码完成后重绘，paintGL中上传到纹理
+    connect(&m_textureLoader, &TextureLoader::textureDecoded, this, QOverload<>::of(&Widget::update));
+    m_frameScheduler.start();
+
+    connect(&m_titleTimer, &QTimer::timeout, this, &Widget::updateTitle);
+    m_titleTimer.start(1000);
 }
 
 Widget::~Widget()
 {
     makeCurrent();
     m_vbo.destroy();
+    m_hud.destroy();
     doneCurrent();
 
     delete ui;
@@ -78,6 +91,7 @@ void Widget::initializeGL()
     qDebug() << "format:" << context()->format();
 
     initializeOpenGLFunctions();
+    m_hud.initialize(this);
     // 黑色背景
     glClearColor(0.0f, 1.0f, 0.0f, 1.0f);
 
@@ -99,9 +113,8 @@ void Widget::initializeGL()
     m_ebo.allocate(indices, sizeof(indices));
 
     // 编译着色器
-    m_shaderProgram.addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShaderSource);
-    m_shaderProgram.addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShaderSource);
-    m_shaderProgram.link();
+    const QString fragmentShader = QString::fromStdString(ShaderDefines().set("MIX_FACTOR", mixFactor).inject(fragmentShaderSource));
+    buildCachedProgram(m_shaderProgram, vertexShaderSource, fragmentShader, "Transform");
     m_shaderProgram.bind();
 
     // 指定顶点坐标在vbo中的访问方式
@@ -132,7 +145,7 @@ void Widget::initializeGL()
     // 设置纹理缩放时的策略
     m_texture.setMinificationFilter(QOpenGLTexture::Linear);
     m_texture.setMagnificationFilter(QOpenGLTexture::Linear);
-    m_texture.setData(QImage(":/wall.jpg"));
+    m_textureLoader.load(m_texture, ":/wall.jpg");
 
     // 设置st方向上纹理超出坐标时的显示策略
     m_texture2.setWrapMode(QOpenGLTexture::DirectionS, QOpenGLTexture::ClampToEdge);
@@ -140,13 +153,13 @@ void Widget::initializeGL()
     // 设置纹理缩放时的策略
     m_texture2.setMinificationFilter(QOpenGLTexture::Linear);
     m_texture2.setMagnificationFilter(QOpenGLTexture::Linear);
-    m_texture2.setData(QImage(":/face.png"));
+    m_textureLoader.load(m_texture2, ":/face.png");
 
     // 图片是rgba8888格式，注意这里的参数GL_RGBA8/GL_RGBA
     //glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, wall.width(), wall.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, wall.bits());
 
     m_vao.release();
-    qDebug() << m_shaderProgram.log();
+    ALOG("{}", m_shaderProgram.log());
 }
 
 void Widget::resizeGL(int w, int h)
@@ -157,12 +170,15 @@ void Widget::resizeGL(int w, int h)
 
 void Widget::paintGL()
 {
-    // 每隔100ms刷新一次
-    static int count = 0;
-    QTimer::singleShot(100, this, [this](){
-        count += 1;
-        update();
-    });
+    // 统计这一帧的cpu/gpu耗时，作用域结束（包括提前return）时绘制HUD
+    FrameHud::Frame hudFrame(m_hud);
+
+    // 上传已经解码好的图片（在绑定纹理之前）
+    m_textureLoader.uploadReady();
+
+    // 动画时间按单调时钟推进，每秒旋转10度，和帧率无关
+    m_frameScheduler.beginFrame();
+    const float angle = float(m_frameScheduler.time() * 10.0);
 
     // 激活纹理单元0
     glActiveTexture(GL_TEXTURE0);
@@ -177,8 +193,8 @@ void Widget::paintGL()
     QMatrix4x4 modelview;
     // 移动（现移动再旋转和先旋转再移动效果是不一样的）
     modelview.translate(0.5f, -0.5f, 0.0f);
-    // 旋转（垂直于z轴的面逆时针旋转conut角度）
-    modelview.rotate(count, 0.0f, 0.0f, 1.0f);
+    // 旋转（垂直于z轴的面逆时针旋转angle角度）
+    modelview.rotate(angle, 0.0f, 0.0f, 1.0f);
     //modelview.rotate(90.0f, 0.0f, 0.0f, 1.0f);
     // 缩放
     modelview.scale(0.5f);
@@ -192,4 +208,14 @@ void Widget::paintGL()
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
     m_vao.release();
     m_shaderProgram.release();
+
+    m_frameScheduler.endFrame();
+
+    m_textureLoader.frameDone();
+}
+
+void Widget::updateTitle()
+{
+    // 帧率和帧间隔抖动显示在标题栏上
+    setWindowTitle(m_frameScheduler.stats().summary());
 }
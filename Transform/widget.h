@@ -7,6 +7,11 @@
 #include <QOpenGLVertexArrayObject>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLTexture>
+#include <QTimer>
+
+#include "framescheduler.h"
+#include "textureloader.h"
+#include "framehud.h"
 
 namespace Ui {
 class Widget;
@@ -25,6 +30,9 @@ protected:
     virtual void resizeGL(int w, int h) override;
     virtual void paintGL() override;
 
+private:
+    void updateTitle();
+
 private:
     Ui::Widget *ui;
 
@@ -44,6 +52,17 @@ private:
 
     // 向顶点着色器传递数据的矩阵
     int m_matrixUniform = 0;
+
+    // 动画帧调度：按时间推进旋转角度，每帧swap完成后请求下一帧
+    FrameScheduler m_frameScheduler {this};
+    // 标题栏的统计每秒更新一次：setWindowTitle要同步访问窗口系统，不放在paintGL中
+    QTimer m_titleTimer;
+
+    // 纹理异步加载：图片在线程池中解码，解码完成前使用占位纹理
+    TextureLoader m_textureLoader;
+
+    // 帧统计HUD：FRAME_HUD=1时显示，默认关闭
+    FrameHud m_hud;
 };
 
 #endif // WIDGET_H
@@ -0,0 +1,339 @@
+#include "asynclog.h"
+
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <condition_variable>
+
+namespace {
+
+// 每个线程的环形缓冲可以容纳的记录数（2的幂），64字节一条，共256KB
+const uint32_t kRingCapacity = 4096;
+// 后台线程的输出间隔
+const int kDrainIntervalMs = 5;
+
+// 单生产者（写日志的线程）单消费者（持有Logger::drainMutex的线程）的无锁环形缓冲
+struct Ring
+{
+    // head/tail分开在不同的cache line上，避免生产者和消费者互相干扰
+    std::atomic<uint32_t> head {0};
+    char headPadding[64 - sizeof(std::atomic<uint32_t>)];
+    std::atomic<uint32_t> tail {0};
+    char tailPadding[64 - sizeof(std::atomic<uint32_t>)];
+    // 线程已经退出，记录输出完以后释放
+    std::atomic<bool> closed {false};
+    uint32_t threadIndex = 0;
+    AsyncLog::Record records[kRingCapacity];
+};
+
+class Logger
+{
+public:
+    Logger()
+    {
+        m_worker = std::thread([this]() { run(); });
+    }
+
+    ~Logger()
+    {
+        {
+            std::lock_guard<std::mutex> locker(m_wakeMutex);
+            m_stop = true;
+        }
+        m_wake.notify_one();
+        m_worker.join();
+        drain();
+        if (m_file) {
+            fclose(m_file);
+        }
+    }
+
+    Ring* registerThread()
+    {
+        Ring* ring = new Ring;
+        std::lock_guard<std::mutex> locker(m_ringsMutex);
+        ring->threadIndex = m_nextThreadIndex++;
+        m_rings.push_back(ring);
+        return ring;
+    }
+
+    void setOutputFile(const char* path)
+    {
+        std::lock_guard<std::mutex> locker(m_drainMutex);
+        if (m_file) {
+            fclose(m_file);
+            m_file = nullptr;
+        }
+        if (path) {
+            m_file = fopen(path, "a");
+        }
+    }
+
+    // 输出所有线程已经提交的记录，同一时间只有一个线程作为消费者
+    void drain()
+    {
+        std::lock_guard<std::mutex> drainLocker(m_drainMutex);
+
+        std::vector<Ring*> rings;
+        {
+            std::lock_guard<std::mutex> locker(m_ringsMutex);
+            rings = m_rings;
+        }
+
+        m_batch.clear();
+        std::vector<Ring*> finished;
+        for (Ring* ring : rings) {
+            // 先读closed再读head：线程退出前提交的记录一定能在这次读到
+            const bool closed = ring->closed.load(std::memory_order_acquire);
+            const uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+            const uint32_t head = ring->head.load(std::memory_order_acquire);
+            for (uint32_t i = tail; i != head; i++) {
+                m_batch.push_back(Entry {ring->records[i & (kRingCapacity - 1)], ring->threadIndex});
+            }
+            ring->tail.store(head, std::memory_order_release);
+            if (closed) {
+                finished.push_back(ring);
+            }
+        }
+
+        // 多个线程的记录按时间排序后输出
+        std::stable_sort(m_batch.begin(), m_batch.end(), [](const Entry& a, const Entry& b) {
+            return a.record.timestampNs < b.record.timestampNs;
+        });
+        FILE* out = m_file ? m_file : stderr;
+        for (Entry& entry : m_batch) {
+            format(entry, m_line);
+            fwrite(m_line.data(), 1, m_line.size(), out);
+            releaseStrings(entry.record);
+        }
+        if (!m_batch.empty()) {
+            fflush(out);
+            written.fetch_add(m_batch.size(), std::memory_order_relaxed);
+        }
+
+        if (!finished.empty()) {
+            std::lock_guard<std::mutex> locker(m_ringsMutex);
+            for (Ring* ring : finished) {
+                m_rings.erase(std::find(m_rings.begin(), m_rings.end(), ring));
+                delete ring;
+            }
+        }
+    }
+
+    std::atomic<uint64_t> written {0};
+    std::atomic<uint64_t> dropped {0};
+    std::atomic<uint64_t> suppressed {0};
+
+private:
+    struct Entry
+    {
+        AsyncLog::Record record;
+        uint32_t threadIndex;
+    };
+
+    void run()
+    {
+        std::unique_lock<std::mutex> locker(m_wakeMutex);
+        while (!m_stop) {
+            // 生产者不会通知这个条件变量（通知需要加锁），这里按固定间隔醒来
+            m_wake.wait_for(locker, std::chrono::milliseconds(kDrainIntervalMs));
+            locker.unlock();
+            drain();
+            locker.lock();
+        }
+    }
+
+    // 把"{}"依次替换为参数
+    static void format(const Entry& entry, std::string& line)
+    {
+        const AsyncLog::Record& record = entry.record;
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "[%12.6f] [t%u] ", record.timestampNs / 1e9, entry.threadIndex);
+        line = buffer;
+
+        int arg = 0;
+        for (const char* p = record.format; *p; p++) {
+            if (p[0] == '{' && p[1] == '}' && arg < record.argCount) {
+                appendArg(record, arg++, line);
+                p++;
+            } else {
+                line += *p;
+            }
+        }
+        // 格式字符串中没有占位符的参数附在末尾，和qDebug() << a << b的效果一样
+        for (; arg < record.argCount; arg++) {
+            line += ' ';
+            appendArg(record, arg, line);
+        }
+        if (record.suppressed > 0) {
+            snprintf(buffer, sizeof(buffer), " (%u similar messages suppressed)", record.suppressed);
+            line += buffer;
+        }
+        line += '\n';
+    }
+
+    static void appendArg(const AsyncLog::Record& record, int index, std::string& line)
+    {
+        char buffer[32];
+        const AsyncLog::ArgValue& value = record.args[index];
+        switch (record.types[index]) {
+        case AsyncLog::Int:
+            snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(value.i));
+            line += buffer;
+            break;
+        case AsyncLog::UInt:
+            snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(value.u));
+            line += buffer;
+            break;
+        case AsyncLog::Double:
+            snprintf(buffer, sizeof(buffer), "%g", value.d);
+            line += buffer;
+            break;
+        case AsyncLog::Bool:
+            line += value.i ? "true" : "false";
+            break;
+        case AsyncLog::StaticString:
+        case AsyncLog::OwnedString:
+            line += value.s ? value.s : "(null)";
+            break;
+        }
+    }
+
+    static void releaseStrings(AsyncLog::Record& record)
+    {
+        for (int i = 0; i < record.argCount; i++) {
+            if (record.types[i] == AsyncLog::OwnedString) {
+                delete[] record.args[i].s;
+            }
+        }
+    }
+
+private:
+    std::thread m_worker;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    bool m_stop = false;
+
+    std::mutex m_ringsMutex;
+    std::vector<Ring*> m_rings;
+    uint32_t m_nextThreadIndex = 0;
+
+    // 消费者状态，由m_drainMutex保护
+    std::mutex m_drainMutex;
+    FILE* m_file = nullptr;
+    std::vector<Entry> m_batch;
+    std::string m_line;
+};
+
+Logger& logger()
+{
+    // 第一次写日志时创建，进程退出时输出剩余的记录
+    static Logger instance;
+    return instance;
+}
+
+// 线程退出时把环形缓冲标记为关闭，由后台线程输出剩余记录后释放
+struct ThreadRing
+{
+    Ring* ring = nullptr;
+    uint32_t writeIndex = 0;
+
+    ~ThreadRing()
+    {
+        if (ring) {
+            ring->closed.store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadRing threadRing;
+
+}
+
+AsyncLog::RateLimiter::RateLimiter(int perSecond)
+    : m_perSecond(perSecond)
+    , m_windowStartNs(0)
+    , m_count(0)
+    , m_suppressed(0)
+{
+}
+
+bool AsyncLog::RateLimiter::allow(uint32_t &suppressed)
+{
+    const uint64_t now = nowNs();
+    uint64_t windowStart = m_windowStartNs.load(std::memory_order_relaxed);
+    // 进入新的1秒窗口时重新计数，多个线程同时进入时只有一个线程重置
+    if (now - windowStart >= 1000000000ULL
+            && m_windowStartNs.compare_exchange_strong(windowStart, now, std::memory_order_relaxed)) {
+        m_count.store(0, std::memory_order_relaxed);
+    }
+    if (m_count.fetch_add(1, std::memory_order_relaxed) < m_perSecond) {
+        suppressed = m_suppressed.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+    m_suppressed.fetch_add(1, std::memory_order_relaxed);
+    logger().suppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void AsyncLog::setOutputFile(const char *path)
+{
+    logger().setOutputFile(path);
+}
+
+void AsyncLog::flush()
+{
+    logger().drain();
+}
+
+AsyncLog::Stats AsyncLog::stats()
+{
+    Stats stats;
+    stats.written = logger().written.load(std::memory_order_relaxed);
+    stats.dropped = logger().dropped.load(std::memory_order_relaxed);
+    stats.suppressed = logger().suppressed.load(std::memory_order_relaxed);
+    return stats;
+}
+
+uint64_t AsyncLog::nowNs()
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+AsyncLog::Record *AsyncLog::beginRecord()
+{
+    ThreadRing& local = threadRing;
+    if (!local.ring) {
+        local.ring = logger().registerThread();
+    }
+    Ring* ring = local.ring;
+    const uint32_t head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= kRingCapacity) {
+        logger().dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    local.writeIndex = head;
+    Record* record = &ring->records[head & (kRingCapacity - 1)];
+    record->timestampNs = nowNs();
+    return record;
+}
+
+void AsyncLog::commitRecord()
+{
+    ThreadRing& local = threadRing;
+    local.ring->head.store(local.writeIndex + 1, std::memory_order_release);
+}
+
+void AsyncLog::encodeCopy(AsyncLog::Record &record, const char *data, size_t size)
+{
+    char* copy = new char[size + 1];
+    memcpy(copy, data, size);
+    copy[size] = '\0';
+    record.types[record.argCount] = OwnedString;
+    record.args[record.argCount++].s = copy;
+}
@@ -0,0 +1,190 @@
+#ifndef ASYNCLOG_H
+#define ASYNCLOG_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#ifdef QT_CORE_LIB
+#include <QString>
+#endif
+
+/*
+ * 渲染热路径中使用的异步日志
+ * qDebug()在调用线程中同步完成格式化和输出（写stderr/控制台可能阻塞几十us到几ms），每帧调用会拖慢渲染
+ * 这里调用线程只把一条固定大小（64字节）的二进制记录写入本线程的无锁环形缓冲（单生产者单消费者），
+ * 格式化和写文件都在后台线程中完成，调用线程不加锁、不分配内存（QString/std::string参数除外）、不做io
+ *
+ * 使用方法：
+ *   ALOG("toImage cost: {} ms", t.elapsed());
+ *   ALOG_RATE(1, "greenValue: {}", greenValue);   // 同一个调用点每秒最多输出1条，被丢弃的条数附在下一条后面
+ * 1. 格式字符串和const char*参数只保存指针，必须是字符串字面量等生命周期足够长的字符串
+ * 2. 参数最多4个，支持整数、浮点数、bool、const char*，以及std::string/QString（会复制一份，适合初始化等非热路径）
+ * 3. 环形缓冲满了（后台线程来不及输出）时丢弃新的记录并计数，不会阻塞调用线程
+ * 4. 定义ASYNCLOG_DISABLE（qmake CONFIG += asynclog_off）时ALOG/ALOG_RATE为空，参数不会被求值
+ *
+ * 进程退出时自动输出剩余的记录，也可以调用AsyncLog::flush()立即输出
+*/
+class AsyncLog
+{
+public:
+    enum { MaxArgs = 4 };
+
+    enum ArgType : uint8_t {
+        Int,
+        UInt,
+        Double,
+        Bool,
+        // 只保存指针
+        StaticString,
+        // 复制的字符串，后台线程输出后释放
+        OwnedString
+    };
+
+    union ArgValue
+    {
+        int64_t i;
+        uint64_t u;
+        double d;
+        const char* s;
+    };
+
+    // 固定大小的二进制记录
+    struct Record
+    {
+        uint64_t timestampNs;
+        const char* format;
+        // 这条记录之前因为限流被丢弃的条数
+        uint32_t suppressed;
+        uint8_t argCount;
+        uint8_t types[MaxArgs];
+        ArgValue args[MaxArgs];
+    };
+
+    struct Stats
+    {
+        // 已经输出的记录数
+        uint64_t written = 0;
+        // 环形缓冲满了被丢弃的记录数
+        uint64_t dropped = 0;
+        // 限流丢弃的记录数
+        uint64_t suppressed = 0;
+    };
+
+    // 调用点的限流：每秒最多perSecond条
+    class RateLimiter
+    {
+    public:
+        explicit RateLimiter(int perSecond);
+        // 允许输出时返回true，suppressed为上一次允许输出以来丢弃的条数
+        bool allow(uint32_t& suppressed);
+
+    private:
+        const int m_perSecond;
+        std::atomic<uint64_t> m_windowStartNs;
+        std::atomic<int> m_count;
+        std::atomic<uint32_t> m_suppressed;
+    };
+
+    template<typename... Args>
+    static void write(const char* format, const Args&... args)
+    {
+        writeLimited(nullptr, format, args...);
+    }
+
+    template<typename... Args>
+    static void writeLimited(RateLimiter* limiter, const char* format, const Args&... args)
+    {
+        static_assert(sizeof...(Args) <= MaxArgs, "AsyncLog supports at most 4 arguments");
+        uint32_t suppressed = 0;
+        if (limiter && !limiter->allow(suppressed)) {
+            return;
+        }
+        Record* record = beginRecord();
+        if (!record) {
+            return;
+        }
+        record->format = format;
+        record->suppressed = suppressed;
+        record->argCount = 0;
+        pack(*record, args...);
+        commitRecord();
+    }
+
+    // 输出到文件（追加），nullptr或者打开失败时输出到stderr
+    static void setOutputFile(const char* path);
+    // 在调用线程中立即输出所有线程已经写入的记录
+    static void flush();
+    static Stats stats();
+    // 单调时钟，记录中的时间戳
+    static uint64_t nowNs();
+
+private:
+    static Record* beginRecord();
+    static void commitRecord();
+
+    static void pack(Record&) {}
+    template<typename T, typename... Rest>
+    static void pack(Record& record, const T& value, const Rest&... rest)
+    {
+        encode(record, value);
+        pack(record, rest...);
+    }
+
+    static void encode(Record& record, int value) { encodeInt(record, value); }
+    static void encode(Record& record, long value) { encodeInt(record, value); }
+    static void encode(Record& record, long long value) { encodeInt(record, value); }
+    static void encode(Record& record, unsigned value) { encodeUInt(record, value); }
+    static void encode(Record& record, unsigned long value) { encodeUInt(record, value); }
+    static void encode(Record& record, unsigned long long value) { encodeUInt(record, value); }
+    static void encode(Record& record, double value)
+    {
+        record.types[record.argCount] = Double;
+        record.args[record.argCount++].d = value;
+    }
+    static void encode(Record& record, bool value)
+    {
+        record.types[record.argCount] = Bool;
+        record.args[record.argCount++].i = value;
+    }
+    static void encode(Record& record, const char* value)
+    {
+        record.types[record.argCount] = StaticString;
+        record.args[record.argCount++].s = value;
+    }
+    static void encode(Record& record, const std::string& value) { encodeCopy(record, value.data(), value.size()); }
+#ifdef QT_CORE_LIB
+    static void encode(Record& record, const QString& value)
+    {
+        const QByteArray utf8 = value.toUtf8();
+        encodeCopy(record, utf8.constData(), size_t(utf8.size()));
+    }
+#endif
+
+    static void encodeInt(Record& record, int64_t value)
+    {
+        record.types[record.argCount] = Int;
+        record.args[record.argCount++].i = value;
+    }
+    static void encodeUInt(Record& record, uint64_t value)
+    {
+        record.types[record.argCount] = UInt;
+        record.args[record.argCount++].u = value;
+    }
+    static void encodeCopy(Record& record, const char* data, size_t size);
+};
+
+#ifdef ASYNCLOG_DISABLE
+// if (false)中的调用不会执行，参数不会被求值，但仍然会做类型检查
+#define ALOG(...) do { if (false) { AsyncLog::write(__VA_ARGS__); } } while (0)
+#define ALOG_RATE(perSecond, ...) do { if (false) { AsyncLog::write(__VA_ARGS__); } } while (0)
+#else
+#define ALOG(...) AsyncLog::write(__VA_ARGS__)
+#define ALOG_RATE(perSecond, ...) \
+    do { \
+        static AsyncLog::RateLimiter asyncLogLimiter(perSecond); \
+        AsyncLog::writeLimited(&asyncLogLimiter, __VA_ARGS__); \
+    } while (0)
+#endif
+
+#endif // ASYNCLOG_H
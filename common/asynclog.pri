@@ -0,0 +1,10 @@
+# 异步日志：调用线程只写入无锁环形缓冲，格式化和输出在后台线程完成，支持限流，CONFIG += asynclog_off时日志在编译期去掉
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/asynclog.h
+
+SOURCES += \
+    $$PWD/asynclog.cpp
+
+asynclog_off: DEFINES += ASYNCLOG_DISABLE
@@ -0,0 +1,292 @@
+#include "asyncreadback.h"
+#include "trace.h"
+
+#include <cstring>
+
+#include <QDebug>
+#include <QOpenGLContext>
+
+// opengles2的头文件中没有这些定义
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ 0x88E1
+#endif
+#ifndef GL_MAP_READ_BIT
+#define GL_MAP_READ_BIT 0x0001
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif
+#ifndef GL_SYNC_FLUSH_COMMANDS_BIT
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#endif
+#ifndef GL_ALREADY_SIGNALED
+#define GL_ALREADY_SIGNALED 0x911A
+#endif
+#ifndef GL_TIMEOUT_EXPIRED
+#define GL_TIMEOUT_EXPIRED 0x911B
+#endif
+#ifndef GL_CONDITION_SATISFIED
+#define GL_CONDITION_SATISFIED 0x911C
+#endif
+
+AsyncReadback::AsyncReadback(int ringSize)
+    : m_slots(qMax(ringSize, 1))
+{
+}
+
+AsyncReadback::~AsyncReadback()
+{
+    if (m_created) {
+        qWarning() << "AsyncReadback: destroy() should be called with context current before destruction";
+    }
+}
+
+bool AsyncReadback::create(const QSize &size)
+{
+    QOpenGLContext* context = QOpenGLContext::currentContext();
+    if (!context || size.isEmpty()) {
+        return false;
+    }
+
+    if (m_created) {
+        destroy();
+    }
+
+    initializeOpenGLFunctions();
+
+    // PBO需要opengl 2.1/opengles 3.0，fence需要opengl 3.2/opengles 3.0（或者GL_ARB_sync）
+    const QSurfaceFormat format = context->format();
+    if (context->isOpenGLES()) {
+        m_async = format.majorVersion() >= 3;
+    } else {
+        m_async = format.version() >= qMakePair(3, 2) || context->hasExtension("GL_ARB_sync");
+    }
+
+    m_size = size;
+    m_head = 0;
+    m_tail = 0;
+    m_pending = 0;
+
+    if (m_async) {
+        const GLsizeiptr bytes = GLsizeiptr(size.width()) * size.height() * 4;
+        for (Slot& slot : m_slots) {
+            glGenBuffers(1, &slot.pbo);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+            // GL_STREAM_READ：gpu写入，cpu读取一次
+            glBufferData(GL_PIXEL_PACK_BUFFER, bytes, Q_NULLPTR, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    m_clock.start();
+    resetStats();
+    m_created = true;
+    return true;
+}
+
+void AsyncReadback::destroy()
+{
+    if (!m_created) {
+        return;
+    }
+
+    for (Slot& slot : m_slots) {
+        if (slot.fence) {
+            glDeleteSync(slot.fence);
+        }
+        if (slot.pbo) {
+            glDeleteBuffers(1, &slot.pbo);
+        }
+        slot = Slot();
+    }
+
+    m_pending = 0;
+    m_created = false;
+}
+
+bool AsyncReadback::isCreated() const
+{
+    return m_created;
+}
+
+bool AsyncReadback::isAsync() const
+{
+    return m_async;
+}
+
+QSize AsyncReadback::size() const
+{
+    return m_size;
+}
+
+void AsyncReadback::setFlipped(bool flipped)
+{
+    m_flipped = flipped;
+}
+
+void AsyncReadback::setCallback(const Callback &callback)
+{
+    m_callback = callback;
+}
+
+quint64 AsyncReadback::readback(const Callback &callback)
+{
+    if (!m_created) {
+        return 0;
+    }
+
+    TRACE_SCOPE("readback");
+    const quint64 frameId = ++m_nextFrameId;
+    m_stats.submitted++;
+
+    if (!m_async) {
+        // 同步路径：和toImage一样直接glReadPixels到内存
+        QImage image(m_size, QImage::Format_RGBA8888_Premultiplied);
+        glReadPixels(0, 0, m_size.width(), m_size.height(), GL_RGBA, GL_UNSIGNED_BYTE, image.bits());
+        deliverImage(m_flipped ? image.mirrored() : image, frameId, m_clock.nsecsElapsed(), callback);
+        return frameId;
+    }
+
+    // 先把已经完成的交付掉，腾出slot
+    poll();
+
+    if (m_pending == m_slots.size()) {
+        // PBO环满了（gpu落后太多），只能等最老的一次读取完成
+        m_stats.stalls++;
+        Slot& oldest = m_slots[m_tail];
+        isSignaled(oldest, true);
+        deliver(oldest);
+        m_tail = (m_tail + 1) % m_slots.size();
+        m_pending--;
+    }
+
+    Slot& slot = m_slots[m_head];
+    slot.frameId = frameId;
+    slot.submitNs = m_clock.nsecsElapsed();
+    slot.callback = callback;
+
+    // 绑定了GL_PIXEL_PACK_BUFFER后，glReadPixels的最后一个参数是PBO中的偏移，调用只是发起拷贝，不会等待
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    glReadPixels(0, 0, m_size.width(), m_size.height(), GL_RGBA, GL_UNSIGNED_BYTE, Q_NULLPTR);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    // 插入fence，fence之前的命令（包括上面的拷贝）执行完以后fence才会signaled
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    m_head = (m_head + 1) % m_slots.size();
+    m_pending++;
+    return frameId;
+}
+
+int AsyncReadback::poll()
+{
+    int count = 0;
+    while (m_pending > 0 && isSignaled(m_slots[m_tail], false)) {
+        deliver(m_slots[m_tail]);
+        m_tail = (m_tail + 1) % m_slots.size();
+        m_pending--;
+        count++;
+    }
+    return count;
+}
+
+void AsyncReadback::flush()
+{
+    while (m_pending > 0) {
+        isSignaled(m_slots[m_tail], true);
+        deliver(m_slots[m_tail]);
+        m_tail = (m_tail + 1) % m_slots.size();
+        m_pending--;
+    }
+}
+
+AsyncReadback::Stats AsyncReadback::stats() const
+{
+    return m_stats;
+}
+
+void AsyncReadback::resetStats()
+{
+    m_stats = Stats();
+    m_latencySumNs = 0;
+    m_latencyFramesSum = 0;
+    m_statsStartNs = m_clock.isValid() ? m_clock.nsecsElapsed() : 0;
+}
+
+bool AsyncReadback::isSignaled(Slot &slot, bool wait)
+{
+    // wait为false时timeout为0，只查询不等待
+    GLenum result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? 1000000000 : 0);
+    while (wait && result == GL_TIMEOUT_EXPIRED) {
+        result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    }
+
+    if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) {
+        return true;
+    }
+    if (result != GL_TIMEOUT_EXPIRED) {
+        // GL_WAIT_FAILED，不再等待这个fence，避免永远卡住
+        qWarning() << "AsyncReadback: glClientWaitSync failed";
+        return true;
+    }
+    return false;
+}
+
+void AsyncReadback::deliver(Slot &slot)
+{
+    TRACE_SCOPE("readback map");
+    glDeleteSync(slot.fence);
+    slot.fence = 0;
+
+    const int width = m_size.width();
+    const int height = m_size.height();
+    const int rowBytes = width * 4;
+
+    QImage image(m_size, QImage::Format_RGBA8888_Premultiplied);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    const uchar* data = static_cast<const uchar*>(
+                glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, GLsizeiptr(rowBytes) * height, GL_MAP_READ_BIT));
+    if (data) {
+        // glReadPixels的结果是从下到上的行序，flipped时拷贝的同时翻转，省掉一次mirrored()
+        for (int y = 0; y < height; y++) {
+            const int srcRow = m_flipped ? height - 1 - y : y;
+            memcpy(image.scanLine(y), data + qptrdiff(srcRow) * rowBytes, rowBytes);
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+        qWarning() << "AsyncReadback: glMapBufferRange failed";
+        image = QImage();
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    Callback callback;
+    std::swap(callback, slot.callback);
+    deliverImage(image, slot.frameId, slot.submitNs, callback);
+}
+
+void AsyncReadback::deliverImage(QImage image, quint64 frameId, qint64 submitNs, const Callback &callback)
+{
+    const qint64 nowNs = m_clock.nsecsElapsed();
+    const qint64 latencyNs = nowNs - submitNs;
+
+    m_stats.delivered++;
+    m_latencySumNs += latencyNs;
+    m_latencyFramesSum += m_nextFrameId - frameId;
+    m_stats.lastLatencyMs = latencyNs / 1e6;
+    m_stats.avgLatencyMs = m_latencySumNs / 1e6 / m_stats.delivered;
+    m_stats.avgLatencyFrames = double(m_latencyFramesSum) / m_stats.delivered;
+
+    const qint64 windowNs = nowNs - m_statsStartNs;
+    if (windowNs > 0) {
+        m_stats.deliveredPerSecond = m_stats.delivered * 1e9 / windowNs;
+        m_stats.megabytesPerSecond = m_stats.deliveredPerSecond * m_size.width() * m_size.height() * 4 / (1024.0 * 1024.0);
+    }
+
+    if (callback) {
+        callback(image, frameId);
+    } else if (m_callback) {
+        m_callback(image, frameId);
+    }
+}
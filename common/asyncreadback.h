@@ -0,0 +1,108 @@
+#ifndef ASYNCREADBACK_H
+#define ASYNCREADBACK_H
+
+#include <functional>
+
+#include <QImage>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QOpenGLExtraFunctions>
+
+/*
+ * 基于PBO(pixel pack buffer) + fence的异步readpix
+ * QOpenGLFramebufferObject::toImage内部直接glReadPixels到内存，cpu要一直等到gpu把这一帧画完才能返回（paintGL中大约25ms）
+ * 这里改为glReadPixels到一个PBO环中的某一个PBO，此时glReadPixels只是发起一次gpu侧的拷贝，立即返回，
+ * 再插入一个glFenceSync，之后的帧里通过fence查询拷贝是否完成，完成后才map PBO读取数据，这样读取结果会延迟1~2帧交付，
+ * 但是渲染循环中不再有阻塞等待
+ *
+ * 不支持PBO/fence的环境（opengl 3.2或opengles 3.0以下）退化为同步的glReadPixels
+ *
+ * 所有接口都需要在创建它的context current的情况下调用
+*/
+class AsyncReadback : protected QOpenGLExtraFunctions
+{
+public:
+    // image为读取结果，frameId为readback()返回的帧序号
+    typedef std::function<void(const QImage& image, quint64 frameId)> Callback;
+
+    struct Stats
+    {
+        // 已发起/已交付的读取次数
+        quint64 submitted = 0;
+        quint64 delivered = 0;
+        // PBO环满了，只能阻塞等待最老的一次读取完成的次数，正常情况下应该为0
+        quint64 stalls = 0;
+        // 从发起读取到交付的延迟
+        double lastLatencyMs = 0.0;
+        double avgLatencyMs = 0.0;
+        // 交付时已经又发起了多少帧读取
+        double avgLatencyFrames = 0.0;
+        // 每秒交付帧数和带宽
+        double deliveredPerSecond = 0.0;
+        double megabytesPerSecond = 0.0;
+    };
+
+    explicit AsyncReadback(int ringSize = 3);
+    ~AsyncReadback();
+
+    // 按照读取区域大小分配PBO环，size变化时需要重新create
+    bool create(const QSize& size);
+    // 释放PBO和fence，未交付的读取会被丢弃
+    void destroy();
+    bool isCreated() const;
+    // 是否真正走异步路径（否则为同步glReadPixels）
+    bool isAsync() const;
+    QSize size() const;
+
+    // flipped和QOpenGLFramebufferObject::toImage(flipped)含义一致：true时结果为从上到下的行序
+    void setFlipped(bool flipped);
+    // 默认的交付回调，readback()没有单独指定回调时使用
+    void setCallback(const Callback& callback);
+
+    // 从当前绑定的读fbo发起一次读取，立即返回帧序号
+    quint64 readback(const Callback& callback = Callback());
+    // 检查已完成的读取并回调，不阻塞，返回本次交付的数量
+    int poll();
+    // 阻塞等待所有未完成的读取并回调
+    void flush();
+
+    Stats stats() const;
+    void resetStats();
+
+private:
+    struct Slot
+    {
+        GLuint pbo = 0;
+        GLsync fence = 0;
+        quint64 frameId = 0;
+        qint64 submitNs = 0;
+        Callback callback;
+    };
+
+    bool isSignaled(Slot& slot, bool wait);
+    void deliver(Slot& slot);
+    void deliverImage(QImage image, quint64 frameId, qint64 submitNs, const Callback& callback);
+
+private:
+    QVector<Slot> m_slots;
+    // 下一次写入的slot，和最老的未交付slot
+    int m_head = 0;
+    int m_tail = 0;
+    int m_pending = 0;
+
+    QSize m_size;
+    bool m_created = false;
+    bool m_async = false;
+    bool m_flipped = true;
+    Callback m_callback;
+
+    quint64 m_nextFrameId = 0;
+    QElapsedTimer m_clock;
+
+    Stats m_stats;
+    qint64 m_latencySumNs = 0;
+    quint64 m_latencyFramesSum = 0;
+    qint64 m_statsStartNs = 0;
+};
+
+#endif // ASYNCREADBACK_H
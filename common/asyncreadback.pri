@@ -0,0 +1,10 @@
+# 基于PBO + fence的异步readpix，include到需要的工程中即可
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/asyncreadback.h
+
+SOURCES += \
+    $$PWD/asyncreadback.cpp
+
+include($$PWD/trace.pri)
@@ -0,0 +1,138 @@
+#include "damagetracker.h"
+
+#include <QTime>
+#include <QEvent>
+#include <QOpenGLWidget>
+
+QString DamageTracker::Stats::summary() const
+{
+    return QString("frames %1 (time %2, uniform %3, resize %4, texture %5, external %6), unchanged uniforms %7")
+            .arg(frames).arg(timeQuantum).arg(uniform).arg(resize).arg(texture).arg(external)
+            .arg(uniformUnchanged);
+}
+
+DamageTracker::DamageTracker(QOpenGLWidget *widget)
+    : QObject(widget)
+    , m_widget(widget)
+{
+    m_quantumTimer.setSingleShot(true);
+    // 需要在量子边界之后尽快触发，例如颜色按秒变化时不能晚几十毫秒
+    m_quantumTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_quantumTimer, &QTimer::timeout, this, &DamageTracker::onQuantum);
+    m_widget->installEventFilter(this);
+}
+
+void DamageTracker::watch(Sources sources)
+{
+    m_watched = sources;
+}
+
+DamageTracker::Sources DamageTracker::watched() const
+{
+    return m_watched;
+}
+
+void DamageTracker::setContinuous(bool continuous)
+{
+    m_continuous = continuous;
+    if (m_continuous) {
+        m_widget->update();
+    }
+}
+
+bool DamageTracker::isContinuous() const
+{
+    return m_continuous;
+}
+
+void DamageTracker::setTimeQuantum(int msecs)
+{
+    m_quantumMs = qMax(msecs, 0);
+    m_quantumTimer.stop();
+    if (m_quantumMs > 0) {
+        scheduleQuantum();
+    }
+}
+
+bool DamageTracker::setUniform(const QByteArray &name, const QVariant &value)
+{
+    QHash<QByteArray, QVariant>::iterator it = m_uniforms.find(name);
+    if (it != m_uniforms.end() && it.value() == value) {
+        m_stats.uniformUnchanged++;
+        return false;
+    }
+    m_uniforms.insert(name, value);
+    invalidate(Uniform);
+    return true;
+}
+
+QVariant DamageTracker::uniform(const QByteArray &name) const
+{
+    return m_uniforms.value(name);
+}
+
+void DamageTracker::textureChanged()
+{
+    invalidate(Texture);
+}
+
+void DamageTracker::invalidate(Source source)
+{
+    if (!(m_watched & source) && source != External) {
+        return;
+    }
+    // 一帧之内多次update()会被Qt合并为一次paintGL
+    m_pending |= source;
+    m_widget->update();
+}
+
+DamageTracker::Sources DamageTracker::beginFrame()
+{
+    // 没有记录原因的重绘是Qt自己触发的（第一次显示、被遮挡后重新显示等）
+    const Sources reasons = m_pending ? m_pending : Sources(External);
+    m_pending = Sources();
+
+    m_stats.frames++;
+    m_stats.timeQuantum += reasons.testFlag(TimeQuantum) ? 1 : 0;
+    m_stats.uniform += reasons.testFlag(Uniform) ? 1 : 0;
+    m_stats.resize += reasons.testFlag(Resize) ? 1 : 0;
+    m_stats.texture += reasons.testFlag(Texture) ? 1 : 0;
+    m_stats.external += reasons.testFlag(External) ? 1 : 0;
+
+    if (m_continuous) {
+        m_widget->update();
+    }
+    return reasons;
+}
+
+DamageTracker::Stats DamageTracker::stats() const
+{
+    return m_stats;
+}
+
+bool DamageTracker::eventFilter(QObject *watched, QEvent *event)
+{
+    // QOpenGLWidget大小变化时自己会重绘，这里只记录原因
+    if (watched == m_widget && event->type() == QEvent::Resize) {
+        m_pending |= Resize;
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void DamageTracker::scheduleQuantum()
+{
+    // 按墙上时间对齐到下一个量子边界，例如量子为1000ms时在每一秒开始时触发
+    const int now = QTime::currentTime().msecsSinceStartOfDay();
+    const int remaining = m_quantumMs - now % m_quantumMs;
+    // 多等1ms，保证触发时已经越过边界
+    m_quantumTimer.start(remaining + 1);
+}
+
+void DamageTracker::onQuantum()
+{
+    emit timeQuantumElapsed();
+    if (m_watched & TimeQuantum) {
+        invalidate(TimeQuantum);
+    }
+    scheduleQuantum();
+}
@@ -0,0 +1,108 @@
+#ifndef DAMAGETRACKER_H
+#define DAMAGETRACKER_H
+
+#include <QHash>
+#include <QTimer>
+#include <QObject>
+#include <QVariant>
+#include <QByteArray>
+
+class QOpenGLWidget;
+
+/*
+ * 按需重绘：控件声明哪些输入变化时需要重绘（时间量子、uniform、窗口大小、纹理），
+ * 只有这些输入真正变化时才调用update()，画面不变时不再每帧重绘，空闲时几乎不占用cpu
+ *
+ * 使用方法：
+ * 1. 构造时传入控件，watch()声明哪些输入会让画面失效
+ * 2. 输入变化时调用对应的接口：setUniform()（值没变不会重绘）、textureChanged()、invalidate()，
+ *    窗口大小变化通过事件过滤器自动记录
+ * 3. 画面随时间变化时setTimeQuantum()，每个时间量子的边界（按墙上时间对齐）发出timeQuantumElapsed()，
+ *    如果声明了TimeQuantum，同时触发重绘
+ * 4. paintGL开始时调用beginFrame()，返回本帧的重绘原因
+ *
+ * setContinuous(true)时退化为原来的连续重绘（每帧paintGL中都update），用于对比cpu占用
+*/
+class DamageTracker : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Source {
+        TimeQuantum = 0x1,
+        Uniform = 0x2,
+        Resize = 0x4,
+        Texture = 0x8,
+        // 其他原因（例如Qt自己触发的expose），不能屏蔽
+        External = 0x10
+    };
+    Q_DECLARE_FLAGS(Sources, Source)
+
+    struct Stats
+    {
+        // 总共绘制的帧数
+        int frames = 0;
+        // 每种原因触发的重绘次数（一帧可能有多个原因）
+        int timeQuantum = 0;
+        int uniform = 0;
+        int resize = 0;
+        int texture = 0;
+        int external = 0;
+        // 值没有变化被忽略的setUniform次数
+        int uniformUnchanged = 0;
+
+        // 例如 "frames 12 (time 0, uniform 10, resize 1, texture 0, external 1), unchanged uniforms 0"
+        QString summary() const;
+    };
+
+    explicit DamageTracker(QOpenGLWidget* widget);
+
+    // 声明会让画面失效的输入，没有声明的输入变化时不重绘
+    void watch(Sources sources);
+    Sources watched() const;
+
+    // 连续重绘模式：beginFrame中每帧都请求下一帧
+    void setContinuous(bool continuous);
+    bool isContinuous() const;
+
+    // 时间量子（毫秒），0为关闭
+    void setTimeQuantum(int msecs);
+
+    // 值和上一次不同时才失效，返回是否变化
+    bool setUniform(const QByteArray& name, const QVariant& value);
+    QVariant uniform(const QByteArray& name) const;
+    void textureChanged();
+    void invalidate(Source source);
+
+    // paintGL开始时调用，返回本帧的重绘原因并清空
+    Sources beginFrame();
+
+    Stats stats() const;
+
+signals:
+    void timeQuantumElapsed();
+
+protected:
+    virtual bool eventFilter(QObject* watched, QEvent* event) override;
+
+private:
+    void scheduleQuantum();
+    void onQuantum();
+
+private:
+    QOpenGLWidget* m_widget = nullptr;
+    Sources m_watched = Sources(Uniform | Resize | Texture);
+    // 自上一帧以来的重绘原因
+    Sources m_pending;
+    bool m_continuous = false;
+
+    int m_quantumMs = 0;
+    QTimer m_quantumTimer;
+
+    QHash<QByteArray, QVariant> m_uniforms;
+    Stats m_stats;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(DamageTracker::Sources)
+
+#endif // DAMAGETRACKER_H
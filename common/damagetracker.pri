@@ -0,0 +1,8 @@
+# 按需重绘：控件声明时间量子/uniform/窗口大小/纹理等输入，只有输入变化时才重绘，空闲时几乎不占用cpu
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/damagetracker.h
+
+SOURCES += \
+    $$PWD/damagetracker.cpp
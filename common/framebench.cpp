@@ -0,0 +1,182 @@
+#include "framebench.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QImage>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QElapsedTimer>
+#include <QOpenGLWidget>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QOpenGLTimerQuery>
+#include <QCoreApplication>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 最近秩法：排序后第ceil(p * n)个
+double percentile(const QVector<double>& sorted, double p)
+{
+    const int rank = qBound(1, int(std::ceil(p * sorted.size())), sorted.size());
+    return sorted[rank - 1];
+}
+
+QString glString(QOpenGLFunctions* f, GLenum name)
+{
+    return QString::fromLatin1(reinterpret_cast<const char*>(f->glGetString(name)));
+}
+
+}
+
+FrameBench::Options FrameBench::parse(const QStringList &args)
+{
+    Options options;
+    int index = args.indexOf("--frame-bench");
+    if (index >= 0) {
+        options.frames = qMax(args.value(index + 1).toInt(), 1);
+    }
+    index = args.indexOf("--frame-bench-size");
+    if (index >= 0) {
+        const QStringList size = args.value(index + 1).split('x');
+        if (size.size() == 2 && size[0].toInt() > 0 && size[1].toInt() > 0) {
+            options.size = QSize(size[0].toInt(), size[1].toInt());
+        }
+    }
+    index = args.indexOf("--frame-bench-out");
+    if (index >= 0) {
+        options.output = args.value(index + 1);
+    }
+    if (options.output.isEmpty()) {
+        options.output = QCoreApplication::applicationName() + ".bench.json";
+    }
+    return options;
+}
+
+int FrameBench::run(QOpenGLWidget *widget, const Options &options)
+{
+    // 控件不显示，grabFramebuffer()在第一次调用时创建context和fbo并调用initializeGL
+    widget->resize(options.size);
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+    if (widget->grabFramebuffer().isNull()) {
+        qDebug() << "frame bench: offscreen rendering failed (check QT_QPA_PLATFORM and the OpenGL driver)";
+        return 1;
+    }
+    const double startupMs = startupTimer.nsecsElapsed() / 1e6;
+
+    widget->makeCurrent();
+    QOpenGLContext* context = widget->context();
+    QOpenGLFunctions* f = context->functions();
+    const QString renderer = glString(f, GL_RENDERER);
+    const QString version = glString(f, GL_VERSION);
+#if !defined(QT_OPENGL_ES_2)
+    const bool gpuTiming = !context->isOpenGLES()
+            && (context->format().version() >= qMakePair(3, 3) || context->hasExtension("GL_ARB_timer_query"));
+    QOpenGLTimerQuery begin;
+    QOpenGLTimerQuery end;
+    if (gpuTiming) {
+        begin.create();
+        end.create();
+    }
+#else
+    // 只有gles的Qt没有QOpenGLTimerQuery
+    const bool gpuTiming = false;
+#endif
+
+    QVector<double> cpuMs;
+    QVector<double> gpuMs;
+    for (int i = 0; i < options.warmup + options.frames; i++) {
+        // 图片解码完成等信号在帧之间处理，不计入帧时间
+        QCoreApplication::processEvents();
+
+        widget->makeCurrent();
+#if !defined(QT_OPENGL_ES_2)
+        if (gpuTiming) {
+            begin.recordTimestamp();
+        }
+#endif
+        QElapsedTimer timer;
+        timer.start();
+        widget->grabFramebuffer();
+        const double cpu = timer.nsecsElapsed() / 1e6;
+
+        widget->makeCurrent();
+        double gpu = 0.0;
+#if !defined(QT_OPENGL_ES_2)
+        if (gpuTiming) {
+            end.recordTimestamp();
+            // 读回像素时已经等待渲染完成，这里基本不会阻塞
+            gpu = (end.waitForResult() - begin.waitForResult()) / 1e6;
+        }
+#endif
+        if (i >= options.warmup) {
+            cpuMs.append(cpu);
+            if (gpuTiming) {
+                gpuMs.append(gpu);
+            }
+        }
+    }
+#if !defined(QT_OPENGL_ES_2)
+    if (gpuTiming) {
+        begin.destroy();
+        end.destroy();
+    }
+#endif
+    widget->doneCurrent();
+
+    QJsonObject result;
+    result["example"] = QCoreApplication::applicationName();
+    result["frames"] = options.frames;
+    result["warmup"] = options.warmup;
+    result["width"] = options.size.width();
+    result["height"] = options.size.height();
+    result["renderer"] = renderer;
+    result["version"] = version;
+    result["startup_ms"] = startupMs;
+    const QJsonObject cpu = summarize(cpuMs);
+    const QJsonObject gpu = summarize(gpuMs);
+    result["cpu_ms"] = cpu;
+    if (gpuTiming) {
+        result["gpu_ms"] = gpu;
+    }
+
+    QFile file(options.output);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "frame bench: can't write" << options.output << file.errorString();
+        return 1;
+    }
+    file.write(QJsonDocument(result).toJson());
+
+    qDebug().noquote() << QString("frame bench %1: startup %2 ms cpu p50 %3 p99 %4 ms%5 -> %6")
+                          .arg(result["example"].toString())
+                          .arg(startupMs, 0, 'f', 1)
+                          .arg(cpu["p50"].toDouble(), 0, 'f', 3)
+                          .arg(cpu["p99"].toDouble(), 0, 'f', 3)
+                          .arg(gpuTiming ? QString(" gpu p50 %1 ms").arg(gpu["p50"].toDouble(), 0, 'f', 3)
+                                         : QString())
+                          .arg(QFileInfo(file).absoluteFilePath());
+    return 0;
+}
+
+QJsonObject FrameBench::summarize(QVector<double> samples)
+{
+    QJsonObject summary;
+    if (samples.isEmpty()) {
+        return summary;
+    }
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    summary["mean"] = sum / samples.size();
+    summary["min"] = samples.first();
+    summary["p50"] = percentile(samples, 0.50);
+    summary["p90"] = percentile(samples, 0.90);
+    summary["p99"] = percentile(samples, 0.99);
+    summary["max"] = samples.last();
+    return summary;
+}
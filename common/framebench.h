@@ -0,0 +1,48 @@
+#ifndef FRAMEBENCH_H
+#define FRAMEBENCH_H
+
+#include <QSize>
+#include <QString>
+#include <QVector>
+#include <QStringList>
+#include <QJsonObject>
+
+class QOpenGLWidget;
+
+/*
+ * 例子的离屏帧时间测试：不显示窗口，通过grabFramebuffer()驱动控件的initializeGL/paintGL，
+ * 渲染到QOpenGLWidget自己的fbo中，统计每帧的cpu和gpu耗时（均值、最小、p50/p90/p99、最大），结果写为json
+ *
+ * 命令行参数（main中在show之前调用run）：
+ *   --frame-bench N           渲染N帧后退出（另外有10帧预热不计入）
+ *   --frame-bench-size WxH    控件大小，默认800x600
+ *   --frame-bench-out FILE    json输出路径，默认为当前目录下的<程序名>.bench.json
+ *
+ * linux上用mesa llvmpipe测试：LIBGL_ALWAYS_SOFTWARE=1 QT_QPA_PLATFORM=offscreen HelloRect --frame-bench 300
+ * （offscreen平台没有opengl时用xvfb-run），所有例子一起测试并和baseline比较见BenchCompare
+ *
+ * cpu时间是整个grabFramebuffer()的耗时，包括paintGL和读回像素（每帧一次glReadPixels）；
+ * gpu时间是前后两个时间戳查询（glQueryCounter）的差值，需要gl 3.3或者ARB_timer_query，gles上没有gpu时间
+*/
+class FrameBench
+{
+public:
+    struct Options
+    {
+        // 0表示没有--frame-bench，正常显示窗口
+        int frames = 0;
+        int warmup = 10;
+        QSize size {800, 600};
+        QString output;
+    };
+
+    static Options parse(const QStringList& args);
+
+    // 返回进程的退出码：成功0，不能离屏渲染或者写文件失败1
+    static int run(QOpenGLWidget* widget, const Options& options);
+
+    // {"mean","min","p50","p90","p99","max"}，单位ms
+    static QJsonObject summarize(QVector<double> samples);
+};
+
+#endif // FRAMEBENCH_H
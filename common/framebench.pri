@@ -0,0 +1,8 @@
+# 离屏帧时间测试：--frame-bench N时不显示窗口，驱动initializeGL/paintGL渲染N帧，cpu/gpu帧时间的百分位写为json
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/framebench.h
+
+SOURCES += \
+    $$PWD/framebench.cpp
@@ -0,0 +1,640 @@
+#include "framehud.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QOpenGLWidget>
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+#include <QCoreApplication>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+
+#ifndef GL_TIMESTAMP
+#define GL_TIMESTAMP 0x8E28
+#endif
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+#ifndef GL_VERTEX_ARRAY_BINDING
+#define GL_VERTEX_ARRAY_BINDING 0x85B5
+#endif
+
+namespace {
+
+// 百分位的滚动窗口（帧）和柱状图显示的帧数
+const int kWindow = 600;
+const int kSparkline = 120;
+// 直方图的桶：10ms以内0.01ms一个桶，10~100ms 0.1ms一个桶，100ms以上一个桶
+const int kFineBins = 1000;
+const int kCoarseBins = 900;
+const int kBins = kFineBins + kCoarseBins + 1;
+// 同时在路上的gpu时间戳（帧），超过时最旧的一帧被覆盖
+const int kGpuSlots = 4;
+const qint64 kTextIntervalNs = 250 * 1000000LL;
+// 柱状图满高度对应的时间，中间的参考线为16.7ms
+const float kSparklineMaxMs = 33.3f;
+
+const char* const kSeriesNames[] = {"cpu", "gpu", "interval", "hud"};
+const char* const kSeriesLabels[] = {"CPU", "GPU", "INT", "HUD"};
+const quint8 kSeriesColors[][4] = {
+    {90, 200, 255, 255},
+    {255, 170, 60, 255},
+    {120, 230, 120, 255},
+    {200, 200, 200, 255},
+};
+const quint8 kHeaderColor[] = {255, 255, 255, 255};
+const quint8 kBackgroundColor[] = {0, 0, 0, 170};
+const quint8 kGuideColor[] = {255, 255, 255, 70};
+const quint8 kOverflowColor[] = {255, 70, 70, 255};
+
+// 一行的格式：标签4个字符，4列数值每列6个字符
+const int kColumns = 4 + 4 * 6;
+const int kLines = 1 + 4;
+// 字符3x5点，间距1点，行距2点
+const int kGlyphAdvance = 4;
+const int kLineAdvance = 7;
+const int kSparklineHeight = 10;
+const int kSparklineGap = 2;
+const int kPadding = 3;
+const int kMargin = 4;
+
+// 3x5点阵，每行3位为一个八进制数字，从上到下，高位在左边
+quint16 glyph(char c)
+{
+    switch (c) {
+    case '0': return 075557;
+    case '1': return 026227;
+    case '2': return 071747;
+    case '3': return 071717;
+    case '4': return 055711;
+    case '5': return 074717;
+    case '6': return 074757;
+    case '7': return 071122;
+    case '8': return 075757;
+    case '9': return 075717;
+    case '.': return 000002;
+    case '-': return 000700;
+    case 'A': return 025755;
+    case 'C': return 074447;
+    case 'D': return 065556;
+    case 'G': return 074557;
+    case 'H': return 055755;
+    case 'I': return 072227;
+    case 'M': return 057755;
+    case 'N': return 065555;
+    case 'P': return 075744;
+    case 'S': return 074717;
+    case 'T': return 072222;
+    case 'U': return 055557;
+    case 'X': return 055255;
+    default: return 0;
+    }
+}
+
+// 桌面gl中是核心函数，gles上是EXT_disjoint_timer_query的EXT版本
+template <typename T>
+T resolve(QOpenGLContext* context, const char* name)
+{
+    T function = reinterpret_cast<T>(context->getProcAddress(name));
+    if (!function) {
+        function = reinterpret_cast<T>(context->getProcAddress(QByteArray(name) + "EXT"));
+    }
+    return function;
+}
+
+bool enabledFromEnvironment()
+{
+    const QByteArray value = qgetenv("FRAME_HUD");
+    return !value.isEmpty() && value != "0";
+}
+
+// 像素坐标（左上角为原点）换算到裁剪空间
+const char* vertexShaderSource =
+        "#version 330 core\n"
+        "layout (location = 0) in vec2 aPos;\n"
+        "layout (location = 1) in vec4 aColor;\n"
+        "uniform vec2 uViewport;\n"
+        "out vec4 vColor;\n"
+        "void main()\n"
+        "{\n"
+        "   gl_Position = vec4(aPos / uViewport * vec2(2.0, -2.0) + vec2(-1.0, 1.0), 0.0, 1.0);\n"
+        "   vColor = aColor;\n"
+        "}\n";
+
+const char* fragmentShaderSource =
+        "#version 330 core\n"
+        "in vec4 vColor;\n"
+        "out vec4 FragColor;\n"
+        "void main()\n"
+        "{\n"
+        "   FragColor = vColor;\n"
+        "}\n";
+
+const char* vertexShaderSourceEs =
+        "#version 100\n"
+        "attribute vec2 aPos;\n"
+        "attribute vec4 aColor;\n"
+        "uniform vec2 uViewport;\n"
+        "varying vec4 vColor;\n"
+        "void main()\n"
+        "{\n"
+        "   gl_Position = vec4(aPos / uViewport * vec2(2.0, -2.0) + vec2(-1.0, 1.0), 0.0, 1.0);\n"
+        "   vColor = aColor;\n"
+        "}\n";
+
+const char* fragmentShaderSourceEs =
+        "#version 100\n"
+        "precision mediump float;\n"
+        "varying vec4 vColor;\n"
+        "void main()\n"
+        "{\n"
+        "   gl_FragColor = vColor;\n"
+        "}\n";
+
+}
+
+FrameHud::Histogram::Histogram()
+    : m_window(kBins, 0)
+    , m_total(kBins, 0)
+    , m_samples(kWindow, 0.0f)
+{
+}
+
+void FrameHud::Histogram::add(double ms)
+{
+    if (m_count == kWindow) {
+        m_window[bin(m_samples[m_next])]--;
+    } else {
+        m_count++;
+    }
+    m_samples[m_next] = float(ms);
+    m_next = (m_next + 1) % kWindow;
+
+    const int index = bin(ms);
+    m_window[index]++;
+    m_total[index]++;
+    m_totalCount++;
+    m_totalSum += ms;
+    m_totalMax = qMax(m_totalMax, ms);
+}
+
+double FrameHud::Histogram::percentile(double q) const
+{
+    return percentileOf(m_window, m_count, q);
+}
+
+double FrameHud::Histogram::windowMax() const
+{
+    if (m_count == 0) {
+        return -1.0;
+    }
+    float result = 0.0f;
+    for (int i = 0; i < m_count; i++) {
+        result = qMax(result, m_samples[i]);
+    }
+    return result;
+}
+
+double FrameHud::Histogram::totalPercentile(double q) const
+{
+    return percentileOf(m_total, m_totalCount, q);
+}
+
+double FrameHud::Histogram::totalMean() const
+{
+    return m_totalCount ? m_totalSum / m_totalCount : -1.0;
+}
+
+double FrameHud::Histogram::totalMax() const
+{
+    return m_totalCount ? m_totalMax : -1.0;
+}
+
+qint64 FrameHud::Histogram::totalCount() const
+{
+    return m_totalCount;
+}
+
+double FrameHud::Histogram::recent(int i) const
+{
+    if (i >= m_count) {
+        return -1.0;
+    }
+    return m_samples[(m_next - 1 - i + kWindow) % kWindow];
+}
+
+int FrameHud::Histogram::bin(double ms)
+{
+    if (ms < 10.0) {
+        return qMax(0, int(ms * 100.0));
+    }
+    if (ms < 100.0) {
+        return kFineBins + int((ms - 10.0) * 10.0);
+    }
+    return kBins - 1;
+}
+
+double FrameHud::Histogram::percentileOf(const QVector<int> &bins, qint64 count, double q)
+{
+    if (count == 0) {
+        return -1.0;
+    }
+    // 最近秩法：累加到第ceil(q * n)个样本所在的桶，返回桶的上边界
+    const qint64 rank = qBound(qint64(1), qint64(std::ceil(q * count)), count);
+    qint64 seen = 0;
+    for (int i = 0; i < bins.size(); i++) {
+        seen += bins[i];
+        if (seen >= rank) {
+            if (i < kFineBins) {
+                return (i + 1) * 0.01;
+            }
+            return 10.0 + (i - kFineBins + 1) * 0.1;
+        }
+    }
+    return 100.0;
+}
+
+FrameHud::FrameHud()
+    : m_enabled(enabledFromEnvironment())
+    , m_output(QString::fromLocal8Bit(qgetenv("FRAME_HUD_OUT")))
+    , m_vbo(QOpenGLBuffer::VertexBuffer)
+{
+}
+
+FrameHud::~FrameHud()
+{
+}
+
+void FrameHud::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+}
+
+bool FrameHud::isEnabled() const
+{
+    return m_enabled;
+}
+
+void FrameHud::initialize(QOpenGLWidget *widget)
+{
+    m_widget = widget;
+    m_context = widget->context();
+    m_active = false;
+    if (!m_enabled) {
+        return;
+    }
+
+    // 需要vao和glBindVertexArray（恢复例子自己的vao），gles 2.0上不显示
+    const bool es = m_context->isOpenGLES();
+    if (es && m_context->format().majorVersion() < 3) {
+        qDebug() << "frame hud: needs gles 3.0 or desktop gl 3.3";
+        return;
+    }
+    m_functions = m_context->extraFunctions();
+
+    GLint previousVao = 0;
+    GLint previousBuffer = 0;
+    m_functions->glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previousVao);
+    m_functions->glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &previousBuffer);
+
+    m_program.addShaderFromSourceCode(QOpenGLShader::Vertex, es ? vertexShaderSourceEs : vertexShaderSource);
+    m_program.addShaderFromSourceCode(QOpenGLShader::Fragment, es ? fragmentShaderSourceEs : fragmentShaderSource);
+    m_program.bindAttributeLocation("aPos", 0);
+    m_program.bindAttributeLocation("aColor", 1);
+    if (!m_program.link()) {
+        qDebug() << "frame hud: link failed" << m_program.log();
+        return;
+    }
+    m_viewportLocation = m_program.uniformLocation("uViewport");
+
+    m_vao.create();
+    m_vao.bind();
+    m_vbo.create();
+    m_vbo.bind();
+    m_vbo.setUsagePattern(QOpenGLBuffer::StreamDraw);
+    // 位置为2个float，颜色为4个归一化的unsigned byte
+    m_program.setAttributeBuffer(0, GL_FLOAT, offsetof(Vertex, x), 2, sizeof(Vertex));
+    m_program.enableAttributeArray(0);
+    m_program.setAttributeBuffer(1, GL_UNSIGNED_BYTE, offsetof(Vertex, r), 4, sizeof(Vertex));
+    m_program.enableAttributeArray(1);
+    m_functions->glBindVertexArray(previousVao);
+    m_functions->glBindBuffer(GL_ARRAY_BUFFER, previousBuffer);
+
+    const bool timerSupported = es ? m_context->hasExtension("GL_EXT_disjoint_timer_query")
+                                   : m_context->format().version() >= qMakePair(3, 3)
+                                     || m_context->hasExtension("GL_ARB_timer_query");
+    m_genQueries = resolve<GenQueries>(m_context, "glGenQueries");
+    m_deleteQueries = resolve<DeleteQueries>(m_context, "glDeleteQueries");
+    m_queryCounter = resolve<QueryCounter>(m_context, "glQueryCounter");
+    m_getQueryObjectuiv = resolve<GetQueryObjectuiv>(m_context, "glGetQueryObjectuiv");
+    m_getQueryObjectui64v = resolve<GetQueryObjectui64v>(m_context, "glGetQueryObjectui64v");
+    m_gpuTimer = timerSupported && m_genQueries && m_deleteQueries && m_queryCounter && m_getQueryObjectuiv
+            && m_getQueryObjectui64v;
+    if (m_gpuTimer) {
+        m_queries.resize(kGpuSlots * 2);
+        m_genQueries(m_queries.size(), m_queries.data());
+        m_pendingSlots.fill(false, kGpuSlots);
+    } else {
+        qDebug() << "frame hud: gpu timestamps not supported";
+    }
+
+    // 文字最多kLines * kColumns个字符，每个字符最多5行 * 2段，柱状图每帧kSparkline * 3个矩形
+    m_vertices.reserve((kLines * kColumns * 10 + kSparkline * 3 + 8) * 6);
+    m_clock.start();
+    m_active = true;
+}
+
+void FrameHud::destroy()
+{
+    if (!m_enabled) {
+        return;
+    }
+    if (!m_output.isEmpty() && m_frames > 0) {
+        write();
+    }
+    if (!m_active) {
+        return;
+    }
+    if (!m_queries.isEmpty()) {
+        m_deleteQueries(m_queries.size(), m_queries.constData());
+        m_queries.clear();
+    }
+    m_vbo.destroy();
+    m_vao.destroy();
+    m_program.removeAllShaders();
+    m_active = false;
+}
+
+bool FrameHud::isActive() const
+{
+    return m_active;
+}
+
+void FrameHud::beginFrame()
+{
+    const qint64 startNs = m_clock.nsecsElapsed();
+    if (m_lastFrameStartNs >= 0) {
+        m_series[Interval].add((startNs - m_lastFrameStartNs) / 1e6);
+    }
+    m_lastFrameStartNs = startNs;
+
+    if (m_gpuTimer) {
+        collectGpu();
+        // 4帧之前的结果还没有完成：丢弃，复用这一对查询
+        m_pendingSlots[m_slot] = false;
+        m_queryCounter(m_queries[m_slot * 2], GL_TIMESTAMP);
+    }
+    m_frameStartNs = m_clock.nsecsElapsed();
+    m_beginCostNs = m_frameStartNs - startNs;
+}
+
+void FrameHud::endFrame()
+{
+    const qint64 endNs = m_clock.nsecsElapsed();
+    m_series[Cpu].add((endNs - m_frameStartNs) / 1e6);
+    if (m_gpuTimer) {
+        m_queryCounter(m_queries[m_slot * 2 + 1], GL_TIMESTAMP);
+        m_pendingSlots[m_slot] = true;
+        m_slot = (m_slot + 1) % kGpuSlots;
+    }
+    m_frames++;
+
+    const qreal dpr = m_widget->devicePixelRatioF();
+    const float scale = qMax(1.0f, float(qRound(2.0 * dpr)));
+    if (m_textUpdatedNs < 0 || endNs - m_textUpdatedNs >= kTextIntervalNs) {
+        rebuildText(scale);
+        m_textUpdatedNs = endNs;
+    }
+    m_vertices.resize(m_textVertexCount);
+    appendSparklines(scale);
+    draw();
+
+    m_series[Hud].add((m_beginCostNs + m_clock.nsecsElapsed() - endNs) / 1e6);
+}
+
+void FrameHud::collectGpu()
+{
+    // 从最旧的一帧开始读，遇到还没有完成的就停下，不等待
+    for (int i = 0; i < kGpuSlots; i++) {
+        const int slot = (m_slot + i) % kGpuSlots;
+        if (!m_pendingSlots[slot]) {
+            continue;
+        }
+        GLuint available = GL_FALSE;
+        m_getQueryObjectuiv(m_queries[slot * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            break;
+        }
+        quint64 beginNs = 0;
+        quint64 endNs = 0;
+        m_getQueryObjectui64v(m_queries[slot * 2], GL_QUERY_RESULT, &beginNs);
+        m_getQueryObjectui64v(m_queries[slot * 2 + 1], GL_QUERY_RESULT, &endNs);
+        m_series[Gpu].add((endNs - beginNs) / 1e6);
+        m_pendingSlots[slot] = false;
+    }
+}
+
+void FrameHud::rebuildText(float scale)
+{
+    m_vertices.clear();
+
+    const float x = kMargin * scale;
+    const float y = kMargin * scale;
+    const float textWidth = kColumns * kGlyphAdvance * scale;
+    const float sparklineWidth = kSparkline * scale;
+    const float width = qMax(textWidth, sparklineWidth) + 2 * kPadding * scale;
+    const float height = (2 * kPadding + kLines * kLineAdvance + 3 * (kSparklineHeight + kSparklineGap)) * scale;
+    appendRect(x, y, width, height, kBackgroundColor);
+
+    char line[64];
+    std::snprintf(line, sizeof(line), "%-4s%6s%6s%6s%6s", "MS", "P50", "P95", "P99", "MAX");
+    appendText(line, x + kPadding * scale, y + kPadding * scale, scale, kHeaderColor);
+    for (int series = 0; series < SeriesCount; series++) {
+        const Histogram& histogram = m_series[series];
+        const double values[] = {histogram.percentile(0.50), histogram.percentile(0.95),
+                                 histogram.percentile(0.99), histogram.windowMax()};
+        int length = std::snprintf(line, sizeof(line), "%-4s", kSeriesLabels[series]);
+        for (double value : values) {
+            // HUD自己的耗时在0.1ms以内，多显示一位
+            if (value < 0.0) {
+                length += std::snprintf(line + length, sizeof(line) - length, "%6s", "-");
+            } else {
+                length += std::snprintf(line + length, sizeof(line) - length, series == Hud ? "%6.3f" : "%6.2f",
+                                        qMin(value, 999.99));
+            }
+        }
+        appendText(line, x + kPadding * scale, y + (kPadding + (series + 1) * kLineAdvance) * scale, scale,
+                   kSeriesColors[series]);
+    }
+    m_textVertexCount = m_vertices.size();
+}
+
+void FrameHud::appendText(const char *text, float x, float y, float scale, const quint8 *color)
+{
+    for (const char* p = text; *p; p++, x += kGlyphAdvance * scale) {
+        const quint16 bits = glyph(*p);
+        if (!bits) {
+            continue;
+        }
+        // 每行连续的点合并为一个矩形
+        for (int row = 0; row < 5; row++) {
+            const int rowBits = (bits >> (3 * (4 - row))) & 7;
+            int column = 0;
+            while (column < 3) {
+                if (!(rowBits & (4 >> column))) {
+                    column++;
+                    continue;
+                }
+                const int start = column;
+                while (column < 3 && (rowBits & (4 >> column))) {
+                    column++;
+                }
+                appendRect(x + start * scale, y + row * scale, (column - start) * scale, scale, color);
+            }
+        }
+    }
+}
+
+void FrameHud::appendRect(float x, float y, float w, float h, const quint8 *color)
+{
+    const Vertex corners[] = {
+        {x, y, color[0], color[1], color[2], color[3]},
+        {x + w, y, color[0], color[1], color[2], color[3]},
+        {x + w, y + h, color[0], color[1], color[2], color[3]},
+        {x, y + h, color[0], color[1], color[2], color[3]},
+    };
+    m_vertices.append(corners[0]);
+    m_vertices.append(corners[1]);
+    m_vertices.append(corners[2]);
+    m_vertices.append(corners[0]);
+    m_vertices.append(corners[2]);
+    m_vertices.append(corners[3]);
+}
+
+void FrameHud::appendSparklines(float scale)
+{
+    // cpu、gpu、present间隔各一行，最新的一帧在最右边，超过kSparklineMaxMs的用红色画满
+    const float x = (kMargin + kPadding) * scale;
+    float y = (kMargin + kPadding + kLines * kLineAdvance + kSparklineGap) * scale;
+    const float height = kSparklineHeight * scale;
+    const int series[] = {Cpu, Gpu, Interval};
+    for (int s : series) {
+        const Histogram& histogram = m_series[s];
+        for (int i = 0; i < kSparkline; i++) {
+            const double value = histogram.recent(i);
+            if (value < 0.0) {
+                break;
+            }
+            const bool overflow = value > kSparklineMaxMs;
+            const float barHeight = overflow ? height : qMax(1.0f, float(value) / kSparklineMaxMs * height);
+            appendRect(x + (kSparkline - 1 - i) * scale, y + height - barHeight, scale, barHeight,
+                       overflow ? kOverflowColor : kSeriesColors[s]);
+        }
+        // 16.7ms参考线
+        appendRect(x, y + height / 2, kSparkline * scale, 1.0f, kGuideColor);
+        y += (kSparklineHeight + kSparklineGap) * scale;
+    }
+}
+
+void FrameHud::draw()
+{
+    QOpenGLExtraFunctions* f = m_functions;
+
+    // 保存例子的状态，画完以后恢复，不影响下一帧
+    GLint program = 0;
+    GLint vao = 0;
+    GLint buffer = 0;
+    GLint viewport[4] = {};
+    GLint blendSrcRgb = 0;
+    GLint blendDstRgb = 0;
+    GLint blendSrcAlpha = 0;
+    GLint blendDstAlpha = 0;
+    f->glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+    f->glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vao);
+    f->glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &buffer);
+    f->glGetIntegerv(GL_VIEWPORT, viewport);
+    f->glGetIntegerv(GL_BLEND_SRC_RGB, &blendSrcRgb);
+    f->glGetIntegerv(GL_BLEND_DST_RGB, &blendDstRgb);
+    f->glGetIntegerv(GL_BLEND_SRC_ALPHA, &blendSrcAlpha);
+    f->glGetIntegerv(GL_BLEND_DST_ALPHA, &blendDstAlpha);
+    const GLboolean blend = f->glIsEnabled(GL_BLEND);
+    const GLboolean depthTest = f->glIsEnabled(GL_DEPTH_TEST);
+    const GLboolean cullFace = f->glIsEnabled(GL_CULL_FACE);
+    const GLboolean scissorTest = f->glIsEnabled(GL_SCISSOR_TEST);
+
+    const qreal dpr = m_widget->devicePixelRatioF();
+    const int width = qRound(m_widget->width() * dpr);
+    const int height = qRound(m_widget->height() * dpr);
+    f->glViewport(0, 0, width, height);
+    f->glEnable(GL_BLEND);
+    // 不改变目标的alpha，避免窗口合成时HUD的区域变成半透明
+    f->glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ZERO, GL_ONE);
+    f->glDisable(GL_DEPTH_TEST);
+    f->glDisable(GL_CULL_FACE);
+    f->glDisable(GL_SCISSOR_TEST);
+
+    m_program.bind();
+    m_program.setUniformValue(m_viewportLocation, GLfloat(width), GLfloat(height));
+    m_vao.bind();
+    m_vbo.bind();
+    // 每帧重新分配（orphan），不等待上一帧还在使用的缓冲
+    m_vbo.allocate(m_vertices.constData(), m_vertices.size() * int(sizeof(Vertex)));
+    f->glDrawArrays(GL_TRIANGLES, 0, m_vertices.size());
+
+    f->glBindVertexArray(vao);
+    f->glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    f->glUseProgram(program);
+    f->glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    f->glBlendFuncSeparate(blendSrcRgb, blendDstRgb, blendSrcAlpha, blendDstAlpha);
+    if (!blend) {
+        f->glDisable(GL_BLEND);
+    }
+    if (depthTest) {
+        f->glEnable(GL_DEPTH_TEST);
+    }
+    if (cullFace) {
+        f->glEnable(GL_CULL_FACE);
+    }
+    if (scissorTest) {
+        f->glEnable(GL_SCISSOR_TEST);
+    }
+}
+
+void FrameHud::write() const
+{
+    QJsonObject result;
+    result["example"] = QCoreApplication::applicationName();
+    result["frames"] = m_frames;
+    result["gpu_timer"] = m_gpuTimer;
+    for (int series = 0; series < SeriesCount; series++) {
+        const Histogram& histogram = m_series[series];
+        if (histogram.totalCount() == 0) {
+            continue;
+        }
+        // 百分位为直方图桶的上边界（10ms以内0.01ms，10~100ms 0.1ms）
+        QJsonObject summary;
+        summary["count"] = histogram.totalCount();
+        summary["mean"] = histogram.totalMean();
+        summary["p50"] = histogram.totalPercentile(0.50);
+        summary["p95"] = histogram.totalPercentile(0.95);
+        summary["p99"] = histogram.totalPercentile(0.99);
+        summary["max"] = histogram.totalMax();
+        result[QString("%1_ms").arg(kSeriesNames[series])] = summary;
+    }
+
+    QFile file(m_output);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "frame hud: can't write" << m_output << file.errorString();
+        return;
+    }
+    file.write(QJsonDocument(result).toJson());
+    qDebug().noquote() << QString("frame hud: %1 frames -> %2").arg(m_frames).arg(QFileInfo(file).absoluteFilePath());
+}
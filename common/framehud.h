@@ -0,0 +1,179 @@
+#ifndef FRAMEHUD_H
+#define FRAMEHUD_H
+
+#include <QString>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QOpenGLBuffer>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLVertexArrayObject>
+
+class QOpenGLWidget;
+class QOpenGLContext;
+class QOpenGLExtraFunctions;
+
+/*
+ * 帧统计HUD：在QOpenGLWidget的左上角叠加显示最近600帧的p50/p95/p99/max和最近120帧的柱状图
+ *   CPU：paintGL的cpu耗时（不包括HUD自己）
+ *   GPU：paintGL开始和结束之间的gpu时间，各一个glQueryCounter(GL_TIMESTAMP)（可以和GpuProfiler的GL_TIME_ELAPSED同时使用），
+ *        结果完成以后才读取，不等待；不支持timer query时不显示
+ *   INT：相邻两次paintGL开始的间隔（present间隔）
+ *   HUD：HUD自己的cpu耗时（统计、生成顶点、上传、绘制），目标是每帧0.1ms以内
+ *
+ * 百分位不排序：每个指标一个滚动直方图（10ms以内0.01ms一个桶，10~100ms 0.1ms一个桶，100ms以上算一个桶），新样本加一、移出窗口的样本减一，
+ * 查询时累加到目标个数；文字每250ms更新一次，只有这时才计算百分位、重新生成文字的顶点
+ * 背景、文字（内置的3x5点阵字体，每行连续的点合并为一个矩形）和柱状图都放在同一个vbo里，一次glDrawArrays画完
+ *
+ * 默认关闭，环境变量开启，不需要修改main：
+ *   FRAME_HUD=1 ./Blend
+ *   FRAME_HUD=1 FRAME_HUD_OUT=blend_hud.json ./Blend   // 退出时把整个运行期间的统计写为json
+ *
+ * 使用方法：
+ * 1. initializeGL中调用initialize(this)
+ * 2. paintGL的第一行：FrameHud::Frame hudFrame(m_hud); 作用域结束（包括提前return）时统计这一帧并绘制HUD
+ * 3. 析构时在makeCurrent()之后调用destroy()
+*/
+class FrameHud
+{
+public:
+    class Frame
+    {
+    public:
+        explicit Frame(FrameHud& hud)
+            : m_hud(hud)
+        {
+            if (m_hud.m_active) {
+                m_hud.beginFrame();
+            }
+        }
+
+        ~Frame()
+        {
+            if (m_hud.m_active) {
+                m_hud.endFrame();
+            }
+        }
+
+    private:
+        Q_DISABLE_COPY(Frame)
+        FrameHud& m_hud;
+    };
+
+    FrameHud();
+    ~FrameHud();
+
+    // 默认根据环境变量FRAME_HUD确定，需要在initialize()之前调用
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    // 需要在context current时调用
+    void initialize(QOpenGLWidget* widget);
+    // 设置了FRAME_HUD_OUT时写json，然后释放gl资源
+    void destroy();
+    bool isActive() const;
+
+private:
+    enum Series
+    {
+        Cpu,
+        Gpu,
+        Interval,
+        Hud,
+        SeriesCount
+    };
+
+    // 最近kWindow个样本的滚动直方图，加上整个运行期间的直方图（退出时输出）
+    class Histogram
+    {
+    public:
+        Histogram();
+
+        void add(double ms);
+        // 0 <= q <= 1，返回桶的上边界（ms），没有样本时为-1
+        double percentile(double q) const;
+        double windowMax() const;
+        double totalPercentile(double q) const;
+        double totalMean() const;
+        double totalMax() const;
+        qint64 totalCount() const;
+        // 最近的第i个样本（0为最新），超出范围时为-1
+        double recent(int i) const;
+
+    private:
+        static int bin(double ms);
+        static double percentileOf(const QVector<int>& bins, qint64 count, double q);
+
+        QVector<int> m_window;
+        QVector<int> m_total;
+        QVector<float> m_samples;
+        int m_next = 0;
+        int m_count = 0;
+        qint64 m_totalCount = 0;
+        double m_totalSum = 0.0;
+        double m_totalMax = 0.0;
+    };
+
+    struct Vertex
+    {
+        float x;
+        float y;
+        quint8 r;
+        quint8 g;
+        quint8 b;
+        quint8 a;
+    };
+
+    typedef void (QOPENGLF_APIENTRYP GenQueries)(GLsizei n, GLuint* ids);
+    typedef void (QOPENGLF_APIENTRYP DeleteQueries)(GLsizei n, const GLuint* ids);
+    typedef void (QOPENGLF_APIENTRYP QueryCounter)(GLuint id, GLenum target);
+    typedef void (QOPENGLF_APIENTRYP GetQueryObjectuiv)(GLuint id, GLenum pname, GLuint* params);
+    typedef void (QOPENGLF_APIENTRYP GetQueryObjectui64v)(GLuint id, GLenum pname, quint64* params);
+
+    void beginFrame();
+    void endFrame();
+    void collectGpu();
+    void rebuildText(float scale);
+    void appendText(const char* text, float x, float y, float scale, const quint8* color);
+    void appendRect(float x, float y, float w, float h, const quint8* color);
+    void appendSparklines(float scale);
+    void draw();
+    void write() const;
+
+private:
+    bool m_enabled = false;
+    bool m_active = false;
+    QString m_output;
+    QOpenGLWidget* m_widget = nullptr;
+    QOpenGLContext* m_context = nullptr;
+    QOpenGLExtraFunctions* m_functions = nullptr;
+
+    QOpenGLShaderProgram m_program;
+    QOpenGLVertexArrayObject m_vao;
+    QOpenGLBuffer m_vbo;
+    int m_viewportLocation = -1;
+
+    // gpu时间：每帧一对时间戳，kGpuSlots帧的查询轮流使用
+    GenQueries m_genQueries = nullptr;
+    DeleteQueries m_deleteQueries = nullptr;
+    QueryCounter m_queryCounter = nullptr;
+    GetQueryObjectuiv m_getQueryObjectuiv = nullptr;
+    GetQueryObjectui64v m_getQueryObjectui64v = nullptr;
+    bool m_gpuTimer = false;
+    QVector<GLuint> m_queries;
+    QVector<bool> m_pendingSlots;
+    int m_slot = 0;
+
+    QElapsedTimer m_clock;
+    qint64 m_frameStartNs = -1;
+    qint64 m_beginCostNs = 0;
+    qint64 m_lastFrameStartNs = -1;
+    qint64 m_textUpdatedNs = -1;
+    qint64 m_frames = 0;
+    Histogram m_series[SeriesCount];
+
+    // 前m_textVertexCount个是背景和文字，只在更新文字时重新生成，柱状图每帧追加在后面
+    QVector<Vertex> m_vertices;
+    int m_textVertexCount = 0;
+};
+
+#endif // FRAMEHUD_H
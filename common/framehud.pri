@@ -0,0 +1,8 @@
+# 帧统计HUD：FRAME_HUD=1时在窗口左上角显示cpu/gpu/present间隔的p50/p95/p99和柱状图，FRAME_HUD_OUT=文件路径时退出时写json
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/framehud.h
+
+SOURCES += \
+    $$PWD/framehud.cpp
@@ -0,0 +1,165 @@
+#include "framescheduler.h"
+
+#include <cmath>
+
+#include <QScreen>
+#include <QWindow>
+#include <QOpenGLWidget>
+#include <QGuiApplication>
+
+QString FrameScheduler::Stats::summary() const
+{
+    return QString("%1 fps, interval %2 ms, jitter %3 ms, max %4 ms, paint %5 ms, skipped %6")
+            .arg(fps, 0, 'f', 1)
+            .arg(avgIntervalMs, 0, 'f', 2)
+            .arg(jitterMs, 0, 'f', 2)
+            .arg(maxIntervalMs, 0, 'f', 2)
+            .arg(lastPaintMs, 0, 'f', 2)
+            .arg(skippedIntervals);
+}
+
+FrameScheduler::FrameScheduler(QOpenGLWidget *widget)
+    : QObject(widget)
+    , m_widget(widget)
+{
+    m_skipTimer.setSingleShot(true);
+    // 跳过的是整数个刷新周期，需要毫秒精度
+    m_skipTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_skipTimer, &QTimer::timeout, this, &FrameScheduler::requestFrame);
+    connect(m_widget, &QOpenGLWidget::frameSwapped, this, &FrameScheduler::onFrameSwapped);
+}
+
+void FrameScheduler::start()
+{
+    if (m_running) {
+        return;
+    }
+    m_running = true;
+    if (!m_clock.isValid()) {
+        m_clock.start();
+    }
+    // 停止期间的时间不计入动画时间
+    m_lastFrameNs = -1;
+    requestFrame();
+}
+
+void FrameScheduler::stop()
+{
+    m_running = false;
+    m_skipTimer.stop();
+}
+
+bool FrameScheduler::isRunning() const
+{
+    return m_running;
+}
+
+void FrameScheduler::setAdaptiveFrameSkip(bool enabled)
+{
+    m_adaptiveFrameSkip = enabled;
+}
+
+void FrameScheduler::setMaxDeltaTime(double seconds)
+{
+    m_maxDeltaTime = seconds;
+}
+
+double FrameScheduler::beginFrame()
+{
+    if (!m_clock.isValid()) {
+        m_clock.start();
+    }
+    const qint64 now = m_clock.nsecsElapsed();
+    m_paintStartNs = now;
+
+    // 第一帧（或者重新start以后的第一帧）时间间隔为0
+    m_deltaTime = 0.0;
+    if (m_lastFrameNs >= 0) {
+        const qint64 interval = now - m_lastFrameNs;
+        m_intervals[m_intervalHead] = interval;
+        m_intervalHead = (m_intervalHead + 1) % kStatsWindow;
+        m_intervalCount = qMin(m_intervalCount + 1, int(kStatsWindow));
+        m_deltaTime = qMin(interval / 1e9, m_maxDeltaTime);
+    }
+    m_lastFrameNs = now;
+    m_time += m_deltaTime;
+    return m_deltaTime;
+}
+
+void FrameScheduler::endFrame()
+{
+    m_lastPaintNs = m_clock.nsecsElapsed() - m_paintStartNs;
+}
+
+double FrameScheduler::refreshIntervalMs() const
+{
+    QScreen* screen = nullptr;
+    QWindow* window = m_widget->window()->windowHandle();
+    if (window) {
+        screen = window->screen();
+    }
+    if (!screen) {
+        screen = QGuiApplication::primaryScreen();
+    }
+    const double refreshRate = screen ? screen->refreshRate() : 0.0;
+    return 1000.0 / (refreshRate > 0.0 ? refreshRate : 60.0);
+}
+
+FrameScheduler::Stats FrameScheduler::stats() const
+{
+    Stats stats;
+    stats.frames = m_intervalCount;
+    stats.lastPaintMs = m_lastPaintNs / 1e6;
+    stats.skippedIntervals = m_skippedIntervals;
+    if (m_intervalCount == 0) {
+        return stats;
+    }
+
+    double sum = 0.0;
+    double max = 0.0;
+    for (int i = 0; i < m_intervalCount; i++) {
+        const double ms = m_intervals[i] / 1e6;
+        sum += ms;
+        max = qMax(max, ms);
+    }
+    const double avg = sum / m_intervalCount;
+    double variance = 0.0;
+    for (int i = 0; i < m_intervalCount; i++) {
+        const double diff = m_intervals[i] / 1e6 - avg;
+        variance += diff * diff;
+    }
+
+    stats.avgIntervalMs = avg;
+    stats.fps = avg > 0.0 ? 1000.0 / avg : 0.0;
+    stats.jitterMs = std::sqrt(variance / m_intervalCount);
+    stats.maxIntervalMs = max;
+    return stats;
+}
+
+void FrameScheduler::onFrameSwapped()
+{
+    if (!m_running) {
+        return;
+    }
+
+    if (m_adaptiveFrameSkip) {
+        // paintGL超过了一个刷新周期，下一帧一定会错过垂直同步，
+        // 干脆多等待整数个刷新周期，帧间隔保持稳定（动画按时间推进，速度不变）
+        const double refreshMs = refreshIntervalMs();
+        const double paintMs = m_lastPaintNs / 1e6;
+        const int skip = int(std::ceil(paintMs / refreshMs)) - 1;
+        if (skip > 0) {
+            m_skippedIntervals += skip;
+            m_skipTimer.start(int(skip * refreshMs));
+            return;
+        }
+    }
+    requestFrame();
+}
+
+void FrameScheduler::requestFrame()
+{
+    if (m_running) {
+        m_widget->update();
+    }
+}
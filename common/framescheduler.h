@@ -0,0 +1,100 @@
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QString>
+#include <QElapsedTimer>
+
+class QOpenGLWidget;
+
+/*
+ * 动画帧调度：代替paintGL中的QTimer::singleShot(100, ...) + static int count
+ * 1. 单调时钟（QElapsedTimer）计算每帧的时间间隔，动画按时间推进（速度 * time()），和帧率无关
+ * 2. 每帧swap完成（QOpenGLWidget::frameSwapped）以后才请求下一帧，开启垂直同步（默认swapInterval为1）时
+ *    帧率自然被限制为屏幕刷新率，每帧只有一次update请求，不会因为paintGL被其他原因触发而叠加定时器
+ * 3. 可选的自适应跳帧：paintGL的cpu耗时超过一个刷新周期时，下一帧延后若干个刷新周期再请求，
+ *    保持稳定的低帧率，而不是时快时慢地错过垂直同步
+ * 4. 统计最近一段时间的帧间隔、抖动（帧间隔的标准差）和跳过的刷新周期数
+ *
+ * 使用方法：
+ * 1. 构造时传入控件，show之前或initializeGL中调用start()
+ * 2. paintGL开始时调用beginFrame()，结束时调用endFrame()，动画使用time()/deltaTime()
+*/
+class FrameScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Stats
+    {
+        // 统计窗口内的帧数
+        int frames = 0;
+        double fps = 0.0;
+        double avgIntervalMs = 0.0;
+        // 帧间隔的标准差
+        double jitterMs = 0.0;
+        double maxIntervalMs = 0.0;
+        // 最近一帧paintGL的cpu耗时
+        double lastPaintMs = 0.0;
+        // 自适应跳帧跳过的刷新周期总数
+        int skippedIntervals = 0;
+
+        // 例如 "60.0 fps, interval 16.67 ms, jitter 0.21 ms, max 17.40 ms, paint 1.20 ms, skipped 0"
+        QString summary() const;
+    };
+
+    explicit FrameScheduler(QOpenGLWidget* widget);
+
+    void start();
+    void stop();
+    bool isRunning() const;
+
+    // paintGL的cpu耗时超过一个刷新周期时跳过刷新周期，默认关闭
+    void setAdaptiveFrameSkip(bool enabled);
+    // 两帧之间时间间隔的上限（秒），窗口被隐藏或者调试断点停住以后动画不会突然跳一大步，默认0.1秒
+    void setMaxDeltaTime(double seconds);
+
+    // paintGL开始时调用，推进动画时钟，返回和上一帧的时间间隔（秒）
+    double beginFrame();
+    // paintGL结束时调用，记录本帧的cpu耗时
+    void endFrame();
+
+    // 动画时间（秒），等于所有帧时间间隔的和
+    double time() const { return m_time; }
+    double deltaTime() const { return m_deltaTime; }
+    // 屏幕刷新周期
+    double refreshIntervalMs() const;
+
+    // 最近kStatsWindow帧的统计
+    Stats stats() const;
+
+private:
+    void onFrameSwapped();
+    void requestFrame();
+
+private:
+    enum { kStatsWindow = 120 };
+
+    QOpenGLWidget* m_widget = nullptr;
+    bool m_running = false;
+    bool m_adaptiveFrameSkip = false;
+    double m_maxDeltaTime = 0.1;
+    // 跳过刷新周期时延后请求下一帧，只有一个定时器，重复start只会重新计时
+    QTimer m_skipTimer;
+
+    QElapsedTimer m_clock;
+    qint64 m_lastFrameNs = -1;
+    qint64 m_paintStartNs = 0;
+    qint64 m_lastPaintNs = 0;
+    double m_time = 0.0;
+    double m_deltaTime = 0.0;
+
+    // 最近kStatsWindow帧的帧间隔（ns），环形缓冲
+    qint64 m_intervals[kStatsWindow];
+    int m_intervalCount = 0;
+    int m_intervalHead = 0;
+    int m_skippedIntervals = 0;
+};
+
+#endif // FRAMESCHEDULER_H
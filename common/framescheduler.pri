@@ -0,0 +1,8 @@
+# 动画帧调度：单调时钟按时间推进动画，frameSwapped驱动重绘（垂直同步限制为屏幕刷新率），可选自适应跳帧和帧间隔抖动统计
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/framescheduler.h
+
+SOURCES += \
+    $$PWD/framescheduler.cpp
@@ -0,0 +1,308 @@
+#include "frustumculler.h"
+
+#include <cmath>
+#include <chrono>
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#  define FRUSTUMCULLER_X86 1
+// gcc/clang：只有这个函数使用AVX指令编译，其他代码不受影响，不支持AVX的cpu上不会调用它
+#  define FRUSTUMCULLER_TARGET_AVX __attribute__((target("avx")))
+#  include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#  define FRUSTUMCULLER_X86 1
+// msvc不需要/arch:AVX也可以使用AVX intrinsics
+#  define FRUSTUMCULLER_TARGET_AVX
+#  include <intrin.h>
+#  include <immintrin.h>
+#endif
+
+namespace {
+
+int paddedSize(int count)
+{
+    return (count + 7) & ~7;
+}
+
+}
+
+FrustumCuller::FrustumCuller()
+    : m_backend(bestBackend())
+{
+    // 默认不剔除任何东西：6个平面都是 0*x+0*y+0*z+1 >= 0
+    for (int i = 0; i < 6; i++) {
+        m_planes[0][i] = 0.0f;
+        m_planes[1][i] = 0.0f;
+        m_planes[2][i] = 0.0f;
+        m_planes[3][i] = 1.0f;
+    }
+}
+
+void FrustumCuller::clear()
+{
+    m_count = 0;
+    resizeArrays(0);
+}
+
+void FrustumCuller::reserve(int count)
+{
+    const size_t capacity = paddedSize(count);
+    m_centerX.reserve(capacity);
+    m_centerY.reserve(capacity);
+    m_centerZ.reserve(capacity);
+    m_halfX.reserve(capacity);
+    m_halfY.reserve(capacity);
+    m_halfZ.reserve(capacity);
+}
+
+int FrustumCuller::addBox(float centerX, float centerY, float centerZ, float halfX, float halfY, float halfZ)
+{
+    const int index = m_count++;
+    if (paddedSize(m_count) > int(m_centerX.size())) {
+        resizeArrays(paddedSize(m_count));
+    }
+
+    m_centerX[index] = centerX;
+    m_centerY[index] = centerY;
+    m_centerZ[index] = centerZ;
+    m_halfX[index] = halfX;
+    m_halfY[index] = halfY;
+    m_halfZ[index] = halfZ;
+    return index;
+}
+
+void FrustumCuller::setFrustum(const float *viewProjection)
+{
+    // 列主序：第r行第c列为m[c * 4 + r]
+    const float* m = viewProjection;
+    auto row = [m](int r, int c) { return m[c * 4 + r]; };
+
+    // 裁剪空间中点在视锥体内的条件：-w<=x<=w, -w<=y<=w, -w<=z<=w
+    // 即 (row3 + row0)·p >= 0 (左)，(row3 - row0)·p >= 0 (右)，y/z同理
+    for (int i = 0; i < 6; i++) {
+        const int axis = i / 2;
+        const float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+        float plane[4];
+        for (int c = 0; c < 4; c++) {
+            plane[c] = row(3, c) + sign * row(axis, c);
+        }
+
+        // 归一化平面方程，dist为真实的距离（不影响剔除结果，方便调试）
+        const float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        const float scale = length > 0.0f ? 1.0f / length : 1.0f;
+        for (int c = 0; c < 4; c++) {
+            m_planes[c][i] = plane[c] * scale;
+        }
+    }
+}
+
+int FrustumCuller::cull(std::vector<int> &visible)
+{
+    visible.resize(m_count);
+
+    const auto start = std::chrono::steady_clock::now();
+    int visibleCount = 0;
+    switch (m_backend) {
+    case AVX:
+        visibleCount = cullAVX(visible.data());
+        break;
+    case SSE:
+        visibleCount = cullSSE(visible.data());
+        break;
+    default:
+        visibleCount = cullScalar(visible.data());
+        break;
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    visible.resize(visibleCount);
+
+    m_stats.tested = m_count;
+    m_stats.visible = visibleCount;
+    m_stats.culled = m_count - visibleCount;
+    m_stats.cullTimeUs = std::chrono::duration<double, std::micro>(end - start).count();
+    return visibleCount;
+}
+
+void FrustumCuller::setBackend(Backend backend)
+{
+    const Backend best = bestBackend();
+    m_backend = backend > best ? best : backend;
+}
+
+FrustumCuller::Backend FrustumCuller::bestBackend()
+{
+#if defined(FRUSTUMCULLER_X86) && defined(__GNUC__)
+    return __builtin_cpu_supports("avx") ? AVX : SSE;
+#elif defined(FRUSTUMCULLER_X86) && defined(_MSC_VER)
+    // cpuid: AVX(ecx bit 28)和OSXSAVE(ecx bit 27)，并且操作系统保存了ymm寄存器(xcr0 bit 1/2)
+    int info[4];
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+        return AVX;
+    }
+    return SSE;
+#else
+    return Scalar;
+#endif
+}
+
+const char *FrustumCuller::backendName(Backend backend)
+{
+    switch (backend) {
+    case AVX:
+        return "AVX";
+    case SSE:
+        return "SSE";
+    default:
+        return "Scalar";
+    }
+}
+
+void FrustumCuller::resizeArrays(int capacity)
+{
+    m_centerX.resize(capacity, 0.0f);
+    m_centerY.resize(capacity, 0.0f);
+    m_centerZ.resize(capacity, 0.0f);
+    m_halfX.resize(capacity, 0.0f);
+    m_halfY.resize(capacity, 0.0f);
+    m_halfZ.resize(capacity, 0.0f);
+}
+
+int FrustumCuller::cullScalar(int *visible) const
+{
+    int visibleCount = 0;
+    for (int i = 0; i < m_count; i++) {
+        bool outside = false;
+        for (int p = 0; p < 6 && !outside; p++) {
+            const float a = m_planes[0][p];
+            const float b = m_planes[1][p];
+            const float c = m_planes[2][p];
+            const float dist = a * m_centerX[i] + b * m_centerY[i] + c * m_centerZ[i] + m_planes[3][p];
+            const float radius = std::fabs(a) * m_halfX[i] + std::fabs(b) * m_halfY[i] + std::fabs(c) * m_halfZ[i];
+            outside = dist + radius < 0.0f;
+        }
+        if (!outside) {
+            visible[visibleCount++] = i;
+        }
+    }
+    return visibleCount;
+}
+
+#ifdef FRUSTUMCULLER_X86
+
+int FrustumCuller::cullSSE(int *visible) const
+{
+    // 清除符号位得到绝对值
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 zero = _mm_setzero_ps();
+
+    __m128 planeA[6], planeB[6], planeC[6], planeD[6];
+    __m128 absA[6], absB[6], absC[6];
+    for (int p = 0; p < 6; p++) {
+        planeA[p] = _mm_set1_ps(m_planes[0][p]);
+        planeB[p] = _mm_set1_ps(m_planes[1][p]);
+        planeC[p] = _mm_set1_ps(m_planes[2][p]);
+        planeD[p] = _mm_set1_ps(m_planes[3][p]);
+        absA[p] = _mm_and_ps(planeA[p], absMask);
+        absB[p] = _mm_and_ps(planeB[p], absMask);
+        absC[p] = _mm_and_ps(planeC[p], absMask);
+    }
+
+    int visibleCount = 0;
+    for (int i = 0; i < m_count; i += 4) {
+        const __m128 cx = _mm_loadu_ps(&m_centerX[i]);
+        const __m128 cy = _mm_loadu_ps(&m_centerY[i]);
+        const __m128 cz = _mm_loadu_ps(&m_centerZ[i]);
+        const __m128 ex = _mm_loadu_ps(&m_halfX[i]);
+        const __m128 ey = _mm_loadu_ps(&m_halfY[i]);
+        const __m128 ez = _mm_loadu_ps(&m_halfZ[i]);
+
+        // 4个包围盒同时和6个平面比较，任意一个平面的外侧即为不可见
+        __m128 outside = _mm_setzero_ps();
+        for (int p = 0; p < 6; p++) {
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(planeA[p], cx), _mm_mul_ps(planeB[p], cy)),
+                                                _mm_mul_ps(planeC[p], cz)), planeD[p]);
+            __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absA[p], ex), _mm_mul_ps(absB[p], ey)),
+                                       _mm_mul_ps(absC[p], ez));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(dist, radius), zero));
+        }
+
+        int mask = ~_mm_movemask_ps(outside) & 0xf;
+        if (m_count - i < 4) {
+            mask &= (1 << (m_count - i)) - 1;
+        }
+        // movemask的第k位对应第i+k个包围盒
+        for (int lane = 0; mask; lane++, mask >>= 1) {
+            if (mask & 1) {
+                visible[visibleCount++] = i + lane;
+            }
+        }
+    }
+    return visibleCount;
+}
+
+FRUSTUMCULLER_TARGET_AVX int FrustumCuller::cullAVX(int *visible) const
+{
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 zero = _mm256_setzero_ps();
+
+    __m256 planeA[6], planeB[6], planeC[6], planeD[6];
+    __m256 absA[6], absB[6], absC[6];
+    for (int p = 0; p < 6; p++) {
+        planeA[p] = _mm256_set1_ps(m_planes[0][p]);
+        planeB[p] = _mm256_set1_ps(m_planes[1][p]);
+        planeC[p] = _mm256_set1_ps(m_planes[2][p]);
+        planeD[p] = _mm256_set1_ps(m_planes[3][p]);
+        absA[p] = _mm256_and_ps(planeA[p], absMask);
+        absB[p] = _mm256_and_ps(planeB[p], absMask);
+        absC[p] = _mm256_and_ps(planeC[p], absMask);
+    }
+
+    int visibleCount = 0;
+    for (int i = 0; i < m_count; i += 8) {
+        const __m256 cx = _mm256_loadu_ps(&m_centerX[i]);
+        const __m256 cy = _mm256_loadu_ps(&m_centerY[i]);
+        const __m256 cz = _mm256_loadu_ps(&m_centerZ[i]);
+        const __m256 ex = _mm256_loadu_ps(&m_halfX[i]);
+        const __m256 ey = _mm256_loadu_ps(&m_halfY[i]);
+        const __m256 ez = _mm256_loadu_ps(&m_halfZ[i]);
+
+        // 8个包围盒同时和6个平面比较
+        __m256 outside = _mm256_setzero_ps();
+        for (int p = 0; p < 6; p++) {
+            __m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeA[p], cx), _mm256_mul_ps(planeB[p], cy)),
+                                                      _mm256_mul_ps(planeC[p], cz)), planeD[p]);
+            __m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(absA[p], ex), _mm256_mul_ps(absB[p], ey)),
+                                          _mm256_mul_ps(absC[p], ez));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(dist, radius), zero, _CMP_LT_OQ));
+        }
+
+        int mask = ~_mm256_movemask_ps(outside) & 0xff;
+        if (m_count - i < 8) {
+            mask &= (1 << (m_count - i)) - 1;
+        }
+        for (int lane = 0; mask; lane++, mask >>= 1) {
+            if (mask & 1) {
+                visible[visibleCount++] = i + lane;
+            }
+        }
+    }
+    return visibleCount;
+}
+
+#else
+
+// 非x86平台：setBackend()不会选中SIMD实现，这里只是保证链接通过
+int FrustumCuller::cullSSE(int *visible) const
+{
+    return cullScalar(visible);
+}
+
+int FrustumCuller::cullAVX(int *visible) const
+{
+    return cullScalar(visible);
+}
+
+#endif
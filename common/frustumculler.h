@@ -0,0 +1,83 @@
+#ifndef FRUSTUMCULLER_H
+#define FRUSTUMCULLER_H
+
+#include <vector>
+
+/*
+ * 视锥体剔除：在提交绘制之前，把完全在视锥体外面的物体（AABB包围盒）剔除掉
+ *
+ * 1. 视锥体的6个平面直接从 投影矩阵*观察矩阵 中提取（Gribb/Hartmann方法），
+ *    裁剪空间中 -w<=x<=w 等6个不等式，展开后就是世界空间中的6个平面方程
+ * 2. 包围盒按照SoA（Structure of Arrays）布局存储：中心点x/y/z和半边长x/y/z各一个连续数组，
+ *    一条SIMD指令可以同时处理4个（SSE）或8个（AVX）包围盒
+ * 3. 对每个平面(n, d)：包围盒中心到平面的距离 dist = n·c + d，包围盒在法线方向上的投影半径 r = |n|·e，
+ *    dist < -r 说明整个包围盒都在平面外侧，可以剔除
+ *
+ * AVX在运行时检测cpu是否支持，不支持时使用SSE，非x86平台使用标量实现，结果完全一致
+ * 这里只依赖标准库，矩阵为列主序的16个float（即QMatrix4x4::constData()的布局）
+*/
+class FrustumCuller
+{
+public:
+    enum Backend {
+        Scalar,
+        SSE,
+        AVX
+    };
+
+    struct Stats
+    {
+        int tested = 0;
+        int visible = 0;
+        int culled = 0;
+        // 上一次cull()的耗时
+        double cullTimeUs = 0.0;
+    };
+
+    FrustumCuller();
+
+    void clear();
+    void reserve(int count);
+    // 添加一个包围盒，返回它的序号
+    int addBox(float centerX, float centerY, float centerZ, float halfX, float halfY, float halfZ);
+    int boxCount() const { return m_count; }
+
+    // viewProjection：投影矩阵*观察矩阵，列主序
+    void setFrustum(const float* viewProjection);
+
+    // 输出可见包围盒的序号（按从小到大的顺序），返回可见数量
+    int cull(std::vector<int>& visible);
+
+    // 默认为当前cpu支持的最快实现，设置为不支持的实现时退回到支持的最快实现
+    void setBackend(Backend backend);
+    Backend backend() const { return m_backend; }
+    static Backend bestBackend();
+    static const char* backendName(Backend backend);
+
+    const Stats& stats() const { return m_stats; }
+
+private:
+    // 每个数组的长度补齐到8的倍数，SIMD每次读取4/8个float时不会越界，补齐部分的结果被忽略
+    void resizeArrays(int capacity);
+
+    int cullScalar(int* visible) const;
+    int cullSSE(int* visible) const;
+    int cullAVX(int* visible) const;
+
+private:
+    int m_count = 0;
+    std::vector<float> m_centerX;
+    std::vector<float> m_centerY;
+    std::vector<float> m_centerZ;
+    std::vector<float> m_halfX;
+    std::vector<float> m_halfY;
+    std::vector<float> m_halfZ;
+
+    // 6个平面：a/b/c/d分别连续存放，方便SIMD广播
+    float m_planes[4][6];
+
+    Backend m_backend;
+    Stats m_stats;
+};
+
+#endif // FRUSTUMCULLER_H
@@ -0,0 +1,8 @@
+# 视锥体剔除：SoA包围盒 + SSE/AVX（运行时检测）/标量实现，只依赖标准库
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/frustumculler.h
+
+SOURCES += \
+    $$PWD/frustumculler.cpp
@@ -0,0 +1,113 @@
+#ifndef GLBACKENDS_H
+#define GLBACKENDS_H
+
+#include "renderercore.h"
+
+/*
+ * RendererCore的后端，区别在于着色器方言和顶点状态的设置方式：
+ * VertexArrayBackend：创建网格时把顶点属性记录到vao中，绘制时只需要glBindVertexArray（gl 3.3 core必须使用vao）
+ * Gles2Backend：gles2没有vao（OES_vertex_array_object是扩展），绘制时重新绑定vbo/ibo并设置所有顶点属性
+ *
+ * Functions为QOpenGLExtraFunctions或者headless-egl-cmake中的GLFunctions
+*/
+template<typename F, ShaderDialect::Target Dialect>
+class VertexArrayBackend
+{
+public:
+    typedef F Functions;
+
+    explicit VertexArrayBackend(F* functions) : m_f(functions) {}
+
+    static ShaderDialect::Target dialect() { return Dialect; }
+    static const char* name() { return Dialect == ShaderDialect::Glsl330Core ? "gl33" : "gles3"; }
+
+    // vao保持绑定，之后绑定的ibo也会记录到vao中
+    void createMesh(Mesh& mesh)
+    {
+        m_f->glGenVertexArrays(1, &mesh.vao);
+        m_f->glBindVertexArray(mesh.vao);
+        m_f->glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+        for (size_t i = 0; i < mesh.layout.attributes.size(); i++) {
+            const VertexAttribute& attribute = mesh.layout.attributes[i];
+            m_f->glVertexAttribPointer(GLuint(i), attribute.components, GL_FLOAT, GL_FALSE, mesh.layout.stride,
+                                       reinterpret_cast<const void*>(size_t(attribute.offset)));
+            m_f->glEnableVertexAttribArray(GLuint(i));
+        }
+    }
+
+    void deleteMesh(Mesh& mesh)
+    {
+        m_f->glDeleteVertexArrays(1, &mesh.vao);
+        mesh.vao = 0;
+    }
+
+    void bindMesh(const Mesh& mesh)
+    {
+        m_f->glBindVertexArray(mesh.vao);
+    }
+
+    void unbindMesh()
+    {
+        m_f->glBindVertexArray(0);
+    }
+
+private:
+    F* m_f;
+};
+
+template<typename F>
+using GL33Backend = VertexArrayBackend<F, ShaderDialect::Glsl330Core>;
+
+template<typename F>
+using Gles3Backend = VertexArrayBackend<F, ShaderDialect::GlslEs300>;
+
+template<typename F>
+class Gles2Backend
+{
+public:
+    typedef F Functions;
+
+    explicit Gles2Backend(F* functions) : m_f(functions) {}
+
+    static ShaderDialect::Target dialect() { return ShaderDialect::GlslEs100; }
+    static const char* name() { return "gles2"; }
+
+    void createMesh(Mesh&) {}
+    void deleteMesh(Mesh&) {}
+
+    void bindMesh(const Mesh& mesh)
+    {
+        m_f->glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+        m_f->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ibo);
+        const size_t count = mesh.layout.attributes.size();
+        for (size_t i = 0; i < count; i++) {
+            const VertexAttribute& attribute = mesh.layout.attributes[i];
+            m_f->glVertexAttribPointer(GLuint(i), attribute.components, GL_FLOAT, GL_FALSE, mesh.layout.stride,
+                                       reinterpret_cast<const void*>(size_t(attribute.offset)));
+            if (i >= m_enabledAttributes) {
+                m_f->glEnableVertexAttribArray(GLuint(i));
+            }
+        }
+        // 上一个网格多出来的属性关闭
+        for (size_t i = count; i < m_enabledAttributes; i++) {
+            m_f->glDisableVertexAttribArray(GLuint(i));
+        }
+        m_enabledAttributes = count;
+    }
+
+    void unbindMesh()
+    {
+        for (size_t i = 0; i < m_enabledAttributes; i++) {
+            m_f->glDisableVertexAttribArray(GLuint(i));
+        }
+        m_enabledAttributes = 0;
+        m_f->glBindBuffer(GL_ARRAY_BUFFER, 0);
+        m_f->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+private:
+    F* m_f;
+    size_t m_enabledAttributes = 0;
+};
+
+#endif // GLBACKENDS_H
@@ -0,0 +1,234 @@
+#include "glstatecache.h"
+
+#include <QOpenGLShaderProgram>
+#include <QOpenGLVertexArrayObject>
+#include <QOpenGLTexture>
+
+int GLStateCache::Counters::totalIssued() const
+{
+    int total = 0;
+    for (int count : issued) {
+        total += count;
+    }
+    return total;
+}
+
+int GLStateCache::Counters::totalSkipped() const
+{
+    int total = 0;
+    for (int count : skipped) {
+        total += count;
+    }
+    return total;
+}
+
+QString GLStateCache::Counters::summary() const
+{
+    QString details;
+    for (int i = 0; i < StateCount; i++) {
+        if (issued[i] == 0 && skipped[i] == 0) {
+            continue;
+        }
+        if (!details.isEmpty()) {
+            details += ", ";
+        }
+        details += QString("%1 %2/%3").arg(stateName(State(i))).arg(issued[i]).arg(skipped[i]);
+    }
+    return QString("gl state calls issued %1 / skipped %2 (%3)").arg(totalIssued()).arg(totalSkipped()).arg(details);
+}
+
+GLStateCache::GLStateCache()
+{
+    invalidate();
+}
+
+void GLStateCache::initialize()
+{
+    initializeOpenGLFunctions();
+    invalidate();
+}
+
+void GLStateCache::beginFrame()
+{
+    m_last = m_current;
+    m_current = Counters();
+    invalidate();
+}
+
+void GLStateCache::invalidate()
+{
+    m_programKnown = false;
+    m_vaoKnown = false;
+    m_activeTexture = -1;
+    for (int i = 0; i < MaxTextureUnits; i++) {
+        m_texturesKnown[i] = false;
+    }
+    m_blend = -1;
+    m_blendFuncKnown = false;
+    m_depthTest = -1;
+    m_depthMask = -1;
+    m_depthFuncKnown = false;
+}
+
+void GLStateCache::useProgram(GLuint program)
+{
+    if (skip(Program, m_programKnown, m_program == program)) {
+        return;
+    }
+    glUseProgram(program);
+    m_programKnown = true;
+    m_program = program;
+}
+
+void GLStateCache::useProgram(QOpenGLShaderProgram &program)
+{
+    useProgram(program.programId());
+}
+
+void GLStateCache::bindVertexArray(QOpenGLVertexArrayObject *vao)
+{
+    if (skip(VertexArray, m_vaoKnown, m_vao == vao)) {
+        return;
+    }
+    if (vao) {
+        vao->bind();
+        m_lastVao = vao;
+    } else if (m_lastVao) {
+        // release()对任何vao对象都是绑定0
+        m_lastVao->release();
+    }
+    // 从来没有通过这里绑定过vao时无法解除绑定，状态仍然是未知
+    m_vaoKnown = m_lastVao != nullptr;
+    m_vao = vao;
+}
+
+void GLStateCache::bindVertexArray(QOpenGLVertexArrayObject &vao)
+{
+    bindVertexArray(&vao);
+}
+
+void GLStateCache::activeTexture(int unit)
+{
+    if (skip(ActiveTexture, m_activeTexture >= 0, m_activeTexture == unit)) {
+        return;
+    }
+    glActiveTexture(GLenum(GL_TEXTURE0 + unit));
+    m_activeTexture = unit;
+}
+
+void GLStateCache::bindTexture(int unit, GLenum target, GLuint texture)
+{
+    // 超出记录范围的纹理单元不做缓存
+    const bool tracked = unit >= 0 && unit < MaxTextureUnits;
+    if (tracked) {
+        const TextureBinding& binding = m_textures[unit];
+        // 同一个纹理单元上不同target是不同的绑定点，这里只记录最后一次，target不同时按变化处理（多调用但不会出错）
+        if (skip(Texture, m_texturesKnown[unit], binding.target == target && binding.texture == texture)) {
+            return;
+        }
+    } else {
+        m_current.issued[Texture]++;
+    }
+
+    activeTexture(unit);
+    glBindTexture(target, texture);
+    if (tracked) {
+        m_textures[unit].target = target;
+        m_textures[unit].texture = texture;
+        m_texturesKnown[unit] = true;
+    }
+}
+
+void GLStateCache::bindTexture(int unit, QOpenGLTexture &texture)
+{
+    bindTexture(unit, GLenum(texture.target()), texture.textureId());
+}
+
+void GLStateCache::setBlend(bool enabled)
+{
+    setCapability(Blend, m_blend, GL_BLEND, enabled);
+}
+
+void GLStateCache::blendFunc(GLenum source, GLenum destination)
+{
+    if (skip(BlendFunc, m_blendFuncKnown, m_blendSource == source && m_blendDestination == destination)) {
+        return;
+    }
+    glBlendFunc(source, destination);
+    m_blendFuncKnown = true;
+    m_blendSource = source;
+    m_blendDestination = destination;
+}
+
+void GLStateCache::setDepthTest(bool enabled)
+{
+    setCapability(DepthTest, m_depthTest, GL_DEPTH_TEST, enabled);
+}
+
+void GLStateCache::depthMask(bool enabled)
+{
+    if (skip(DepthMask, m_depthMask >= 0, m_depthMask == int(enabled))) {
+        return;
+    }
+    glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+    m_depthMask = int(enabled);
+}
+
+void GLStateCache::depthFunc(GLenum func)
+{
+    if (skip(DepthFunc, m_depthFuncKnown, m_depthFunc == func)) {
+        return;
+    }
+    glDepthFunc(func);
+    m_depthFuncKnown = true;
+    m_depthFunc = func;
+}
+
+const char *GLStateCache::stateName(State state)
+{
+    switch (state) {
+    case Program:
+        return "program";
+    case VertexArray:
+        return "vao";
+    case ActiveTexture:
+        return "active texture";
+    case Texture:
+        return "texture";
+    case Blend:
+        return "blend";
+    case BlendFunc:
+        return "blend func";
+    case DepthTest:
+        return "depth test";
+    case DepthMask:
+        return "depth mask";
+    case DepthFunc:
+        return "depth func";
+    default:
+        return "unknown";
+    }
+}
+
+bool GLStateCache::skip(State state, bool known, bool same)
+{
+    if (known && same) {
+        m_current.skipped[state]++;
+        return true;
+    }
+    m_current.issued[state]++;
+    return false;
+}
+
+void GLStateCache::setCapability(State state, int &shadow, GLenum capability, bool enabled)
+{
+    if (skip(state, shadow >= 0, shadow == int(enabled))) {
+        return;
+    }
+    if (enabled) {
+        glEnable(capability);
+    } else {
+        glDisable(capability);
+    }
+    shadow = int(enabled);
+}
@@ -0,0 +1,119 @@
+#ifndef GLSTATECACHE_H
+#define GLSTATECACHE_H
+
+#include <QString>
+#include <QOpenGLFunctions>
+
+class QOpenGLShaderProgram;
+class QOpenGLVertexArrayObject;
+class QOpenGLTexture;
+
+/*
+ * opengl状态缓存：记录当前绑定的program/vao/各个纹理单元的纹理，以及混合和深度测试的状态，
+ * 设置的值和当前值一样时直接跳过，不调用gl函数，减少驱动的无用工作
+ *
+ * 使用方法：
+ * 1. initializeGL中调用initialize()
+ * 2. paintGL开始时调用beginFrame()：QOpenGLWidget在两帧之间会修改gl状态（例如合成窗口），
+ *    所以每帧开始时把记录的状态全部作废，每种状态第一次设置时一定会调用gl函数
+ * 3. paintGL中的bind/状态设置都通过这里完成，绕过这里直接修改了状态（例如QOpenGLTexture::bind()、QPainter）
+ *    之后需要调用invalidate()
+ *
+ * 每帧统计实际调用（issued）和跳过（skipped）的次数，beginFrame()之后可以通过lastFrame()拿到上一帧的统计
+*/
+class GLStateCache : protected QOpenGLFunctions
+{
+public:
+    enum State {
+        Program,
+        VertexArray,
+        ActiveTexture,
+        Texture,
+        Blend,
+        BlendFunc,
+        DepthTest,
+        DepthMask,
+        DepthFunc,
+        StateCount
+    };
+
+    struct Counters
+    {
+        int issued[StateCount] = {};
+        int skipped[StateCount] = {};
+
+        int totalIssued() const;
+        int totalSkipped() const;
+        // 例如 "gl state calls issued 6 / skipped 10 (program 1/1, vao 1/1, ...)"
+        QString summary() const;
+    };
+
+    GLStateCache();
+
+    void initialize();
+    void beginFrame();
+    void invalidate();
+
+    void useProgram(GLuint program);
+    void useProgram(QOpenGLShaderProgram& program);
+
+    // vao通过QOpenGLVertexArrayObject绑定（Qt会根据context选择core/ARB/APPLE的实现），nullptr为解除绑定
+    void bindVertexArray(QOpenGLVertexArrayObject* vao);
+    void bindVertexArray(QOpenGLVertexArrayObject& vao);
+
+    // unit为纹理单元序号（0对应GL_TEXTURE0）
+    void activeTexture(int unit);
+    void bindTexture(int unit, GLenum target, GLuint texture);
+    void bindTexture(int unit, QOpenGLTexture& texture);
+
+    void setBlend(bool enabled);
+    void blendFunc(GLenum source, GLenum destination);
+
+    void setDepthTest(bool enabled);
+    void depthMask(bool enabled);
+    void depthFunc(GLenum func);
+
+    const Counters& currentFrame() const { return m_current; }
+    const Counters& lastFrame() const { return m_last; }
+
+    static const char* stateName(State state);
+
+private:
+    // 记录的状态已知并且和要设置的值相同时返回true（跳过），否则返回false（需要调用gl函数），同时更新统计
+    bool skip(State state, bool known, bool same);
+    void setCapability(State state, int& shadow, GLenum capability, bool enabled);
+
+private:
+    enum { MaxTextureUnits = 32 };
+
+    struct TextureBinding
+    {
+        GLenum target;
+        GLuint texture;
+    };
+
+    // 未知状态，下一次设置时一定会调用gl函数
+    bool m_programKnown = false;
+    GLuint m_program = 0;
+    bool m_vaoKnown = false;
+    QOpenGLVertexArrayObject* m_vao = nullptr;
+    // 最近绑定过的vao对象，用来解除绑定
+    QOpenGLVertexArrayObject* m_lastVao = nullptr;
+    int m_activeTexture = -1;
+    TextureBinding m_textures[MaxTextureUnits];
+    bool m_texturesKnown[MaxTextureUnits];
+    // 开关状态：-1未知，0关闭，1开启
+    int m_blend = -1;
+    bool m_blendFuncKnown = false;
+    GLenum m_blendSource = 0;
+    GLenum m_blendDestination = 0;
+    int m_depthTest = -1;
+    int m_depthMask = -1;
+    bool m_depthFuncKnown = false;
+    GLenum m_depthFunc = 0;
+
+    Counters m_current;
+    Counters m_last;
+};
+
+#endif // GLSTATECACHE_H
@@ -0,0 +1,8 @@
+# opengl状态缓存：跳过重复的program/vao/纹理/混合/深度状态设置，并统计每帧实际调用和跳过的次数
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/glstatecache.h
+
+SOURCES += \
+    $$PWD/glstatecache.cpp
@@ -0,0 +1,376 @@
+#include "gpuprofiler.h"
+
+#include <QDebug>
+#include <QStringList>
+#include <QOpenGLFunctions>
+
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#endif
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+#ifndef GL_VERTEX_SHADER_INVOCATIONS_ARB
+#define GL_VERTEX_SHADER_INVOCATIONS_ARB 0x82F0
+#endif
+#ifndef GL_FRAGMENT_SHADER_INVOCATIONS_ARB
+#define GL_FRAGMENT_SHADER_INVOCATIONS_ARB 0x82F4
+#endif
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
+namespace {
+
+// 超过这么多帧还没有完成的查询直接丢弃
+const int kMaxPendingFrames = 8;
+// 每统计这么多帧更新一次stats()
+const int kWindowFrames = 60;
+
+// 桌面gl（3.3或ARB_timer_query）中是核心函数，gles上是EXT_disjoint_timer_query的EXT版本
+template <typename T>
+T resolve(QOpenGLContext* context, const char* name)
+{
+    T function = reinterpret_cast<T>(context->getProcAddress(name));
+    if (!function) {
+        function = reinterpret_cast<T>(context->getProcAddress(QByteArray(name) + "EXT"));
+    }
+    return function;
+}
+
+}
+
+GpuProfiler::Scope::Scope(GpuProfiler &profiler, const char *name)
+    : m_profiler(profiler)
+{
+    m_begun = m_profiler.begin(name);
+}
+
+GpuProfiler::Scope::~Scope()
+{
+    if (m_begun) {
+        m_profiler.end();
+    }
+}
+
+GpuProfiler::GpuProfiler()
+{
+}
+
+GpuProfiler::~GpuProfiler()
+{
+}
+
+void GpuProfiler::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+}
+
+bool GpuProfiler::isEnabled() const
+{
+    return m_enabled;
+}
+
+void GpuProfiler::initialize(QOpenGLContext *context)
+{
+    m_context = context;
+    m_active = false;
+    if (!m_enabled) {
+        return;
+    }
+
+    const QPair<int, int> version = context->format().version();
+    bool timer = false;
+    if (context->isOpenGLES()) {
+        timer = context->hasExtension("GL_EXT_disjoint_timer_query");
+        m_checkDisjoint = timer;
+    } else {
+        timer = version >= qMakePair(3, 3) || context->hasExtension("GL_ARB_timer_query");
+        m_pipelineStatistics = version >= qMakePair(4, 6) || context->hasExtension("GL_ARB_pipeline_statistics_query");
+    }
+
+    m_genQueries = resolve<GenQueries>(context, "glGenQueries");
+    m_deleteQueries = resolve<DeleteQueries>(context, "glDeleteQueries");
+    m_beginQuery = resolve<BeginQuery>(context, "glBeginQuery");
+    m_endQuery = resolve<EndQuery>(context, "glEndQuery");
+    m_getQueryObjectuiv = resolve<GetQueryObjectuiv>(context, "glGetQueryObjectuiv");
+    m_getQueryObjectui64v = resolve<GetQueryObjectui64v>(context, "glGetQueryObjectui64v");
+    m_active = timer && m_genQueries && m_deleteQueries && m_beginQuery && m_endQuery
+            && m_getQueryObjectuiv && m_getQueryObjectui64v;
+    if (!m_active) {
+        m_pipelineStatistics = false;
+    }
+    qDebug() << "gpu profiler:" << (m_active ? "timer query" : "not supported")
+             << (m_pipelineStatistics ? "+ pipeline statistics" : "");
+}
+
+void GpuProfiler::destroy()
+{
+    if (!m_active) {
+        return;
+    }
+    while (!m_pending.isEmpty()) {
+        recycle(m_pending.dequeue());
+    }
+    recycle(m_current);
+    m_current.clear();
+    m_inScope = false;
+    for (QVector<GLuint>& queries : m_freeQueries) {
+        if (!queries.isEmpty()) {
+            m_deleteQueries(queries.size(), queries.constData());
+        }
+        queries.clear();
+    }
+    m_active = false;
+}
+
+bool GpuProfiler::isActive() const
+{
+    return m_active;
+}
+
+bool GpuProfiler::hasPipelineStatistics() const
+{
+    return m_pipelineStatistics;
+}
+
+void GpuProfiler::beginFrame()
+{
+    if (!m_active) {
+        return;
+    }
+    collect();
+}
+
+void GpuProfiler::endFrame()
+{
+    if (!m_active) {
+        return;
+    }
+    if (m_inScope) {
+        end();
+    }
+    if (!m_current.isEmpty()) {
+        m_pending.enqueue(m_current);
+        m_current.clear();
+    }
+    // gpu跟不上时不等待，丢弃最旧的一帧（查询对象可以直接复用，旧的结果会被覆盖）
+    while (m_pending.size() > kMaxPendingFrames) {
+        recycle(m_pending.dequeue());
+        m_dropped++;
+    }
+}
+
+bool GpuProfiler::begin(const char *name)
+{
+    if (!m_active) {
+        return false;
+    }
+    if (m_inScope) {
+        static bool warned = false;
+        if (!warned) {
+            warned = true;
+            qDebug() << "gpu profiler: nested scope ignored:" << name;
+        }
+        return false;
+    }
+
+    Sample sample;
+    sample.scope = scopeIndex(name);
+    const int kinds = m_pipelineStatistics ? QueryKindCount : Timer + 1;
+    for (int kind = 0; kind < kinds; kind++) {
+        sample.queries[kind] = acquireQuery(QueryKind(kind));
+        m_beginQuery(queryTarget(QueryKind(kind)), sample.queries[kind]);
+    }
+    m_current.append(sample);
+    m_inScope = true;
+    return true;
+}
+
+void GpuProfiler::end()
+{
+    if (!m_active || !m_inScope) {
+        return;
+    }
+    const int kinds = m_pipelineStatistics ? QueryKindCount : Timer + 1;
+    for (int kind = 0; kind < kinds; kind++) {
+        m_endQuery(queryTarget(QueryKind(kind)));
+    }
+    m_inScope = false;
+}
+
+QVector<GpuProfiler::ScopeStats> GpuProfiler::stats() const
+{
+    return m_stats;
+}
+
+QString GpuProfiler::summary() const
+{
+    QStringList scopes;
+    for (const ScopeStats& stats : m_stats) {
+        QString scope = QString("%1 %2 ms (max %3)")
+                .arg(stats.name)
+                .arg(stats.gpuMs, 0, 'f', 2)
+                .arg(stats.maxGpuMs, 0, 'f', 2);
+        if (stats.calls > 1.0) {
+            scope += QString(" x%1").arg(stats.calls, 0, 'f', 0);
+        }
+        if (stats.vertexInvocations >= 0.0) {
+            scope += QString(" vs %1 fs %2").arg(stats.vertexInvocations, 0, 'f', 0)
+                    .arg(stats.fragmentInvocations, 0, 'f', 0);
+        }
+        scopes.append(scope);
+    }
+    return scopes.join(" | ");
+}
+
+int GpuProfiler::droppedFrames() const
+{
+    return m_dropped;
+}
+
+int GpuProfiler::scopeIndex(const char *name)
+{
+    // scope一般只有几个，线性查找；同一个字符串常量先比较指针
+    for (int i = 0; i < m_names.size(); i++) {
+        if (m_names[i] == name || qstrcmp(m_names[i], name) == 0) {
+            return i;
+        }
+    }
+    m_names.append(name);
+    m_accumulators.append(Accumulator());
+    return m_names.size() - 1;
+}
+
+GLuint GpuProfiler::acquireQuery(QueryKind kind)
+{
+    QVector<GLuint>& queries = m_freeQueries[kind];
+    if (queries.isEmpty()) {
+        // 查询对象第一次begin时确定类型，每种类型单独复用
+        queries.resize(8);
+        m_genQueries(queries.size(), queries.data());
+    }
+    const GLuint query = queries.last();
+    queries.removeLast();
+    return query;
+}
+
+void GpuProfiler::recycle(const QVector<Sample> &samples)
+{
+    for (const Sample& sample : samples) {
+        for (int kind = 0; kind < QueryKindCount; kind++) {
+            if (sample.queries[kind]) {
+                m_freeQueries[kind].append(sample.queries[kind]);
+            }
+        }
+    }
+}
+
+bool GpuProfiler::isAvailable(const Sample &sample)
+{
+    for (GLuint query : sample.queries) {
+        if (!query) {
+            continue;
+        }
+        GLuint available = GL_FALSE;
+        m_getQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void GpuProfiler::collect()
+{
+    if (m_checkDisjoint) {
+        // 读取后标记被清除，期间的所有时间查询都不可信
+        GLint disjoint = 0;
+        m_context->functions()->glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+        if (disjoint) {
+            while (!m_pending.isEmpty()) {
+                recycle(m_pending.dequeue());
+                m_dropped++;
+            }
+            return;
+        }
+    }
+
+    // 查询按提交顺序完成，一帧的最后一个查询可用时整帧都可用；遇到还没有完成的帧就停下，不等待
+    while (!m_pending.isEmpty() && isAvailable(m_pending.head().last())) {
+        const QVector<Sample> samples = m_pending.dequeue();
+        accumulate(samples);
+        recycle(samples);
+    }
+}
+
+void GpuProfiler::accumulate(const QVector<Sample> &samples)
+{
+    QVector<quint64> frameNs(m_names.size(), 0);
+    QVector<bool> seen(m_names.size(), false);
+    for (const Sample& sample : samples) {
+        Accumulator& accumulator = m_accumulators[sample.scope];
+        quint64 value = 0;
+        m_getQueryObjectui64v(sample.queries[Timer], GL_QUERY_RESULT, &value);
+        accumulator.gpuNs += value;
+        accumulator.calls++;
+        frameNs[sample.scope] += value;
+        seen[sample.scope] = true;
+        if (sample.queries[VertexInvocations]) {
+            m_getQueryObjectui64v(sample.queries[VertexInvocations], GL_QUERY_RESULT, &value);
+            accumulator.vertexInvocations += value;
+            m_getQueryObjectui64v(sample.queries[FragmentInvocations], GL_QUERY_RESULT, &value);
+            accumulator.fragmentInvocations += value;
+        }
+    }
+    for (int i = 0; i < m_names.size(); i++) {
+        if (seen[i]) {
+            m_accumulators[i].frames++;
+            m_accumulators[i].maxFrameNs = qMax(m_accumulators[i].maxFrameNs, frameNs[i]);
+        }
+    }
+
+    m_windowFrames++;
+    if (m_windowFrames >= kWindowFrames) {
+        publish();
+    }
+}
+
+void GpuProfiler::publish()
+{
+    m_stats.clear();
+    for (int i = 0; i < m_names.size(); i++) {
+        Accumulator& accumulator = m_accumulators[i];
+        if (accumulator.frames == 0) {
+            continue;
+        }
+        ScopeStats stats;
+        stats.name = m_names[i];
+        stats.frames = accumulator.frames;
+        stats.calls = double(accumulator.calls) / accumulator.frames;
+        stats.gpuMs = accumulator.gpuNs / 1e6 / accumulator.frames;
+        stats.maxGpuMs = accumulator.maxFrameNs / 1e6;
+        if (m_pipelineStatistics) {
+            stats.vertexInvocations = double(accumulator.vertexInvocations) / accumulator.frames;
+            stats.fragmentInvocations = double(accumulator.fragmentInvocations) / accumulator.frames;
+        }
+        m_stats.append(stats);
+        accumulator = Accumulator();
+    }
+    m_windowFrames = 0;
+}
+
+GLenum GpuProfiler::queryTarget(QueryKind kind)
+{
+    switch (kind) {
+    case VertexInvocations:
+        return GL_VERTEX_SHADER_INVOCATIONS_ARB;
+    case FragmentInvocations:
+        return GL_FRAGMENT_SHADER_INVOCATIONS_ARB;
+    default:
+        return GL_TIME_ELAPSED;
+    }
+}
@@ -0,0 +1,151 @@
+#ifndef GPUPROFILER_H
+#define GPUPROFILER_H
+
+#include <QQueue>
+#include <QString>
+#include <QVector>
+#include <QOpenGLContext>
+
+/*
+ * gpu性能分析：用命名的scope包住一次或多次绘制（例如一个pass、一个图层），统计每个scope在gpu上的耗时，
+ * 支持ARB_pipeline_statistics_query时同时统计顶点/片段着色器的调用次数（overdraw、被裁剪掉的片段都可以从这里看出来）
+ *
+ *   GL_TIME_ELAPSED：桌面gl 3.3或者ARB_timer_query，gles上需要EXT_disjoint_timer_query
+ *   GL_VERTEX_SHADER_INVOCATIONS_ARB / GL_FRAGMENT_SHADER_INVOCATIONS_ARB：ARB_pipeline_statistics_query（或gl 4.6）
+ *
+ * 查询结果不等待：每帧开始时只读取已经完成的帧（一般是2~3帧之前），最多保留8帧没有完成的查询，再多时丢弃最旧的一帧
+ * 统计按scope名字聚合，每60帧更新一次stats()/summary()（每帧平均值）
+ *
+ * 使用方法（默认关闭，setEnabled(true)之后才会创建查询）：
+ * 1. initializeGL中调用initialize()
+ * 2. paintGL开始时调用beginFrame()，结束时调用endFrame()
+ * 3. 需要统计的绘制用GpuProfiler::Scope包起来，name需要是字符串常量：
+ *      { GpuProfiler::Scope scope(m_profiler, "screen"); glDrawElements(...); }
+ *    同一个target的查询不能嵌套，scope也不能嵌套（嵌套的scope被忽略），同一帧中同名的scope累加
+ * 4. 析构前在context current时调用destroy()
+*/
+class GpuProfiler
+{
+public:
+    struct ScopeStats
+    {
+        const char* name = nullptr;
+        // 统计窗口内出现过的帧数，下面的值都是这些帧的每帧平均值
+        int frames = 0;
+        double calls = 0.0;
+        double gpuMs = 0.0;
+        double maxGpuMs = 0.0;
+        // 不支持pipeline statistics时为-1
+        double vertexInvocations = -1.0;
+        double fragmentInvocations = -1.0;
+    };
+
+    class Scope
+    {
+    public:
+        Scope(GpuProfiler& profiler, const char* name);
+        ~Scope();
+
+    private:
+        Q_DISABLE_COPY(Scope)
+        GpuProfiler& m_profiler;
+        bool m_begun = false;
+    };
+
+    GpuProfiler();
+    ~GpuProfiler();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    // 需要在context current时调用，不支持timer query时isActive()为false，之后的调用都直接返回
+    void initialize(QOpenGLContext* context);
+    void destroy();
+    bool isActive() const;
+    bool hasPipelineStatistics() const;
+
+    void beginFrame();
+    void endFrame();
+
+    // 返回是否开始了查询（没有开启、不支持或者嵌套时返回false，这时不需要调用end()）
+    bool begin(const char* name);
+    void end();
+
+    QVector<ScopeStats> stats() const;
+    // 例如 "offscreen 1.20 ms (max 1.90) vs 4 fs 480000 | screen 0.31 ms ..."，还没有统计时为空
+    QString summary() const;
+    // 因为结果迟迟没有完成被丢弃的帧数
+    int droppedFrames() const;
+
+private:
+    enum QueryKind {
+        Timer,
+        VertexInvocations,
+        FragmentInvocations,
+        QueryKindCount
+    };
+
+    struct Sample
+    {
+        int scope = -1;
+        GLuint queries[QueryKindCount] = {};
+    };
+
+    struct Accumulator
+    {
+        int frames = 0;
+        int calls = 0;
+        quint64 gpuNs = 0;
+        quint64 maxFrameNs = 0;
+        quint64 vertexInvocations = 0;
+        quint64 fragmentInvocations = 0;
+    };
+
+    typedef void (QOPENGLF_APIENTRYP GenQueries)(GLsizei n, GLuint* ids);
+    typedef void (QOPENGLF_APIENTRYP DeleteQueries)(GLsizei n, const GLuint* ids);
+    typedef void (QOPENGLF_APIENTRYP BeginQuery)(GLenum target, GLuint id);
+    typedef void (QOPENGLF_APIENTRYP EndQuery)(GLenum target);
+    typedef void (QOPENGLF_APIENTRYP GetQueryObjectuiv)(GLuint id, GLenum pname, GLuint* params);
+    typedef void (QOPENGLF_APIENTRYP GetQueryObjectui64v)(GLuint id, GLenum pname, quint64* params);
+
+    int scopeIndex(const char* name);
+    GLuint acquireQuery(QueryKind kind);
+    void recycle(const QVector<Sample>& samples);
+    bool isAvailable(const Sample& sample);
+    void collect();
+    void accumulate(const QVector<Sample>& samples);
+    void publish();
+
+    static GLenum queryTarget(QueryKind kind);
+
+private:
+    bool m_enabled = false;
+    bool m_active = false;
+    bool m_pipelineStatistics = false;
+    // gles的EXT_disjoint_timer_query：gpu频率变化等情况下结果不可信，需要检查GL_GPU_DISJOINT_EXT
+    bool m_checkDisjoint = false;
+    QOpenGLContext* m_context = nullptr;
+
+    GenQueries m_genQueries = nullptr;
+    DeleteQueries m_deleteQueries = nullptr;
+    BeginQuery m_beginQuery = nullptr;
+    EndQuery m_endQuery = nullptr;
+    GetQueryObjectuiv m_getQueryObjectuiv = nullptr;
+    GetQueryObjectui64v m_getQueryObjectui64v = nullptr;
+
+    // scope名字，下标即为scope的序号
+    QVector<const char*> m_names;
+    // 当前帧的查询，正在进行的是m_current.last()
+    QVector<Sample> m_current;
+    bool m_inScope = false;
+    // 已经提交、结果还没有读取的帧
+    QQueue<QVector<Sample>> m_pending;
+    QVector<GLuint> m_freeQueries[QueryKindCount];
+    int m_dropped = 0;
+
+    QVector<Accumulator> m_accumulators;
+    int m_windowFrames = 0;
+    QVector<ScopeStats> m_stats;
+};
+
+#endif // GPUPROFILER_H
@@ -0,0 +1,8 @@
+# gpu性能分析：命名scope的GL_TIME_ELAPSED和pipeline statistics查询，延迟几帧读取结果不阻塞
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/gpuprofiler.h
+
+SOURCES += \
+    $$PWD/gpuprofiler.cpp
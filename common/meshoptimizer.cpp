@@ -0,0 +1,289 @@
+#include "meshoptimizer.h"
+
+#include <cmath>
+#include <string>
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+
+// Forsyth算法的参数，取自原文 https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+const float kCacheDecayPower = 1.5f;
+const float kLastTriScore = 0.75f;
+const float kValenceBoostScale = 2.0f;
+const float kValenceBoostPower = 0.5f;
+
+// 顶点分数：在cache中越靠前分数越高（刚用过的三角形的3个顶点固定为kLastTriScore，避免总是选相邻的三角形形成长条），
+// 剩余未绘制的三角形越少分数越高（尽快用完只剩少量三角形的顶点）
+float vertexScore(int cachePosition, int remainingTriangles, int cacheSize)
+{
+    if (remainingTriangles == 0) {
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            score = kLastTriScore;
+        } else {
+            const float scaler = 1.0f / (cacheSize - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scaler, kCacheDecayPower);
+        }
+    }
+
+    score += kValenceBoostScale * std::pow(float(remainingTriangles), -kValenceBoostPower);
+    return score;
+}
+
+}
+
+IndexedMesh MeshOptimizer::deduplicate(const float *vertices, int vertexCount, int floatsPerVertex)
+{
+    IndexedMesh mesh;
+    mesh.floatsPerVertex = floatsPerVertex;
+    mesh.indices.reserve(vertexCount);
+
+    // 以顶点的原始字节作为key，按位完全相同的顶点才合并
+    const size_t vertexBytes = floatsPerVertex * sizeof(float);
+    std::unordered_map<std::string, unsigned int> lookup;
+    lookup.reserve(vertexCount);
+
+    for (int i = 0; i < vertexCount; i++) {
+        const float* vertex = vertices + size_t(i) * floatsPerVertex;
+        std::string key(reinterpret_cast<const char*>(vertex), vertexBytes);
+
+        auto it = lookup.find(key);
+        if (it != lookup.end()) {
+            mesh.indices.push_back(it->second);
+            continue;
+        }
+
+        const unsigned int index = mesh.vertexCount();
+        lookup.emplace(std::move(key), index);
+        mesh.vertices.insert(mesh.vertices.end(), vertex, vertex + floatsPerVertex);
+        mesh.indices.push_back(index);
+    }
+
+    return mesh;
+}
+
+IndexedMesh MeshOptimizer::unindexed(const float *vertices, int vertexCount, int floatsPerVertex)
+{
+    IndexedMesh mesh;
+    mesh.floatsPerVertex = floatsPerVertex;
+    mesh.vertices.assign(vertices, vertices + size_t(vertexCount) * floatsPerVertex);
+    mesh.indices.resize(vertexCount);
+    for (int i = 0; i < vertexCount; i++) {
+        mesh.indices[i] = i;
+    }
+    return mesh;
+}
+
+void MeshOptimizer::optimizeVertexCache(IndexedMesh &mesh, int cacheSize)
+{
+    const int triangleCount = mesh.triangleCount();
+    const int vertexCount = mesh.vertexCount();
+    if (triangleCount == 0) {
+        return;
+    }
+    cacheSize = std::max(cacheSize, 4);
+
+    // 每个顶点相邻的三角形列表，每个列表的前remaining[v]项是还没有绘制的三角形
+    std::vector<int> remaining(vertexCount, 0);
+    for (unsigned int index : mesh.indices) {
+        remaining[index]++;
+    }
+    std::vector<int> offsets(vertexCount + 1, 0);
+    for (int v = 0; v < vertexCount; v++) {
+        offsets[v + 1] = offsets[v] + remaining[v];
+    }
+    std::vector<int> adjacency(mesh.indices.size());
+    {
+        std::vector<int> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < mesh.indices.size(); i++) {
+            adjacency[cursor[mesh.indices[i]]++] = int(i / 3);
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (int v = 0; v < vertexCount; v++) {
+        vertexScores[v] = vertexScore(-1, remaining[v], cacheSize);
+    }
+
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<char> emitted(triangleCount, 0);
+    for (int t = 0; t < triangleCount; t++) {
+        const unsigned int* tri = &mesh.indices[t * 3];
+        triangleScores[t] = vertexScores[tri[0]] + vertexScores[tri[1]] + vertexScores[tri[2]];
+    }
+
+    std::vector<unsigned int> result;
+    result.reserve(mesh.indices.size());
+    std::vector<int> cache;
+    std::vector<int> newCache;
+    cache.reserve(cacheSize + 3);
+    newCache.reserve(cacheSize + 3);
+
+    int bestTriangle = int(std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin());
+    int scanCursor = 0;
+
+    for (int n = 0; n < triangleCount; n++) {
+        if (bestTriangle < 0) {
+            // cache中的顶点已经没有相邻的三角形了，在剩下的三角形中找分数最高的
+            while (scanCursor < triangleCount && emitted[scanCursor]) {
+                scanCursor++;
+            }
+            bestTriangle = scanCursor;
+            for (int t = scanCursor + 1; t < triangleCount; t++) {
+                if (!emitted[t] && triangleScores[t] > triangleScores[bestTriangle]) {
+                    bestTriangle = t;
+                }
+            }
+        }
+
+        const unsigned int* tri = &mesh.indices[bestTriangle * 3];
+        result.insert(result.end(), tri, tri + 3);
+        emitted[bestTriangle] = 1;
+
+        // 从3个顶点的相邻列表中移除这个三角形
+        for (int k = 0; k < 3; k++) {
+            const unsigned int v = tri[k];
+            int* list = &adjacency[offsets[v]];
+            for (int i = 0; i < remaining[v]; i++) {
+                if (list[i] == bestTriangle) {
+                    std::swap(list[i], list[remaining[v] - 1]);
+                    remaining[v]--;
+                    break;
+                }
+            }
+        }
+
+        // 模拟LRU cache：新三角形的顶点放到最前面，其他顶点依次后移
+        newCache.clear();
+        for (int k = 0; k < 3; k++) {
+            if (std::find(newCache.begin(), newCache.end(), int(tri[k])) == newCache.end()) {
+                newCache.push_back(tri[k]);
+            }
+        }
+        for (int v : cache) {
+            if (v != int(tri[0]) && v != int(tri[1]) && v != int(tri[2])) {
+                newCache.push_back(v);
+            }
+        }
+
+        // 更新cache中（以及刚被挤出cache）的顶点分数，并把分数变化累加到相邻三角形上
+        for (size_t i = 0; i < newCache.size(); i++) {
+            const int v = newCache[i];
+            cachePosition[v] = int(i) < cacheSize ? int(i) : -1;
+            const float score = vertexScore(cachePosition[v], remaining[v], cacheSize);
+            const float delta = score - vertexScores[v];
+            vertexScores[v] = score;
+            for (int j = 0; j < remaining[v]; j++) {
+                triangleScores[adjacency[offsets[v] + j]] += delta;
+            }
+        }
+
+        if (int(newCache.size()) > cacheSize) {
+            newCache.resize(cacheSize);
+        }
+        std::swap(cache, newCache);
+
+        // 下一个三角形只在cache中顶点的相邻三角形里找
+        bestTriangle = -1;
+        float bestScore = -1.0f;
+        for (int v : cache) {
+            for (int j = 0; j < remaining[v]; j++) {
+                const int t = adjacency[offsets[v] + j];
+                if (triangleScores[t] > bestScore) {
+                    bestScore = triangleScores[t];
+                    bestTriangle = t;
+                }
+            }
+        }
+    }
+
+    mesh.indices.swap(result);
+}
+
+void MeshOptimizer::optimizeVertexFetch(IndexedMesh &mesh)
+{
+    const int floatsPerVertex = mesh.floatsPerVertex;
+    std::vector<int> remap(mesh.vertexCount(), -1);
+    std::vector<float> vertices;
+    vertices.reserve(mesh.vertices.size());
+
+    int next = 0;
+    for (unsigned int& index : mesh.indices) {
+        if (remap[index] < 0) {
+            remap[index] = next++;
+            const float* vertex = &mesh.vertices[size_t(index) * floatsPerVertex];
+            vertices.insert(vertices.end(), vertex, vertex + floatsPerVertex);
+        }
+        index = remap[index];
+    }
+
+    mesh.vertices.swap(vertices);
+}
+
+IndexedMesh MeshOptimizer::optimize(const float *vertices, int vertexCount, int floatsPerVertex,
+                                    MeshStats *before, MeshStats *after)
+{
+    IndexedMesh mesh = deduplicate(vertices, vertexCount, floatsPerVertex);
+    optimizeVertexCache(mesh);
+    optimizeVertexFetch(mesh);
+
+    if (before) {
+        *before = analyze(unindexed(vertices, vertexCount, floatsPerVertex));
+    }
+    if (after) {
+        *after = analyze(mesh);
+    }
+    return mesh;
+}
+
+MeshStats MeshOptimizer::analyze(const IndexedMesh &mesh, int cacheSize)
+{
+    MeshStats stats;
+    stats.vertexCount = mesh.vertexCount();
+    stats.triangleCount = mesh.triangleCount();
+    if (stats.triangleCount == 0 || stats.vertexCount == 0) {
+        return stats;
+    }
+
+    const size_t vertexBytes = mesh.floatsPerVertex * sizeof(float);
+
+    // FIFO cache：顶点在第t次写入cache，之后再写入cacheSize个顶点后被挤出
+    std::vector<int> insertedAt(stats.vertexCount, -1);
+    int insertCount = 0;
+
+    // 顶点读取按64字节cache line统计，模拟一个4KB的直接映射cache
+    const size_t lineSize = 64;
+    const size_t lineCount = 64;
+    std::vector<size_t> lineTags(lineCount, size_t(-1));
+
+    for (unsigned int index : mesh.indices) {
+        if (insertedAt[index] >= 0 && insertCount - insertedAt[index] < cacheSize) {
+            continue;
+        }
+
+        insertedAt[index] = insertCount++;
+        stats.transformedVertices++;
+
+        const size_t begin = index * vertexBytes;
+        const size_t end = begin + vertexBytes;
+        for (size_t line = begin / lineSize; line * lineSize < end; line++) {
+            size_t& tag = lineTags[line % lineCount];
+            if (tag != line) {
+                tag = line;
+                stats.fetchLineBytes += lineSize;
+            }
+        }
+    }
+
+    stats.acmr = double(stats.transformedVertices) / stats.triangleCount;
+    stats.atvr = double(stats.transformedVertices) / stats.vertexCount;
+    stats.fetchBytes = stats.transformedVertices * vertexBytes;
+    stats.overfetch = double(stats.fetchLineBytes) / (stats.vertexCount * vertexBytes);
+    return stats;
+}
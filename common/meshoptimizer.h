@@ -0,0 +1,69 @@
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * 网格预处理：把glDrawArrays用的无索引顶点数组转换为适合glDrawElements的索引网格
+ * 1. deduplicate：合并完全相同的顶点，生成顶点数组+索引数组（Box3d的立方体36个顶点 -> 16个顶点+36个索引）
+ * 2. optimizeVertexCache：按照Tom Forsyth的算法重排三角形顺序，让相邻三角形尽量复用
+ *    gpu的post-transform vertex cache中已经变换过的顶点，减少顶点着色器执行次数
+ * 3. optimizeVertexFetch：按照索引中第一次出现的顺序重排顶点数据，让顶点读取尽量顺序访问内存
+ *
+ * analyze()用于评估效果：
+ * ACMR(average cache miss ratio)：每个三角形平均需要变换的顶点数，无索引绘制为3，越低越好（下限约0.5）
+ * ATVR(average transformed vertex ratio)：变换的顶点数/唯一顶点数，1为最优
+ * fetch bytes：顶点着色器读取的顶点数据字节数，以及按64字节cache line统计的实际读取字节数
+ *
+ * 这里只依赖标准库，顶点格式为连续的float（例如位置3个float+纹理坐标2个float）
+*/
+
+struct IndexedMesh
+{
+    // 每个顶点的float数量
+    int floatsPerVertex = 0;
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+
+    int vertexCount() const { return floatsPerVertex > 0 ? int(vertices.size()) / floatsPerVertex : 0; }
+    int triangleCount() const { return int(indices.size()) / 3; }
+};
+
+struct MeshStats
+{
+    int vertexCount = 0;
+    int triangleCount = 0;
+    // 模拟的post-transform cache中未命中（需要执行顶点着色器）的顶点数
+    int transformedVertices = 0;
+    double acmr = 0.0;
+    double atvr = 0.0;
+    // 顶点着色器读取的字节数：transformedVertices * 顶点大小
+    size_t fetchBytes = 0;
+    // 按64字节cache line统计的显存读取字节数，以及相对于顶点数据总大小的比例（overfetch，1为最优）
+    size_t fetchLineBytes = 0;
+    double overfetch = 0.0;
+};
+
+class MeshOptimizer
+{
+public:
+    // 合并相同的顶点，vertices为vertexCount * floatsPerVertex个float
+    static IndexedMesh deduplicate(const float* vertices, int vertexCount, int floatsPerVertex);
+    // 无索引绘制（glDrawArrays）对应的网格：索引即为0,1,2,...
+    static IndexedMesh unindexed(const float* vertices, int vertexCount, int floatsPerVertex);
+
+    // Forsyth算法重排三角形，cacheSize为算法假设的cache大小
+    static void optimizeVertexCache(IndexedMesh& mesh, int cacheSize = 32);
+    // 按照索引中首次出现的顺序重排顶点，没有被引用的顶点会被丢弃
+    static void optimizeVertexFetch(IndexedMesh& mesh);
+
+    // deduplicate + optimizeVertexCache + optimizeVertexFetch，before/after不为空时输出处理前（无索引绘制）和处理后的统计
+    static IndexedMesh optimize(const float* vertices, int vertexCount, int floatsPerVertex,
+                                MeshStats* before = nullptr, MeshStats* after = nullptr);
+
+    // 用FIFO cache模拟post-transform cache（大多数gpu的行为接近16~32项的FIFO）
+    static MeshStats analyze(const IndexedMesh& mesh, int cacheSize = 16);
+};
+
+#endif // MESHOPTIMIZER_H
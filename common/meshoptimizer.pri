@@ -0,0 +1,8 @@
+# 网格预处理：顶点去重/三角形重排/顶点重排，只依赖标准库
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/meshoptimizer.h
+
+SOURCES += \
+    $$PWD/meshoptimizer.cpp
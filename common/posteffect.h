@@ -0,0 +1,124 @@
+#ifndef POSTEFFECT_H
+#define POSTEFFECT_H
+
+#include <string>
+
+#include "shaderdefines.h"
+
+/*
+ * 屏幕后处理特效（反相、灰度、模糊），同一份着色器源码有两种编译方式：
+ *   变体：defines(effect)注入EFFECT，每个特效编译成一个单独的program，没有分支
+ *   uber shader：uberDefines()，所有特效编译到一个program中，运行时按uniform uEffect分支
+ * RenderToTexture使用变体，headless-egl-cmake/effect-bench对比两种方式的片段着色器开销
+ *
+ * 着色器按#version 330 core的写法，uniform：screenTexture（纹理单元），uTexelSize（一个像素的纹理坐标大小，模糊使用），
+ * uEffect（只有uber shader有）；顶点属性：0 aPos（vec2），1 aTexCoords（vec2）
+*/
+class PostEffect
+{
+public:
+    // 值即为着色器中EFFECT的值
+    enum Effect {
+        None,
+        Invert,
+        Grayscale,
+        Blur,
+        EffectCount
+    };
+
+    static const char* name(Effect effect)
+    {
+        static const char* names[] = {"none", "invert", "grayscale", "blur"};
+        return effect >= None && effect < EffectCount ? names[effect] : "";
+    }
+
+    // 名字不对时返回None
+    static Effect fromName(const std::string& name, bool* ok = nullptr)
+    {
+        for (int i = 0; i < EffectCount; i++) {
+            if (name == PostEffect::name(Effect(i))) {
+                if (ok) {
+                    *ok = true;
+                }
+                return Effect(i);
+            }
+        }
+        if (ok) {
+            *ok = false;
+        }
+        return None;
+    }
+
+    static Effect next(Effect effect) { return Effect((effect + 1) % EffectCount); }
+
+    static ShaderDefines defines(Effect effect) { return ShaderDefines().set("EFFECT", int(effect)); }
+    static ShaderDefines uberDefines() { return ShaderDefines().set("UBER_SHADER"); }
+
+    static const char* vertexShader()
+    {
+        return R"(#version 330 core
+                layout (location = 0) in vec2 aPos;
+                layout (location = 1) in vec2 aTexCoords;
+
+                out vec2 TexCoords;
+
+                void main()
+                {
+                    gl_Position = vec4(aPos.x, aPos.y, 0.0, 1.0);
+                    TexCoords = aTexCoords;
+                })";
+    }
+
+    static const char* fragmentShader()
+    {
+        // 第一个声明之前不要有#if，转换到gles时精度声明等会插入到第一个声明之前（见shaderdialect.h）
+        return R"(#version 330 core
+                out vec4 FragColor;
+
+                in vec2 TexCoords;
+
+                uniform sampler2D screenTexture;
+                uniform vec2 uTexelSize;
+
+                #define EFFECT_NONE 0
+                #define EFFECT_INVERT 1
+                #define EFFECT_GRAYSCALE 2
+                #define EFFECT_BLUR 3
+
+                #ifdef UBER_SHADER
+                uniform int uEffect;
+                #define IS_EFFECT(e) (uEffect == e)
+                #else
+                // 条件是常量，编译器只保留EFFECT对应的代码
+                #define IS_EFFECT(e) (EFFECT == e)
+                #endif
+
+                void main()
+                {
+                    vec4 color = texture(screenTexture, TexCoords);
+                    if (IS_EFFECT(EFFECT_INVERT)) {
+                        // 特效处理：反相
+                        color = vec4(vec3(1.0) - color.rgb, 1.0);
+                    } else if (IS_EFFECT(EFFECT_GRAYSCALE)) {
+                        // 特效处理：灰度
+                        float average = 0.2126 * color.r + 0.7152 * color.g + 0.0722 * color.b;
+                        color = vec4(average, average, average, 1.0);
+                    } else if (IS_EFFECT(EFFECT_BLUR)) {
+                        // 特效处理：3x3高斯模糊
+                        vec3 sum = color.rgb * 4.0;
+                        sum += texture(screenTexture, TexCoords + vec2(-uTexelSize.x, 0.0)).rgb * 2.0;
+                        sum += texture(screenTexture, TexCoords + vec2(uTexelSize.x, 0.0)).rgb * 2.0;
+                        sum += texture(screenTexture, TexCoords + vec2(0.0, -uTexelSize.y)).rgb * 2.0;
+                        sum += texture(screenTexture, TexCoords + vec2(0.0, uTexelSize.y)).rgb * 2.0;
+                        sum += texture(screenTexture, TexCoords - uTexelSize).rgb;
+                        sum += texture(screenTexture, TexCoords + uTexelSize).rgb;
+                        sum += texture(screenTexture, TexCoords + vec2(-uTexelSize.x, uTexelSize.y)).rgb;
+                        sum += texture(screenTexture, TexCoords + vec2(uTexelSize.x, -uTexelSize.y)).rgb;
+                        color = vec4(sum / 16.0, 1.0);
+                    }
+                    FragColor = color;
+                })";
+    }
+};
+
+#endif // POSTEFFECT_H
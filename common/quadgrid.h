@@ -0,0 +1,116 @@
+#ifndef QUADGRID_H
+#define QUADGRID_H
+
+#include <cmath>
+#include <string>
+
+#include "renderercore.h"
+
+/*
+ * RendererCore各个后端共用的测试负载：n x n个小四边形，每个四边形一次绘制调用，
+ * 绘制前更新位置和颜色两个uniform，片段着色器中有少量计算。
+ * 绘制调用多、每次的gpu工作量小，主要对比后端的cpu开销（顶点状态设置、uniform更新、驱动的验证）
+ *
+ * 着色器按#version 330 core的写法只写一份，由RendererCore转换为后端的方言
+*/
+template<typename Renderer>
+class QuadGrid
+{
+public:
+    bool create(Renderer& renderer, int gridSize, std::string* log = nullptr)
+    {
+        m_gridSize = gridSize;
+
+        VertexLayout layout;
+        layout.stride = 4 * sizeof(float);
+        layout.attributes.push_back(VertexAttribute {"aPos", 2, 0});
+        layout.attributes.push_back(VertexAttribute {"aTexCoord", 2, int(2 * sizeof(float))});
+
+        const float vertices[] = {
+            //  位置        纹理坐标
+            0.0f, 0.0f,   0.0f, 0.0f,
+            1.0f, 0.0f,   1.0f, 0.0f,
+            1.0f, 1.0f,   1.0f, 1.0f,
+            0.0f, 1.0f,   0.0f, 1.0f
+        };
+        const GLushort indices[] = {0, 1, 2, 0, 2, 3};
+
+        m_program = renderer.createProgram(vertexShader(), fragmentShader(), layout, log);
+        if (!m_program) {
+            return false;
+        }
+        m_transformUniform = renderer.uniformLocation(m_program, "uTransform");
+        m_colorUniform = renderer.uniformLocation(m_program, "uColor");
+        return renderer.createMesh(&m_mesh, layout, vertices, 4, indices, 6);
+    }
+
+    void destroy(Renderer& renderer)
+    {
+        renderer.deleteMesh(&m_mesh);
+        renderer.deleteProgram(m_program);
+        m_program = 0;
+    }
+
+    // time用来让颜色随时间变化，所有后端在同一个time下的结果相同
+    void render(Renderer& renderer, GLuint framebuffer, int width, int height, float time)
+    {
+        renderer.beginPass(framebuffer, width, height, 0.1f, 0.1f, 0.1f, 1.0f);
+        renderer.useProgram(m_program);
+        typename Renderer::Functions* f = renderer.functions();
+
+        // 四边形之间留10%的间隔，坐标范围[-1, 1]
+        const float cell = 2.0f / m_gridSize;
+        for (int y = 0; y < m_gridSize; y++) {
+            for (int x = 0; x < m_gridSize; x++) {
+                f->glUniform4f(m_transformUniform, -1.0f + x * cell, -1.0f + y * cell, cell * 0.9f, cell * 0.9f);
+                const float phase = time + (x + y * m_gridSize) * 0.1f;
+                f->glUniform4f(m_colorUniform, 0.5f + 0.5f * std::sin(phase), float(x) / m_gridSize,
+                               float(y) / m_gridSize, 1.0f);
+                renderer.draw(m_mesh);
+            }
+        }
+        renderer.endPass();
+    }
+
+    int drawCallsPerFrame() const { return m_gridSize * m_gridSize; }
+
+private:
+    static const char* vertexShader()
+    {
+        return R"(#version 330 core
+                layout (location = 0) in vec2 aPos;
+                layout (location = 1) in vec2 aTexCoord;
+                // xy为左下角位置，zw为大小
+                uniform vec4 uTransform;
+                out vec2 vTexCoord;
+                void main()
+                {
+                    gl_Position = vec4(uTransform.xy + aPos * uTransform.zw, 0.0, 1.0);
+                    vTexCoord = aTexCoord;
+                })";
+    }
+
+    static const char* fragmentShader()
+    {
+        return R"(#version 330 core
+                in vec2 vTexCoord;
+                uniform vec4 uColor;
+                out vec4 FragColor;
+                void main()
+                {
+                    // 圆角和渐变，让每个像素有一点计算量
+                    vec2 d = abs(vTexCoord - 0.5) * 2.0;
+                    float edge = smoothstep(0.8, 1.0, max(d.x, d.y));
+                    FragColor = vec4(mix(uColor.rgb, uColor.bgr, vTexCoord.y) * (1.0 - edge), 1.0f);
+                })";
+    }
+
+private:
+    int m_gridSize = 0;
+    GLuint m_program = 0;
+    GLint m_transformUniform = -1;
+    GLint m_colorUniform = -1;
+    Mesh m_mesh;
+};
+
+#endif // QUADGRID_H
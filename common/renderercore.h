@@ -0,0 +1,272 @@
+#ifndef RENDERERCORE_H
+#define RENDERERCORE_H
+
+#include <string>
+#include <vector>
+
+#include "shaderdialect.h"
+
+/*
+ * 和后端无关的渲染核心：shader编译链接、网格（vbo/ibo）、离屏渲染目标（fbo）和绘制，
+ * 具体后端作为模板参数在编译期确定（见glbackends.h），没有虚函数调用：
+ *   RendererCore<GL33Backend<QOpenGLExtraFunctions>>   Qt，desktop gl 3.3 core，vao
+ *   RendererCore<Gles2Backend<QOpenGLExtraFunctions>>  Qt + ANGLE/gles2，每次绘制设置顶点属性
+ *   RendererCore<Gles2Backend<GLFunctions>>            EGL，见headless-egl-cmake
+ *
+ * 着色器只写一份（#version 330 core或者gles2的写法都可以），createProgram()按后端的方言转换（见shaderdialect.h）
+ *
+ * 本文件不包含gl头文件，包含之前需要先包含（Qt: <QOpenGLExtraFunctions>，EGL: "GLES2/gl2.h"）
+ * Functions需要提供和gl函数同名的成员函数（QOpenGLExtraFunctions即是如此），所有接口都需要在context current时调用
+*/
+
+// 顶点属性，都是float，序号即为属性的location
+struct VertexAttribute
+{
+    std::string name;
+    int components;
+    // 在顶点中的偏移，单位为字节
+    int offset;
+};
+
+struct VertexLayout
+{
+    // 顶点的大小，单位为字节
+    int stride = 0;
+    std::vector<VertexAttribute> attributes;
+};
+
+struct Mesh
+{
+    GLuint vbo = 0;
+    GLuint ibo = 0;
+    // 只有使用vao的后端（GL33Backend/Gles3Backend）才会创建
+    GLuint vao = 0;
+    GLsizei indexCount = 0;
+    VertexLayout layout;
+};
+
+struct RenderTarget
+{
+    GLuint fbo = 0;
+    GLuint texture = 0;
+    int width = 0;
+    int height = 0;
+};
+
+template<typename Backend>
+class RendererCore
+{
+public:
+    typedef typename Backend::Functions Functions;
+
+    struct Stats
+    {
+        int drawCalls = 0;
+        // 和上一次绘制使用同一个网格，跳过的顶点状态设置
+        int meshBindsSkipped = 0;
+    };
+
+    explicit RendererCore(Functions* functions)
+        : m_f(functions)
+        , m_backend(functions)
+    {
+    }
+
+    static ShaderDialect::Target dialect() { return Backend::dialect(); }
+    static const char* backendName() { return Backend::name(); }
+
+    // 着色器转换为后端的方言后编译链接，layout中属性的序号绑定为location，失败时返回0
+    GLuint createProgram(const std::string& vertexShader, const std::string& fragmentShader,
+                         const VertexLayout& layout, std::string* log = nullptr)
+    {
+        const GLuint vertex = compileShader(GL_VERTEX_SHADER,
+                                            ShaderDialect::rewrite(vertexShader, ShaderDialect::Vertex, dialect()), log);
+        const GLuint fragment = compileShader(GL_FRAGMENT_SHADER,
+                                              ShaderDialect::rewrite(fragmentShader, ShaderDialect::Fragment, dialect()), log);
+        if (!vertex || !fragment) {
+            m_f->glDeleteShader(vertex);
+            m_f->glDeleteShader(fragment);
+            return 0;
+        }
+
+        const GLuint program = m_f->glCreateProgram();
+        m_f->glAttachShader(program, vertex);
+        m_f->glAttachShader(program, fragment);
+        for (size_t i = 0; i < layout.attributes.size(); i++) {
+            m_f->glBindAttribLocation(program, GLuint(i), layout.attributes[i].name.c_str());
+        }
+        m_f->glLinkProgram(program);
+        m_f->glDeleteShader(vertex);
+        m_f->glDeleteShader(fragment);
+
+        GLint linked = GL_FALSE;
+        m_f->glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            if (log) {
+                *log += infoLog(program, true);
+            }
+            m_f->glDeleteProgram(program);
+            return 0;
+        }
+        return program;
+    }
+
+    void deleteProgram(GLuint program)
+    {
+        if (m_program == program) {
+            m_program = 0;
+        }
+        m_f->glDeleteProgram(program);
+    }
+
+    void useProgram(GLuint program)
+    {
+        if (m_program != program) {
+            m_f->glUseProgram(program);
+            m_program = program;
+        }
+    }
+
+    GLint uniformLocation(GLuint program, const char* name)
+    {
+        return m_f->glGetUniformLocation(program, name);
+    }
+
+    // vertices为layout格式的顶点数据，indices为三角形的索引
+    bool createMesh(Mesh* mesh, const VertexLayout& layout, const float* vertices, int vertexCount,
+                    const GLushort* indices, GLsizei indexCount)
+    {
+        mesh->layout = layout;
+        mesh->indexCount = indexCount;
+        m_f->glGenBuffers(1, &mesh->vbo);
+        m_f->glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
+        m_f->glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(vertexCount) * layout.stride, vertices, GL_STATIC_DRAW);
+        // 使用vao的后端在这里创建并绑定vao，下面ibo的绑定会记录到vao中
+        m_backend.createMesh(*mesh);
+        m_f->glGenBuffers(1, &mesh->ibo);
+        m_f->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ibo);
+        m_f->glBufferData(GL_ELEMENT_ARRAY_BUFFER, GLsizeiptr(indexCount) * sizeof(GLushort), indices, GL_STATIC_DRAW);
+        m_backend.unbindMesh();
+        m_mesh = nullptr;
+        return m_f->glGetError() == GL_NO_ERROR;
+    }
+
+    void deleteMesh(Mesh* mesh)
+    {
+        if (m_mesh == mesh) {
+            m_backend.unbindMesh();
+            m_mesh = nullptr;
+        }
+        m_backend.deleteMesh(*mesh);
+        m_f->glDeleteBuffers(1, &mesh->vbo);
+        m_f->glDeleteBuffers(1, &mesh->ibo);
+        mesh->vbo = 0;
+        mesh->ibo = 0;
+        mesh->indexCount = 0;
+    }
+
+    // RGBA8颜色附件的fbo
+    bool createRenderTarget(RenderTarget* target, int width, int height)
+    {
+        target->width = width;
+        target->height = height;
+        m_f->glGenTextures(1, &target->texture);
+        m_f->glBindTexture(GL_TEXTURE_2D, target->texture);
+        m_f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        m_f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        m_f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        m_f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        m_f->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        m_f->glGenFramebuffers(1, &target->fbo);
+        m_f->glBindFramebuffer(GL_FRAMEBUFFER, target->fbo);
+        m_f->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target->texture, 0);
+        return m_f->glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+
+    void deleteRenderTarget(RenderTarget* target)
+    {
+        m_f->glDeleteFramebuffers(1, &target->fbo);
+        m_f->glDeleteTextures(1, &target->texture);
+        target->fbo = 0;
+        target->texture = 0;
+    }
+
+    // framebuffer为0时是默认的framebuffer（QOpenGLWidget中需要传入defaultFramebufferObject()）
+    void beginPass(GLuint framebuffer, int width, int height, float r, float g, float b, float a)
+    {
+        m_f->glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        m_f->glViewport(0, 0, width, height);
+        m_f->glClearColor(r, g, b, a);
+        m_f->glClear(GL_COLOR_BUFFER_BIT);
+        m_stats = Stats();
+    }
+
+    void draw(const Mesh& mesh)
+    {
+        if (m_mesh != &mesh) {
+            m_backend.bindMesh(mesh);
+            m_mesh = &mesh;
+        } else {
+            m_stats.meshBindsSkipped++;
+        }
+        m_f->glDrawElements(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_SHORT, nullptr);
+        m_stats.drawCalls++;
+    }
+
+    // 绘制结束后恢复状态，外部（例如Qt）可以继续修改gl状态
+    void endPass()
+    {
+        m_backend.unbindMesh();
+        m_mesh = nullptr;
+        m_f->glUseProgram(0);
+        m_program = 0;
+    }
+
+    const Stats& stats() const { return m_stats; }
+    Functions* functions() const { return m_f; }
+
+private:
+    GLuint compileShader(GLenum type, const std::string& source, std::string* log)
+    {
+        const GLuint shader = m_f->glCreateShader(type);
+        const GLchar* text = source.c_str();
+        m_f->glShaderSource(shader, 1, &text, nullptr);
+        m_f->glCompileShader(shader);
+        GLint compiled = GL_FALSE;
+        m_f->glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+        if (!compiled) {
+            if (log) {
+                *log += infoLog(shader, false) + "\n" + source + "\n";
+            }
+            m_f->glDeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+
+    std::string infoLog(GLuint object, bool program)
+    {
+        GLint length = 0;
+        if (program) {
+            m_f->glGetProgramiv(object, GL_INFO_LOG_LENGTH, &length);
+        } else {
+            m_f->glGetShaderiv(object, GL_INFO_LOG_LENGTH, &length);
+        }
+        std::vector<GLchar> text(size_t(length) + 1, '\0');
+        if (program) {
+            m_f->glGetProgramInfoLog(object, length + 1, nullptr, text.data());
+        } else {
+            m_f->glGetShaderInfoLog(object, length + 1, nullptr, text.data());
+        }
+        return std::string(text.data());
+    }
+
+private:
+    Functions* m_f;
+    Backend m_backend;
+    GLuint m_program = 0;
+    const Mesh* m_mesh = nullptr;
+    Stats m_stats;
+};
+
+#endif // RENDERERCORE_H
@@ -0,0 +1,11 @@
+# 和后端无关的渲染核心：编译期选择gl 3.3 core或者gles2/gles3后端，着色器按后端的方言转换
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/renderercore.h \
+    $$PWD/glbackends.h \
+    $$PWD/shaderdialect.h \
+    $$PWD/quadgrid.h
+
+SOURCES += \
+    $$PWD/shaderdialect.cpp
@@ -0,0 +1,382 @@
+#include "shadercompiler.h"
+#include "trace.h"
+
+#include <QDebug>
+#include <QQueue>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+#include <QCoreApplication>
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
+#include <QOpenGLExtraFunctions>
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace {
+
+typedef void (QOPENGLF_APIENTRYP MaxShaderCompilerThreads)(GLuint count);
+
+// 编译两个shader并链接，不查询任何状态（查询会等待编译完成）
+void attachAndLink(QOpenGLExtraFunctions* f, GLuint program, const QByteArray& vertexShader,
+                   const QByteArray& fragmentShader)
+{
+    const GLenum types[] = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER};
+    const QByteArray* sources[] = {&vertexShader, &fragmentShader};
+    for (int i = 0; i < 2; i++) {
+        const GLuint shader = f->glCreateShader(types[i]);
+        const char* source = sources[i]->constData();
+        f->glShaderSource(shader, 1, &source, nullptr);
+        f->glCompileShader(shader);
+        f->glAttachShader(program, shader);
+        // 只是标记删除，program删除时一起释放，编译失败时还可以通过glGetAttachedShaders取得日志
+        f->glDeleteShader(shader);
+    }
+    f->glLinkProgram(program);
+}
+
+void logShaderErrors(QOpenGLExtraFunctions* f, GLuint program)
+{
+    GLuint shaders[2] = {0, 0};
+    GLsizei count = 0;
+    f->glGetAttachedShaders(program, 2, &count, shaders);
+    for (GLsizei i = 0; i < count; i++) {
+        GLint compiled = GL_FALSE;
+        f->glGetShaderiv(shaders[i], GL_COMPILE_STATUS, &compiled);
+        if (compiled) {
+            continue;
+        }
+        GLint length = 0;
+        f->glGetShaderiv(shaders[i], GL_INFO_LOG_LENGTH, &length);
+        QByteArray log(qMax(length, 1), '\0');
+        f->glGetShaderInfoLog(shaders[i], log.size(), nullptr, log.data());
+        qDebug() << "shader compile failed:" << log.constData();
+    }
+}
+
+}
+
+struct ShaderCompiler::Job
+{
+    QOpenGLShaderProgram* program = nullptr;
+    GLuint programId = 0;
+    QByteArray vertexShader;
+    QByteArray fragmentShader;
+    // WorkerThread：工作线程编译完成，由Worker的锁保护
+    bool done = false;
+};
+
+/*
+ * 工作线程：共享context中按提交顺序编译链接，完成后glFinish，保证gui线程的context能看到链接的结果
+ * 和RenderThread一样，context和离屏surface在gui线程中创建
+*/
+class ShaderCompiler::Worker : public QThread
+{
+public:
+    explicit Worker(QOpenGLContext* shareContext)
+    {
+        m_context = new QOpenGLContext;
+        m_context->setFormat(shareContext->format());
+        m_context->setShareContext(shareContext);
+        m_valid = m_context->create();
+        m_context->moveToThread(this);
+
+        m_surface = new QOffscreenSurface;
+        m_surface->setFormat(m_context->format());
+        m_surface->create();
+    }
+
+    ~Worker()
+    {
+        {
+            QMutexLocker locker(&m_mutex);
+            m_stop = true;
+            m_jobAdded.wakeAll();
+        }
+        wait();
+
+        delete m_context;
+        delete m_surface;
+    }
+
+    bool isValid() const { return m_valid; }
+
+    void enqueue(Job* job)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_queue.enqueue(job);
+        m_jobAdded.wakeOne();
+    }
+
+    bool isDone(Job* job)
+    {
+        QMutexLocker locker(&m_mutex);
+        return job->done || m_finished;
+    }
+
+    void waitFor(Job* job)
+    {
+        QMutexLocker locker(&m_mutex);
+        while (!job->done && !m_finished) {
+            m_jobDone.wait(&m_mutex);
+        }
+    }
+
+protected:
+    void run() override
+    {
+        if (!m_context->makeCurrent(m_surface)) {
+            qDebug() << "shader compiler: makeCurrent failed";
+            markAllDone();
+            return;
+        }
+        QOpenGLExtraFunctions* f = m_context->extraFunctions();
+        Trace::setThreadName("shader compiler");
+
+        QMutexLocker locker(&m_mutex);
+        while (!m_stop) {
+            if (m_queue.isEmpty()) {
+                m_jobAdded.wait(&m_mutex);
+                continue;
+            }
+            Job* job = m_queue.dequeue();
+            locker.unlock();
+
+            {
+                TRACE_SCOPE("shader compile");
+                attachAndLink(f, job->programId, job->vertexShader, job->fragmentShader);
+                f->glFinish();
+            }
+
+            locker.relock();
+            job->done = true;
+            m_jobDone.wakeAll();
+        }
+        m_context->doneCurrent();
+        // 退出时队列中剩下的program不再编译，等待它们的线程直接返回
+        m_queue.clear();
+        m_finished = true;
+        m_jobDone.wakeAll();
+    }
+
+private:
+    void markAllDone()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_queue.clear();
+        m_finished = true;
+        m_jobDone.wakeAll();
+    }
+
+private:
+    QOpenGLContext* m_context = nullptr;
+    QOffscreenSurface* m_surface = nullptr;
+    bool m_valid = false;
+
+    QMutex m_mutex;
+    QWaitCondition m_jobAdded;
+    QWaitCondition m_jobDone;
+    QQueue<Job*> m_queue;
+    bool m_stop = false;
+    // 线程已经退出（或者makeCurrent失败），没有完成的program不会再编译
+    bool m_finished = false;
+};
+
+QString ShaderCompiler::Stats::summary() const
+{
+    return QString("%1 programs %2 startup %3 ms stalls %4 / %5 ms")
+            .arg(modeName(mode)).arg(programs)
+            .arg(startupUs / 1000.0, 0, 'f', 1)
+            .arg(stalls).arg(stallUs / 1000.0, 0, 'f', 1);
+}
+
+ShaderCompiler::ShaderCompiler()
+{
+}
+
+ShaderCompiler::~ShaderCompiler()
+{
+    destroy();
+}
+
+void ShaderCompiler::initialize(QOpenGLContext *context)
+{
+    m_context = context;
+    const QByteArray forced = qgetenv("SHADER_COMPILER");
+
+    if (forced != "sync" && forced != "thread"
+            && (context->hasExtension("GL_KHR_parallel_shader_compile")
+                || context->hasExtension("GL_ARB_parallel_shader_compile"))) {
+        m_mode = ParallelExtension;
+        // 0xFFFFFFFF：由驱动决定编译线程数
+        MaxShaderCompilerThreads maxThreads = reinterpret_cast<MaxShaderCompilerThreads>(
+                    context->getProcAddress("glMaxShaderCompilerThreadsKHR"));
+        if (!maxThreads) {
+            maxThreads = reinterpret_cast<MaxShaderCompilerThreads>(
+                        context->getProcAddress("glMaxShaderCompilerThreadsARB"));
+        }
+        if (maxThreads) {
+            maxThreads(0xFFFFFFFF);
+        }
+    } else if (forced != "sync" && QThread::currentThread() == QCoreApplication::instance()->thread()) {
+        m_mode = WorkerThread;
+        m_worker = new Worker(context);
+        if (m_worker->isValid()) {
+            m_worker->start();
+        } else {
+            qDebug() << "shader compiler: create shared context failed";
+            delete m_worker;
+            m_worker = nullptr;
+            m_mode = Synchronous;
+        }
+    } else {
+        m_mode = Synchronous;
+    }
+    m_stats.mode = m_mode;
+    qDebug() << "shader compiler:" << modeName(m_mode);
+}
+
+void ShaderCompiler::destroy()
+{
+    delete m_worker;
+    m_worker = nullptr;
+    qDeleteAll(m_jobs);
+    m_jobs.clear();
+    m_stats.pending = 0;
+}
+
+void ShaderCompiler::compile(QOpenGLShaderProgram *program, const QByteArray &vertexShader,
+                             const QByteArray &fragmentShader)
+{
+    TRACE_SCOPE(m_mode == Synchronous ? "shader compile" : "shader compile submit");
+    if (m_stats.programs == 0) {
+        m_startupTimer.start();
+    }
+    m_stats.programs++;
+
+    if (m_mode == Synchronous) {
+        // addCacheableShaderFromSourceCode：可以命中磁盘上的program binary缓存
+        program->addCacheableShaderFromSourceCode(QOpenGLShader::Vertex, vertexShader);
+        program->addCacheableShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShader);
+        program->link();
+        m_stats.startupUs = m_startupTimer.nsecsElapsed() / 1000;
+        return;
+    }
+
+    program->create();
+    Job* job = new Job;
+    job->program = program;
+    job->programId = program->programId();
+    m_jobs.insert(program, job);
+    m_stats.pending++;
+
+    if (m_mode == ParallelExtension) {
+        attachAndLink(m_context->extraFunctions(), job->programId, vertexShader, fragmentShader);
+    } else {
+        job->vertexShader = vertexShader;
+        job->fragmentShader = fragmentShader;
+        m_worker->enqueue(job);
+    }
+}
+
+bool ShaderCompiler::isReady(QOpenGLShaderProgram *program)
+{
+    Job* job = m_jobs.value(program);
+    if (!job) {
+        return true;
+    }
+    if (!poll(job)) {
+        return false;
+    }
+    complete(job);
+    return true;
+}
+
+bool ShaderCompiler::finish(QOpenGLShaderProgram *program)
+{
+    Job* job = m_jobs.value(program);
+    if (!job) {
+        return program->isLinked();
+    }
+
+    if (!poll(job)) {
+        TRACE_SCOPE("shader compile wait");
+        QElapsedTimer timer;
+        timer.start();
+        if (m_mode == WorkerThread) {
+            m_worker->waitFor(job);
+        } else {
+            // 查询链接状态会等待编译链接完成
+            GLint linked = GL_FALSE;
+            m_context->extraFunctions()->glGetProgramiv(job->programId, GL_LINK_STATUS, &linked);
+        }
+        m_stats.stalls++;
+        m_stats.stallUs += timer.nsecsElapsed() / 1000;
+    }
+    return complete(job);
+}
+
+void ShaderCompiler::cancel(QOpenGLShaderProgram *program)
+{
+    Job* job = m_jobs.take(program);
+    if (!job) {
+        return;
+    }
+    // 工作线程可能正在使用这个program
+    if (m_mode == WorkerThread) {
+        m_worker->waitFor(job);
+    }
+    m_stats.pending--;
+    delete job;
+}
+
+ShaderCompiler::Mode ShaderCompiler::mode() const
+{
+    return m_mode;
+}
+
+ShaderCompiler::Stats ShaderCompiler::stats() const
+{
+    return m_stats;
+}
+
+const char *ShaderCompiler::modeName(Mode mode)
+{
+    switch (mode) {
+    case ParallelExtension:
+        return "parallel-extension";
+    case WorkerThread:
+        return "worker-thread";
+    default:
+        return "sync";
+    }
+}
+
+bool ShaderCompiler::poll(Job *job)
+{
+    if (m_mode == WorkerThread) {
+        return m_worker->isDone(job);
+    }
+    GLint completed = GL_FALSE;
+    m_context->extraFunctions()->glGetProgramiv(job->programId, GL_COMPLETION_STATUS_KHR, &completed);
+    return completed == GL_TRUE;
+}
+
+bool ShaderCompiler::complete(Job *job)
+{
+    m_jobs.remove(job->program);
+    m_stats.pending--;
+    if (m_stats.pending == 0) {
+        m_stats.startupUs = m_startupTimer.nsecsElapsed() / 1000;
+    }
+
+    // program中没有QOpenGLShader时，link()只查询链接状态，已经链接成功的不会重新链接
+    const bool ok = job->program->link();
+    if (!ok) {
+        logShaderErrors(m_context->extraFunctions(), job->programId);
+    }
+    delete job;
+    return ok;
+}
@@ -0,0 +1,88 @@
+#ifndef SHADERCOMPILER_H
+#define SHADERCOMPILER_H
+
+#include <QHash>
+#include <QString>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QOpenGLShaderProgram>
+
+class QOpenGLContext;
+
+/*
+ * 不阻塞的着色器编译：initializeGL中提交所有program，gl在后台编译链接，第一次用到某个program时才等待它完成
+ *   ParallelExtension：支持KHR_parallel_shader_compile（或ARB_parallel_shader_compile）时，驱动在自己的线程中编译，
+ *                      通过GL_COMPLETION_STATUS_KHR查询是否完成（查询不阻塞）
+ *   WorkerThread：     不支持扩展时，在工作线程的共享context中编译链接（program对象在共享的context之间可见）
+ *   Synchronous：      提交时直接编译链接（和原来一样，可以命中磁盘上的program binary缓存），
+ *                      不在gui线程中（QOffscreenSurface只能在gui线程创建）时也使用这种方式
+ * 环境变量SHADER_COMPILER=sync/thread可以强制使用Synchronous/WorkerThread，对比启动耗时
+ *
+ * 使用方法：
+ * 1. initialize()，需要在context current时调用，之后的接口也都需要context current
+ * 2. compile(program, vertex, fragment)提交编译，program是空的QOpenGLShaderProgram（不要addShader）
+ * 3. 每帧可以isReady()查询；用到program之前调用finish()，还没有完成时阻塞等待（计入stalls）
+ * 4. 析构前调用destroy()（等待工作线程结束）
+ *
+ * program由调用者持有，在finish()之前删除program需要先调用cancel()
+*/
+class ShaderCompiler
+{
+public:
+    enum Mode {
+        Synchronous,
+        ParallelExtension,
+        WorkerThread
+    };
+
+    struct Stats
+    {
+        Mode mode = Synchronous;
+        int programs = 0;
+        int pending = 0;
+        // 第一次提交到最后一个program完成（或者被finish）的时间
+        qint64 startupUs = 0;
+        // finish()时还没有编译完成，需要阻塞等待的次数和总耗时
+        int stalls = 0;
+        qint64 stallUs = 0;
+
+        // 例如 "parallel-extension programs 3 startup 52.1 ms stalls 1 / 12.3 ms"
+        QString summary() const;
+    };
+
+    ShaderCompiler();
+    ~ShaderCompiler();
+
+    void initialize(QOpenGLContext* context);
+    void destroy();
+
+    void compile(QOpenGLShaderProgram* program, const QByteArray& vertexShader, const QByteArray& fragmentShader);
+    // 不阻塞，没有提交过的program返回true
+    bool isReady(QOpenGLShaderProgram* program);
+    // 阻塞直到编译链接完成，返回是否链接成功，失败原因见program->log()
+    bool finish(QOpenGLShaderProgram* program);
+    void cancel(QOpenGLShaderProgram* program);
+
+    Mode mode() const;
+    Stats stats() const;
+
+    static const char* modeName(Mode mode);
+
+private:
+    struct Job;
+    class Worker;
+
+    bool poll(Job* job);
+    bool complete(Job* job);
+
+private:
+    QOpenGLContext* m_context = nullptr;
+    Mode m_mode = Synchronous;
+    Worker* m_worker = nullptr;
+    QHash<QOpenGLShaderProgram*, Job*> m_jobs;
+
+    QElapsedTimer m_startupTimer;
+    Stats m_stats;
+};
+
+#endif // SHADERCOMPILER_H
@@ -0,0 +1,10 @@
+# 不阻塞的着色器编译：KHR_parallel_shader_compile，不支持时在工作线程的共享context中编译，第一次使用时才等待
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/shadercompiler.h
+
+SOURCES += \
+    $$PWD/shadercompiler.cpp
+
+include($$PWD/trace.pri)
@@ -0,0 +1,78 @@
+#ifndef SHADERDEFINES_H
+#define SHADERDEFINES_H
+
+#include <cstdio>
+#include <map>
+#include <string>
+
+/*
+ * 着色器变体的特性开关和常量：以#define的形式插入到着色器源码中，
+ * 着色器中用#if/#ifdef或者常量条件选择代码，编译器直接去掉没有用到的部分，运行时没有分支
+ *
+ *   ShaderDefines().set("EFFECT", 2).set("MIX_FACTOR", 0.2).inject(source)
+ *
+ * key()是按名字排序的字符串，相同的define集合得到相同的key，用作变体缓存的键（见shadervariantcache.h）
+ * 纯c++实现，不依赖Qt，Qt的例子和headless-egl-cmake共用
+*/
+class ShaderDefines
+{
+public:
+    ShaderDefines& set(const std::string& name, const std::string& value = "1")
+    {
+        m_defines[name] = value;
+        return *this;
+    }
+
+    ShaderDefines& set(const std::string& name, int value)
+    {
+        return set(name, std::to_string(value));
+    }
+
+    // 总是带小数点，在glsl中是float常量（没有f后缀，gles2也可以使用）
+    ShaderDefines& set(const std::string& name, double value)
+    {
+        char text[32];
+        snprintf(text, sizeof(text), "%.9g", value);
+        std::string result = text;
+        if (result.find_first_of(".en") == std::string::npos) {
+            result += ".0";
+        }
+        return set(name, result);
+    }
+
+    bool isEmpty() const { return m_defines.empty(); }
+
+    // 例如 "EFFECT=2;MIX_FACTOR=0.2;"
+    std::string key() const
+    {
+        std::string result;
+        for (const auto& define : m_defines) {
+            result += define.first + "=" + define.second + ";";
+        }
+        return result;
+    }
+
+    // #define插入到#version之后（#version必须在最前面），没有#version时插入到最前面
+    std::string inject(const std::string& source) const
+    {
+        std::string defines;
+        for (const auto& define : m_defines) {
+            defines += "#define " + define.first + " " + define.second + "\n";
+        }
+
+        const size_t start = source.find_first_not_of(" \t\r\n");
+        if (start == std::string::npos || source.compare(start, 8, "#version") != 0) {
+            return defines + source;
+        }
+        const size_t lineEnd = source.find('\n', start);
+        if (lineEnd == std::string::npos) {
+            return source + "\n" + defines;
+        }
+        return source.substr(0, lineEnd + 1) + defines + source.substr(lineEnd + 1);
+    }
+
+private:
+    std::map<std::string, std::string> m_defines;
+};
+
+#endif // SHADERDEFINES_H
@@ -0,0 +1,5 @@
+# 着色器的特性开关和常量：以#define注入着色器源码，只有头文件，不依赖Qt
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/shaderdefines.h
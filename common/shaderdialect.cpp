@@ -0,0 +1,255 @@
+#include "shaderdialect.h"
+
+#include <vector>
+#include <cctype>
+
+namespace {
+
+struct Token
+{
+    enum Type {
+        Space,          // 空白和注释，原样输出
+        Preprocessor,   // '#'开始的一整行
+        Identifier,
+        Number,
+        Punct
+    };
+
+    Type type;
+    std::string text;
+};
+
+bool isIdentifierChar(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+std::vector<Token> tokenize(const std::string& source)
+{
+    std::vector<Token> tokens;
+    size_t i = 0;
+    bool lineStart = true;
+    while (i < source.size()) {
+        const char c = source[i];
+        const size_t start = i;
+        Token::Type type;
+        if (c == '/' && i + 1 < source.size() && source[i + 1] == '/') {
+            while (i < source.size() && source[i] != '\n') {
+                i++;
+            }
+            type = Token::Space;
+        } else if (c == '/' && i + 1 < source.size() && source[i + 1] == '*') {
+            const size_t end = source.find("*/", i + 2);
+            i = end == std::string::npos ? source.size() : end + 2;
+            type = Token::Space;
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            while (i < source.size() && std::isspace(static_cast<unsigned char>(source[i]))) {
+                lineStart = lineStart || source[i] == '\n';
+                i++;
+            }
+            tokens.push_back(Token {Token::Space, source.substr(start, i - start)});
+            continue;
+        } else if (c == '#' && lineStart) {
+            while (i < source.size() && source[i] != '\n') {
+                i++;
+            }
+            type = Token::Preprocessor;
+        } else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            while (i < source.size() && isIdentifierChar(source[i])) {
+                i++;
+            }
+            type = Token::Identifier;
+        } else if (std::isdigit(static_cast<unsigned char>(c))
+                   || (c == '.' && i + 1 < source.size() && std::isdigit(static_cast<unsigned char>(source[i + 1])))) {
+            // 数字连同后缀（1.0f、2u、1e-3）作为一个token
+            while (i < source.size() && (isIdentifierChar(source[i]) || source[i] == '.'
+                                         || ((source[i] == '+' || source[i] == '-')
+                                             && (source[i - 1] == 'e' || source[i - 1] == 'E')))) {
+                i++;
+            }
+            type = Token::Number;
+        } else {
+            i++;
+            type = Token::Punct;
+        }
+        lineStart = false;
+        tokens.push_back(Token {type, source.substr(start, i - start)});
+    }
+    return tokens;
+}
+
+bool isSignificant(const Token& token)
+{
+    return token.type != Token::Space;
+}
+
+// 从index开始（包括index）的下一个有效token，没有时返回tokens.size()
+size_t nextSignificant(const std::vector<Token>& tokens, size_t index)
+{
+    while (index < tokens.size() && !isSignificant(tokens[index])) {
+        index++;
+    }
+    return index;
+}
+
+}
+
+std::string ShaderDialect::rewrite(const std::string &source, ShaderDialect::Stage stage, ShaderDialect::Target target)
+{
+    const std::vector<Token> tokens = tokenize(source);
+    const bool es100 = target == GlslEs100;
+    const bool fragment = stage == Fragment;
+
+    std::vector<Token> out;
+    out.reserve(tokens.size());
+    int braceDepth = 0;
+    int parenDepth = 0;
+    bool statementStart = true;
+    bool hasFloatPrecision = false;
+    bool hasFragmentOutput = false;
+    bool usesFragColor = false;
+    std::string fragmentOutputName;
+    // 需要补充的声明插入到第一个非预处理的token之前（#extension必须在所有声明之前）
+    size_t declarationIndex = std::string::npos;
+
+    for (size_t i = 0; i < tokens.size(); i++) {
+        Token token = tokens[i];
+        if (token.type == Token::Space) {
+            out.push_back(token);
+            continue;
+        }
+        if (token.type == Token::Preprocessor) {
+            // 原来的#version去掉，统一换成目标版本
+            if (token.text.compare(0, 8, "#version") != 0) {
+                out.push_back(token);
+            }
+            continue;
+        }
+        if (declarationIndex == std::string::npos) {
+            declarationIndex = out.size();
+        }
+
+        const bool globalStatement = statementStart && braceDepth == 0 && parenDepth == 0;
+        if (token.type == Token::Identifier && globalStatement) {
+            if (token.text == "layout" && es100) {
+                // 跳过layout(...)
+                size_t j = nextSignificant(tokens, i + 1);
+                int depth = 0;
+                for (; j < tokens.size(); j++) {
+                    if (tokens[j].text == "(") {
+                        depth++;
+                    } else if (tokens[j].text == ")" && --depth == 0) {
+                        break;
+                    }
+                }
+                i = nextSignificant(tokens, j + 1) - 1;
+                continue;
+            }
+
+            if (token.text == "out" && fragment && es100) {
+                // gles2只有gl_FragColor：去掉输出变量的声明，之后对它的引用都替换为gl_FragColor
+                size_t j = i + 1;
+                for (; j < tokens.size() && tokens[j].text != ";"; j++) {
+                    if (tokens[j].type == Token::Identifier) {
+                        fragmentOutputName = tokens[j].text;
+                    }
+                }
+                i = j;
+                continue;
+            }
+
+            if (token.text == "attribute" || token.text == "varying" || token.text == "in" || token.text == "out") {
+                const bool input = token.text == "attribute" || token.text == "in"
+                        || (token.text == "varying" && fragment);
+                if (es100) {
+                    token.text = !fragment && input ? "attribute" : "varying";
+                } else {
+                    token.text = input ? "in" : "out";
+                }
+                if (fragment && token.text == "out") {
+                    hasFragmentOutput = true;
+                }
+            } else if (token.text == "precision") {
+                for (size_t j = i + 1; j < tokens.size() && tokens[j].text != ";"; j++) {
+                    if (tokens[j].text == "float") {
+                        hasFloatPrecision = true;
+                    }
+                }
+            }
+        }
+
+        if (token.type == Token::Identifier) {
+            if (token.text == "texture2D" && !es100) {
+                token.text = "texture";
+            } else if (token.text == "texture" && es100) {
+                const size_t next = nextSignificant(tokens, i + 1);
+                if (next < tokens.size() && tokens[next].text == "(") {
+                    token.text = "texture2D";
+                }
+            } else if (token.text == "gl_FragColor" && fragment && !es100) {
+                token.text = "FragColor";
+                usesFragColor = true;
+            } else if (es100 && !fragmentOutputName.empty() && token.text == fragmentOutputName) {
+                token.text = "gl_FragColor";
+            }
+        } else if (token.type == Token::Number && es100) {
+            // glsl es 1.00不支持浮点数的f后缀
+            const char last = token.text[token.text.size() - 1];
+            if ((last == 'f' || last == 'F') && token.text.find_first_of(".eE") != std::string::npos
+                    && token.text.compare(0, 2, "0x") != 0) {
+                token.text.erase(token.text.size() - 1);
+            }
+        }
+
+        if (token.text == "{") {
+            braceDepth++;
+        } else if (token.text == "}") {
+            braceDepth--;
+        } else if (token.text == "(") {
+            parenDepth++;
+        } else if (token.text == ")") {
+            parenDepth--;
+        }
+        statementStart = token.text == ";" || token.text == "{" || token.text == "}";
+        out.push_back(token);
+    }
+
+    std::string declarations;
+    if (fragment && isEs(target) && !hasFloatPrecision) {
+        declarations += "precision mediump float;\n";
+    }
+    if (fragment && usesFragColor && !hasFragmentOutput) {
+        declarations += "out vec4 FragColor;\n";
+    }
+
+    std::string result = versionLine(target);
+    result += '\n';
+    for (size_t i = 0; i < out.size(); i++) {
+        if (i == declarationIndex) {
+            result += declarations;
+        }
+        result += out[i].text;
+    }
+    if (declarationIndex == std::string::npos) {
+        result += declarations;
+    }
+    return result;
+}
+
+const char *ShaderDialect::versionLine(ShaderDialect::Target target)
+{
+    switch (target) {
+    case GlslEs100:
+        return "#version 100";
+    case GlslEs300:
+        return "#version 300 es";
+    case Glsl330Core:
+    default:
+        return "#version 330 core";
+    }
+}
+
+bool ShaderDialect::isEs(ShaderDialect::Target target)
+{
+    return target == GlslEs100 || target == GlslEs300;
+}
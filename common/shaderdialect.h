@@ -0,0 +1,44 @@
+#ifndef SHADERDIALECT_H
+#define SHADERDIALECT_H
+
+#include <string>
+
+/*
+ * glsl方言转换：同一份着色器源码转换为desktop gl 3.3 core（#version 330 core）、gles2（#version 100）
+ * 或者gles3（#version 300 es）可以接受的写法，输入可以是任意一种写法（可以不写#version）
+ *
+ *                          330 core / 300 es            100
+ * 顶点着色器输入            in                           attribute
+ * 顶点着色器输出            out                          varying
+ * 片段着色器输入            in                           varying
+ * 片段着色器输出            out vec4 FragColor           gl_FragColor
+ * 纹理采样                  texture()                    texture2D()
+ * layout(location = n)     保留                         去掉（由glBindAttribLocation指定）
+ * 片段着色器float精度       300 es没有声明时补上mediump    没有声明时补上mediump
+ *
+ * 只处理全局作用域中的声明和上面列出的内置名字，不做完整的语法分析；
+ * 转换到330/300 es时texture是内置函数，不要用texture作为变量名
+ *
+ * 纯c++实现，不依赖Qt，Qt的例子和headless-egl-cmake共用
+*/
+class ShaderDialect
+{
+public:
+    enum Target {
+        Glsl330Core,
+        GlslEs100,
+        GlslEs300
+    };
+
+    enum Stage {
+        Vertex,
+        Fragment
+    };
+
+    static std::string rewrite(const std::string& source, Stage stage, Target target);
+
+    static const char* versionLine(Target target);
+    static bool isEs(Target target);
+};
+
+#endif // SHADERDIALECT_H
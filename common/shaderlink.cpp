@@ -0,0 +1,35 @@
+#include "shaderlink.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QOpenGLShaderProgram>
+
+bool linkTimed(QOpenGLShaderProgram &program, const char *tag)
+{
+    QElapsedTimer linkTimer;
+    linkTimer.start();
+    if (!program.link())
+    {
+        qDebug() << tag << "Can't link program.";
+        return false;
+    }
+    qDebug() << tag << "shader link cost:" << linkTimer.nsecsElapsed() / 1000 << "us"
+             << (program.shaders().isEmpty() ? "(warm start: binary cache hit)" : "(cold start: compiled from source)");
+    return true;
+}
+
+bool buildCachedProgram(QOpenGLShaderProgram &program, const QString &vertexShader,
+                        const QString &fragmentShader, const char *tag)
+{
+    if (!program.addCacheableShaderFromSourceCode(QOpenGLShader::Vertex, vertexShader))
+    {
+        qDebug() << tag << "Can't add vertex shader.";
+        return false;
+    }
+    if (!program.addCacheableShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShader))
+    {
+        qDebug() << tag << "Can't add fragment shader.";
+        return false;
+    }
+    return linkTimed(program, tag);
+}
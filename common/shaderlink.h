@@ -0,0 +1,27 @@
+#ifndef SHADERLINK_H
+#define SHADERLINK_H
+
+#include <QString>
+
+class QOpenGLShaderProgram;
+
+/*
+ * 着色器的编译链接，各个示例共用
+ *
+ * 着色器通过addCacheableShaderFromSourceCode添加：链接好的program binary按照着色器源码和驱动的vendor/renderer/version
+ * 缓存到磁盘，之后启动直接加载binary不再编译（binary被驱动拒绝时自动退回到从源码编译）
+ * 命中磁盘缓存时没有编译任何shader，链接以后shaders()为空，据此区分warm start和cold start
+ *
+ * 使用方法（需要在context current时调用）：
+ *   buildCachedProgram(m_shaderProgram, vertexShaderSource, fragmentShaderSource, "Blend");
+ * 或者自己添加着色器以后调用linkTimed(m_shaderProgram, "Blend")
+*/
+
+// 链接program，输出耗时以及是否命中磁盘缓存，tag用于区分输出，返回link()的结果
+bool linkTimed(QOpenGLShaderProgram& program, const char* tag);
+
+// 添加可缓存的顶点/片段着色器并调用linkTimed，任何一步失败时输出原因并返回false
+bool buildCachedProgram(QOpenGLShaderProgram& program, const QString& vertexShader,
+                        const QString& fragmentShader, const char* tag);
+
+#endif // SHADERLINK_H
@@ -0,0 +1,8 @@
+# 着色器的编译链接：使用磁盘上的program binary缓存，输出链接耗时以及是否命中缓存
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/shaderlink.h
+
+SOURCES += \
+    $$PWD/shaderlink.cpp
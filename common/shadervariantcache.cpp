@@ -0,0 +1,132 @@
+#include "shadervariantcache.h"
+#include "shadercompiler.h"
+#include <QDebug>
+#include <QElapsedTimer>
+
+QString ShaderVariantCache::Stats::summary() const
+{
+    return QString("variants %1 hits %2 misses %3 compile %4 ms")
+            .arg(variants).arg(hits).arg(misses)
+            .arg(compileUs / 1000.0, 0, 'f', 1);
+}
+
+ShaderVariantCache::ShaderVariantCache()
+{
+}
+
+ShaderVariantCache::~ShaderVariantCache()
+{
+    qDeleteAll(m_programs);
+}
+
+void ShaderVariantCache::setSources(const char *vertexShader, const char *fragmentShader)
+{
+    clear();
+    m_vertexShader = vertexShader;
+    m_fragmentShader = fragmentShader;
+}
+
+void ShaderVariantCache::setCompiler(ShaderCompiler *compiler)
+{
+    m_compiler = compiler;
+}
+
+void ShaderVariantCache::request(const ShaderDefines &defines)
+{
+    const QString key = QString::fromStdString(defines.key());
+    if (!m_programs.contains(key)) {
+        compile(key, defines);
+    }
+}
+
+QOpenGLShaderProgram *ShaderVariantCache::program(const ShaderDefines &defines)
+{
+    const QString key = QString::fromStdString(defines.key());
+    if (m_programs.contains(key)) {
+        m_stats.hits++;
+    } else {
+        compile(key, defines);
+    }
+    if (m_pending.contains(key)) {
+        finish(key);
+    }
+    return m_programs.value(key);
+}
+
+void ShaderVariantCache::clear()
+{
+    for (const QString& key : m_pending) {
+        m_compiler->cancel(m_programs.value(key));
+    }
+    m_pending.clear();
+    qDeleteAll(m_programs);
+    m_programs.clear();
+    m_stats.variants = 0;
+    m_stats.failures = 0;
+}
+
+void ShaderVariantCache::compile(const QString &key, const ShaderDefines &defines)
+{
+    m_stats.misses++;
+
+    QElapsedTimer timer;
+    timer.start();
+    QOpenGLShaderProgram* program = new QOpenGLShaderProgram;
+    const QByteArray vertexShader = QByteArray::fromStdString(defines.inject(m_vertexShader));
+    const QByteArray fragmentShader = QByteArray::fromStdString(defines.inject(m_fragmentShader));
+    m_programs.insert(key, program);
+    if (m_compiler) {
+        m_compiler->compile(program, vertexShader, fragmentShader);
+        m_pending.insert(key);
+        m_stats.compileUs += timer.nsecsElapsed() / 1000;
+        return;
+    }
+
+    const bool ok = program->addCacheableShaderFromSourceCode(QOpenGLShader::Vertex, vertexShader)
+            && program->addCacheableShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShader)
+            && program->link();
+    const qint64 us = timer.nsecsElapsed() / 1000;
+    m_stats.compileUs += us;
+    if (!ok) {
+        m_log = program->log();
+        qDebug() << "shader variant" << key << "failed:" << m_log;
+        delete program;
+        m_programs.insert(key, nullptr);
+        m_stats.failures++;
+    } else {
+        // 命中磁盘缓存时没有编译任何shader，shaders()为空
+        qDebug() << "shader variant" << key << "link cost:" << us << "us"
+                 << (program->shaders().isEmpty() ? "(binary cache hit)" : "(compiled from source)");
+        m_stats.variants++;
+    }
+}
+
+void ShaderVariantCache::finish(const QString &key)
+{
+    m_pending.remove(key);
+    QOpenGLShaderProgram* program = m_programs.value(key);
+
+    QElapsedTimer timer;
+    timer.start();
+    const bool ok = m_compiler->finish(program);
+    m_stats.compileUs += timer.nsecsElapsed() / 1000;
+    if (!ok) {
+        m_log = program->log();
+        qDebug() << "shader variant" << key << "failed:" << m_log;
+        delete program;
+        m_programs.insert(key, nullptr);
+        m_stats.failures++;
+    } else {
+        m_stats.variants++;
+    }
+}
+
+const ShaderVariantCache::Stats &ShaderVariantCache::stats() const
+{
+    return m_stats;
+}
+
+QString ShaderVariantCache::log() const
+{
+    return m_log;
+}
@@ -0,0 +1,81 @@
+#ifndef SHADERVARIANTCACHE_H
+#define SHADERVARIANTCACHE_H
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QOpenGLShaderProgram>
+
+#include <string>
+
+#include "shaderdefines.h"
+
+class ShaderCompiler;
+
+/*
+ * 着色器变体缓存：同一份着色器源码按不同的ShaderDefines（特性开关、常量）编译成不同的program，
+ * 每个用到的组合只编译链接一次，之后直接返回缓存的program
+ *
+ * 使用方法：
+ * 1. setSources()设置源码（#version 330 core的写法，#define插入到#version之后）
+ * 2. 需要时（例如切换特效时）program(defines)取得program，不要每帧都查找（每次查找都要拼接key）
+ * 3. 析构前在context current时调用clear()释放所有program
+ *
+ * 设置了ShaderCompiler时，request(defines)只提交编译不等待，initializeGL中提前提交之后会用到的变体，
+ * program(defines)时还没有编译完成才阻塞；没有设置时request()和program()都直接编译链接
+ *
+ * 同步编译使用addCacheableShaderFromSourceCode，不同变体的源码不同，在磁盘上各自缓存program binary
+*/
+class ShaderVariantCache
+{
+public:
+    struct Stats
+    {
+        int variants = 0;
+        // 编译或者链接失败的变体，之后再取也直接返回nullptr，不会重复编译
+        int failures = 0;
+        quint64 hits = 0;
+        quint64 misses = 0;
+        // 调用线程上编译链接的总耗时（异步编译时只包括提交和等待的时间）
+        qint64 compileUs = 0;
+
+        // 例如 "variants 3 hits 10 misses 3 compile 12.3 ms"
+        QString summary() const;
+    };
+
+    ShaderVariantCache();
+    ~ShaderVariantCache();
+
+    void setSources(const char* vertexShader, const char* fragmentShader);
+    // 之后的变体交给compiler异步编译，compiler需要比缓存中的program活得更久（或者先clear()）
+    void setCompiler(ShaderCompiler* compiler);
+
+    // 以下接口需要在context current时调用
+    // 提交编译，不等待编译完成
+    void request(const ShaderDefines& defines);
+    // 失败时返回nullptr，失败原因见log()
+    QOpenGLShaderProgram* program(const ShaderDefines& defines);
+
+    void clear();
+
+    const Stats& stats() const;
+    // 最近一次编译失败的日志
+    QString log() const;
+
+private:
+    void compile(const QString& key, const ShaderDefines& defines);
+    void finish(const QString& key);
+
+private:
+    ShaderCompiler* m_compiler = nullptr;
+    std::string m_vertexShader;
+    std::string m_fragmentShader;
+    // key为ShaderDefines::key()，编译失败的变体为nullptr
+    QHash<QString, QOpenGLShaderProgram*> m_programs;
+    // 已经提交给m_compiler，还没有finish的变体
+    QSet<QString> m_pending;
+    QString m_log;
+    Stats m_stats;
+};
+
+#endif // SHADERVARIANTCACHE_H
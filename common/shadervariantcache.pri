@@ -0,0 +1,14 @@
+# 着色器变体缓存：特性开关和常量以#define注入着色器源码，每个用到的组合只编译一次
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/posteffect.h \
+    $$PWD/shadervariantcache.h
+
+SOURCES += \
+    $$PWD/shadervariantcache.cpp
+
+include($$PWD/shaderdefines.pri)
+
+# 设置了ShaderCompiler时异步编译
+include($$PWD/shadercompiler.pri)
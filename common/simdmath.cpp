@@ -0,0 +1,410 @@
+#include "simdmath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#  define SIMDMATH_X86 1
+// gcc/clang：只有AVX2的kernel使用AVX2/FMA指令编译，不支持的cpu上不会调用它
+#  define SIMDMATH_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#  include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#  define SIMDMATH_X86 1
+#  define SIMDMATH_TARGET_AVX2
+#  include <intrin.h>
+#  include <immintrin.h>
+#endif
+
+namespace {
+
+// sin/cos在[-pi/4, pi/4]上的多项式近似（系数来自Cephes的sinf/cosf，误差约1ulp）
+const float kSinC1 = -1.6666654611e-1f;
+const float kSinC2 = 8.3321608736e-3f;
+const float kSinC3 = -1.9515295891e-4f;
+const float kCosC1 = 4.166664568298827e-2f;
+const float kCosC2 = -1.388731625493765e-3f;
+const float kCosC3 = 2.443315711809948e-5f;
+
+const float kTwoOverPi = 0.636619772367581343f;
+// pi/2拆成两部分，减去整数倍的pi/2时保留更多精度
+const float kPiOver2Hi = 1.57079637050628662109375f;
+const float kPiOver2Lo = -4.37113900018624283e-8f;
+
+SimdMath::Backend& currentBackend()
+{
+    static SimdMath::Backend backend = SimdMath::bestBackend();
+    return backend;
+}
+
+// 先在角度制下把角度归约到[-180, 180]（避免很大的角度转换成弧度时损失精度），
+// 再按象限归约到[-pi/4, pi/4]计算多项式
+void sinCosDegrees(float degrees, float& s, float& c)
+{
+    const float turns = std::nearbyint(degrees * (1.0f / 360.0f));
+    const float x = degreesToRadians(degrees - turns * 360.0f);
+    const float q = std::nearbyint(x * kTwoOverPi);
+    const float r = (x - q * kPiOver2Hi) - q * kPiOver2Lo;
+    const float z = r * r;
+    const float sinR = ((kSinC3 * z + kSinC2) * z + kSinC1) * z * r + r;
+    const float cosR = ((kCosC3 * z + kCosC2) * z + kCosC1) * z * z - 0.5f * z + 1.0f;
+
+    // 象限q（mod 4）：0 -> (sin, cos)，1 -> (cos, -sin)，2 -> (-sin, -cos)，3 -> (-cos, sin)
+    const int quadrant = int(q);
+    s = (quadrant & 1) ? cosR : sinR;
+    c = (quadrant & 1) ? sinR : cosR;
+    if (quadrant & 2) {
+        s = -s;
+    }
+    if ((quadrant + 1) & 2) {
+        c = -c;
+    }
+}
+
+void translateRotateOne(const float* translation, float degrees, const RotationAxis& axis, float* out)
+{
+    float s, c;
+    sinCosDegrees(degrees, s, c);
+    const float t = 1.0f - c;
+
+    // 绕单位轴旋转的矩阵（Rodrigues公式），再左乘平移矩阵，平移只影响第4列
+    out[0] = t * axis.xx + c;
+    out[1] = t * axis.xy + s * axis.z;
+    out[2] = t * axis.xz - s * axis.y;
+    out[3] = 0.0f;
+    out[4] = t * axis.xy - s * axis.z;
+    out[5] = t * axis.yy + c;
+    out[6] = t * axis.yz + s * axis.x;
+    out[7] = 0.0f;
+    out[8] = t * axis.xz + s * axis.y;
+    out[9] = t * axis.yz - s * axis.x;
+    out[10] = t * axis.zz + c;
+    out[11] = 0.0f;
+    out[12] = translation[0];
+    out[13] = translation[1];
+    out[14] = translation[2];
+    out[15] = 1.0f;
+}
+
+void translateRotateScalar(const float* translations, const float* baseAngles, float angleOffset,
+                           const int* indices, int begin, int end, const RotationAxis& axis, float* out)
+{
+    for (int n = begin; n < end; n++) {
+        const int i = indices ? indices[n] : n;
+        translateRotateOne(translations + i * 3, baseAngles[i] + angleOffset, axis, out + n * 16);
+    }
+}
+
+#ifdef SIMDMATH_X86
+
+// 4个物体同时计算，最后不足4个的一组补齐（重复最后一个物体）后同样用SIMD计算，写到临时缓冲再复制需要的部分，
+// 这样同一个物体不论落在哪一组，结果都逐位相同（FMA和非FMA的舍入不同，混用标量实现会导致结果取决于物体的位置）
+int translateRotateSSE2(const float* translations, const float* baseAngles, float angleOffset,
+                        const int* indices, int count, const RotationAxis& axis, float* out)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 ax = _mm_set1_ps(axis.x), ay = _mm_set1_ps(axis.y), az = _mm_set1_ps(axis.z);
+    const __m128 axx = _mm_set1_ps(axis.xx), axy = _mm_set1_ps(axis.xy), axz = _mm_set1_ps(axis.xz);
+    const __m128 ayy = _mm_set1_ps(axis.yy), ayz = _mm_set1_ps(axis.yz), azz = _mm_set1_ps(axis.zz);
+    const __m128i intOne = _mm_set1_epi32(1);
+    const __m128i intTwo = _mm_set1_epi32(2);
+
+    alignas(16) float tail[4 * 16];
+    for (int n = 0; n < count; n += 4) {
+        // AoS -> SoA：4个物体的平移和角度分别放到一个寄存器中
+        alignas(16) float tx[4], ty[4], tz[4], degrees[4];
+        for (int k = 0; k < 4; k++) {
+            const int m = std::min(n + k, count - 1);
+            const int i = indices ? indices[m] : m;
+            tx[k] = translations[i * 3];
+            ty[k] = translations[i * 3 + 1];
+            tz[k] = translations[i * 3 + 2];
+            degrees[k] = baseAngles[i] + angleOffset;
+        }
+
+        // sin/cos，步骤和sinCosDegrees()一致
+        __m128 deg = _mm_load_ps(degrees);
+        const __m128 turns = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(deg, _mm_set1_ps(1.0f / 360.0f))));
+        deg = _mm_sub_ps(deg, _mm_mul_ps(turns, _mm_set1_ps(360.0f)));
+        const __m128 x = _mm_mul_ps(deg, _mm_set1_ps(degreesToRadians(1.0f)));
+        const __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(kTwoOverPi)));
+        const __m128 q = _mm_cvtepi32_ps(quadrant);
+        const __m128 r = _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(q, _mm_set1_ps(kPiOver2Hi))), _mm_mul_ps(q, _mm_set1_ps(kPiOver2Lo)));
+        const __m128 z = _mm_mul_ps(r, r);
+
+        __m128 sinR = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(kSinC3), z), _mm_set1_ps(kSinC2));
+        sinR = _mm_add_ps(_mm_mul_ps(sinR, z), _mm_set1_ps(kSinC1));
+        sinR = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinR, z), r), r);
+        __m128 cosR = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(kCosC3), z), _mm_set1_ps(kCosC2));
+        cosR = _mm_add_ps(_mm_mul_ps(cosR, z), _mm_set1_ps(kCosC1));
+        cosR = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(_mm_mul_ps(cosR, z), z), _mm_mul_ps(_mm_set1_ps(0.5f), z)), one);
+
+        // 奇数象限交换sin/cos，符号位由象限的第2位决定
+        const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, intOne), intOne));
+        const __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, intTwo), 30));
+        const __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, intOne), intTwo), 30));
+        const __m128 s = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, cosR), _mm_andnot_ps(swap, sinR)), sinSign);
+        const __m128 c = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, sinR), _mm_andnot_ps(swap, cosR)), cosSign);
+        const __m128 t = _mm_sub_ps(one, c);
+
+        // 每个寄存器是4个物体的同一个矩阵元素
+        __m128 m0 = _mm_add_ps(_mm_mul_ps(t, axx), c);
+        __m128 m1 = _mm_add_ps(_mm_mul_ps(t, axy), _mm_mul_ps(s, az));
+        __m128 m2 = _mm_sub_ps(_mm_mul_ps(t, axz), _mm_mul_ps(s, ay));
+        __m128 m3 = zero;
+        __m128 m4 = _mm_sub_ps(_mm_mul_ps(t, axy), _mm_mul_ps(s, az));
+        __m128 m5 = _mm_add_ps(_mm_mul_ps(t, ayy), c);
+        __m128 m6 = _mm_add_ps(_mm_mul_ps(t, ayz), _mm_mul_ps(s, ax));
+        __m128 m7 = zero;
+        __m128 m8 = _mm_add_ps(_mm_mul_ps(t, axz), _mm_mul_ps(s, ay));
+        __m128 m9 = _mm_sub_ps(_mm_mul_ps(t, ayz), _mm_mul_ps(s, ax));
+        __m128 m10 = _mm_add_ps(_mm_mul_ps(t, azz), c);
+        __m128 m11 = zero;
+        __m128 m12 = _mm_load_ps(tx);
+        __m128 m13 = _mm_load_ps(ty);
+        __m128 m14 = _mm_load_ps(tz);
+        __m128 m15 = one;
+
+        // SoA -> AoS：转置后每个寄存器是一个物体的一列
+        _MM_TRANSPOSE4_PS(m0, m1, m2, m3);
+        _MM_TRANSPOSE4_PS(m4, m5, m6, m7);
+        _MM_TRANSPOSE4_PS(m8, m9, m10, m11);
+        _MM_TRANSPOSE4_PS(m12, m13, m14, m15);
+
+        float* dst = n + 4 <= count ? out + n * 16 : tail;
+        _mm_storeu_ps(dst + 0, m0);   _mm_storeu_ps(dst + 4, m4);   _mm_storeu_ps(dst + 8, m8);   _mm_storeu_ps(dst + 12, m12);
+        _mm_storeu_ps(dst + 16, m1);  _mm_storeu_ps(dst + 20, m5);  _mm_storeu_ps(dst + 24, m9);  _mm_storeu_ps(dst + 28, m13);
+        _mm_storeu_ps(dst + 32, m2);  _mm_storeu_ps(dst + 36, m6);  _mm_storeu_ps(dst + 40, m10); _mm_storeu_ps(dst + 44, m14);
+        _mm_storeu_ps(dst + 48, m3);  _mm_storeu_ps(dst + 52, m7);  _mm_storeu_ps(dst + 56, m11); _mm_storeu_ps(dst + 60, m15);
+        if (dst == tail) {
+            memcpy(out + n * 16, tail, (count - n) * 16 * sizeof(float));
+        }
+    }
+    return count;
+}
+
+// 把8个物体的某一列（4个寄存器，每个寄存器是8个物体的一个元素）转置写出
+SIMDMATH_TARGET_AVX2 inline void storeColumn8(__m256 e0, __m256 e1, __m256 e2, __m256 e3, float* dst)
+{
+    const __m256 t0 = _mm256_unpacklo_ps(e0, e1);
+    const __m256 t1 = _mm256_unpackhi_ps(e0, e1);
+    const __m256 t2 = _mm256_unpacklo_ps(e2, e3);
+    const __m256 t3 = _mm256_unpackhi_ps(e2, e3);
+    // 每个寄存器的低128位是物体k的列，高128位是物体k+4的列
+    const __m256 c0 = _mm256_shuffle_ps(t0, t2, 0x44);
+    const __m256 c1 = _mm256_shuffle_ps(t0, t2, 0xee);
+    const __m256 c2 = _mm256_shuffle_ps(t1, t3, 0x44);
+    const __m256 c3 = _mm256_shuffle_ps(t1, t3, 0xee);
+    _mm_storeu_ps(dst + 0 * 16, _mm256_castps256_ps128(c0));
+    _mm_storeu_ps(dst + 1 * 16, _mm256_castps256_ps128(c1));
+    _mm_storeu_ps(dst + 2 * 16, _mm256_castps256_ps128(c2));
+    _mm_storeu_ps(dst + 3 * 16, _mm256_castps256_ps128(c3));
+    _mm_storeu_ps(dst + 4 * 16, _mm256_extractf128_ps(c0, 1));
+    _mm_storeu_ps(dst + 5 * 16, _mm256_extractf128_ps(c1, 1));
+    _mm_storeu_ps(dst + 6 * 16, _mm256_extractf128_ps(c2, 1));
+    _mm_storeu_ps(dst + 7 * 16, _mm256_extractf128_ps(c3, 1));
+}
+
+// 8个物体同时计算，平移和角度用AVX2的gather指令直接按索引读取，最后不足8个的一组和SSE2一样补齐后计算
+SIMDMATH_TARGET_AVX2 int translateRotateAVX2(const float* translations, const float* baseAngles, float angleOffset,
+                                             const int* indices, int count, const RotationAxis& axis, float* out)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 ax = _mm256_set1_ps(axis.x), ay = _mm256_set1_ps(axis.y), az = _mm256_set1_ps(axis.z);
+    const __m256 axx = _mm256_set1_ps(axis.xx), axy = _mm256_set1_ps(axis.xy), axz = _mm256_set1_ps(axis.xz);
+    const __m256 ayy = _mm256_set1_ps(axis.yy), ayz = _mm256_set1_ps(axis.yz), azz = _mm256_set1_ps(axis.zz);
+    const __m256i intOne = _mm256_set1_epi32(1);
+    const __m256i intTwo = _mm256_set1_epi32(2);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256 offset = _mm256_set1_ps(angleOffset);
+
+    alignas(32) float tail[8 * 16];
+    for (int n = 0; n < count; n += 8) {
+        const bool full = n + 8 <= count;
+        __m256i index;
+        if (full) {
+            index = indices ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + n))
+                            : _mm256_add_epi32(_mm256_set1_epi32(n), lanes);
+        } else {
+            alignas(32) int padded[8];
+            for (int k = 0; k < 8; k++) {
+                const int m = std::min(n + k, count - 1);
+                padded[k] = indices ? indices[m] : m;
+            }
+            index = _mm256_load_si256(reinterpret_cast<const __m256i*>(padded));
+        }
+        const __m256i index3 = _mm256_add_epi32(index, _mm256_add_epi32(index, index));
+        const __m256 tx = _mm256_i32gather_ps(translations, index3, 4);
+        const __m256 ty = _mm256_i32gather_ps(translations + 1, index3, 4);
+        const __m256 tz = _mm256_i32gather_ps(translations + 2, index3, 4);
+        __m256 deg = _mm256_add_ps(_mm256_i32gather_ps(baseAngles, index, 4), offset);
+
+        const __m256 turns = _mm256_round_ps(_mm256_mul_ps(deg, _mm256_set1_ps(1.0f / 360.0f)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        deg = _mm256_fnmadd_ps(turns, _mm256_set1_ps(360.0f), deg);
+        const __m256 x = _mm256_mul_ps(deg, _mm256_set1_ps(degreesToRadians(1.0f)));
+        const __m256i quadrant = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(kTwoOverPi)));
+        const __m256 q = _mm256_cvtepi32_ps(quadrant);
+        const __m256 r = _mm256_fnmadd_ps(q, _mm256_set1_ps(kPiOver2Lo), _mm256_fnmadd_ps(q, _mm256_set1_ps(kPiOver2Hi), x));
+        const __m256 z = _mm256_mul_ps(r, r);
+
+        __m256 sinR = _mm256_fmadd_ps(_mm256_set1_ps(kSinC3), z, _mm256_set1_ps(kSinC2));
+        sinR = _mm256_fmadd_ps(sinR, z, _mm256_set1_ps(kSinC1));
+        sinR = _mm256_fmadd_ps(_mm256_mul_ps(sinR, z), r, r);
+        __m256 cosR = _mm256_fmadd_ps(_mm256_set1_ps(kCosC3), z, _mm256_set1_ps(kCosC2));
+        cosR = _mm256_fmadd_ps(cosR, z, _mm256_set1_ps(kCosC1));
+        cosR = _mm256_add_ps(_mm256_fnmadd_ps(_mm256_set1_ps(0.5f), z, _mm256_mul_ps(_mm256_mul_ps(cosR, z), z)), one);
+
+        const __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, intOne), intOne));
+        const __m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(quadrant, intTwo), 30));
+        const __m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(quadrant, intOne), intTwo), 30));
+        const __m256 s = _mm256_xor_ps(_mm256_blendv_ps(sinR, cosR, swap), sinSign);
+        const __m256 c = _mm256_xor_ps(_mm256_blendv_ps(cosR, sinR, swap), cosSign);
+        const __m256 t = _mm256_sub_ps(one, c);
+
+        float* dst = full ? out + n * 16 : tail;
+        storeColumn8(_mm256_fmadd_ps(t, axx, c),
+                     _mm256_fmadd_ps(s, az, _mm256_mul_ps(t, axy)),
+                     _mm256_fnmadd_ps(s, ay, _mm256_mul_ps(t, axz)),
+                     zero, dst + 0);
+        storeColumn8(_mm256_fnmadd_ps(s, az, _mm256_mul_ps(t, axy)),
+                     _mm256_fmadd_ps(t, ayy, c),
+                     _mm256_fmadd_ps(s, ax, _mm256_mul_ps(t, ayz)),
+                     zero, dst + 4);
+        storeColumn8(_mm256_fmadd_ps(s, ay, _mm256_mul_ps(t, axz)),
+                     _mm256_fnmadd_ps(s, ax, _mm256_mul_ps(t, ayz)),
+                     _mm256_fmadd_ps(t, azz, c),
+                     zero, dst + 8);
+        storeColumn8(tx, ty, tz, one, dst + 12);
+        if (!full) {
+            memcpy(out + n * 16, tail, (count - n) * 16 * sizeof(float));
+        }
+    }
+    return count;
+}
+
+#endif
+
+}
+
+Mat4 Mat4::identity()
+{
+    Mat4 matrix = {{1.0f, 0.0f, 0.0f, 0.0f,
+                    0.0f, 1.0f, 0.0f, 0.0f,
+                    0.0f, 0.0f, 1.0f, 0.0f,
+                    0.0f, 0.0f, 0.0f, 1.0f}};
+    return matrix;
+}
+
+void SimdMath::setBackend(Backend backend)
+{
+    const Backend best = bestBackend();
+    currentBackend() = backend > best ? best : backend;
+}
+
+SimdMath::Backend SimdMath::backend()
+{
+    return currentBackend();
+}
+
+SimdMath::Backend SimdMath::bestBackend()
+{
+#if defined(SIMDMATH_X86) && defined(__GNUC__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") ? AVX2 : SSE2;
+#elif defined(SIMDMATH_X86) && defined(_MSC_VER)
+    // cpuid: FMA(ecx bit 12)、OSXSAVE(ecx bit 27)、AVX(ecx bit 28)，操作系统保存了ymm寄存器(xcr0 bit 1/2)，AVX2(leaf 7 ebx bit 5)
+    int info[4];
+    __cpuid(info, 1);
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!(fma && osxsave && avx) || (_xgetbv(0) & 0x6) != 0x6) {
+        return SSE2;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) ? AVX2 : SSE2;
+#else
+    return Scalar;
+#endif
+}
+
+const char *SimdMath::backendName(Backend backend)
+{
+    switch (backend) {
+    case AVX2:
+        return "AVX2";
+    case SSE2:
+        return "SSE2";
+    default:
+        return "Scalar";
+    }
+}
+
+Mat4 SimdMath::multiply(const Mat4 &a, const Mat4 &b)
+{
+    Mat4 result;
+#ifdef SIMDMATH_X86
+    // 结果的第j列 = a的4列按b第j列的4个元素加权求和
+    const __m128 a0 = _mm_load_ps(a.m + 0);
+    const __m128 a1 = _mm_load_ps(a.m + 4);
+    const __m128 a2 = _mm_load_ps(a.m + 8);
+    const __m128 a3 = _mm_load_ps(a.m + 12);
+    for (int j = 0; j < 4; j++) {
+        const float* column = b.m + j * 4;
+        __m128 sum = _mm_mul_ps(a0, _mm_set1_ps(column[0]));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a1, _mm_set1_ps(column[1])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a2, _mm_set1_ps(column[2])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a3, _mm_set1_ps(column[3])));
+        _mm_store_ps(result.m + j * 4, sum);
+    }
+#else
+    for (int j = 0; j < 4; j++) {
+        for (int r = 0; r < 4; r++) {
+            result.m[j * 4 + r] = a.m[r] * b.m[j * 4] + a.m[4 + r] * b.m[j * 4 + 1]
+                    + a.m[8 + r] * b.m[j * 4 + 2] + a.m[12 + r] * b.m[j * 4 + 3];
+        }
+    }
+#endif
+    return result;
+}
+
+Vec4 SimdMath::transform(const Mat4 &matrix, const Vec4 &vector)
+{
+    Vec4 result;
+#ifdef SIMDMATH_X86
+    __m128 sum = _mm_mul_ps(_mm_load_ps(matrix.m + 0), _mm_set1_ps(vector.x));
+    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(matrix.m + 4), _mm_set1_ps(vector.y)));
+    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(matrix.m + 8), _mm_set1_ps(vector.z)));
+    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(matrix.m + 12), _mm_set1_ps(vector.w)));
+    _mm_store_ps(&result.x, sum);
+#else
+    const float* m = matrix.m;
+    result.x = m[0] * vector.x + m[4] * vector.y + m[8] * vector.z + m[12] * vector.w;
+    result.y = m[1] * vector.x + m[5] * vector.y + m[9] * vector.z + m[13] * vector.w;
+    result.z = m[2] * vector.x + m[6] * vector.y + m[10] * vector.z + m[14] * vector.w;
+    result.w = m[3] * vector.x + m[7] * vector.y + m[11] * vector.z + m[15] * vector.w;
+#endif
+    return result;
+}
+
+void SimdMath::translateRotate(const float *translations, const float *baseAngles, float angleOffset,
+                               const int *indices, int count, const RotationAxis &axis, float *out)
+{
+    int done = 0;
+#ifdef SIMDMATH_X86
+    switch (backend()) {
+    case AVX2:
+        done = translateRotateAVX2(translations, baseAngles, angleOffset, indices, count, axis, out);
+        break;
+    case SSE2:
+        done = translateRotateSSE2(translations, baseAngles, angleOffset, indices, count, axis, out);
+        break;
+    default:
+        break;
+    }
+#endif
+    // 标量实现（SIMD实现已经处理了全部物体时为空循环）
+    translateRotateScalar(translations, baseAngles, angleOffset, indices, done, count, axis, out);
+}
@@ -0,0 +1,102 @@
+#ifndef SIMDMATH_H
+#define SIMDMATH_H
+
+/*
+ * 批量计算模型矩阵的SIMD数学库
+ *
+ * RotateCamera每帧给每个立方体构造一个QMatrix4x4，再调用translate()和rotate(angle, 1.0f, 0.3f, 0.5f)，
+ * rotate()每次都要重新归一化旋转轴，并且逐个标量计算三角函数和矩阵乘法
+ * 这里把不变的部分（归一化的旋转轴及其分量乘积）用constexpr在编译期算好，
+ * 变化的部分（每个物体的平移和角度）按批处理：一次计算4个（SSE2）或8个（AVX2）物体的sin/cos和矩阵元素，
+ * 再转置写出为连续的列主序矩阵，可以直接作为实例缓冲上传或传给glUniformMatrix4fv
+ *
+ * AVX2在运行时检测cpu是否支持，非x86平台使用标量实现
+ * 这里只依赖标准库，矩阵为列主序的16个float，和QMatrix4x4::constData()/OpenGL的布局一致
+*/
+
+// 编译期开平方（牛顿迭代，C++11的constexpr函数只能有一条return语句，所以用递归）
+constexpr float constexprSqrtIteration(float x, float guess, int iterations)
+{
+    return iterations == 0 ? guess : constexprSqrtIteration(x, 0.5f * (guess + x / guess), iterations - 1);
+}
+
+constexpr float constexprSqrt(float x)
+{
+    return x <= 0.0f ? 0.0f : constexprSqrtIteration(x, x > 1.0f ? x : 1.0f, 24);
+}
+
+constexpr float degreesToRadians(float degrees)
+{
+    return degrees * 0.0174532925199432957692f;
+}
+
+struct alignas(16) Vec4
+{
+    float x;
+    float y;
+    float z;
+    float w;
+};
+
+// 列主序4x4矩阵，第c列第r行为m[c * 4 + r]
+struct alignas(16) Mat4
+{
+    float m[16];
+
+    static Mat4 identity();
+
+    const float* data() const { return m; }
+    float* data() { return m; }
+};
+
+// 归一化的旋转轴，以及旋转矩阵中用到的分量乘积，都可以在编译期计算
+// 例如：constexpr RotationAxis axis(1.0f, 0.3f, 0.5f);
+struct RotationAxis
+{
+    float x, y, z;
+    float xx, xy, xz, yy, yz, zz;
+
+    constexpr RotationAxis(float ax, float ay, float az)
+        : RotationAxis(ax, ay, az, constexprSqrt(ax * ax + ay * ay + az * az))
+    {
+    }
+
+private:
+    constexpr RotationAxis(float ax, float ay, float az, float length)
+        : x(ax / length), y(ay / length), z(az / length)
+        , xx((ax / length) * (ax / length)), xy((ax / length) * (ay / length)), xz((ax / length) * (az / length))
+        , yy((ay / length) * (ay / length)), yz((ay / length) * (az / length))
+        , zz((az / length) * (az / length))
+    {
+    }
+};
+
+class SimdMath
+{
+public:
+    enum Backend {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    // 默认为当前cpu支持的最快实现，设置为不支持的实现时退回到支持的最快实现（全局设置，主要用于benchmark对比）
+    static void setBackend(Backend backend);
+    static Backend backend();
+    static Backend bestBackend();
+    static const char* backendName(Backend backend);
+
+    static Mat4 multiply(const Mat4& a, const Mat4& b);
+    static Vec4 transform(const Mat4& matrix, const Vec4& vector);
+
+    // 批量计算 平移*旋转 的模型矩阵，等价于对每个物体：
+    //     QMatrix4x4 model; model.translate(t); model.rotate(angle, axis);
+    // translations：每个物体3个float(x, y, z)
+    // baseAngles：每个物体的旋转角度（角度制），实际角度为baseAngles[i] + angleOffset
+    // indices：为空时计算前count个物体，否则计算indices中的count个物体（例如视锥体剔除后可见的物体）
+    // out：16 * count个float，第n个矩阵对应第n个物体（或indices[n]），不要求对齐
+    static void translateRotate(const float* translations, const float* baseAngles, float angleOffset,
+                                const int* indices, int count, const RotationAxis& axis, float* out);
+};
+
+#endif // SIMDMATH_H
@@ -0,0 +1,8 @@
+# 批量模型矩阵计算：SSE2/AVX2（运行时检测）/标量实现，只依赖标准库
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/simdmath.h
+
+SOURCES += \
+    $$PWD/simdmath.cpp
@@ -0,0 +1,187 @@
+#include "texturecache.h"
+#include "textureloader.h"
+
+#include <vector>
+#include <algorithm>
+
+namespace {
+
+// 纹理格式每个像素占用的字节数，未列出的格式按4字节估算
+int bytesPerTexel(QOpenGLTexture::TextureFormat format)
+{
+    switch (format) {
+    case QOpenGLTexture::R8_UNorm:
+        return 1;
+    case QOpenGLTexture::RG8_UNorm:
+    case QOpenGLTexture::R16F:
+        return 2;
+    case QOpenGLTexture::RG16F:
+    case QOpenGLTexture::R32F:
+        return 4;
+    case QOpenGLTexture::RGBA16F:
+    case QOpenGLTexture::RG32F:
+        return 8;
+    case QOpenGLTexture::RGBA32F:
+        return 16;
+    default:
+        // RGB8一般也按4字节对齐存储
+        return 4;
+    }
+}
+
+}
+
+QString TextureCache::Stats::summary() const
+{
+    return QString("textures %1/%2 resident %3/%4 MB hits %5 misses %6 evictions %7")
+            .arg(resident).arg(textures)
+            .arg(residentBytes / (1024.0 * 1024.0), 0, 'f', 1)
+            .arg(budgetBytes / (1024.0 * 1024.0), 0, 'f', 1)
+            .arg(hits).arg(misses).arg(evictions);
+}
+
+TextureCache::TextureCache(TextureLoader &loader)
+    : m_loader(loader)
+{
+    m_stats.budgetBytes = qint64(256) * 1024 * 1024;
+}
+
+TextureCache::~TextureCache()
+{
+    qDeleteAll(m_entries);
+}
+
+void TextureCache::setBudget(qint64 bytes)
+{
+    m_stats.budgetBytes = qMax<qint64>(bytes, 0);
+}
+
+qint64 TextureCache::budget() const
+{
+    return m_stats.budgetBytes;
+}
+
+void TextureCache::setWrapMode(QOpenGLTexture::WrapMode mode)
+{
+    m_wrapMode = mode;
+}
+
+void TextureCache::setFilters(QOpenGLTexture::Filter minificationFilter, QOpenGLTexture::Filter magnificationFilter)
+{
+    m_minificationFilter = minificationFilter;
+    m_magnificationFilter = magnificationFilter;
+}
+
+void TextureCache::beginFrame()
+{
+    m_frame++;
+}
+
+QOpenGLTexture &TextureCache::texture(const QString &path)
+{
+    Entry*& entry = m_entries[path];
+    if (!entry) {
+        entry = new Entry;
+    }
+    entry->lastUse = ++m_useCounter;
+    entry->lastFrame = m_frame;
+
+    if (entry->resident) {
+        m_stats.hits++;
+    } else {
+        m_stats.misses++;
+        load(path, *entry);
+    }
+    return entry->texture;
+}
+
+void TextureCache::endFrame()
+{
+    updateResidentBytes();
+    if (m_stats.residentBytes <= m_stats.budgetBytes) {
+        return;
+    }
+
+    // 超过预算：按最近使用的先后排序，从最久没有使用的开始释放，本帧可见的和正在加载的不释放
+    std::vector<Entry*> candidates;
+    for (Entry* entry : m_entries) {
+        if (entry->resident && entry->lastFrame != m_frame && !m_loader.isLoading(entry->texture)) {
+            candidates.push_back(entry);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Entry* a, const Entry* b) {
+        return a->lastUse < b->lastUse;
+    });
+    for (Entry* entry : candidates) {
+        if (m_stats.residentBytes <= m_stats.budgetBytes) {
+            break;
+        }
+        m_stats.residentBytes -= estimateBytes(entry->texture);
+        evict(*entry);
+    }
+    m_stats.resident = 0;
+    for (const Entry* entry : m_entries) {
+        m_stats.resident += entry->resident ? 1 : 0;
+    }
+}
+
+void TextureCache::clear()
+{
+    // 正在加载的纹理对象还会被TextureLoader访问，这里只释放显存，对象在析构时删除
+    for (Entry* entry : m_entries) {
+        entry->texture.destroy();
+        entry->resident = false;
+    }
+    m_stats.residentBytes = 0;
+    m_stats.resident = 0;
+}
+
+TextureCache::Stats TextureCache::stats() const
+{
+    Stats stats = m_stats;
+    stats.textures = m_entries.size();
+    return stats;
+}
+
+qint64 TextureCache::estimateBytes(const QOpenGLTexture &texture)
+{
+    if (!texture.isStorageAllocated()) {
+        return 0;
+    }
+    qint64 bytes = 0;
+    const qint64 texel = bytesPerTexel(texture.format());
+    for (int level = 0; level < qMax(texture.mipLevels(), 1); level++) {
+        bytes += qMax(texture.width() >> level, 1) * qint64(qMax(texture.height() >> level, 1)) * texel;
+    }
+    return bytes;
+}
+
+void TextureCache::load(const QString &path, TextureCache::Entry &entry)
+{
+    // destroy()之后参数恢复为默认值，每次加载前重新设置
+    entry.texture.setWrapMode(QOpenGLTexture::DirectionS, m_wrapMode);
+    entry.texture.setWrapMode(QOpenGLTexture::DirectionT, m_wrapMode);
+    entry.texture.setMinificationFilter(m_minificationFilter);
+    entry.texture.setMagnificationFilter(m_magnificationFilter);
+    m_loader.load(entry.texture, path);
+    entry.resident = true;
+}
+
+void TextureCache::evict(TextureCache::Entry &entry)
+{
+    entry.texture.destroy();
+    entry.resident = false;
+    m_stats.evictions++;
+}
+
+void TextureCache::updateResidentBytes()
+{
+    m_stats.residentBytes = 0;
+    m_stats.resident = 0;
+    for (const Entry* entry : m_entries) {
+        if (entry->resident) {
+            m_stats.residentBytes += estimateBytes(entry->texture);
+            m_stats.resident++;
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef TEXTURECACHE_H
+#define TEXTURECACHE_H
+
+#include <QHash>
+#include <QString>
+#include <QOpenGLTexture>
+
+class TextureLoader;
+
+/*
+ * 纹理缓存：按图片路径管理纹理，估算每个纹理占用的显存，超过预算时按最近最少使用（LRU）的顺序释放纹理的显存，
+ * 之后再次用到时从图片重新加载（通过TextureLoader异步解码，加载完成前是占位纹理）
+ *
+ * 使用方法：
+ * 1. paintGL开始时调用beginFrame()
+ * 2. 绘制时通过texture(path)取得纹理，本帧取过的纹理即为本帧可见的纹理
+ * 3. paintGL结束时调用endFrame()，超过预算时先释放本帧没有用到的纹理，
+ *    本帧可见的纹理不会被释放（全部可见的纹理超过预算时允许超出预算，在统计中可以看到）
+ * 4. 析构前在context current时调用clear()释放所有纹理
+ *
+ * 显存只是估算：宽x高x每像素字节数，加上所有mip层级，不包括驱动的对齐和额外开销
+*/
+class TextureCache
+{
+public:
+    struct Stats
+    {
+        qint64 budgetBytes = 0;
+        qint64 residentBytes = 0;
+        int textures = 0;
+        int resident = 0;
+        // texture(path)时已经在显存中（或者正在加载）为命中，需要重新加载为未命中
+        quint64 hits = 0;
+        quint64 misses = 0;
+        quint64 evictions = 0;
+
+        // 例如 "textures 2/2 resident 1.3/64.0 MB hits 120 misses 2 evictions 0"
+        QString summary() const;
+    };
+
+    explicit TextureCache(TextureLoader& loader);
+    ~TextureCache();
+
+    // 显存预算，默认256MB
+    void setBudget(qint64 bytes);
+    qint64 budget() const;
+
+    // 之后加载的纹理使用的wrap/filter参数，默认ClampToEdge/Linear
+    void setWrapMode(QOpenGLTexture::WrapMode mode);
+    void setFilters(QOpenGLTexture::Filter minificationFilter, QOpenGLTexture::Filter magnificationFilter);
+
+    void beginFrame();
+    // 返回的引用在clear()之前一直有效，需要在context current时调用
+    QOpenGLTexture& texture(const QString& path);
+    void endFrame();
+
+    void clear();
+
+    Stats stats() const;
+
+    // 纹理当前storage占用的显存估算值，没有分配storage时为0
+    static qint64 estimateBytes(const QOpenGLTexture& texture);
+
+private:
+    struct Entry
+    {
+        QOpenGLTexture texture {QOpenGLTexture::Target2D};
+        // 最近一次使用的序号，越小越久没有使用
+        quint64 lastUse = 0;
+        quint64 lastFrame = 0;
+        bool resident = false;
+    };
+
+    void load(const QString& path, Entry& entry);
+    void evict(Entry& entry);
+    void updateResidentBytes();
+
+private:
+    TextureLoader& m_loader;
+    QHash<QString, Entry*> m_entries;
+
+    QOpenGLTexture::WrapMode m_wrapMode = QOpenGLTexture::ClampToEdge;
+    QOpenGLTexture::Filter m_minificationFilter = QOpenGLTexture::Linear;
+    QOpenGLTexture::Filter m_magnificationFilter = QOpenGLTexture::Linear;
+
+    quint64 m_frame = 0;
+    quint64 m_useCounter = 0;
+    Stats m_stats;
+};
+
+#endif // TEXTURECACHE_H
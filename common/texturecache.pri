@@ -0,0 +1,8 @@
+# 纹理缓存：估算显存占用，超过预算时按LRU释放本帧不可见的纹理，再次使用时通过TextureLoader重新加载
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/texturecache.h
+
+SOURCES += \
+    $$PWD/texturecache.cpp
@@ -0,0 +1,271 @@
+#include "textureloader.h"
+#include "trace.h"
+
+#include <functional>
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QImageReader>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QOpenGLPixelTransferOptions>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+// 静态初始化时开始计时，近似为进程启动的时间
+struct StartupClock
+{
+    StartupClock() { timer.start(); }
+    QElapsedTimer timer;
+};
+
+StartupClock startupClock;
+
+// 进程的峰值内存（Linux上即/proc/self/status中的VmHWM），单位KB，不支持时返回-1
+qint64 peakRssKb()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return -1;
+    }
+    return qint64(counters.PeakWorkingSetSize / 1024);
+#elif defined(Q_OS_UNIX)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+#ifdef Q_OS_MACOS
+    // macOS上ru_maxrss的单位是字节
+    return qint64(usage.ru_maxrss / 1024);
+#else
+    return qint64(usage.ru_maxrss);
+#endif
+#else
+    return -1;
+#endif
+}
+
+class DecodeTask : public QRunnable
+{
+public:
+    explicit DecodeTask(const std::function<void()>& function) : m_function(function) {}
+    virtual void run() override { m_function(); }
+
+private:
+    std::function<void()> m_function;
+};
+
+}
+
+TextureLoader::TextureLoader(QObject *parent)
+    : QObject(parent)
+{
+    m_synchronous = qEnvironmentVariableIsSet("TEXTURE_LOADER_SYNC");
+
+    const QString packPath = QString::fromLocal8Bit(qgetenv("TEXTURE_PACK"));
+    if (!packPath.isEmpty() && m_pack.open(packPath)) {
+        qDebug() << "TextureLoader: texture pack" << packPath << m_pack.names();
+    }
+}
+
+TextureLoader::~TextureLoader()
+{
+    m_pool.waitForDone();
+}
+
+void TextureLoader::setPlaceholderColor(const QColor &color)
+{
+    m_placeholderColor = color;
+}
+
+void TextureLoader::load(QOpenGLTexture &texture, const QString &path)
+{
+    m_stats.requested++;
+    m_stats.allResidentMs = -1;
+
+    if (m_pack.isOpen()) {
+        // 纹理包中的数据可以直接上传，不需要放到线程池中
+        QElapsedTimer timer;
+        timer.start();
+        if (m_pack.upload(texture, QFileInfo(path).fileName())) {
+            m_stats.uploadMsTotal += timer.elapsed();
+            m_stats.resident++;
+            m_stats.fromPack++;
+            if (allSettled()) {
+                if (allResident()) {
+                    m_stats.allResidentMs = startupClock.timer.elapsed();
+                }
+                logIfDone();
+            }
+            return;
+        }
+    }
+
+    if (m_synchronous) {
+        // 对比用：和原来一样在调用线程中解码并上传
+        decode(&texture, path);
+        uploadReady();
+        return;
+    }
+
+    // 解码完成前先使用1x1的占位纹理，纹理的wrap/filter参数保持不变
+    QImage placeholder(1, 1, QImage::Format_RGBA8888);
+    placeholder.fill(m_placeholderColor);
+    texture.setData(placeholder);
+
+    QOpenGLTexture* target = &texture;
+    m_loading.insert(target);
+    m_pool.start(new DecodeTask([this, target, path]() {
+        decode(target, path);
+    }));
+}
+
+int TextureLoader::uploadReady()
+{
+    QVector<Decoded> ready;
+    {
+        QMutexLocker locker(&m_mutex);
+        ready.swap(m_decoded);
+    }
+
+    for (const Decoded& decoded : ready) {
+        upload(decoded);
+    }
+    if (!ready.isEmpty() && allSettled()) {
+        if (allResident()) {
+            m_stats.allResidentMs = startupClock.timer.elapsed();
+        }
+        logIfDone();
+    }
+    return ready.size();
+}
+
+void TextureLoader::frameDone()
+{
+    if (m_stats.firstFrameMs < 0) {
+        m_stats.firstFrameMs = startupClock.timer.elapsed();
+        logIfDone();
+    }
+}
+
+bool TextureLoader::allResident() const
+{
+    return m_stats.resident == m_stats.requested;
+}
+
+bool TextureLoader::allSettled() const
+{
+    return m_stats.resident + m_stats.failed == m_stats.requested;
+}
+
+bool TextureLoader::isLoading(const QOpenGLTexture &texture) const
+{
+    return m_loading.contains(&texture);
+}
+
+TextureLoader::Stats TextureLoader::stats() const
+{
+    return m_stats;
+}
+
+void TextureLoader::decode(QOpenGLTexture *texture, const QString &path)
+{
+    Trace::setThreadName("texture decode pool");
+    TRACE_SCOPE("texture decode");
+    QElapsedTimer timer;
+    timer.start();
+
+    Decoded decoded;
+    decoded.texture = texture;
+    decoded.path = path;
+    QImageReader reader(path);
+    if (!reader.read(&decoded.image)) {
+        qDebug() << "TextureLoader: can't decode" << path << reader.errorString();
+    }
+    // 格式转换也在工作线程中完成，上传时不再转换
+    decoded.image = decoded.image.convertToFormat(QImage::Format_RGBA8888);
+    decoded.decodeMs = timer.elapsed();
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_decoded.append(decoded);
+    }
+    emit textureDecoded();
+}
+
+void TextureLoader::upload(const Decoded &decoded)
+{
+    TRACE_SCOPE("texture upload");
+    QElapsedTimer timer;
+    timer.start();
+
+    QOpenGLTexture& texture = *decoded.texture;
+    m_loading.remove(decoded.texture);
+    m_stats.decodeMsTotal += decoded.decodeMs;
+    if (decoded.image.isNull()) {
+        // 解码失败时保留占位纹理，不算作resident
+        m_stats.failed++;
+        return;
+    }
+    m_stats.resident++;
+
+    // 占位纹理的storage是1x1，已经分配的storage不能修改大小，需要重新创建纹理，
+    // destroy()会把参数恢复为默认值，这里先保存initializeGL中设置的参数
+    const QOpenGLTexture::WrapMode wrapS = texture.wrapMode(QOpenGLTexture::DirectionS);
+    const QOpenGLTexture::WrapMode wrapT = texture.wrapMode(QOpenGLTexture::DirectionT);
+    const QOpenGLTexture::Filter minFilter = texture.minificationFilter();
+    const QOpenGLTexture::Filter magFilter = texture.magnificationFilter();
+    const bool created = texture.isCreated();
+    if (created) {
+        texture.destroy();
+    }
+    texture.create();
+
+    // RGBA8存储；只有缩小过滤使用mipmap时才分配并生成完整的mipmap，
+    // 否则只分配level 0（示例中都是Linear，多出来的mipmap只会占用约1/3的显存）
+    const bool mipmapped = minFilter != QOpenGLTexture::Nearest && minFilter != QOpenGLTexture::Linear;
+    texture.setFormat(QOpenGLTexture::RGBA8_UNorm);
+    texture.setSize(decoded.image.width(), decoded.image.height());
+    texture.setMipLevels(mipmapped ? texture.maximumMipLevels() : 1);
+    texture.allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8);
+    QOpenGLPixelTransferOptions uploadOptions;
+    uploadOptions.setAlignment(1);
+    texture.setData(0, QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, decoded.image.constBits(), &uploadOptions);
+    if (mipmapped) {
+        texture.generateMipMaps();
+    }
+
+    if (created) {
+        texture.setWrapMode(QOpenGLTexture::DirectionS, wrapS);
+        texture.setWrapMode(QOpenGLTexture::DirectionT, wrapT);
+        texture.setMinificationFilter(minFilter);
+        texture.setMagnificationFilter(magFilter);
+    }
+
+    m_stats.uploadMsTotal += timer.elapsed();
+}
+
+void TextureLoader::logIfDone()
+{
+    if (m_logged || m_stats.firstFrameMs < 0 || !allSettled()) {
+        return;
+    }
+    m_logged = true;
+    qDebug() << "textures:" << m_stats.requested << (m_synchronous ? "(sync)" : "(async)")
+             << "from pack:" << m_stats.fromPack
+             << "first frame:" << m_stats.firstFrameMs << "ms"
+             << "all resident:" << m_stats.allResidentMs << "ms"
+             << "failed:" << m_stats.failed
+             << "decode total:" << m_stats.decodeMsTotal << "ms"
+             << "upload total:" << m_stats.uploadMsTotal << "ms"
+             << "peak rss:" << peakRssKb() << "KB";
+}
@@ -0,0 +1,114 @@
+#ifndef TEXTURELOADER_H
+#define TEXTURELOADER_H
+
+#include <QColor>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include <QThreadPool>
+#include <QOpenGLTexture>
+
+#include "texturepack.h"
+
+/*
+ * 纹理异步加载：图片在线程池中并行解码并转换为opengl可以直接上传的RGBA8888格式，
+ * 解码完成前纹理是一个1x1的占位纹理，第一帧不用等待图片解码
+ *
+ * 原来的QOpenGLTexture::setData(QImage(":/wall.jpg"))在gui线程中依次完成解码、格式转换和上传，
+ * 这里gui线程只剩下上传（glTexSubImage2D）
+ *
+ * 使用方法：
+ * 1. initializeGL中像原来一样设置纹理的wrap/filter，然后load(texture, path)代替setData
+ * 2. paintGL开始时（绑定纹理之前）调用uploadReady()，把已经解码好的图片上传到纹理
+ * 3. paintGL结束时调用frameDone()，用来统计第一帧的时间
+ * 4. 图片解码完成时发出textureDecoded()，可以连接到QWidget::update触发重绘
+ *
+ * 第一帧的时间和所有纹理上传完成的时间（都从进程启动开始计算）会输出到日志，
+ * 设置环境变量TEXTURE_LOADER_SYNC=1时在load()中同步解码和上传，用于对比
+ *
+ * 设置环境变量TEXTURE_PACK=xxx.tpk时先在纹理包中按文件名查找，找到时在load()中直接从映射的内存上传
+ * （已经是RGBA8并且带有mipmap，没有解码），找不到时仍然异步解码；日志中同时输出峰值内存，
+ * 用来和qrc中的jpg/png对比启动时间和内存
+ *
+ * uploadReady()/frameDone()需要在纹理所属的context current时调用
+*/
+class TextureLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Stats
+    {
+        int requested = 0;
+        int resident = 0;
+        // 解码失败、仍然显示占位纹理的数量，不算在resident中
+        int failed = 0;
+        // 从进程启动开始计算，还没有发生时为-1（有纹理解码失败时allResidentMs一直为-1）
+        qint64 firstFrameMs = -1;
+        qint64 allResidentMs = -1;
+        // 所有图片在工作线程中解码+格式转换的耗时之和，以及gui线程中上传的耗时之和
+        qint64 decodeMsTotal = 0;
+        qint64 uploadMsTotal = 0;
+        // 从纹理包中加载的数量
+        int fromPack = 0;
+    };
+
+    explicit TextureLoader(QObject *parent = nullptr);
+    ~TextureLoader();
+
+    // 占位纹理的颜色
+    void setPlaceholderColor(const QColor& color);
+
+    // texture先设置为占位纹理，图片在线程池中解码，texture需要在uploadReady()之前一直有效
+    void load(QOpenGLTexture& texture, const QString& path);
+    // 上传已经解码好的图片，返回本次上传的数量
+    int uploadReady();
+    void frameDone();
+
+    bool allResident() const;
+    // 所有纹理都已经上传或者解码失败
+    bool allSettled() const;
+    // texture已经load()，图片还在解码或者还没有上传
+    bool isLoading(const QOpenGLTexture& texture) const;
+    Stats stats() const;
+
+signals:
+    // 工作线程中发出
+    void textureDecoded();
+
+private:
+    struct Decoded
+    {
+        QOpenGLTexture* texture = nullptr;
+        QString path;
+        QImage image;
+        qint64 decodeMs = 0;
+    };
+
+    void decode(QOpenGLTexture* texture, const QString& path);
+    void upload(const Decoded& decoded);
+    void logIfDone();
+
+private:
+    QColor m_placeholderColor {128, 128, 128};
+    bool m_synchronous = false;
+    TexturePack m_pack;
+
+    mutable QMutex m_mutex;
+    // 已经解码还没有上传的图片，由m_mutex保护
+    QVector<Decoded> m_decoded;
+
+    // 异步加载中的纹理，只在gui线程中访问
+    QSet<const QOpenGLTexture*> m_loading;
+
+    Stats m_stats;
+    bool m_logged = false;
+
+    // 最后声明，析构时最先析构，等待所有解码任务结束
+    QThreadPool m_pool;
+};
+
+#endif // TEXTURELOADER_H
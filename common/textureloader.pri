@@ -0,0 +1,15 @@
+# 纹理异步加载：线程池中并行解码为RGBA8888，解码完成前使用占位纹理，统计第一帧和所有纹理上传完成的时间
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/textureloader.h
+
+SOURCES += \
+    $$PWD/textureloader.cpp
+
+# 设置了TEXTURE_PACK时从纹理包中加载
+include($$PWD/texturepack.pri)
+include($$PWD/trace.pri)
+
+# 峰值内存（PeakWorkingSetSize）
+win32: LIBS += -lpsapi
@@ -0,0 +1,143 @@
+#include "texturepack.h"
+
+#include <cstring>
+
+#include <QDebug>
+#include <QOpenGLPixelTransferOptions>
+
+TexturePack::TexturePack()
+{
+}
+
+TexturePack::~TexturePack()
+{
+    close();
+}
+
+bool TexturePack::open(const QString &path)
+{
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qDebug() << "TexturePack: can't open" << path << m_file.errorString();
+        return false;
+    }
+    m_size = m_file.size();
+    // 只映射不读取，纹理数据在上传时才按页读入
+    m_data = m_file.map(0, m_size);
+    if (!m_data) {
+        qDebug() << "TexturePack: can't map" << path << m_file.errorString();
+        close();
+        return false;
+    }
+
+    const quint64 size = quint64(m_size);
+    const Header* header = reinterpret_cast<const Header*>(m_data);
+    if (size < sizeof(Header) || memcmp(header->magic, magic(), 4) != 0 || header->version != Version
+            || header->textureCount > (size - sizeof(Header)) / sizeof(Entry)) {
+        qDebug() << "TexturePack: invalid header" << path;
+        close();
+        return false;
+    }
+
+    // 检查索引，保证上传时不会越界访问
+    const Entry* entries = reinterpret_cast<const Entry*>(m_data + sizeof(Header));
+    for (quint32 i = 0; i < header->textureCount; i++) {
+        const Entry& entry = entries[i];
+        bool valid = entry.format == RGBA8 && entry.mipCount >= 1 && entry.mipCount <= MaxMipLevels
+                && entry.name[NameSize - 1] == '\0';
+        for (quint32 level = 0; valid && level < entry.mipCount; level++) {
+            const quint64 width = qMax<quint64>(entry.width >> level, 1);
+            const quint64 height = qMax<quint64>(entry.height >> level, 1);
+            valid = entry.mipSize[level] == width * height * 4
+                    && entry.mipOffset[level] <= size && entry.mipSize[level] <= size - entry.mipOffset[level];
+        }
+        if (!valid) {
+            qDebug() << "TexturePack: invalid entry" << i << path;
+            close();
+            return false;
+        }
+        m_entries.insert(QString::fromUtf8(entry.name), &entry);
+    }
+    return true;
+}
+
+void TexturePack::close()
+{
+    m_entries.clear();
+    if (m_data) {
+        m_file.unmap(m_data);
+        m_data = nullptr;
+    }
+    m_size = 0;
+    m_file.close();
+}
+
+bool TexturePack::isOpen() const
+{
+    return m_data != nullptr;
+}
+
+QStringList TexturePack::names() const
+{
+    return m_entries.keys();
+}
+
+bool TexturePack::contains(const QString &name) const
+{
+    return m_entries.contains(name);
+}
+
+qint64 TexturePack::size() const
+{
+    return m_size;
+}
+
+bool TexturePack::upload(QOpenGLTexture &texture, const QString &name) const
+{
+    const Entry* entry = m_entries.value(name);
+    if (!entry) {
+        return false;
+    }
+
+    // 已经分配的storage不能修改大小和格式，需要重新创建纹理，
+    // destroy()会把参数恢复为默认值，这里先保存initializeGL中设置的参数
+    const bool recreate = texture.isStorageAllocated();
+    const QOpenGLTexture::WrapMode wrapS = texture.wrapMode(QOpenGLTexture::DirectionS);
+    const QOpenGLTexture::WrapMode wrapT = texture.wrapMode(QOpenGLTexture::DirectionT);
+    const QOpenGLTexture::Filter minFilter = texture.minificationFilter();
+    const QOpenGLTexture::Filter magFilter = texture.magnificationFilter();
+    if (recreate) {
+        texture.destroy();
+    }
+    if (!texture.isCreated()) {
+        texture.create();
+    }
+
+    texture.setFormat(QOpenGLTexture::RGBA8_UNorm);
+    texture.setSize(int(entry->width), int(entry->height));
+    texture.setMipLevels(int(entry->mipCount));
+    texture.allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8);
+
+    // 直接从映射的内存上传，行之间没有填充
+    QOpenGLPixelTransferOptions uploadOptions;
+    uploadOptions.setAlignment(1);
+    for (quint32 level = 0; level < entry->mipCount; level++) {
+        texture.setData(int(level), QOpenGLTexture::RGBA, QOpenGLTexture::UInt8,
+                        m_data + entry->mipOffset[level], &uploadOptions);
+    }
+
+    if (recreate) {
+        texture.setWrapMode(QOpenGLTexture::DirectionS, wrapS);
+        texture.setWrapMode(QOpenGLTexture::DirectionT, wrapT);
+        texture.setMinificationFilter(minFilter);
+        texture.setMagnificationFilter(magFilter);
+    }
+    return true;
+}
+
+const char *TexturePack::magic()
+{
+    return "TPK1";
+}
@@ -0,0 +1,82 @@
+#ifndef TEXTUREPACK_H
+#define TEXTUREPACK_H
+
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QOpenGLTexture>
+
+/*
+ * 预先烘焙的纹理包：TexturePacker离线把图片解码为RGBA8，生成完整的mipmap链，写到一个文件中，
+ * 运行时把文件映射到内存（QFile::map），直接把映射的纹理数据交给glTexSubImage2D上传，
+ * 没有解码、格式转换、mipmap生成，也没有中间的QImage拷贝
+ *
+ * 文件布局（小端，所有偏移都从文件开头计算）：
+ *   Header
+ *   Entry[textureCount]      索引，紧跟在Header后面
+ *   纹理数据                  每个mip层级的数据按16字节对齐，行之间没有填充
+ *
+ * 纹理数据的行顺序和QImage一样（第一行是图片的最上面一行），和QOpenGLTexture::setData(QImage)的结果一致
+*/
+class TexturePack
+{
+public:
+    enum {
+        Version = 1,
+        MaxMipLevels = 16,
+        NameSize = 64,
+        DataAlignment = 16
+    };
+
+    // 纹理数据的格式，目前只有RGBA8，以后可以加上压缩格式
+    enum Format : quint32 {
+        RGBA8 = 1
+    };
+
+    struct Header
+    {
+        char magic[4];              // "TPK1"
+        quint32 version;
+        quint32 textureCount;
+        quint32 reserved;
+    };
+
+    struct Entry
+    {
+        char name[NameSize];        // 图片的文件名（不含路径），以'\0'结尾
+        quint32 width;
+        quint32 height;
+        quint32 format;
+        quint32 mipCount;
+        quint64 mipOffset[MaxMipLevels];
+        quint64 mipSize[MaxMipLevels];
+    };
+
+    TexturePack();
+    ~TexturePack();
+
+    // 映射纹理包并检查索引，失败时返回false
+    bool open(const QString& path);
+    void close();
+    bool isOpen() const;
+
+    QStringList names() const;
+    bool contains(const QString& name) const;
+    // 映射的文件大小
+    qint64 size() const;
+
+    // 把name对应的纹理（包括所有mip层级）上传到texture，texture的wrap/filter参数保持不变
+    // 需要在纹理所属的context current时调用
+    bool upload(QOpenGLTexture& texture, const QString& name) const;
+
+    static const char* magic();
+
+private:
+    QFile m_file;
+    uchar* m_data = nullptr;
+    qint64 m_size = 0;
+    QHash<QString, const Entry*> m_entries;
+};
+
+#endif // TEXTUREPACK_H
@@ -0,0 +1,8 @@
+# 预先烘焙的纹理包：内存映射后直接上传RGBA8数据和mipmap链，由TexturePacker生成
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/texturepack.h
+
+SOURCES += \
+    $$PWD/texturepack.cpp
@@ -0,0 +1,243 @@
+#include "trace.h"
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+// 每块16K个事件（512KB），每个线程最多64块
+const uint32_t kChunkEvents = 16384;
+const uint32_t kMaxChunks = 64;
+// registerTrack()最多的轨道数
+const uint32_t kMaxTracks = 16;
+
+struct Event
+{
+    const char* name;
+    const char* category;
+    uint64_t startNs;
+    uint64_t endNs;
+};
+
+// 一个线程（或者一个轨道）的事件，单生产者：只有所属的线程写入，写文件的线程只读已经提交的部分
+struct Buffer
+{
+    uint32_t tid = 0;
+    std::atomic<const char*> name {nullptr};
+    std::atomic<Event*> chunks[kMaxChunks] = {};
+    std::atomic<uint32_t> count {0};
+    std::atomic<uint64_t> dropped {0};
+
+    ~Buffer()
+    {
+        for (std::atomic<Event*>& chunk : chunks) {
+            delete[] chunk.load();
+        }
+    }
+
+    void append(const Event& event)
+    {
+        const uint32_t index = count.load(std::memory_order_relaxed);
+        const uint32_t chunkIndex = index / kChunkEvents;
+        if (chunkIndex >= kMaxChunks) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        Event* chunk = chunks[chunkIndex].load(std::memory_order_relaxed);
+        if (!chunk) {
+            chunk = new Event[kChunkEvents];
+            chunks[chunkIndex].store(chunk, std::memory_order_release);
+        }
+        chunk[index % kChunkEvents] = event;
+        count.store(index + 1, std::memory_order_release);
+    }
+};
+
+void writeEscaped(FILE* file, const char* text)
+{
+    for (const char* p = text; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            fputc('\\', file);
+            fputc(*p, file);
+        } else if (static_cast<unsigned char>(*p) < 0x20) {
+            fprintf(file, "\\u%04x", *p);
+        } else {
+            fputc(*p, file);
+        }
+    }
+}
+
+class Tracer
+{
+public:
+    Tracer()
+    {
+        const char* path = std::getenv("GL_TRACE");
+        if (path) {
+            m_path = path;
+        }
+    }
+
+    ~Tracer()
+    {
+        if (Trace::enabled) {
+            write();
+        }
+        for (Buffer* buffer : m_buffers) {
+            delete buffer;
+        }
+    }
+
+    Buffer* addBuffer(const char* name)
+    {
+        Buffer* buffer = new Buffer;
+        buffer->name.store(name, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> locker(m_mutex);
+        buffer->tid = uint32_t(m_buffers.size()) + 1;
+        m_buffers.push_back(buffer);
+        return buffer;
+    }
+
+    uint32_t registerTrack(const char* name)
+    {
+        Buffer* buffer = addBuffer(name);
+        const uint32_t track = m_trackCount.fetch_add(1) + 1;
+        if (track > kMaxTracks) {
+            return 0;
+        }
+        m_tracks[track - 1].store(buffer, std::memory_order_release);
+        return track;
+    }
+
+    Buffer* track(uint32_t track)
+    {
+        return track <= kMaxTracks ? m_tracks[track - 1].load(std::memory_order_acquire) : nullptr;
+    }
+
+    // Chrome trace的json格式：线程名为"M"事件，每个事件为"X"（complete）事件，时间单位us
+    void write()
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        FILE* file = fopen(m_path.c_str(), "w");
+        if (!file) {
+            fprintf(stderr, "trace: can't write %s\n", m_path.c_str());
+            return;
+        }
+        fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        bool first = true;
+        uint64_t events = 0;
+        uint64_t dropped = 0;
+        for (Buffer* buffer : m_buffers) {
+            const char* name = buffer->name.load(std::memory_order_relaxed);
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"",
+                    first ? "" : ",\n", buffer->tid);
+            if (name) {
+                writeEscaped(file, name);
+            } else {
+                fprintf(file, "thread %u", buffer->tid);
+            }
+            fprintf(file, "\"}}");
+            first = false;
+
+            const uint32_t count = buffer->count.load(std::memory_order_acquire);
+            for (uint32_t i = 0; i < count; i++) {
+                const Event& event = buffer->chunks[i / kChunkEvents].load(std::memory_order_acquire)[i % kChunkEvents];
+                fprintf(file, ",\n{\"name\":\"");
+                writeEscaped(file, event.name);
+                fprintf(file, "\",\"cat\":\"");
+                writeEscaped(file, event.category);
+                fprintf(file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", buffer->tid,
+                        int64_t(event.startNs - m_originNs) / 1000.0, (event.endNs - event.startNs) / 1000.0);
+            }
+            events += count;
+            dropped += buffer->dropped.load(std::memory_order_relaxed);
+        }
+        fprintf(file, "\n]}\n");
+        fclose(file);
+        fprintf(stderr, "trace: %llu events (%llu dropped) -> %s\n", static_cast<unsigned long long>(events),
+                static_cast<unsigned long long>(dropped), m_path.c_str());
+    }
+
+private:
+    std::string m_path;
+    const uint64_t m_originNs = Trace::nowNs();
+
+    std::mutex m_mutex;
+    std::vector<Buffer*> m_buffers;
+    std::atomic<Buffer*> m_tracks[kMaxTracks] = {};
+    std::atomic<uint32_t> m_trackCount {0};
+};
+
+Tracer& tracer()
+{
+    // 第一次记录事件时创建，进程退出时写文件
+    static Tracer instance;
+    return instance;
+}
+
+// 线程退出后缓冲仍然保留，写文件时输出
+thread_local Buffer* threadBuffer = nullptr;
+
+Buffer* currentThreadBuffer()
+{
+    if (!threadBuffer) {
+        threadBuffer = tracer().addBuffer(nullptr);
+    }
+    return threadBuffer;
+}
+
+bool enabledFromEnvironment()
+{
+    const char* path = std::getenv("GL_TRACE");
+    if (!path || !*path) {
+        return false;
+    }
+    // 先创建Tracer，保证它在所有用到它的静态对象之后析构，退出时能写文件
+    tracer();
+    return true;
+}
+
+}
+
+const bool Trace::enabled = enabledFromEnvironment();
+
+void Trace::complete(const char *name, const char *category, uint64_t startNs, uint64_t endNs, uint32_t track)
+{
+    if (!enabled) {
+        return;
+    }
+    Buffer* buffer = track ? tracer().track(track) : currentThreadBuffer();
+    if (buffer) {
+        buffer->append(Event {name, category, startNs, endNs});
+    }
+}
+
+uint32_t Trace::registerTrack(const char *name)
+{
+    return enabled ? tracer().registerTrack(name) : 0;
+}
+
+void Trace::setThreadName(const char *name)
+{
+    if (enabled) {
+        currentThreadBuffer()->name.store(name, std::memory_order_relaxed);
+    }
+}
+
+uint64_t Trace::nowNs()
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Trace::flush()
+{
+    if (enabled) {
+        tracer().write();
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+
+/*
+ * cpu/gpu时间线：输出Chrome trace格式的json（chrome://tracing或者https://ui.perfetto.dev打开），
+ * 把initializeGL/paintGL、纹理解码、着色器编译、readback、工作线程等放到同一条时间线上看
+ *
+ * 环境变量GL_TRACE=文件路径时开启，进程退出时（或者Trace::flush()）写文件：
+ *   GL_TRACE=trace.json ./RenderToTexture
+ *
+ * 使用方法：
+ *   TRACE_SCOPE("paintGL");              // 作用域结束时记录一个事件，name必须是字符串字面量（只保存指针）
+ *   Trace::setThreadName("decode pool");  // 时间线上线程的名字，同样只保存指针
+ * gpu上的耗时见tracegpu.h，gpu时间戳换算到cpu时钟后显示在单独的"GPU"轨道上
+ *
+ * 开销：
+ * 1. 没有开启时TRACE_SCOPE只有一次全局bool的判断（进程启动时确定，之后不变，分支预测总是命中）
+ * 2. 开启时每个事件写入本线程的缓冲（32字节，按16K个事件一块分配），不加锁，每个线程最多记录1M个事件，超过后丢弃并计数
+ * 3. 定义TRACE_DISABLE（qmake CONFIG += trace_off）时TRACE_SCOPE为空
+*/
+class Trace
+{
+public:
+    // 进程启动时根据环境变量GL_TRACE确定
+    static const bool enabled;
+
+    class Scope
+    {
+    public:
+        explicit Scope(const char* name, const char* category = "cpu")
+        {
+            if (enabled) {
+                m_name = name;
+                m_category = category;
+                m_startNs = nowNs();
+            }
+        }
+
+        ~Scope()
+        {
+            if (m_name) {
+                complete(m_name, m_category, m_startNs, nowNs());
+            }
+        }
+
+    private:
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        const char* m_name = nullptr;
+        const char* m_category = nullptr;
+        uint64_t m_startNs = 0;
+    };
+
+    // 记录一个[startNs, endNs]的事件，时间为nowNs()的时钟，track为0时记录在调用线程上
+    static void complete(const char* name, const char* category, uint64_t startNs, uint64_t endNs,
+                         uint32_t track = 0);
+    // 不对应线程的轨道（例如GPU），返回的track用于complete()
+    static uint32_t registerTrack(const char* name);
+    static void setThreadName(const char* name);
+
+    // 单调时钟（steady_clock）
+    static uint64_t nowNs();
+    // 立即写文件（覆盖），进程退出时也会写一次
+    static void flush();
+};
+
+#define TRACE_JOIN_(a, b) a##b
+#define TRACE_JOIN(a, b) TRACE_JOIN_(a, b)
+
+#ifdef TRACE_DISABLE
+#define TRACE_SCOPE(...) do { } while (0)
+#else
+#define TRACE_SCOPE(...) Trace::Scope TRACE_JOIN(traceScope, __LINE__)(__VA_ARGS__)
+#endif
+
+#endif // TRACE_H
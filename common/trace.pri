@@ -0,0 +1,17 @@
+# cpu/gpu时间线：GL_TRACE=文件路径时输出Chrome trace json，CONFIG += trace_off时在编译期去掉
+# 其它common模块的pri也会include这里，只添加一次
+isEmpty(TRACE_PRI_INCLUDED) {
+TRACE_PRI_INCLUDED = 1
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/trace.h \
+    $$PWD/tracegpu.h
+
+SOURCES += \
+    $$PWD/trace.cpp \
+    $$PWD/tracegpu.cpp
+
+trace_off: DEFINES += TRACE_DISABLE
+}
@@ -0,0 +1,175 @@
+#include "tracegpu.h"
+
+#include <QDebug>
+
+#ifndef GL_TIMESTAMP
+#define GL_TIMESTAMP 0x8E28
+#endif
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+
+namespace {
+
+// 结果一直没有完成（或者scope一直没有结束）时最多保留的scope数，再多时丢弃最旧的
+const int kMaxPending = 1024;
+// 重新校准gpu和cpu时钟的间隔
+const uint64_t kCalibrateIntervalNs = 1000000000ULL;
+
+// 桌面gl中是核心函数，gles上是EXT_disjoint_timer_query的EXT版本
+template <typename T>
+T resolve(QOpenGLContext* context, const char* name)
+{
+    T function = reinterpret_cast<T>(context->getProcAddress(name));
+    if (!function) {
+        function = reinterpret_cast<T>(context->getProcAddress(QByteArray(name) + "EXT"));
+    }
+    return function;
+}
+
+}
+
+TraceGpu::TraceGpu()
+{
+}
+
+TraceGpu::~TraceGpu()
+{
+}
+
+void TraceGpu::initialize(QOpenGLContext *context, const char *trackName)
+{
+    m_context = context;
+    m_active = false;
+    if (!Trace::enabled) {
+        return;
+    }
+
+    const bool supported = context->isOpenGLES()
+            ? context->hasExtension("GL_EXT_disjoint_timer_query")
+            : context->format().version() >= qMakePair(3, 3) || context->hasExtension("GL_ARB_timer_query");
+    m_genQueries = resolve<GenQueries>(context, "glGenQueries");
+    m_deleteQueries = resolve<DeleteQueries>(context, "glDeleteQueries");
+    m_queryCounter = resolve<QueryCounter>(context, "glQueryCounter");
+    m_getQueryObjectuiv = resolve<GetQueryObjectuiv>(context, "glGetQueryObjectuiv");
+    m_getQueryObjectui64v = resolve<GetQueryObjectui64v>(context, "glGetQueryObjectui64v");
+    m_getInteger64v = resolve<GetInteger64v>(context, "glGetInteger64v");
+    m_active = supported && m_genQueries && m_deleteQueries && m_queryCounter && m_getQueryObjectuiv
+            && m_getQueryObjectui64v && m_getInteger64v;
+    if (!m_active) {
+        qDebug() << "trace: gpu timestamps not supported";
+        return;
+    }
+    m_track = Trace::registerTrack(trackName);
+    calibrate();
+}
+
+void TraceGpu::destroy()
+{
+    if (!m_active) {
+        return;
+    }
+    while (!m_pending.isEmpty()) {
+        const Pending pending = m_pending.dequeue();
+        m_freeQueries.append(pending.begin);
+        if (pending.end) {
+            m_freeQueries.append(pending.end);
+        }
+    }
+    if (!m_freeQueries.isEmpty()) {
+        m_deleteQueries(m_freeQueries.size(), m_freeQueries.constData());
+        m_freeQueries.clear();
+    }
+    m_active = false;
+}
+
+bool TraceGpu::isActive() const
+{
+    return m_active;
+}
+
+void TraceGpu::collect()
+{
+    if (!m_active) {
+        return;
+    }
+    if (Trace::nowNs() - m_calibratedNs >= kCalibrateIntervalNs) {
+        calibrate();
+    }
+
+    // 按开始的顺序读取，遇到还没有结束或者结果还没有完成的scope就停下，不等待
+    while (!m_pending.isEmpty() && m_pending.head().end) {
+        const Pending& pending = m_pending.head();
+        GLuint available = GL_FALSE;
+        m_getQueryObjectuiv(pending.end, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            break;
+        }
+        quint64 beginNs = 0;
+        quint64 endNs = 0;
+        m_getQueryObjectui64v(pending.begin, GL_QUERY_RESULT, &beginNs);
+        m_getQueryObjectui64v(pending.end, GL_QUERY_RESULT, &endNs);
+        Trace::complete(pending.name, "gpu", uint64_t(qint64(beginNs) + m_offsetNs),
+                        uint64_t(qint64(endNs) + m_offsetNs), m_track);
+
+        m_freeQueries.append(pending.begin);
+        m_freeQueries.append(pending.end);
+        m_pending.dequeue();
+        m_firstIndex++;
+    }
+}
+
+int TraceGpu::begin(const char *name)
+{
+    if (m_pending.size() >= kMaxPending) {
+        const Pending dropped = m_pending.dequeue();
+        m_freeQueries.append(dropped.begin);
+        if (dropped.end) {
+            m_freeQueries.append(dropped.end);
+        }
+        m_firstIndex++;
+    }
+
+    Pending pending;
+    pending.name = name;
+    pending.begin = acquireQuery();
+    m_queryCounter(pending.begin, GL_TIMESTAMP);
+    m_pending.enqueue(pending);
+    return m_firstIndex + m_pending.size() - 1;
+}
+
+void TraceGpu::end(int index)
+{
+    // 已经被丢弃的scope
+    if (!m_active || index < m_firstIndex) {
+        return;
+    }
+    Pending& pending = m_pending[index - m_firstIndex];
+    pending.end = acquireQuery();
+    m_queryCounter(pending.end, GL_TIMESTAMP);
+}
+
+GLuint TraceGpu::acquireQuery()
+{
+    if (m_freeQueries.isEmpty()) {
+        m_freeQueries.resize(32);
+        m_genQueries(m_freeQueries.size(), m_freeQueries.data());
+    }
+    const GLuint query = m_freeQueries.last();
+    m_freeQueries.removeLast();
+    return query;
+}
+
+void TraceGpu::calibrate()
+{
+    // 取gpu时间前后的cpu时间的中点
+    const uint64_t before = Trace::nowNs();
+    qint64 gpuNs = 0;
+    m_getInteger64v(GL_TIMESTAMP, &gpuNs);
+    const uint64_t after = Trace::nowNs();
+    m_offsetNs = qint64(before + (after - before) / 2) - gpuNs;
+    m_calibratedNs = after;
+}
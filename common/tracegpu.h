@@ -0,0 +1,103 @@
+#ifndef TRACEGPU_H
+#define TRACEGPU_H
+
+#include <QQueue>
+#include <QVector>
+#include <QOpenGLContext>
+
+#include "trace.h"
+
+/*
+ * trace.h的gpu部分：scope的开始和结束各记录一个glQueryCounter(GL_TIMESTAMP)，
+ * 结果完成以后换算到cpu的时钟（Trace::nowNs()），记录到时间线上单独的gpu轨道
+ *
+ * gpu和cpu时钟的对应关系通过glGetInteger64v(GL_TIMESTAMP)校准（返回之前的命令到达gpu时的gpu时间），
+ * 每秒重新校准一次，误差一般在几十us以内，足够看出cpu提交和gpu执行之间的延迟
+ *
+ * 需要桌面gl 3.3或者ARB_timer_query，gles上需要EXT_disjoint_timer_query；GL_TRACE没有设置时什么都不做
+ *
+ * 使用方法（和GpuProfiler类似，但scope可以嵌套，结果只输出到trace文件）：
+ * 1. initializeGL中调用initialize()，析构前在context current时调用destroy()
+ * 2. 每帧调用一次collect()，读取已经完成的查询，不等待
+ * 3. { TraceGpu::Scope scope(m_traceGpu, "screen"); glDrawElements(...); }，name需要是字符串常量
+*/
+class TraceGpu
+{
+public:
+    class Scope
+    {
+    public:
+        Scope(TraceGpu& gpu, const char* name)
+            : m_gpu(gpu)
+        {
+            if (m_gpu.m_active) {
+                m_index = m_gpu.begin(name);
+            }
+        }
+
+        ~Scope()
+        {
+            if (m_index >= 0) {
+                m_gpu.end(m_index);
+            }
+        }
+
+    private:
+        Q_DISABLE_COPY(Scope)
+        TraceGpu& m_gpu;
+        int m_index = -1;
+    };
+
+    TraceGpu();
+    ~TraceGpu();
+
+    // trackName为时间线上gpu轨道的名字，多个context（例如渲染线程）使用不同的名字
+    void initialize(QOpenGLContext* context, const char* trackName = "GPU");
+    void destroy();
+    bool isActive() const;
+
+    void collect();
+
+private:
+    struct Pending
+    {
+        const char* name = nullptr;
+        GLuint begin = 0;
+        GLuint end = 0;
+    };
+
+    typedef void (QOPENGLF_APIENTRYP GenQueries)(GLsizei n, GLuint* ids);
+    typedef void (QOPENGLF_APIENTRYP DeleteQueries)(GLsizei n, const GLuint* ids);
+    typedef void (QOPENGLF_APIENTRYP QueryCounter)(GLuint id, GLenum target);
+    typedef void (QOPENGLF_APIENTRYP GetQueryObjectuiv)(GLuint id, GLenum pname, GLuint* params);
+    typedef void (QOPENGLF_APIENTRYP GetQueryObjectui64v)(GLuint id, GLenum pname, quint64* params);
+    typedef void (QOPENGLF_APIENTRYP GetInteger64v)(GLenum pname, qint64* data);
+
+    int begin(const char* name);
+    void end(int index);
+    GLuint acquireQuery();
+    void calibrate();
+
+private:
+    bool m_active = false;
+    QOpenGLContext* m_context = nullptr;
+    uint32_t m_track = 0;
+
+    GenQueries m_genQueries = nullptr;
+    DeleteQueries m_deleteQueries = nullptr;
+    QueryCounter m_queryCounter = nullptr;
+    GetQueryObjectuiv m_getQueryObjectuiv = nullptr;
+    GetQueryObjectui64v m_getQueryObjectui64v = nullptr;
+    GetInteger64v m_getInteger64v = nullptr;
+
+    // 按begin的顺序排列，m_firstIndex为m_pending.head()的序号
+    QQueue<Pending> m_pending;
+    int m_firstIndex = 0;
+    QVector<GLuint> m_freeQueries;
+
+    // cpu时间 = gpu时间 + m_offsetNs
+    qint64 m_offsetNs = 0;
+    uint64_t m_calibratedNs = 0;
+};
+
+#endif // TRACEGPU_H
@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "eglcontext.h"
+#include "glfunctions.h"
+#include "glbackends.h"
+#include "posteffect.h"
+#include "quadgrid.h"
+
+/*
+ * 后处理特效（common/posteffect.h）的片段着色器开销：着色器变体 vs uber shader
+ *   变体：EFFECT以#define注入，每个特效一个program，没有分支
+ *   uber：所有特效在一个program中，按uniform uEffect分支
+ *
+ *   effect-bench [--frames N] [--size N] [--api gles2|gles3|gl33]
+ *
+ * 输入是QuadGrid渲染到size x size纹理的结果，每帧用全屏四边形把它经过特效处理后写到另一个同样大小的fbo，
+ * 只有一次绘制调用，耗时基本都是片段着色器。两种方式的结果读回后逐像素比较，应该完全相同
+*/
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+  int frames = 50;
+  int size = 2048;
+  std::string api = "gles3";
+};
+
+struct Timing {
+  double compileMs = 0.0;
+  double frameMs = 0.0;
+  std::vector<unsigned char> pixels;
+};
+
+double elapsedMs(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+template <typename Renderer>
+class EffectBench {
+public:
+  EffectBench(Renderer &renderer, const Options &options) : m_renderer(renderer), m_options(options) {}
+
+  bool create() {
+    std::string log;
+    QuadGrid<Renderer> grid;
+    if (!m_renderer.createRenderTarget(&m_input, m_options.size, m_options.size) ||
+        !m_renderer.createRenderTarget(&m_output, m_options.size, m_options.size) || !grid.create(m_renderer, 16, &log)) {
+      std::cerr << "setup failed " << log << std::endl;
+      return false;
+    }
+    grid.render(m_renderer, m_input.fbo, m_input.width, m_input.height, 0.0f);
+    grid.destroy(m_renderer);
+
+    VertexLayout layout;
+    layout.stride = 4 * sizeof(float);
+    layout.attributes.push_back(VertexAttribute{"aPos", 2, 0});
+    layout.attributes.push_back(VertexAttribute{"aTexCoords", 2, int(2 * sizeof(float))});
+    m_layout = layout;
+    const float vertices[] = {-1.0f, -1.0f, 0.0f, 0.0f, 1.0f, -1.0f, 1.0f, 0.0f,
+                              1.0f,  1.0f,  1.0f, 1.0f, -1.0f, 1.0f, 0.0f, 1.0f};
+    const GLushort indices[] = {0, 1, 2, 0, 2, 3};
+    return m_renderer.createMesh(&m_quad, layout, vertices, 4, indices, 6);
+  }
+
+  void destroy() {
+    m_renderer.deleteMesh(&m_quad);
+    m_renderer.deleteRenderTarget(&m_input);
+    m_renderer.deleteRenderTarget(&m_output);
+  }
+
+  // uber为true时使用uber shader，否则使用effect的变体
+  bool run(PostEffect::Effect effect, bool uber, Timing *timing) {
+    const ShaderDefines defines = uber ? PostEffect::uberDefines() : PostEffect::defines(effect);
+    std::string log;
+    const Clock::time_point compileStart = Clock::now();
+    const GLuint program = m_renderer.createProgram(defines.inject(PostEffect::vertexShader()),
+                                                    defines.inject(PostEffect::fragmentShader()), m_layout, &log);
+    if (!program) {
+      std::cerr << PostEffect::name(effect) << (uber ? " uber" : "") << ": " << log << std::endl;
+      return false;
+    }
+    typename Renderer::Functions *f = m_renderer.functions();
+    m_renderer.useProgram(program);
+    f->glUniform1i(m_renderer.uniformLocation(program, "screenTexture"), 0);
+    f->glUniform2f(m_renderer.uniformLocation(program, "uTexelSize"), 1.0f / m_input.width, 1.0f / m_input.height);
+    if (uber) {
+      f->glUniform1i(m_renderer.uniformLocation(program, "uEffect"), effect);
+    }
+    f->glActiveTexture(GL_TEXTURE0);
+    f->glBindTexture(GL_TEXTURE_2D, m_input.texture);
+    // 第一帧包括驱动的延迟编译，算在编译时间中
+    draw(program);
+    f->glFinish();
+    timing->compileMs = elapsedMs(compileStart);
+
+    const Clock::time_point start = Clock::now();
+    for (int i = 0; i < m_options.frames; i++) {
+      draw(program);
+    }
+    f->glFinish();
+    timing->frameMs = elapsedMs(start) / m_options.frames;
+
+    timing->pixels.resize(size_t(m_output.width) * m_output.height * 4);
+    f->glBindFramebuffer(GL_FRAMEBUFFER, m_output.fbo);
+    f->glReadPixels(0, 0, m_output.width, m_output.height, GL_RGBA, GL_UNSIGNED_BYTE, timing->pixels.data());
+    m_renderer.deleteProgram(program);
+    return f->glGetError() == GL_NO_ERROR;
+  }
+
+private:
+  void draw(GLuint program) {
+    m_renderer.beginPass(m_output.fbo, m_output.width, m_output.height, 0.0f, 0.0f, 0.0f, 1.0f);
+    m_renderer.useProgram(program);
+    m_renderer.draw(m_quad);
+    // endPass会解绑program，下一帧重新绑定
+    m_renderer.endPass();
+  }
+
+  Renderer &m_renderer;
+  const Options &m_options;
+  VertexLayout m_layout;
+  Mesh m_quad;
+  RenderTarget m_input;
+  RenderTarget m_output;
+};
+
+int maxDifference(const std::vector<unsigned char> &a, const std::vector<unsigned char> &b) {
+  int difference = 0;
+  for (size_t i = 0; i < a.size() && i < b.size(); i++) {
+    difference = std::max(difference, std::abs(int(a[i]) - int(b[i])));
+  }
+  return difference;
+}
+
+template <typename Backend>
+bool run(EglApi api, const Options &options) {
+  EglContext egl;
+  if (!InitEgl(&egl, api)) {
+    return false;
+  }
+  GLFunctions f;
+  if (!f.load(api != EglApi::Gles2)) {
+    DestroyEgl(&egl);
+    return false;
+  }
+  printf("%s backend, %s, %dx%d, %d frames\n", Backend::name(), reinterpret_cast<const char *>(f.glGetString(GL_VERSION)),
+         options.size, options.size, options.frames);
+
+  bool ok = true;
+  {
+    RendererCore<Backend> renderer(&f);
+    EffectBench<RendererCore<Backend>> bench(renderer, options);
+    ok = bench.create();
+    if (ok) {
+      printf("%-10s %16s %16s %8s %18s %9s\n", "effect", "variant ms/frame", "uber ms/frame", "uber/var",
+             "compile var/uber ms", "max diff");
+    }
+    for (int i = 0; ok && i < PostEffect::EffectCount; i++) {
+      const PostEffect::Effect effect = PostEffect::Effect(i);
+      Timing variant;
+      Timing uber;
+      ok = bench.run(effect, false, &variant) && bench.run(effect, true, &uber);
+      if (ok) {
+        printf("%-10s %16.3f %16.3f %8.2f %8.1f / %7.1f %9d\n", PostEffect::name(effect), variant.frameMs, uber.frameMs,
+               uber.frameMs / variant.frameMs, variant.compileMs, uber.compileMs,
+               maxDifference(variant.pixels, uber.pixels));
+      }
+    }
+    bench.destroy();
+  }
+
+  DestroyEgl(&egl);
+  return ok;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  Options options;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "--frames") == 0) {
+      options.frames = std::max(atoi(argv[i + 1]), 1);
+    } else if (strcmp(argv[i], "--size") == 0) {
+      options.size = std::max(atoi(argv[i + 1]), 1);
+    } else if (strcmp(argv[i], "--api") == 0) {
+      options.api = argv[i + 1];
+    }
+  }
+
+  bool ok = false;
+  if (options.api == "gles2") {
+    ok = run<Gles2Backend<GLFunctions>>(EglApi::Gles2, options);
+  } else if (options.api == "gl33") {
+    ok = run<GL33Backend<GLFunctions>>(EglApi::Gl33Core, options);
+  } else {
+    ok = run<Gles3Backend<GLFunctions>>(EglApi::Gles3, options);
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+#include "eglcontext.h"
+
+#include <cstring>
+#include <iostream>
+
+#include "EGL/eglext.h"
+
+namespace {
+
+bool hasExtension(const char *extensions, const char *name) {
+  if (!extensions) {
+    return false;
+  }
+  const size_t length = strlen(name);
+  for (const char *p = extensions; (p = strstr(p, name)) != nullptr; p += length) {
+    // 完整匹配，避免EGL_EXT_platform_device匹配到EGL_EXT_platform_device_xxx
+    if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0')) {
+      return true;
+    }
+  }
+  return false;
+}
+
+EGLDisplay getPlatformDisplay(const char **platform) {
+  // 不带display的查询返回client extensions（EGL 1.5或者EGL_EXT_client_extensions）
+  const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+  PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplayEXT =
+      reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+  if (getPlatformDisplayEXT && hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+    EGLDisplay display = getPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (display != EGL_NO_DISPLAY) {
+      *platform = "surfaceless";
+      return display;
+    }
+  }
+
+  if (getPlatformDisplayEXT && hasExtension(clientExtensions, "EGL_EXT_platform_device")) {
+    PFNEGLQUERYDEVICESEXTPROC queryDevicesEXT =
+        reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(eglGetProcAddress("eglQueryDevicesEXT"));
+    EGLDeviceEXT devices[8];
+    EGLint count = 0;
+    if (queryDevicesEXT && queryDevicesEXT(8, devices, &count) && count > 0) {
+      // 使用第一个设备
+      EGLDisplay display = getPlatformDisplayEXT(EGL_PLATFORM_DEVICE_EXT, devices[0], nullptr);
+      if (display != EGL_NO_DISPLAY) {
+        *platform = "device";
+        return display;
+      }
+    }
+  }
+
+  *platform = "default";
+  return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+} // namespace
+
+bool InitEgl(EglContext *egl, EglApi api) {
+  EGLint configAttribList[] = {EGL_RED_SIZE,
+                               8,
+                               EGL_GREEN_SIZE,
+                               8,
+                               EGL_BLUE_SIZE,
+                               8,
+                               EGL_ALPHA_SIZE,
+                               8,
+                               EGL_RENDERABLE_TYPE,
+                               api == EglApi::Gl33Core ? EGL_OPENGL_BIT
+                                                       : (api == EglApi::Gles3 ? EGL_OPENGL_ES3_BIT : EGL_OPENGL_ES2_BIT),
+                               // 不需要任何surface，surfaceless平台上也没有可以用的surface类型
+                               EGL_SURFACE_TYPE,
+                               0,
+                               EGL_NONE};
+  EGLint contextAttribs[] = {EGL_CONTEXT_CLIENT_VERSION, api == EglApi::Gles3 ? 3 : 2, EGL_NONE, EGL_NONE};
+  // EGL_CONTEXT_MAJOR_VERSION和EGL_CONTEXT_CLIENT_VERSION是同一个值
+  EGLint glContextAttribs[] = {EGL_CONTEXT_MAJOR_VERSION,
+                               3,
+                               EGL_CONTEXT_MINOR_VERSION,
+                               3,
+                               EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                               EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                               EGL_NONE};
+
+  EGLint majorVersion;
+  EGLint minorVersion;
+  EGLint numConfigs;
+  EGLConfig config;
+
+  // Get Display
+  egl->display = getPlatformDisplay(&egl->platform);
+  if (egl->display == EGL_NO_DISPLAY) {
+    std::cerr << "eglGetDisplay failed" << std::endl;
+    return false;
+  }
+
+  // Initialize EGL
+  if (!eglInitialize(egl->display, &majorVersion, &minorVersion)) {
+    std::cerr << "eglInitialize failed: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+    return false;
+  }
+
+  const char *extensions = eglQueryString(egl->display, EGL_EXTENSIONS);
+  if (!hasExtension(extensions, "EGL_KHR_surfaceless_context")) {
+    std::cerr << "EGL_KHR_surfaceless_context not supported" << std::endl;
+    DestroyEgl(egl);
+    return false;
+  }
+
+  if (!eglBindAPI(api == EglApi::Gl33Core ? EGL_OPENGL_API : EGL_OPENGL_ES_API)) {
+    std::cerr << "eglBindAPI failed" << std::endl;
+    DestroyEgl(egl);
+    return false;
+  }
+
+  // Choose config
+  if (!eglChooseConfig(egl->display, configAttribList, &config, 1, &numConfigs) || numConfigs < 1) {
+    std::cerr << "eglChooseConfig failed" << std::endl;
+    DestroyEgl(egl);
+    return false;
+  }
+
+  // Create a GL context
+  egl->context = eglCreateContext(egl->display, config, EGL_NO_CONTEXT,
+                                  api == EglApi::Gl33Core ? glContextAttribs : contextAttribs);
+  if (egl->context == EGL_NO_CONTEXT) {
+    std::cerr << "eglCreateContext failed: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+    DestroyEgl(egl);
+    return false;
+  }
+
+  // Make the context current（没有surface，默认framebuffer不可用，只能渲染到fbo）
+  if (!eglMakeCurrent(egl->display, EGL_NO_SURFACE, EGL_NO_SURFACE, egl->context)) {
+    std::cerr << "eglMakeCurrent failed: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+    DestroyEgl(egl);
+    return false;
+  }
+
+  return true;
+}
+
+void DestroyEgl(EglContext *egl) {
+  if (egl->display == EGL_NO_DISPLAY) {
+    return;
+  }
+  eglMakeCurrent(egl->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  if (egl->context != EGL_NO_CONTEXT) {
+    eglDestroyContext(egl->display, egl->context);
+    egl->context = EGL_NO_CONTEXT;
+  }
+  eglTerminate(egl->display);
+  egl->display = EGL_NO_DISPLAY;
+}
@@ -0,0 +1,29 @@
+#ifndef EGLCONTEXT_H
+#define EGLCONTEXT_H
+
+#include "EGL/egl.h"
+
+/*
+ * 不依赖窗口系统的EGL初始化（linux）：
+ * 1. EGL_MESA_platform_surfaceless：mesa的surfaceless平台，不需要X server/wayland/gbm设备
+ * 2. EGL_EXT_platform_device：直接枚举gpu设备（nvidia等闭源驱动）
+ * 3. 都不支持时退回EGL_DEFAULT_DISPLAY
+ *
+ * context不绑定任何surface（EGL_KHR_surfaceless_context），所有渲染都在fbo中完成
+*/
+
+// context的api：gles2（默认）、gles3或者desktop gl 3.3 core（EGL_KHR_create_context）
+enum class EglApi { Gles2, Gles3, Gl33Core };
+
+struct EglContext {
+  EGLDisplay display = EGL_NO_DISPLAY;
+  EGLContext context = EGL_NO_CONTEXT;
+  // 实际使用的平台，例如"surfaceless"
+  const char *platform = "";
+};
+
+// 创建context并make current，失败时返回false并输出原因
+bool InitEgl(EglContext *egl, EglApi api = EglApi::Gles2);
+void DestroyEgl(EglContext *egl);
+
+#endif // EGLCONTEXT_H
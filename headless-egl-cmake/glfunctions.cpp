@@ -0,0 +1,24 @@
+#include "glfunctions.h"
+
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+// glGenVertexArrays/glBindVertexArray/glDeleteVertexArrays，gles2上没有
+bool isVertexArrayFunction(const char *name) { return strstr(name, "VertexArray") != nullptr; }
+
+} // namespace
+
+bool GLFunctions::load(bool requireVertexArrays) {
+  bool ok = true;
+#define GL_FUNCTION_LOAD(ret, name, params, args)                                       \
+  m_##name = reinterpret_cast<ret(GL_APIENTRY *) params>(eglGetProcAddress(#name));     \
+  if (!m_##name && (requireVertexArrays || !isVertexArrayFunction(#name))) {            \
+    std::cerr << "can't resolve " << #name << std::endl;                                 \
+    ok = false;                                                                          \
+  }
+  GL_FUNCTION_LIST(GL_FUNCTION_LOAD)
+#undef GL_FUNCTION_LOAD
+  return ok;
+}
@@ -0,0 +1,94 @@
+#ifndef GLFUNCTIONS_H
+#define GLFUNCTIONS_H
+
+#include "EGL/egl.h"
+#include "GLES2/gl2.h"
+
+/*
+ * RendererCore（common/renderercore.h）使用的gl函数，全部通过eglGetProcAddress获取，
+ * 同一份代码可以用在gles2/gles3和desktop gl 3.3 core的context上（直接链接libGLESv2时只能用于gles）
+ * 成员函数和gl函数同名，和QOpenGLExtraFunctions的用法一样
+ *
+ * 需要EGL 1.5或者EGL_KHR_get_all_proc_addresses（mesa都支持），load()需要在context current之后调用
+*/
+
+// 返回值，名字，参数声明，参数
+#define GL_FUNCTION_LIST(F)                                                                                         \
+  F(void, glActiveTexture, (GLenum texture), (texture))                                                             \
+  F(void, glAttachShader, (GLuint program, GLuint shader), (program, shader))                                       \
+  F(void, glBindAttribLocation, (GLuint program, GLuint index, const GLchar *name), (program, index, name))         \
+  F(void, glBindBuffer, (GLenum target, GLuint buffer), (target, buffer))                                           \
+  F(void, glBindFramebuffer, (GLenum target, GLuint framebuffer), (target, framebuffer))                            \
+  F(void, glBindTexture, (GLenum target, GLuint texture), (target, texture))                                        \
+  F(void, glBindVertexArray, (GLuint array), (array))                                                               \
+  F(void, glBufferData, (GLenum target, GLsizeiptr size, const void *data, GLenum usage),                           \
+    (target, size, data, usage))                                                                                    \
+  F(GLenum, glCheckFramebufferStatus, (GLenum target), (target))                                                    \
+  F(void, glClear, (GLbitfield mask), (mask))                                                                       \
+  F(void, glClearColor, (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha), (red, green, blue, alpha))       \
+  F(void, glCompileShader, (GLuint shader), (shader))                                                               \
+  F(GLuint, glCreateProgram, (), ())                                                                                \
+  F(GLuint, glCreateShader, (GLenum type), (type))                                                                  \
+  F(void, glDeleteBuffers, (GLsizei n, const GLuint *buffers), (n, buffers))                                        \
+  F(void, glDeleteFramebuffers, (GLsizei n, const GLuint *framebuffers), (n, framebuffers))                         \
+  F(void, glDeleteProgram, (GLuint program), (program))                                                             \
+  F(void, glDeleteShader, (GLuint shader), (shader))                                                                \
+  F(void, glDeleteTextures, (GLsizei n, const GLuint *textures), (n, textures))                                     \
+  F(void, glDeleteVertexArrays, (GLsizei n, const GLuint *arrays), (n, arrays))                                     \
+  F(void, glDisableVertexAttribArray, (GLuint index), (index))                                                      \
+  F(void, glDrawElements, (GLenum mode, GLsizei count, GLenum type, const void *indices),                           \
+    (mode, count, type, indices))                                                                                   \
+  F(void, glEnableVertexAttribArray, (GLuint index), (index))                                                       \
+  F(void, glFinish, (), ())                                                                                         \
+  F(void, glFramebufferTexture2D, (GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level), \
+    (target, attachment, textarget, texture, level))                                                                \
+  F(void, glGenBuffers, (GLsizei n, GLuint *buffers), (n, buffers))                                                 \
+  F(void, glGenFramebuffers, (GLsizei n, GLuint *framebuffers), (n, framebuffers))                                  \
+  F(void, glGenTextures, (GLsizei n, GLuint *textures), (n, textures))                                              \
+  F(void, glGenVertexArrays, (GLsizei n, GLuint *arrays), (n, arrays))                                              \
+  F(GLenum, glGetError, (), ())                                                                                     \
+  F(void, glGetProgramInfoLog, (GLuint program, GLsizei bufSize, GLsizei *length, GLchar *infoLog),                 \
+    (program, bufSize, length, infoLog))                                                                            \
+  F(void, glGetProgramiv, (GLuint program, GLenum pname, GLint *params), (program, pname, params))                  \
+  F(void, glGetShaderInfoLog, (GLuint shader, GLsizei bufSize, GLsizei *length, GLchar *infoLog),                   \
+    (shader, bufSize, length, infoLog))                                                                             \
+  F(void, glGetShaderiv, (GLuint shader, GLenum pname, GLint *params), (shader, pname, params))                     \
+  F(const GLubyte *, glGetString, (GLenum name), (name))                                                            \
+  F(GLint, glGetUniformLocation, (GLuint program, const GLchar *name), (program, name))                             \
+  F(void, glLinkProgram, (GLuint program), (program))                                                               \
+  F(void, glReadPixels, (GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void *pixels), \
+    (x, y, width, height, format, type, pixels))                                                                    \
+  F(void, glShaderSource, (GLuint shader, GLsizei count, const GLchar *const *string, const GLint *length),         \
+    (shader, count, string, length))                                                                                \
+  F(void, glTexImage2D,                                                                                             \
+    (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format,   \
+     GLenum type, const void *pixels),                                                                              \
+    (target, level, internalformat, width, height, border, format, type, pixels))                                   \
+  F(void, glTexParameteri, (GLenum target, GLenum pname, GLint param), (target, pname, param))                      \
+  F(void, glUniform1i, (GLint location, GLint v0), (location, v0))                                                 \
+  F(void, glUniform2f, (GLint location, GLfloat v0, GLfloat v1), (location, v0, v1))                                \
+  F(void, glUniform4f, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3),                            \
+    (location, v0, v1, v2, v3))                                                                                     \
+  F(void, glUseProgram, (GLuint program), (program))                                                                \
+  F(void, glVertexAttribPointer,                                                                                    \
+    (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer),             \
+    (index, size, type, normalized, stride, pointer))                                                               \
+  F(void, glViewport, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height))
+
+class GLFunctions {
+public:
+  // 获取所有函数指针，有任何一个获取不到时返回false；gles2 context上的glGenVertexArrays等gles3函数可以没有
+  bool load(bool requireVertexArrays);
+
+#define GL_FUNCTION_MEMBER(ret, name, params, args) \
+  ret name params { return m_##name args; }
+  GL_FUNCTION_LIST(GL_FUNCTION_MEMBER)
+#undef GL_FUNCTION_MEMBER
+
+private:
+#define GL_FUNCTION_POINTER(ret, name, params, args) ret(GL_APIENTRY *m_##name) params = nullptr;
+  GL_FUNCTION_LIST(GL_FUNCTION_POINTER)
+#undef GL_FUNCTION_POINTER
+};
+
+#endif // GLFUNCTIONS_H
@@ -0,0 +1,87 @@
+#include "glprogram.h"
+
+#include <iostream>
+
+namespace {
+
+void printProgramLog(GLuint f_programId) {
+  if (glIsProgram(f_programId)) {
+    int logLen = 0;
+    glGetProgramiv(f_programId, GL_INFO_LOG_LENGTH, &logLen);
+
+    // 没有日志时logLen为0
+    char *infoLog_a = new char[logLen + 1];
+    infoLog_a[0] = '\0';
+    int infoLogLen = 0;
+    glGetProgramInfoLog(f_programId, logLen + 1, &infoLogLen, infoLog_a);
+
+    std::cerr << infoLog_a << std::endl;
+    delete[] infoLog_a;
+  }
+}
+
+void printShaderLog(GLuint f_shaderId) {
+  if (glIsShader(f_shaderId)) {
+    int logLen = 0;
+    glGetShaderiv(f_shaderId, GL_INFO_LOG_LENGTH, &logLen);
+
+    // 没有日志时logLen为0
+    char *infoLog_a = new char[logLen + 1];
+    infoLog_a[0] = '\0';
+    int infoLogLen = 0;
+    glGetShaderInfoLog(f_shaderId, logLen + 1, &infoLogLen, infoLog_a);
+
+    std::cerr << infoLog_a << std::endl;
+    delete[] infoLog_a;
+  }
+}
+
+GLuint loadShader(const GLchar *f_source_p, GLenum f_type) {
+  GLuint shaderId = glCreateShader(f_type);
+  glShaderSource(shaderId, 1, &f_source_p, nullptr);
+  glCompileShader(shaderId);
+
+  GLint compileStatus = GL_FALSE;
+  glGetShaderiv(shaderId, GL_COMPILE_STATUS, &compileStatus);
+
+  if (!compileStatus) {
+    printShaderLog(shaderId);
+    glDeleteShader(shaderId);
+    shaderId = 0;
+  }
+
+  return shaderId;
+}
+
+} // namespace
+
+GLuint loadProgram(const GLchar *f_vertSource_p, const GLchar *f_fragSource_p) {
+  GLuint vertShader = loadShader(f_vertSource_p, GL_VERTEX_SHADER);
+  GLuint fragShader = loadShader(f_fragSource_p, GL_FRAGMENT_SHADER);
+
+  if (!glIsShader(vertShader) || !glIsShader(fragShader)) {
+    glDeleteShader(vertShader);
+    glDeleteShader(fragShader);
+    return 0;
+  }
+
+  GLuint programId = glCreateProgram();
+  glAttachShader(programId, vertShader);
+  glAttachShader(programId, fragShader);
+
+  glLinkProgram(programId);
+  GLint linkStatus = GL_FALSE;
+  glGetProgramiv(programId, GL_LINK_STATUS, &linkStatus);
+
+  if (!linkStatus) {
+    printProgramLog(programId);
+    glDeleteShader(vertShader);
+    glDeleteShader(fragShader);
+    glDeleteProgram(programId);
+    return 0;
+  }
+
+  glDeleteShader(vertShader);
+  glDeleteShader(fragShader);
+  return programId;
+}
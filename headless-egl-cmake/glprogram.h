@@ -0,0 +1,9 @@
+#ifndef GLPROGRAM_H
+#define GLPROGRAM_H
+
+#include "GLES2/gl2.h"
+
+// 编译链接shader，失败时输出日志并返回0（和angle-triangle-cmake中的实现一样）
+GLuint loadProgram(const GLchar *f_vertSource_p, const GLchar *f_fragSource_p);
+
+#endif // GLPROGRAM_H
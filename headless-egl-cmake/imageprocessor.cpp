@@ -0,0 +1,153 @@
+#include "imageprocessor.h"
+#include "glprogram.h"
+
+#include <iostream>
+
+namespace {
+
+// 全屏四边形（triangle strip）：位置和纹理坐标
+// 纹理第一行（图片最上面一行）在t=0，绘制在fbo的最下面，glReadPixels从最下面一行开始读，读回的行顺序和输入一致
+const GLfloat kVertices[] = {
+    -1.0f, +1.0f, 0.0f, 1.0f, // top-left
+    +1.0f, +1.0f, 1.0f, 1.0f, // top-right
+    -1.0f, -1.0f, 0.0f, 0.0f, // bottom-left
+    +1.0f, -1.0f, 1.0f, 0.0f  // bottom-right
+};
+
+// gles2只支持npot纹理的CLAMP_TO_EDGE和不带mipmap的缩放
+void setTextureParameters() {
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+} // namespace
+
+ImageProcessor::~ImageProcessor() { destroy(); }
+
+bool ImageProcessor::create(const char *vertexShader, const char *fragmentShader, const char *textureVar,
+                            const char *vertexPosVar, const char *textureCoordVar) {
+  m_program = loadProgram(vertexShader, fragmentShader);
+  if (!m_program) {
+    return false;
+  }
+  m_positionLocation = glGetAttribLocation(m_program, vertexPosVar);
+  m_texCoordLocation = glGetAttribLocation(m_program, textureCoordVar);
+  if (m_positionLocation < 0 || m_texCoordLocation < 0) {
+    std::cerr << "attribute " << vertexPosVar << "/" << textureCoordVar << " not found" << std::endl;
+    destroy();
+    return false;
+  }
+  glUseProgram(m_program);
+  glUniform1i(glGetUniformLocation(m_program, textureVar), 0);
+
+  glGenBuffers(1, &m_vertexBuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(kVertices), kVertices, GL_STATIC_DRAW);
+  return glGetError() == GL_NO_ERROR;
+}
+
+void ImageProcessor::destroy() {
+  if (m_fbo) {
+    glDeleteFramebuffers(1, &m_fbo);
+    m_fbo = 0;
+  }
+  if (m_colorTexture) {
+    glDeleteTextures(1, &m_colorTexture);
+    m_colorTexture = 0;
+  }
+  if (m_texture) {
+    glDeleteTextures(1, &m_texture);
+    m_texture = 0;
+  }
+  if (m_vertexBuffer) {
+    glDeleteBuffers(1, &m_vertexBuffer);
+    m_vertexBuffer = 0;
+  }
+  if (m_program) {
+    glDeleteProgram(m_program);
+    m_program = 0;
+  }
+  m_width = 0;
+  m_height = 0;
+}
+
+bool ImageProcessor::process(const Image &input, Image *output) {
+  if (!m_program || !prepareTarget(input.width, input.height)) {
+    return false;
+  }
+
+  // 尺寸不变，只更新纹理数据
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, m_texture);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, input.width, input.height, GL_RGBA, GL_UNSIGNED_BYTE,
+                  input.rgba.data());
+
+  glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+  glViewport(0, 0, input.width, input.height);
+
+  glUseProgram(m_program);
+  glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+  glVertexAttribPointer(GLuint(m_positionLocation), 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), nullptr);
+  glEnableVertexAttribArray(GLuint(m_positionLocation));
+  glVertexAttribPointer(GLuint(m_texCoordLocation), 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat),
+                        reinterpret_cast<const void *>(2 * sizeof(GLfloat)));
+  glEnableVertexAttribArray(GLuint(m_texCoordLocation));
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+  // readpix读取渲染的数据，GL_RGBA/GL_UNSIGNED_BYTE是gles2一定支持的组合
+  output->width = input.width;
+  output->height = input.height;
+  output->rgba.resize(size_t(input.width) * input.height * 4);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, input.width, input.height, GL_RGBA, GL_UNSIGNED_BYTE, output->rgba.data());
+
+  const GLenum error = glGetError();
+  if (error != GL_NO_ERROR) {
+    std::cerr << "gl error: 0x" << std::hex << error << std::dec << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool ImageProcessor::prepareTarget(int width, int height) {
+  if (m_fbo && width == m_width && height == m_height) {
+    return true;
+  }
+
+  GLint maxSize = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+  if (width <= 0 || height <= 0 || width > maxSize || height > maxSize) {
+    std::cerr << "image size " << width << "x" << height << " not supported (max " << maxSize << ")" << std::endl;
+    return false;
+  }
+
+  if (!m_texture) {
+    glGenTextures(1, &m_texture);
+    glGenTextures(1, &m_colorTexture);
+    glGenFramebuffers(1, &m_fbo);
+  }
+
+  // 输入纹理只分配storage，数据在process()中用glTexSubImage2D上传
+  glBindTexture(GL_TEXTURE_2D, m_texture);
+  setTextureParameters();
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+  glBindTexture(GL_TEXTURE_2D, m_colorTexture);
+  setTextureParameters();
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_colorTexture, 0);
+  const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    std::cerr << "fbo incomplete: 0x" << std::hex << status << std::dec << std::endl;
+    return false;
+  }
+
+  m_width = width;
+  m_height = height;
+  return true;
+}
@@ -0,0 +1,47 @@
+#ifndef IMAGEPROCESSOR_H
+#define IMAGEPROCESSOR_H
+
+#include <string>
+
+#include "GLES2/gl2.h"
+#include "ppm.h"
+
+/*
+ * RenderToTextureNoUI中processImage的gles2版本：图片上传为纹理，用片段着色器绘制到fbo，再glReadPixels读回
+ * 和OffscreenProcessor一样常驻：program和四边形的vbo只创建一次，fbo和纹理在图片尺寸不变时复用
+ *
+ * 需要在EGL context current的线程中使用（见eglcontext.h）
+*/
+class ImageProcessor {
+public:
+  ImageProcessor() = default;
+  ~ImageProcessor();
+
+  ImageProcessor(const ImageProcessor &) = delete;
+  ImageProcessor &operator=(const ImageProcessor &) = delete;
+
+  // 编译链接shader并上传四边形，vertexPosVar/textureCoordVar为vec2顶点属性，textureVar为sampler2D
+  bool create(const char *vertexShader, const char *fragmentShader, const char *textureVar,
+              const char *vertexPosVar, const char *textureCoordVar);
+  void destroy();
+
+  bool process(const Image &input, Image *output);
+
+private:
+  bool prepareTarget(int width, int height);
+
+private:
+  GLuint m_program = 0;
+  GLuint m_vertexBuffer = 0;
+  GLint m_positionLocation = -1;
+  GLint m_texCoordLocation = -1;
+
+  // 尺寸不变时复用
+  GLuint m_texture = 0;
+  GLuint m_colorTexture = 0;
+  GLuint m_fbo = 0;
+  int m_width = 0;
+  int m_height = 0;
+};
+
+#endif // IMAGEPROCESSOR_H
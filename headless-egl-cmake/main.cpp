@@ -0,0 +1,179 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+
+#include "eglcontext.h"
+#include "imageprocessor.h"
+#include "ppm.h"
+
+/*
+ * RenderToTextureNoUI的无界面版本：不需要QApplication、平台插件和X server，可以直接在守护进程/容器中运行
+ *   headless-egl [input.ppm] [output.ppm] [--bench N]
+ * 没有输入时使用程序生成的1920x1080渐变图片
+ *
+ * 输出进程启动到EGL可用、到第一张图片处理完成的时间，以及峰值内存（VmHWM），
+ * 和RenderToTextureNoUI（QApplication + QOffscreenSurface）对比，例如：
+ *   ./headless-egl girls.ppm out.ppm
+ *   QT_QPA_PLATFORM=offscreen ./RenderToTextureNoUI
+ * 软件渲染（没有gpu）时可以设置LIBGL_ALWAYS_SOFTWARE=1
+*/
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const char kVertexShader[] = R"(attribute vec4 aPosition;
+attribute vec2 aTexCoord;
+varying vec2 vTexCoord;
+void main()
+{
+    gl_Position = aPosition;
+    vTexCoord = aTexCoord;
+})";
+
+// 使用片段着色器将棕褐色效果应用于图像（和RenderToTextureNoUI相同，gles需要声明精度）
+const char kFragmentShader[] = R"(precision mediump float;
+uniform sampler2D texture;
+varying vec2 vTexCoord;
+void main()
+{
+    vec2 uv = vTexCoord;
+    vec4 orig = texture2D(texture, uv);
+    vec3 col = orig.rgb;
+    float y = 0.3 * col.r + 0.59 * col.g + 0.11 * col.b;
+    gl_FragColor = vec4(y + 0.15, y + 0.07, y - 0.12, 1.0);
+})";
+
+double elapsedMs(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// 进程启动（exec）到现在的时间，/proc/self/stat中的starttime精度为一个clock tick（一般10ms）
+double processUptimeMs() {
+  std::ifstream stat("/proc/self/stat");
+  std::string content;
+  std::getline(stat, content);
+  // 第2个字段（进程名）可能包含空格，从最后一个')'之后开始数，starttime是第22个字段
+  const size_t pos = content.rfind(')');
+  if (pos == std::string::npos) {
+    return -1.0;
+  }
+  const char *p = content.c_str() + pos + 2;
+  for (int field = 3; field < 22 && p; field++) {
+    p = strchr(p, ' ');
+    if (p) {
+      p++;
+    }
+  }
+  if (!p) {
+    return -1.0;
+  }
+  const double startSeconds = strtoull(p, nullptr, 10) / double(sysconf(_SC_CLK_TCK));
+
+  timespec now;
+  clock_gettime(CLOCK_BOOTTIME, &now);
+  return (now.tv_sec + now.tv_nsec / 1e9 - startSeconds) * 1000.0;
+}
+
+// 峰值内存，单位KB
+long peakRssKb() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 6, "VmHWM:") == 0) {
+      return strtol(line.c_str() + 6, nullptr, 10);
+    }
+  }
+  return -1;
+}
+
+Image gradientImage(int width, int height) {
+  Image image;
+  image.width = width;
+  image.height = height;
+  image.rgba.resize(size_t(width) * height * 4);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      uint8_t *pixel = &image.rgba[(size_t(y) * width + x) * 4];
+      pixel[0] = uint8_t(x * 255 / width);
+      pixel[1] = uint8_t(y * 255 / height);
+      pixel[2] = 128;
+      pixel[3] = 255;
+    }
+  }
+  return image;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  const Clock::time_point start = Clock::now();
+  const double execToMainMs = processUptimeMs();
+
+  std::string inputPath;
+  std::string outputPath;
+  int iterations = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+      iterations = atoi(argv[++i]);
+    } else if (inputPath.empty()) {
+      inputPath = argv[i];
+    } else {
+      outputPath = argv[i];
+    }
+  }
+
+  EglContext egl;
+  if (!InitEgl(&egl)) {
+    return 1;
+  }
+  const double eglMs = elapsedMs(start);
+  std::cout << "egl platform: " << egl.platform << " renderer: " << glGetString(GL_RENDERER) << std::endl;
+
+  Image input;
+  if (inputPath.empty()) {
+    input = gradientImage(1920, 1080);
+  } else if (!ReadPpm(inputPath, &input)) {
+    DestroyEgl(&egl);
+    return 1;
+  }
+
+  ImageProcessor processor;
+  Image output;
+  if (!processor.create(kVertexShader, kFragmentShader, "texture", "aPosition", "aTexCoord") ||
+      !processor.process(input, &output)) {
+    processor.destroy();
+    DestroyEgl(&egl);
+    return 1;
+  }
+  const double firstImageMs = elapsedMs(start);
+
+  if (!outputPath.empty() && !WritePpm(outputPath, output)) {
+    processor.destroy();
+    DestroyEgl(&egl);
+    return 1;
+  }
+
+  std::cout << "image size: " << input.width << "x" << input.height << std::endl;
+  std::cout << "startup: exec->main " << execToMainMs << " ms, main->egl ready " << eglMs
+            << " ms, main->first image " << firstImageMs << " ms" << std::endl;
+
+  if (iterations > 0) {
+    // 和RenderToTextureNoUI --bench中OffscreenProcessor的数据对比
+    const Clock::time_point benchStart = Clock::now();
+    for (int i = 0; i < iterations; i++) {
+      processor.process(input, &output);
+    }
+    std::cout << "ImageProcessor calls/sec: " << iterations * 1000.0 / elapsedMs(benchStart) << std::endl;
+  }
+  std::cout << "peak rss: " << peakRssKb() << " KB" << std::endl;
+
+  processor.destroy();
+  DestroyEgl(&egl);
+  return 0;
+}
@@ -0,0 +1,92 @@
+#include "ppm.h"
+
+#include <cstdio>
+#include <cctype>
+#include <iostream>
+
+namespace {
+
+// 读取头部的一个数字，跳过空白和'#'开始的注释
+bool readHeaderValue(FILE *file, int *value) {
+  int c = fgetc(file);
+  while (c != EOF && (isspace(c) || c == '#')) {
+    if (c == '#') {
+      while (c != EOF && c != '\n') {
+        c = fgetc(file);
+      }
+    }
+    c = fgetc(file);
+  }
+  if (c == EOF || !isdigit(c)) {
+    return false;
+  }
+  *value = 0;
+  while (c != EOF && isdigit(c)) {
+    *value = *value * 10 + (c - '0');
+    if (*value > (1 << 16)) {
+      return false;
+    }
+    c = fgetc(file);
+  }
+  // 数字后面紧跟一个空白字符，maxval之后就是像素数据
+  return c != EOF && isspace(c);
+}
+
+} // namespace
+
+bool ReadPpm(const std::string &path, Image *image) {
+  FILE *file = fopen(path.c_str(), "rb");
+  if (!file) {
+    std::cerr << "can't open " << path << std::endl;
+    return false;
+  }
+
+  char magic[2] = {};
+  int width = 0;
+  int height = 0;
+  int maxValue = 0;
+  if (fread(magic, 1, 2, file) != 2 || magic[0] != 'P' || magic[1] != '6' || !readHeaderValue(file, &width) ||
+      !readHeaderValue(file, &height) || !readHeaderValue(file, &maxValue) || width <= 0 || height <= 0 ||
+      maxValue != 255) {
+    std::cerr << path << ": only binary 8-bit PPM (P6) is supported" << std::endl;
+    fclose(file);
+    return false;
+  }
+
+  std::vector<uint8_t> rgb(size_t(width) * height * 3);
+  const bool ok = fread(rgb.data(), 1, rgb.size(), file) == rgb.size();
+  fclose(file);
+  if (!ok) {
+    std::cerr << path << ": truncated" << std::endl;
+    return false;
+  }
+
+  image->width = width;
+  image->height = height;
+  image->rgba.resize(size_t(width) * height * 4);
+  for (size_t i = 0, n = size_t(width) * height; i < n; i++) {
+    image->rgba[i * 4 + 0] = rgb[i * 3 + 0];
+    image->rgba[i * 4 + 1] = rgb[i * 3 + 1];
+    image->rgba[i * 4 + 2] = rgb[i * 3 + 2];
+    image->rgba[i * 4 + 3] = 255;
+  }
+  return true;
+}
+
+bool WritePpm(const std::string &path, const Image &image) {
+  FILE *file = fopen(path.c_str(), "wb");
+  if (!file) {
+    std::cerr << "can't write " << path << std::endl;
+    return false;
+  }
+
+  fprintf(file, "P6\n%d %d\n255\n", image.width, image.height);
+  std::vector<uint8_t> rgb(size_t(image.width) * image.height * 3);
+  for (size_t i = 0, n = size_t(image.width) * image.height; i < n; i++) {
+    rgb[i * 3 + 0] = image.rgba[i * 4 + 0];
+    rgb[i * 3 + 1] = image.rgba[i * 4 + 1];
+    rgb[i * 3 + 2] = image.rgba[i * 4 + 2];
+  }
+  const bool ok = fwrite(rgb.data(), 1, rgb.size(), file) == rgb.size();
+  return fclose(file) == 0 && ok;
+}
@@ -0,0 +1,19 @@
+#ifndef PPM_H
+#define PPM_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// RGBA8图片，行从上到下，行之间没有填充
+struct Image {
+  int width = 0;
+  int height = 0;
+  std::vector<uint8_t> rgba;
+};
+
+// 二进制PPM（P6，maxval 255）读写，不依赖任何图片库；jpeg/png可以先转换：convert in.jpeg in.ppm
+bool ReadPpm(const std::string &path, Image *image);
+bool WritePpm(const std::string &path, const Image &image);
+
+#endif // PPM_H
@@ -0,0 +1,147 @@
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "eglcontext.h"
+#include "glfunctions.h"
+#include "glbackends.h"
+#include "quadgrid.h"
+
+/*
+ * 同一个负载（common/quadgrid.h）分别用RendererCore的三个后端渲染，对比每帧的耗时：
+ *   gles2：gles2 context，Gles2Backend（#version 100，每次绘制设置顶点属性）
+ *   gles3：gles3 context，Gles3Backend（#version 300 es，vao）
+ *   gl33： desktop gl 3.3 core context，GL33Backend（#version 330 core，vao）
+ *
+ *   renderer-bench [--frames N] [--grid N] [--size N]
+ *
+ * 每个后端渲染到size x size的fbo，最后读回所有像素，和gles2的结果比较每个通道的最大差值。
+ * gles和desktop gl转换到8位时的舍入不完全相同（mesa下差1），超过1说明后端的状态设置有问题
+ * mesa下可以用LIBGL_ALWAYS_SOFTWARE=1（llvmpipe）或者GALLIUM_DRIVER=softpipe对比不同的驱动
+*/
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+  int frames = 200;
+  int grid = 32;
+  int size = 512;
+};
+
+struct Result {
+  bool ok = false;
+  std::string renderer;
+  double setupMs = 0.0;
+  double frameMs = 0.0;
+  std::vector<unsigned char> pixels;
+};
+
+double elapsedMs(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+template <typename Backend>
+Result run(EglApi api, const Options &options) {
+  Result result;
+  const Clock::time_point setupStart = Clock::now();
+
+  EglContext egl;
+  if (!InitEgl(&egl, api)) {
+    return result;
+  }
+  GLFunctions f;
+  if (!f.load(api != EglApi::Gles2)) {
+    DestroyEgl(&egl);
+    return result;
+  }
+  result.renderer = reinterpret_cast<const char *>(f.glGetString(GL_VERSION));
+
+  {
+    RendererCore<Backend> renderer(&f);
+    RenderTarget target;
+    QuadGrid<RendererCore<Backend>> grid;
+    std::string log;
+    if (!renderer.createRenderTarget(&target, options.size, options.size) ||
+        !grid.create(renderer, options.grid, &log)) {
+      std::cerr << Backend::name() << ": setup failed " << log << std::endl;
+      DestroyEgl(&egl);
+      return result;
+    }
+
+    // 第一帧包括驱动的shader编译等延迟初始化，算在setup中
+    grid.render(renderer, target.fbo, target.width, target.height, 0.0f);
+    f.glFinish();
+    result.setupMs = elapsedMs(setupStart);
+
+    const Clock::time_point start = Clock::now();
+    for (int i = 0; i < options.frames; i++) {
+      grid.render(renderer, target.fbo, target.width, target.height, i * 0.01f);
+    }
+    f.glFinish();
+    result.frameMs = elapsedMs(start) / options.frames;
+
+    // 最后一帧的time相同，三个后端的像素应该一致
+    result.pixels.resize(size_t(target.width) * target.height * 4);
+    f.glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+    f.glReadPixels(0, 0, target.width, target.height, GL_RGBA, GL_UNSIGNED_BYTE, result.pixels.data());
+    result.ok = f.glGetError() == GL_NO_ERROR;
+
+    grid.destroy(renderer);
+    renderer.deleteRenderTarget(&target);
+  }
+
+  DestroyEgl(&egl);
+  return result;
+}
+
+// 和reference的每个通道的最大差值，reference无效时返回0
+int maxDifference(const Result &result, const Result &reference) {
+  if (!reference.ok || reference.pixels.size() != result.pixels.size()) {
+    return 0;
+  }
+  int difference = 0;
+  for (size_t i = 0; i < result.pixels.size(); i++) {
+    difference = std::max(difference, std::abs(int(result.pixels[i]) - int(reference.pixels[i])));
+  }
+  return difference;
+}
+
+void print(const char *name, const Result &result, const Result &reference, int drawCalls) {
+  if (!result.ok) {
+    printf("%-6s failed\n", name);
+    return;
+  }
+  printf("%-6s %8.3f ms/frame %10.0f draws/s  setup %7.1f ms  max diff %d  (%s)\n", name, result.frameMs,
+         drawCalls * 1000.0 / result.frameMs, result.setupMs, maxDifference(result, reference),
+         result.renderer.c_str());
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  Options options;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "--frames") == 0) {
+      options.frames = std::max(atoi(argv[i + 1]), 1);
+    } else if (strcmp(argv[i], "--grid") == 0) {
+      options.grid = std::max(atoi(argv[i + 1]), 1);
+    } else if (strcmp(argv[i], "--size") == 0) {
+      options.size = std::max(atoi(argv[i + 1]), 1);
+    }
+  }
+
+  const int drawCalls = options.grid * options.grid;
+  printf("frames %d, %d draw calls per frame, %dx%d fbo\n", options.frames, drawCalls, options.size, options.size);
+  const Result gles2 = run<Gles2Backend<GLFunctions>>(EglApi::Gles2, options);
+  print("gles2", gles2, gles2, drawCalls);
+  print("gles3", run<Gles3Backend<GLFunctions>>(EglApi::Gles3, options), gles2, drawCalls);
+  print("gl33", run<GL33Backend<GLFunctions>>(EglApi::Gl33Core, options), gles2, drawCalls);
+  return 0;
+}
@@ -0,0 +1,24 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    AsyncLogBench \
+    BenchCompare \
+    Blend \
+    Box3d \
+    ColourRect \
+    CoordinateSystems \
+    HelloRect \
+    HelloTriangle \
+    MatrixBench \
+    MultiTexture \
+    RenderToTexture \
+    RenderToTextureNoUI \
+    RendererCore \
+    RotateCamera \
+    Texture \
+    TexturePacker \
+    Transform
+
+# make bench：离屏测试所有例子的帧时间并和BenchCompare/baseline.json比较，有回归时失败
+bench.commands = sh $$PWD/BenchCompare/run_bench.sh $$OUT_PWD
+QMAKE_EXTRA_TARGETS += bench